@@ -0,0 +1,231 @@
+#include "analysis_stats.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include "util/allocation_counter.h"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+constexpr u32 Log2Histogram::NumBuckets;
+
+StringPiece phaseName(AnalysisPhase phase) {
+  switch (phase) {
+    case AnalysisPhase::Input:
+      return "input";
+    case AnalysisPhase::DicNodes:
+      return "dictionary";
+    case AnalysisPhase::UnkNodes1:
+      return "unknown words";
+    case AnalysisPhase::UnkNodes2:
+      return "unknown words (2)";
+    case AnalysisPhase::BuildLattice:
+      return "lattice";
+    case AnalysisPhase::Bootstrap:
+      return "bootstrap";
+    case AnalysisPhase::Scoring:
+      return "scoring";
+    case AnalysisPhase::OtherScorers:
+      return "other scorers";
+    default:
+      return "unknown";
+  }
+}
+
+void Log2Histogram::reset() {
+  std::memset(buckets_, 0, sizeof(buckets_));
+  count_ = 0;
+  total_ = 0;
+  max_ = 0;
+}
+
+u32 Log2Histogram::bucketOf(u64 value) {
+  u32 bucket = 0;
+  while (value != 0 && bucket < NumBuckets - 1) {
+    value >>= 1;
+    bucket += 1;
+  }
+  return bucket;
+}
+
+void Log2Histogram::merge(const Log2Histogram& o) {
+  for (u32 i = 0; i < NumBuckets; ++i) {
+    buckets_[i] += o.buckets_[i];
+  }
+  count_ += o.count_;
+  total_ += o.total_;
+  max_ = std::max(max_, o.max_);
+}
+
+double Log2Histogram::mean() const {
+  if (count_ == 0) {
+    return 0;
+  }
+  return static_cast<double>(total_) / count_;
+}
+
+u64 Log2Histogram::quantile(double q) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  auto rank = static_cast<u64>(q * count_);
+  rank = std::min(rank, count_ - 1);
+  u64 seen = 0;
+  for (u32 i = 0; i < NumBuckets; ++i) {
+    seen += buckets_[i];
+    if (seen > rank) {
+      if (i == 0) {
+        return 0;
+      }
+      u64 upper = (u64{1} << i) - 1;
+      return std::min(upper, max_);
+    }
+  }
+  return max_;
+}
+
+void AnalysisStats::reset() { std::memset(this, 0, sizeof(AnalysisStats)); }
+
+u64 AnalysisStats::totalNanos() const {
+  u64 total = 0;
+  for (auto n : phaseNanos) {
+    total += n;
+  }
+  return total;
+}
+
+void AnalysisStatsAggregate::add(const AnalysisStats& stats) {
+  for (u32 i = 0; i < NumAnalysisPhases; ++i) {
+    phases_[i].add(stats.phaseNanos[i]);
+  }
+  total_.add(stats.totalNanos());
+  codepoints_.add(stats.numCodepoints);
+  nodes_.add(stats.numNodes);
+  beamCandidates_.add(stats.beamCandidates);
+  scoredConnections_.add(stats.scoredConnections);
+  prunedConnections_.add(stats.prunedConnections);
+  featuresHashed_.add(stats.featuresHashed);
+  rnnContexts_.add(stats.rnnContexts);
+  rnnContextHits_.add(stats.rnnContextHits);
+  allocations_.add(stats.allocations);
+  for (u32 i = 0; i < 16; ++i) {
+    boundaryNodes_[i] += stats.boundaryNodes[i];
+  }
+}
+
+void AnalysisStatsAggregate::merge(const AnalysisStatsAggregate& o) {
+  for (u32 i = 0; i < NumAnalysisPhases; ++i) {
+    phases_[i].merge(o.phases_[i]);
+  }
+  total_.merge(o.total_);
+  codepoints_.merge(o.codepoints_);
+  nodes_.merge(o.nodes_);
+  beamCandidates_.merge(o.beamCandidates_);
+  scoredConnections_.merge(o.scoredConnections_);
+  prunedConnections_.merge(o.prunedConnections_);
+  featuresHashed_.merge(o.featuresHashed_);
+  rnnContexts_.merge(o.rnnContexts_);
+  rnnContextHits_.merge(o.rnnContextHits_);
+  allocations_.merge(o.allocations_);
+  for (u32 i = 0; i < 16; ++i) {
+    boundaryNodes_[i] += o.boundaryNodes_[i];
+  }
+}
+
+namespace {
+
+void printTimes(std::ostream& os, StringPiece name, const Log2Histogram& h,
+                u64 total) {
+  double share = total == 0 ? 0 : 100.0 * h.total() / total;
+  os << std::left << std::setw(18) << name.str() << std::right;
+  os << std::setw(12) << h.total() * 1e-6 << std::setw(8) << share;
+  os << std::setw(10) << h.mean() * 1e-3;
+  os << std::setw(10) << h.quantile(0.5) * 1e-3;
+  os << std::setw(10) << h.quantile(0.9) * 1e-3;
+  os << std::setw(10) << h.quantile(0.99) * 1e-3;
+  os << std::setw(10) << h.max() * 1e-3 << "\n";
+}
+
+void printCounts(std::ostream& os, StringPiece name, const Log2Histogram& h) {
+  os << std::left << std::setw(18) << name.str() << std::right;
+  os << std::setw(14) << h.total() << std::setw(10) << h.mean();
+  os << std::setw(10) << h.quantile(0.5) << std::setw(10) << h.quantile(0.9);
+  os << std::setw(10) << h.quantile(0.99) << std::setw(10) << h.max() << "\n";
+}
+
+}  // namespace
+
+void AnalysisStatsAggregate::print(std::ostream& os) const {
+  if (!AnalysisStatsEnabled) {
+    os << "Analysis statistics are not available: "
+          "Juman++ was built without JPP_ANALYSIS_STATS\n";
+    return;
+  }
+
+  auto flags = os.flags();
+  auto total = total_.total();
+  os << "Analysis statistics for " << numAnalyses() << " sentences\n";
+  os << "quantiles are upper bounds of power of 2 buckets\n";
+  os << std::fixed << std::setprecision(1);
+  os << std::left << std::setw(18) << "phase" << std::right << std::setw(12)
+     << "total ms" << std::setw(8) << "%" << std::setw(10) << "mean us"
+     << std::setw(10) << "p50 us" << std::setw(10) << "p90 us"
+     << std::setw(10) << "p99 us" << std::setw(10) << "max us"
+     << "\n";
+  for (u32 i = 0; i < NumAnalysisPhases; ++i) {
+    printTimes(os, phaseName(static_cast<AnalysisPhase>(i)), phases_[i],
+               total);
+  }
+  printTimes(os, "total", total_, total);
+
+  os << "\n"
+     << std::left << std::setw(18) << "per sentence" << std::right
+     << std::setw(14) << "total" << std::setw(10) << "mean" << std::setw(10)
+     << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+     << std::setw(10) << "max"
+     << "\n";
+  printCounts(os, "codepoints", codepoints_);
+  printCounts(os, "nodes", nodes_);
+  printCounts(os, "beam candidates", beamCandidates_);
+  printCounts(os, "scored pairs", scoredConnections_);
+  printCounts(os, "pruned pairs", prunedConnections_);
+  printCounts(os, "hashed features", featuresHashed_);
+  if (rnnContexts_.total() != 0) {
+    printCounts(os, "rnn contexts", rnnContexts_);
+    printCounts(os, "rnn cache hits", rnnContextHits_);
+    os << "rnn cache hit rate: "
+       << 100.0 * rnnContextHits_.total() / rnnContexts_.total() << "%\n";
+  }
+  if (util::memory::allocationCountingEnabled()) {
+    printCounts(os, "allocations", allocations_);
+  }
+
+  os << "\nnodes per boundary:\n";
+  u64 numBoundaries = 0;
+  for (auto cnt : boundaryNodes_) {
+    numBoundaries += cnt;
+  }
+  for (u32 i = 0; i < 16; ++i) {
+    auto cnt = boundaryNodes_[i];
+    if (cnt == 0) {
+      continue;
+    }
+    u64 lower = i == 0 ? 0 : u64{1} << (i - 1);
+    os << std::setw(8) << lower << " - ";
+    if (i == 15) {
+      os << std::left << std::setw(8) << "..." << std::right;
+    } else {
+      os << std::left << std::setw(8) << (i == 0 ? 0 : (u64{1} << i) - 1)
+         << std::right;
+    }
+    os << std::setw(14) << cnt << std::setw(8)
+       << 100.0 * cnt / numBoundaries << "%\n";
+  }
+  os.flags(flags);
+}
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,202 @@
+#ifndef JUMANPP_ANALYSIS_STATS_H
+#define JUMANPP_ANALYSIS_STATS_H
+
+#include <chrono>
+#include <iosfwd>
+#include "core_config.h"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+#ifdef JPP_ANALYSIS_STATS
+constexpr bool AnalysisStatsEnabled = true;
+#else
+constexpr bool AnalysisStatsEnabled = false;
+#endif
+
+enum class AnalysisPhase : u32 {
+  Input,         // resetForInput
+  DicNodes,      // dictionary lookup
+  UnkNodes1,     // unknown words which are always created
+  UnkNodes2,     // unknown words for unconnected lattices
+  BuildLattice,  // lattice construction and unigram features
+  Bootstrap,     // score processor creation
+  Scoring,       // ngram features and beams
+  OtherScorers,  // additional scorers, e.g. RNN
+  NumPhases
+};
+
+constexpr u32 NumAnalysisPhases = static_cast<u32>(AnalysisPhase::NumPhases);
+
+StringPiece phaseName(AnalysisPhase phase);
+
+/**
+ * A histogram with power of 2 bucket bounds.
+ * Bucket 0 contains zeros, bucket i contains values from [2^(i-1), 2^i).
+ */
+class Log2Histogram {
+ public:
+  static constexpr u32 NumBuckets = 48;
+
+ private:
+  u64 buckets_[NumBuckets];
+  u64 count_;
+  u64 total_;
+  u64 max_;
+
+ public:
+  Log2Histogram() { reset(); }
+
+  void reset();
+
+  static u32 bucketOf(u64 value);
+
+  void add(u64 value) {
+    buckets_[bucketOf(value)] += 1;
+    count_ += 1;
+    total_ += value;
+    max_ = value > max_ ? value : max_;
+  }
+
+  void merge(const Log2Histogram& o);
+
+  u64 count() const { return count_; }
+  u64 total() const { return total_; }
+  u64 max() const { return max_; }
+  double mean() const;
+  u64 bucket(u32 idx) const { return buckets_[idx]; }
+
+  /**
+   * An upper bound of the quantile value:
+   * the upper bound of the bucket which contains it, clamped by the maximum.
+   * @param q quantile from [0, 1]
+   */
+  u64 quantile(double q) const;
+};
+
+/**
+ * Statistics of a single analysis.
+ * They are collected only if Juman++ was built with JPP_ANALYSIS_STATS.
+ */
+struct AnalysisStats {
+  // wall time of analysis phases
+  u64 phaseNanos[NumAnalysisPhases];
+  u32 numCodepoints;
+  u32 numBoundaries;
+  u32 numNodes;
+  // histogram of node counts starting at a boundary,
+  // in the same buckets as Log2Histogram
+  u32 boundaryNodes[16];
+  // left beam elements which were connected to right nodes
+  u64 beamCandidates;
+  // (left beam element, right node) pairs which had their scores computed
+  u64 scoredConnections;
+  // scored pairs which skipped trigram features because of score bounds
+  u64 prunedConnections;
+  // ngram feature values which were hashed and looked up in the weights,
+  // counted where the feature kernels are called
+  u64 featuresHashed;
+  // RNN contexts which were required by additional scorers
+  u64 rnnContexts;
+  // RNN contexts which were taken from the cache instead of computing them
+  u64 rnnContextHits;
+  // heap allocations, counted only in binaries which link
+  // the jpp_util_alloc_counter library
+  u64 allocations;
+
+  AnalysisStats() { reset(); }
+
+  void reset();
+
+  u64 totalNanos() const;
+
+  void addBoundary(u32 nodes) {
+    auto bucket = Log2Histogram::bucketOf(nodes);
+    bucket = bucket < 15 ? bucket : 15;
+    boundaryNodes[bucket] += 1;
+    numBoundaries += 1;
+    numNodes += nodes;
+  }
+
+  u64 phase(AnalysisPhase p) const {
+    return phaseNanos[static_cast<u32>(p)];
+  }
+};
+
+/**
+ * Measures a phase of analysis for the lifetime of the object.
+ * Does nothing if statistics are not compiled in.
+ */
+class AnalysisPhaseTimer {
+  using clock = std::chrono::steady_clock;
+  AnalysisStats* stats_;
+  AnalysisPhase phase_;
+  clock::time_point start_;
+
+ public:
+  AnalysisPhaseTimer(AnalysisStats* stats, AnalysisPhase phase)
+      : stats_{stats}, phase_{phase} {
+    if (AnalysisStatsEnabled) {
+      start_ = clock::now();
+    }
+  }
+
+  AnalysisPhaseTimer(const AnalysisPhaseTimer&) = delete;
+
+  ~AnalysisPhaseTimer() {
+    if (AnalysisStatsEnabled) {
+      auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          clock::now() - start_);
+      stats_->phaseNanos[static_cast<u32>(phase_)] += elapsed.count();
+    }
+  }
+};
+
+/**
+ * Statistics of many analyses: totals and histograms of per-sentence values.
+ * Aggregates are not thread-safe, use one per thread and merge them.
+ */
+class AnalysisStatsAggregate {
+  Log2Histogram phases_[NumAnalysisPhases];
+  Log2Histogram total_;
+  Log2Histogram codepoints_;
+  Log2Histogram nodes_;
+  Log2Histogram beamCandidates_;
+  Log2Histogram scoredConnections_;
+  Log2Histogram prunedConnections_;
+  Log2Histogram featuresHashed_;
+  Log2Histogram rnnContexts_;
+  Log2Histogram rnnContextHits_;
+  Log2Histogram allocations_;
+  u64 boundaryNodes_[16] = {0};
+
+ public:
+  void add(const AnalysisStats& stats);
+  void merge(const AnalysisStatsAggregate& o);
+
+  u64 numAnalyses() const { return total_.count(); }
+  const Log2Histogram& phase(AnalysisPhase p) const {
+    return phases_[static_cast<u32>(p)];
+  }
+  const Log2Histogram& totalNanos() const { return total_; }
+  const Log2Histogram& nodes() const { return nodes_; }
+  const Log2Histogram& scoredConnections() const { return scoredConnections_; }
+  const Log2Histogram& prunedConnections() const { return prunedConnections_; }
+  const Log2Histogram& allocations() const { return allocations_; }
+
+  /**
+   * Node counts per boundary, in buckets of Log2Histogram
+   */
+  const u64* boundaryNodes() const { return boundaryNodes_; }
+
+  void print(std::ostream& os) const;
+};
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_ANALYSIS_STATS_H
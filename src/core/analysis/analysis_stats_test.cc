@@ -0,0 +1,67 @@
+#include "core/analysis/analysis_stats.h"
+#include <sstream>
+#include "core/test/test_analyzer_env.h"
+
+using namespace tests;
+
+TEST_CASE("log2 histogram has correct buckets") {
+  CHECK(Log2Histogram::bucketOf(0) == 0);
+  CHECK(Log2Histogram::bucketOf(1) == 1);
+  CHECK(Log2Histogram::bucketOf(2) == 2);
+  CHECK(Log2Histogram::bucketOf(3) == 2);
+  CHECK(Log2Histogram::bucketOf(4) == 3);
+  CHECK(Log2Histogram::bucketOf(~u64{0}) == Log2Histogram::NumBuckets - 1);
+}
+
+TEST_CASE("log2 histogram computes quantile bounds") {
+  Log2Histogram h;
+  for (u64 i = 1; i <= 100; ++i) {
+    h.add(i);
+  }
+  CHECK(h.count() == 100);
+  CHECK(h.total() == 5050);
+  CHECK(h.max() == 100);
+  CHECK(h.mean() == Approx(50.5));
+  CHECK(h.quantile(0.5) == 63);
+  CHECK(h.quantile(0.9) == 100);
+  CHECK(h.quantile(0) == 1);
+
+  Log2Histogram h2;
+  h2.add(1000);
+  h.merge(h2);
+  CHECK(h.count() == 101);
+  CHECK(h.max() == 1000);
+  CHECK(h.quantile(1.0) == 1000);
+}
+
+TEST_CASE("analysis stats are collected") {
+  StringPiece dic = "XXX,z,KANA\na,b,\nb,c,\n";
+  PrimFeatureTestEnv env{
+      dic, [](dsl::ModelSpecBuilder& specBldr, FeatureSet& fs) {}};
+  env.analyze2("ab");
+  auto& stats = env.stats();
+  CHECK(stats.numCodepoints == 2);
+  // BOS-a, a-b, b-EOS
+  CHECK(stats.beamCandidates == 3);
+  CHECK(stats.scoredConnections == 3);
+  CHECK(stats.featuresHashed == 3);
+  if (AnalysisStatsEnabled) {
+    CHECK(stats.numBoundaries == 2);
+    CHECK(stats.numNodes == 2);
+    CHECK(stats.boundaryNodes[1] == 2);
+    CHECK(stats.totalNanos() > 0);
+  }
+
+  AnalysisStatsAggregate agg;
+  agg.add(stats);
+  env.analyze2("ba");
+  agg.add(env.stats());
+  CHECK(agg.numAnalyses() == 2);
+  if (AnalysisStatsEnabled) {
+    CHECK(agg.nodes().total() == 4);
+    CHECK(agg.boundaryNodes()[1] == 4);
+  }
+  std::stringstream ss;
+  agg.print(ss);
+  CHECK_FALSE(ss.str().empty());
+}
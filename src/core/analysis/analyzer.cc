@@ -56,6 +56,8 @@ Analyzer::Analyzer() {}
 
 const CoreHolder &Analyzer::core() const { return ptr_->core(); }
 
+const AnalysisStats &Analyzer::stats() const { return ptr_->stats(); }
+
 }  // namespace analysis
 }  // namespace core
 }  // namespace jumanpp
@@ -23,6 +23,18 @@ struct AnalyzerConfig {
   i32 autoBeamStep = 0;
   i32 autoBeamBase = 0;
   i32 autoBeamMax = 0;
+  // Adaptive global beam: candidates which are worse than the best one
+  // by more than the margin are dropped from global and right beams.
+  // Beam sizes above become upper bounds and the minimums are always kept.
+  // Zero margin (the default) disables adaptive beams. Margins were not
+  // evaluated on real text, so they are enabled only explicitly.
+  float adaptiveBeamMargin = 0;
+  i32 adaptiveGlobalBeamMin = 1;
+  i32 adaptiveRightBeamMin = 1;
+  // Global beam scoring skips trigram features of connections which can not
+  // enter the beam even with the largest possible trigram feature weights.
+  // Beams do not change, scores can differ by float rounding.
+  bool trigramPruning = false;
 };
 
 /**
@@ -36,6 +48,8 @@ class ScorePlugin;
 
 struct ScorerDef;
 
+struct AnalysisStats;
+
 class Analyzer {
   std::unique_ptr<AnalyzerImpl> pimpl_;
   AnalyzerImpl* ptr_;
@@ -51,6 +65,11 @@ class Analyzer {
   Status analyze(StringPiece input, ScorePlugin* plugin = nullptr);
   const OutputManager& output() const;
 
+  /**
+   * Statistics of the last analyze() call
+   */
+  const AnalysisStats& stats() const;
+
   const ScorerDef* scorer() const { return scorer_; }
   AnalyzerImpl* impl() const { return ptr_; }
   const CoreHolder& core() const;
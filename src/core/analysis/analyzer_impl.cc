@@ -3,7 +3,6 @@
 //
 
 #include "core/analysis/analyzer_impl.h"
-#include "core/analysis/dictionary_node_creator.h"
 #include "core/analysis/innode_features.h"
 #include "core/analysis/score_api.h"
 #include "core/analysis/score_processor.h"
@@ -17,8 +16,13 @@ namespace core {
 namespace analysis {
 
 Status AnalyzerImpl::resetForInput(StringPiece input) {
+  AnalysisPhaseTimer timer{&stats_, AnalysisPhase::Input};
   reset();
+  if (AnalysisStatsEnabled) {
+    allocStart_ = util::memory::threadAllocationCount();
+  }
   JPP_RETURN_IF_ERROR(input_.reset(input));
+  stats_.numCodepoints = static_cast<u32>(input_.numCodepoints());
   latticeBldr_.reset(input_.numCodepoints());
   autoBeamSizes();
   return Status::Ok();
@@ -33,6 +37,8 @@ AnalyzerImpl::AnalyzerImpl(const CoreHolder* core, const ScoringConfig& sconf,
       input_{cfg.maxInputBytes},
       latticeConfig_{core->latticeConfig(sconf)},
       lattice_{alloc_.get(), latticeConfig_},
+      dicNodes_{core->dic().entries()},
+      overlayNodes_{core->dic().overlayEntries()},
       xtra_{alloc_.get(), core->dic().entries().numFeatures(),
             core->spec().features.numPlaceholders},
       outputManager_{&xtra_, &core->dic(), &lattice_},
@@ -59,6 +65,18 @@ Status AnalyzerImpl::initScorers(const ScorerDef& cfg) {
     return JPPS_INVALID_PARAMETER
            << "right global beam size should not be zero if you enable it";
   }
+
+  if (cfg_.adaptiveBeamMargin < 0) {
+    return JPPS_INVALID_PARAMETER << "adaptive beam margin can not be negative";
+  }
+
+  if (cfg_.adaptiveBeamMargin > 0 &&
+      (cfg_.adaptiveGlobalBeamMin <= 0 || cfg_.adaptiveRightBeamMin <= 0)) {
+    return JPPS_INVALID_PARAMETER
+           << "minimum adaptive beam sizes should be positive, were "
+           << cfg_.adaptiveGlobalBeamMin << " and "
+           << cfg_.adaptiveRightBeamMin;
+  }
   scorers_.clear();
   scorers_.reserve(cfg.others.size());
   for (auto& sf : cfg.others) {
@@ -89,15 +107,22 @@ Status AnalyzerImpl::initScorers(const ScorerDef& cfg) {
 }
 
 Status AnalyzerImpl::makeNodeSeedsFromDic() {
-  DictionaryNodeCreator dnc{core_->dic().entries()};
-  if (!dnc.spawnNodes(input_, &latticeBldr_)) {
+  AnalysisPhaseTimer timer{&stats_, AnalysisPhase::DicNodes};
+  if (!dicNodes_.spawnNodes(input_, &latticeBldr_)) {
     return Status::InvalidState()
            << "error when creating nodes from dictionary";
   }
+  if (core_->dic().hasOverlay()) {
+    if (!overlayNodes_.spawnNodes(input_, &latticeBldr_)) {
+      return Status::InvalidState()
+             << "error when creating nodes from user dictionary";
+    }
+  }
   return Status::Ok();
 }
 
 Status AnalyzerImpl::makeUnkNodes1() {
+  AnalysisPhaseTimer timer{&stats_, AnalysisPhase::UnkNodes1};
   auto& unk = core_->unkMakers();
   analysis::UnkNodesContext unc{&xtra_, alloc(), dic().entries()};
   for (auto& m : unk.stage1) {
@@ -114,6 +139,7 @@ bool AnalyzerImpl::checkLatticeConnectivity() {
 }
 
 Status AnalyzerImpl::makeUnkNodes2() {
+  AnalysisPhaseTimer timer{&stats_, AnalysisPhase::UnkNodes2};
   auto& unk = core_->unkMakers();
   analysis::UnkNodesContext unc{&xtra_, alloc(), dic().entries()};
   for (auto& m : unk.stage2) {
@@ -139,6 +165,7 @@ Status AnalyzerImpl::prepareNodeSeeds() {
 }
 
 Status AnalyzerImpl::buildLattice() {
+  AnalysisPhaseTimer timer{&stats_, AnalysisPhase::BuildLattice};
   lattice_.hintSize(input_.numCodepoints() + 3);
 
   LatticeConstructionContext lcc;
@@ -164,6 +191,9 @@ Status AnalyzerImpl::buildLattice() {
 
     JPP_DCHECK_EQ(bnd->starts()->numEntries(),
                   latticeBldr_.infoAt(boundary).startCount);
+    if (AnalysisStatsEnabled) {
+      stats_.addBoundary(bnd->localNodeCount());
+    }
   }
 
   JPP_RETURN_IF_ERROR(latticeBldr_.makeEos(&lcc, &lattice_));
@@ -177,6 +207,7 @@ Status AnalyzerImpl::buildLattice() {
 }
 
 Status AnalyzerImpl::bootstrapAnalysis() {
+  AnalysisPhaseTimer timer{&stats_, AnalysisPhase::Bootstrap};
   auto x = ScoreProcessor::make(this);
   JPP_RETURN_IF_ERROR(std::move(x.first));
   sproc_ = x.second;
@@ -204,6 +235,7 @@ Status AnalyzerImpl::computeScoresFull(const ScorerDef* sconf) {
     return Status::Ok();
   }
 
+  AnalysisPhaseTimer timer{&stats_, AnalysisPhase::Scoring};
   for (i32 boundary = 2; boundary < bndCount; ++boundary) {
     JPP_CAPTURE(boundary);
     auto bnd = lattice_.boundary(boundary);
@@ -232,6 +264,7 @@ Status AnalyzerImpl::computeScoresFull(const ScorerDef* sconf) {
       proc.resolveBeamAt(t1node.boundary, t1node.position);
       auto scores = bnd->scores();
       i32 activeBeam = proc.activeBeamSize();
+      stats_.beamCandidates += activeBeam;
       for (i32 beamIdx = 0; beamIdx < activeBeam; ++beamIdx) {
         JPP_CAPTURE(beamIdx);
         proc.applyT2(beamIdx, sconf->feature);
@@ -259,34 +292,41 @@ Status AnalyzerImpl::computeScoresGbeam(const ScorerDef* sconf) {
 
   auto& proc = *this->sproc_;
 
-  for (i32 boundary = 2; boundary < bndCount; ++boundary) {
-    JPP_CAPTURE(boundary);
-    auto bnd = lattice_.boundary(boundary);
-    if (bnd->localNodeCount() == 0) {
-      continue;
-    }
-    JPP_DCHECK(bnd->endingsFilled());
-    proc.startBoundary(bnd->localNodeCount());
-    if (proc.patternIsStatic()) {
-      auto entries = dic().entries();
-      features::impl::PrimitiveFeatureContext pfc{&xtra_, dic().fields(),
-                                                  entries, input_.codepoints()};
-      proc.computeT0All(boundary, sconf->feature, &pfc);
-      if (JPP_UNLIKELY(cfg_.storeAllPatterns)) {
-        proc.computeUniOnlyPatterns(boundary, &pfc);
+  {
+    AnalysisPhaseTimer timer{&stats_, AnalysisPhase::Scoring};
+    for (i32 boundary = 2; boundary < bndCount; ++boundary) {
+      JPP_CAPTURE(boundary);
+      auto bnd = lattice_.boundary(boundary);
+      if (bnd->localNodeCount() == 0) {
+        continue;
+      }
+      JPP_DCHECK(bnd->endingsFilled());
+      proc.startBoundary(bnd->localNodeCount());
+      if (proc.patternIsStatic()) {
+        auto entries = dic().entries();
+        features::impl::PrimitiveFeatureContext pfc{
+            &xtra_, dic().fields(), entries, input_.codepoints()};
+        proc.computeT0All(boundary, sconf->feature, &pfc);
+        if (JPP_UNLIKELY(cfg_.storeAllPatterns)) {
+          proc.computeUniOnlyPatterns(boundary, &pfc);
+        }
+      } else {
+        proc.applyT0(boundary, sconf->feature);
       }
-    } else {
-      proc.applyT0(boundary, sconf->feature);
-    }
 
-    auto gbeam = proc.makeGlobalBeam(boundary, latticeConfig_.globalBeamSize);
-    proc.computeGbeamScores(boundary, gbeam, sconf->feature);
+      auto gbeam =
+          proc.makeGlobalBeam(boundary, latticeConfig_.globalBeamSize);
+      stats_.beamCandidates += gbeam.size();
+      proc.computeGbeamScores(boundary, gbeam, sconf->feature);
+    }
   }
 
   if (!scorers_.empty()) {
+    AnalysisPhaseTimer timer{&stats_, AnalysisPhase::OtherScorers};
     u32 idx = 1;
     for (auto& s : scorers_) {
       JPP_RETURN_IF_ERROR(s->scoreLattice(&lattice_, &xtra_, idx));
+      s->addStats(&stats_);
       ++idx;
     }
     proc.adjustBeamScores(sconf->scoreWeights);
@@ -302,10 +342,18 @@ Status AnalyzerImpl::computeScores(const ScorerDef* sconf) {
   }
   // LOG_TRACE() << "Scorer weights: " << VOut(sconf->scoreWeights);
   if (cfg().globalBeamSize <= 0) {
-    return computeScoresFull(sconf);
+    JPP_RETURN_IF_ERROR(computeScoresFull(sconf));
   } else {
-    return computeScoresGbeam(sconf);
+    JPP_RETURN_IF_ERROR(computeScoresGbeam(sconf));
+  }
+  stats_.scoredConnections = sproc_->scoredConnections();
+  stats_.prunedConnections = sproc_->prunedConnections();
+  stats_.featuresHashed = sproc_->featuresHashed();
+  if (AnalysisStatsEnabled) {
+    stats_.allocations = util::memory::threadAllocationCount().allocations -
+                         allocStart_.allocations;
   }
+  return Status::Ok();
 }
 
 bool AnalyzerImpl::setGlobalBeam(i32 leftBeam, i32 rightCheck, i32 rightBeam) {
@@ -330,6 +378,17 @@ bool AnalyzerImpl::setGlobalBeam(i32 leftBeam, i32 rightCheck, i32 rightBeam) {
   return result;
 }
 
+void AnalyzerImpl::setAdaptiveBeam(float margin, i32 minGlobal,
+                                   i32 minRight) {
+  cfg_.adaptiveBeamMargin = margin;
+  cfg_.adaptiveGlobalBeamMin = minGlobal;
+  cfg_.adaptiveRightBeamMin = minRight;
+}
+
+void AnalyzerImpl::setTrigramPruning(bool value) {
+  cfg_.trigramPruning = value;
+}
+
 bool AnalyzerImpl::setStoreAllPatterns(bool value) {
   if (cfg_.storeAllPatterns == value) {
     return false;
@@ -6,12 +6,15 @@
 #define JUMANPP_ANALYZER_IMPL_H
 
 #include "core/analysis/analysis_input.h"
+#include "core/analysis/analysis_stats.h"
 #include "core/analysis/analyzer.h"
+#include "core/analysis/dictionary_node_creator.h"
 #include "core/analysis/extra_nodes.h"
 #include "core/analysis/lattice_builder.h"
 #include "core/analysis/lattice_types.h"
 #include "core/analysis/score_plugin.h"
 #include "core/analysis/score_processor.h"
+#include "util/allocation_counter.h"
 
 namespace jumanpp {
 namespace core {
@@ -27,6 +30,8 @@ class AnalyzerImpl {
   LatticeConfig latticeConfig_;
   Lattice lattice_;
   LatticeBuilder latticeBldr_;
+  DictionaryNodeCreator dicNodes_;
+  DictionaryNodeCreator overlayNodes_;
   ExtraNodesContext xtra_;
   OutputManager outputManager_;
   ScoreProcessor* sproc_;
@@ -34,6 +39,8 @@ class AnalyzerImpl {
   LatticeCompactor compactor_;
   NgramStats ngramStats_;
   ScorePlugin* plugin_ = nullptr;
+  AnalysisStats stats_;
+  util::memory::AllocationCount allocStart_;
 
  public:
   AnalyzerImpl(const AnalyzerImpl&) = delete;
@@ -52,6 +59,7 @@ class AnalyzerImpl {
     alloc_->reset();
     sproc_ = nullptr;
     plugin_ = nullptr;
+    stats_.reset();
   }
 
   // This set of functions is internal
@@ -93,8 +101,14 @@ class AnalyzerImpl {
 
   util::memory::PoolAlloc* alloc() const { return alloc_.get(); }
   const NgramStats& ngramStats() const { return ngramStats_; }
+  /**
+   * Statistics of the current analysis, see AnalysisStatsEnabled
+   */
+  const AnalysisStats& stats() const { return stats_; }
   const AnalyzerConfig& cfg() const { return cfg_; }
   bool setGlobalBeam(i32 leftBeam, i32 rightCheck, i32 rightBeam);
+  void setAdaptiveBeam(float margin, i32 minGlobal, i32 minRight);
+  void setTrigramPruning(bool value);
   bool setStoreAllPatterns(bool value);
   const AnalysisInput& input() const { return input_; }
   i32 autoBeamSizes();
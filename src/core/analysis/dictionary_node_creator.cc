@@ -8,23 +8,51 @@ namespace jumanpp {
 namespace core {
 namespace analysis {
 
-bool DictionaryNodeCreator::spawnNodes(const AnalysisInput& input,
-                                       LatticeBuilder* lattice) {
+using dic::TraverseStatus;
+
+void DictionaryNodeCreator::spawnFrom(dic::IndexTraversal trav,
+                                      const AnalysisInput& input,
+                                      LatticePosition begin,
+                                      LatticePosition position,
+                                      LatticePosition limit,
+                                      LatticeBuilder* lattice) const {
   auto& points = input.codepoints();
+  for (; position < limit; ++position) {
+    auto& cp = points[position];
+    TraverseStatus status = trav.step(cp.bytes);
+    if (status == TraverseStatus::Ok) {
+      LatticePosition end = position + LatticePosition(1);
+      auto dicEntries = trav.entries();
+      while (dicEntries.readOnePtr()) {
+        lattice->appendSeed(dicEntries.currentPtr(), begin, end);
+      }
+    } else if (status == TraverseStatus::NoNode) {
+      break;
+    }
+  }
+}
 
+void DictionaryNodeCreator::spawnWithCodepointTrie(const AnalysisInput& input,
+                                                   LatticeBuilder* lattice) {
+  auto& points = input.codepoints();
+  auto& trie = entries_.codepointTrie();
   LatticePosition totalPoints = (LatticePosition)points.size();
+  codes_.clear();
+  for (auto& cp : points) {
+    codes_.push_back(trie.codeOf(cp));
+  }
 
   for (LatticePosition begin = 0; begin < totalPoints; ++begin) {
-    auto trav = entries_.traversal();
-
-    using dic::TraverseStatus;
-
-    for (LatticePosition position = begin; position < totalPoints; ++position) {
-      auto& cp = points[position];
-      TraverseStatus status = trav.step(cp.bytes);
+    if (codes_[begin] == 0) {
+      continue;
+    }
+    auto trav = trie.traversal();
+    for (LatticePosition position = begin; position < totalPoints;
+         ++position) {
+      TraverseStatus status = trav.step(codes_[position]);
       if (status == TraverseStatus::Ok) {
         LatticePosition end = position + LatticePosition(1);
-        auto dicEntries = trav.entries();
+        auto dicEntries = entries_.entryTraversal(trav);
         while (dicEntries.readOnePtr()) {
           lattice->appendSeed(dicEntries.currentPtr(), begin, end);
         }
@@ -33,6 +61,56 @@ bool DictionaryNodeCreator::spawnNodes(const AnalysisInput& input,
       }
     }
   }
+}
+
+bool DictionaryNodeCreator::spawnNodes(const AnalysisInput& input,
+                                       LatticeBuilder* lattice) {
+  if (entries_.codepointTrie().loaded()) {
+    spawnWithCodepointTrie(input, lattice);
+    return true;
+  }
+
+  auto& points = input.codepoints();
+
+  LatticePosition totalPoints = (LatticePosition)points.size();
+  auto& index = entries_.firstCodepoints();
+
+  if (!index.loaded()) {
+    for (LatticePosition begin = 0; begin < totalPoints; ++begin) {
+      spawnFrom(entries_.traversal(), input, begin, begin, totalPoints,
+                lattice);
+    }
+    return true;
+  }
+
+  for (LatticePosition begin = 0; begin < totalPoints; ++begin) {
+    auto& cp = points[begin];
+    auto info = index.find(cp.codepoint);
+    if (info == nullptr) {
+      continue;
+    }
+
+    if (JPP_UNLIKELY(cp.bytes.size() != info->byteLength)) {
+      // input has a non-canonical encoding of the codepoint
+      spawnFrom(entries_.traversal(), input, begin, begin, totalPoints,
+                lattice);
+      continue;
+    }
+
+    LatticePosition next = begin + LatticePosition(1);
+    if (info->value >= 0) {
+      auto dicEntries = entries_.entriesOf(*info);
+      while (dicEntries.readOnePtr()) {
+        lattice->appendSeed(dicEntries.currentPtr(), begin, next);
+      }
+    }
+
+    auto limit = std::min<u32>(totalPoints, begin + info->maxLength);
+    if (next < limit) {
+      spawnFrom(entries_.traversalAfter(*info), input, begin, next,
+                static_cast<LatticePosition>(limit), lattice);
+    }
+  }
 
   return true;
 }
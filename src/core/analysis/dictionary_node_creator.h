@@ -15,6 +15,14 @@ namespace analysis {
 
 class DictionaryNodeCreator {
   dic::DictionaryEntries entries_;
+  // codepoint trie codes of the current input
+  std::vector<u32> codes_;
+
+  void spawnFrom(dic::IndexTraversal trav, const AnalysisInput& input,
+                 LatticePosition begin, LatticePosition position,
+                 LatticePosition limit, LatticeBuilder* lattice) const;
+  void spawnWithCodepointTrie(const AnalysisInput& input,
+                              LatticeBuilder* lattice);
 
  public:
   DictionaryNodeCreator(const dic::DictionaryEntries& entries_);
@@ -9,6 +9,10 @@
 #include "testing/test_analyzer.h"
 #include "util/string_piece.h"
 
+#include <set>
+#include <sstream>
+#include <tuple>
+
 using namespace jumanpp::core::analysis;
 using namespace jumanpp::core::spec;
 using namespace jumanpp::core::dic;
@@ -21,6 +25,8 @@ namespace {
 class NodeCreatorTestEnv {
   TestEnv tenv;
   StringField fld;
+  std::vector<std::string> keys;
+  FirstCodepointIndexBuilder indexBldr;
 
  public:
   NodeCreatorTestEnv(StringPiece csvData) {
@@ -30,6 +36,17 @@ class NodeCreatorTestEnv {
     });
     tenv.importDic(csvData);
     REQUIRE_OK(tenv.analyzer->output().stringField("a", &fld));
+
+    // dictionaries with a codepoint trie do not contain the index
+    std::stringstream lines{csvData.str()};
+    std::string line;
+    while (std::getline(lines, line)) {
+      keys.push_back(line);
+    }
+    for (auto& key : keys) {
+      indexBldr.add(key);
+    }
+    REQUIRE_OK(indexBldr.build(tenv.restoredDic.trieContent));
   }
 
   void analyze(StringPiece str) {
@@ -38,6 +55,63 @@ class NodeCreatorTestEnv {
     CHECK_OK(tenv.analyzer->makeNodeSeedsFromDic());
   }
 
+  const DictionaryEntries entries() const {
+    return tenv.analyzer->dic().entries();
+  }
+
+  // seeds which are produced by walking the trie from every position
+  std::set<std::tuple<i32, i32, i32>> fullTraversalSeeds(StringPiece str) {
+    std::vector<chars::InputCodepoint> cp;
+    REQUIRE(chars::preprocessRawData(str, &cp));
+    std::set<std::tuple<i32, i32, i32>> result;
+    for (i32 begin = 0; begin < cp.size(); ++begin) {
+      auto trav = entries().traversal();
+      for (i32 pos = begin; pos < cp.size(); ++pos) {
+        auto status = trav.step(cp[pos].bytes);
+        if (status == TraverseStatus::NoNode) {
+          break;
+        }
+        if (status == TraverseStatus::Ok) {
+          auto ents = trav.entries();
+          while (ents.readOnePtr()) {
+            result.emplace(ents.currentPtr().rawValue(), begin, pos + 1);
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  // seeds of the analyzed input which are produced by a dictionary
+  // with some of lookup structures removed
+  std::set<std::tuple<i32, i32, i32>> seedsWith(bool codepointTrie,
+                                                bool firstCodepoints) {
+    dic::BuiltDictionary built = tenv.restoredDic;
+    if (!codepointTrie) {
+      built.codepointTrie = StringPiece{};
+    }
+    if (firstCodepoints) {
+      built.firstCodepointIndex = indexBldr.result();
+    }
+    dic::EntriesHolder holder;
+    REQUIRE_OK(dic::fillEntriesHolder(built, &holder));
+    dic::DictionaryEntries entries{&holder};
+    CHECK(entries.codepointTrie().loaded() == codepointTrie);
+    CHECK(entries.firstCodepoints().loaded() == firstCodepoints);
+
+    auto& input = tenv.analyzer->input();
+    LatticeBuilder builder;
+    builder.reset(static_cast<LatticePosition>(input.codepoints().size()));
+    DictionaryNodeCreator creator{entries};
+    creator.spawnNodes(input, &builder);
+    std::set<std::tuple<i32, i32, i32>> result;
+    for (auto& seed : builder.seeds()) {
+      result.emplace(seed.entryPtr.rawValue(), seed.codepointStart,
+                     seed.codepointEnd);
+    }
+    return result;
+  }
+
   bool exists(StringPiece str, i32 start) {
     CAPTURE(str);
     CAPTURE(start);
@@ -72,6 +146,23 @@ TEST_CASE("it is possible to extract some nodes from input string") {
   CHECK(env.exists("gum", 2));
 }
 
+TEST_CASE("all dictionary lookup paths give the same seeds") {
+  NodeCreatorTestEnv env{
+      "東\n東京\n東京都\n京都\n京都府\n都\na\nab\nabc\n𠮷野家\n野"};
+  for (std::string str :
+       {"東京都の京都府", "abcab𠮷野家", "xyz", "東東京京都都"}) {
+    CAPTURE(str);
+    env.analyze(str);
+    auto expected = env.fullTraversalSeeds(str);
+    CHECK(env.seedsWith(true, true) == expected);
+    CHECK(env.seedsWith(false, true) == expected);
+    CHECK(env.seedsWith(false, false) == expected);
+  }
+  env.analyze("東京都の京都府");
+  CHECK(env.exists("東京都", 0));
+  CHECK(env.exists("京都府", 4));
+}
+
 namespace {
 class NodeCreatorTestEnv2 {
   TestEnv tenv;
@@ -52,11 +52,28 @@ bool LatticeBuilder::checkConnectability() {
 }
 
 void LatticeBuilder::sortSeeds() {
-  std::stable_sort(
-      seeds_.begin(), seeds_.end(),
-      [](const LatticeNodeSeed &l, const LatticeNodeSeed &r) -> bool {
-        return l.codepointStart < r.codepointStart;
-      });
+  auto byStart = [](const LatticeNodeSeed &l, const LatticeNodeSeed &r) {
+    return l.codepointStart < r.codepointStart;
+  };
+  if (std::is_sorted(seeds_.begin(), seeds_.end(), byStart)) {
+    return;
+  }
+
+  // Stable counting sort by the starting codepoint.
+  // std::stable_sort would allocate a temporary buffer for each input.
+  seedOffsets_.clear();
+  seedOffsets_.resize(maxBoundaries_ + 1, 0);
+  for (auto &seed : seeds_) {
+    seedOffsets_[seed.codepointStart + 1] += 1;
+  }
+  for (size_t i = 1; i < seedOffsets_.size(); ++i) {
+    seedOffsets_[i] += seedOffsets_[i - 1];
+  }
+  seedBuffer_.assign(seeds_.begin(), seeds_.end());
+  for (auto &seed : seedBuffer_) {
+    seeds_[seedOffsets_[seed.codepointStart]] = seed;
+    seedOffsets_[seed.codepointStart] += 1;
+  }
 }
 
 void LatticeBuilder::reset(LatticePosition maxCodepoints) {
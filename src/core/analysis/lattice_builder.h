@@ -97,6 +97,9 @@ class LatticeCompactor {
 
 class LatticeBuilder {
   std::vector<LatticeNodeSeed> seeds_;
+  // buffers for sorting seeds, they are reused between inputs
+  std::vector<LatticeNodeSeed> seedBuffer_;
+  std::vector<u32> seedOffsets_;
   std::vector<BoundaryInfo> boundaries_;
   std::vector<bool> connectible;
   LatticePosition maxBoundaries_;
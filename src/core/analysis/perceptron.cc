@@ -3,6 +3,8 @@
 //
 
 #include "core/analysis/perceptron.h"
+#include <limits>
+#include <mutex>
 #include "core/analysis/lattice_types.h"
 #include "core/impl/perceptron_io.h"
 #include "util/logging.hpp"
@@ -40,28 +42,85 @@ void HashedFeaturePerceptron::add(util::ArraySlice<float> source,
 }
 
 const size_t TWO_MEGS_FOR_FLOATS = 2 * 1024 * 1024 / sizeof(float);
+
+#if JPP_WEIGHT_BITS == 32
+using WeightStorage = float;
+inline WeightBuffer emptyWeights() { return WeightBuffer{{}}; }
+#else
+#if JPP_WEIGHT_BITS == 16
+using WeightStorage = i16;
+#else
+using WeightStorage = i8;
+#endif
+inline WeightBuffer emptyWeights() { return WeightBuffer{}; }
+#endif
+
 struct PerceptronState {
   util::memory::Manager manager_;
   std::unique_ptr<util::memory::PoolAlloc> alloc_;
   size_t numElems_;
-  FloatBufferWeights weights_;
+  WeightBuffer weights_;
+  std::once_flag maxWeightFlag_;
+  float maxWeight_ = 0;
 
   PerceptronState(size_t numElems)
-      : manager_{std::max(numElems * sizeof(float), TWO_MEGS_FOR_FLOATS)},
+      : manager_{std::max(numElems * sizeof(WeightStorage),
+                          TWO_MEGS_FOR_FLOATS)},
         alloc_{manager_.core()},
         numElems_{numElems},
-        weights_{{}} {}
+        weights_{emptyWeights()} {}
+
+#if JPP_WEIGHT_BITS == 32
+  void useWeights(util::ArraySlice<float> data, bool copy) {
+    if (copy) {
+      auto arr = alloc_->allocateArray<float>(numElems_);
+      memcpy(arr, data.data(), numElems_ * sizeof(float));
+      weights_ = {{arr, numElems_}};
+    } else {
+      weights_ = {data};
+    }
+  }
+#else
+  void useWeights(util::ArraySlice<float> data, bool copy) {
+    auto arr = alloc_->allocateArray<WeightStorage>(numElems_);
+    util::MutableArraySlice<WeightStorage> slice{arr, numElems_};
+    auto numBlocks = util::numQuantizedRows(numElems_, WeightBlockSize);
+    auto scales = alloc_->allocateArray<float>(numBlocks);
+    util::MutableArraySlice<float> scaleSlice{scales, numBlocks};
+    util::quantizeRows<WeightStorage>(data, WeightBlockSize, slice,
+                                      scaleSlice);
+    weights_ = WeightBuffer{reinterpret_cast<const char*>(arr), scales,
+                            numElems_};
+  }
 
-  const float* importDoubles(const float* data) {
-    auto objs = numElems_;
-    auto arr = alloc_->allocateArray<float>(objs);
-    memcpy(arr, data, objs * sizeof(float));
-    weights_ = {{arr, objs}};
-    return arr;
+  bool useQuantized(const model::ModelInfo& model) {
+    auto part = model.firstPartOf(model::ModelPartKind::QuantizedPerceptron);
+    if (part == nullptr) {
+      return false;
+    }
+    QuantizedPerceptronInfo qi{};
+    StringPiece data;
+    StringPiece scales;
+    auto s = readQuantizedPerceptron(*part, &qi, &data, &scales);
+    if (!s) {
+      LOG_WARN() << "ignoring quantized weights: " << s;
+      return false;
+    }
+    if (qi.bits != JPP_WEIGHT_BITS || qi.blockSize != WeightBlockSize ||
+        (size_t{1} << qi.modelSizeExponent) != numElems_) {
+      return false;
+    }
+    weights_ = WeightBuffer{data.char_begin(),
+                            reinterpret_cast<const float*>(scales.data()),
+                            numElems_};
+    return true;
   }
+#endif
 };
 
-Status HashedFeaturePerceptron::load(const model::ModelInfo& model) {
+Status readPerceptronWeights(const model::ModelInfo& model,
+                             PerceptronInfo* info,
+                             util::ArraySlice<float>* weights) {
   const model::ModelPart* savedPerc = nullptr;
   for (auto& part : model.parts) {
     if (part.kind == model::ModelPartKind::Perceprton) {
@@ -83,7 +142,7 @@ Status HashedFeaturePerceptron::load(const model::ModelInfo& model) {
   auto& data = savedPerc->data;
 
   util::serialization::Loader ldr{data[0]};
-  PerceptronInfo pi{};
+  PerceptronInfo& pi = *info;
   if (!ldr.load(&pi)) {
     return Status::InvalidState()
            << "perceptron: failed to load perceptron information";
@@ -111,14 +170,23 @@ Status HashedFeaturePerceptron::load(const model::ModelInfo& model) {
   }
 
   auto weightData = reinterpret_cast<const float*>(modelData.begin());
+  *weights = util::ArraySlice<float>{weightData, dataSize};
+  return Status::Ok();
+}
 
-  state_.reset(new PerceptronState{weightCount});
-  if (util::memory::Manager::supportHugePages()) {
-    state_->importDoubles(weightData);
-  } else {
-    util::ArraySlice<float> weightSlice{weightData, dataSize};
-    state_->weights_ = weightSlice;
+Status HashedFeaturePerceptron::load(const model::ModelInfo& model) {
+  PerceptronInfo pi{};
+  util::ArraySlice<float> weights;
+  JPP_RETURN_IF_ERROR(readPerceptronWeights(model, &pi, &weights));
+
+  state_.reset(new PerceptronState{weights.size()});
+#if JPP_WEIGHT_BITS != 32
+  if (state_->useQuantized(model)) {
+    return Status::Ok();
   }
+#endif
+  state_->useWeights(
+      weights, copyWeights_ && util::memory::Manager::supportHugePages());
 
   return Status::Ok();
 }
@@ -126,26 +194,119 @@ Status HashedFeaturePerceptron::load(const model::ModelInfo& model) {
 HashedFeaturePerceptron::HashedFeaturePerceptron(
     const util::ArraySlice<float>& weights)
     : state_{new PerceptronState{weights.size()}} {
-  state_->weights_ = {weights};
+  state_->useWeights(weights, false);
 }
 
 HashedFeaturePerceptron::HashedFeaturePerceptron() = default;
 HashedFeaturePerceptron::~HashedFeaturePerceptron() = default;
 
 const WeightBuffer& HashedFeaturePerceptron::weights() const {
-#if 0
-  const char* data = reinterpret_cast<const char*>(weights_.data());
-  size_t sz = weights_.size();
-  float min = -1;
-  float step = 0.1;
-  return WeightBuffer{data, sz, min, step};
-#endif
   return state_->weights_;
 }
 
+float HashedFeaturePerceptron::maxWeight() const {
+  auto state = state_.get();
+  std::call_once(state->maxWeightFlag_, [state]() {
+    auto& weights = state->weights_;
+    if (weights.size() == 0) {
+      return;
+    }
+    float result = std::numeric_limits<float>::lowest();
+    for (size_t i = 0; i < weights.size(); ++i) {
+      result = std::max(result, weights.at(i));
+    }
+    state->maxWeight_ = result;
+  });
+  return state->maxWeight_;
+}
+
 void HashedFeaturePerceptron::setWeightsTo(util::ArraySlice<float> weights) {
   state_.reset(new PerceptronState{weights.size()});
-  state_->weights_ = {weights};
+  state_->useWeights(weights, false);
+}
+
+Status QuantizedPerceptronPart::build(const model::ModelInfo& model,
+                                      i32 bits) {
+  PerceptronInfo pi{};
+  util::ArraySlice<float> weights;
+  JPP_RETURN_IF_ERROR(readPerceptronWeights(model, &pi, &weights));
+
+  QuantizedPerceptronInfo qi{pi.modelSizeExponent, bits,
+                             static_cast<u32>(WeightBlockSize)};
+  scales_.resize(util::numQuantizedRows(weights.size(), WeightBlockSize));
+  if (bits == 8) {
+    data_.resize(weights.size());
+    util::MutableArraySlice<i8> slice{reinterpret_cast<i8*>(data_.data()),
+                                      weights.size()};
+    util::quantizeRows<i8>(weights, WeightBlockSize, slice, &scales_);
+  } else if (bits == 16) {
+    data_.resize(weights.size() * sizeof(i16));
+    util::MutableArraySlice<i16> slice{reinterpret_cast<i16*>(data_.data()),
+                                       weights.size()};
+    util::quantizeRows<i16>(weights, WeightBlockSize, slice, &scales_);
+  } else {
+    return JPPS_INVALID_PARAMETER << "perceptron can be quantized only to 8 "
+                                     "or 16 bits, was requested: "
+                                  << bits;
+  }
+
+  header_.reset();
+  util::serialization::Saver svr{&header_};
+  svr.save(qi);
+  return Status::Ok();
+}
+
+void QuantizedPerceptronPart::fill(model::ModelPart* part) const {
+  part->kind = model::ModelPartKind::QuantizedPerceptron;
+  part->data.clear();
+  part->data.push_back(header_.contents());
+  part->data.push_back(StringPiece{data_.data(), data_.size()});
+  part->data.push_back(
+      StringPiece{reinterpret_cast<StringPiece::pointer_t>(scales_.data()),
+                  scales_.size() * sizeof(float)});
+}
+
+Status readQuantizedPerceptron(const model::ModelPart& part,
+                               QuantizedPerceptronInfo* info,
+                               StringPiece* data, StringPiece* scales) {
+  if (part.data.size() != 3) {
+    return JPPS_INVALID_STATE << "quantized perceptron: model part did not "
+                                 "have exactly three parts, it could be "
+                                 "produced by an older version";
+  }
+  util::serialization::Loader ldr{part.data[0]};
+  if (!ldr.load(info)) {
+    return JPPS_INVALID_STATE
+           << "quantized perceptron: failed to load the header";
+  }
+  if (info->bits != 8 && info->bits != 16) {
+    return JPPS_INVALID_STATE << "quantized perceptron: unsupported bits "
+                              << info->bits;
+  }
+  if (info->modelSizeExponent < 0 || info->modelSizeExponent >= 64) {
+    return JPPS_INVALID_STATE
+           << "quantized perceptron: invalid size exponent";
+  }
+  if (info->blockSize == 0) {
+    return JPPS_INVALID_STATE << "quantized perceptron: block size was zero";
+  }
+  auto numWeights = size_t{1} << info->modelSizeExponent;
+  auto expected = numWeights * (info->bits / 8);
+  if (part.data[1].size() != expected) {
+    return JPPS_INVALID_STATE << "quantized perceptron: data size "
+                              << part.data[1].size()
+                              << " was not equal to expected " << expected;
+  }
+  auto numBlocks = util::numQuantizedRows(numWeights, info->blockSize);
+  if (part.data[2].size() != numBlocks * sizeof(float)) {
+    return JPPS_INVALID_STATE << "quantized perceptron: scales size "
+                              << part.data[2].size()
+                              << " was not equal to expected "
+                              << numBlocks * sizeof(float);
+  }
+  *data = part.data[1];
+  *scales = part.data[2];
+  return Status::Ok();
 }
 
 }  // namespace analysis
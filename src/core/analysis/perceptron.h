@@ -5,10 +5,16 @@
 #ifndef JUMANPP_PERCEPTRON_H
 #define JUMANPP_PERCEPTRON_H
 
+#include <vector>
 #include "score_api.h"
+#include "util/coded_io.h"
 
 namespace jumanpp {
 namespace core {
+
+struct PerceptronInfo;
+struct QuantizedPerceptronInfo;
+
 namespace analysis {
 
 namespace impl {
@@ -75,6 +81,7 @@ struct PerceptronState;
 
 class HashedFeaturePerceptron : public FeatureScorer {
   std::unique_ptr<PerceptronState> state_;
+  bool copyWeights_ = true;
 
  public:
   HashedFeaturePerceptron();
@@ -88,11 +95,49 @@ class HashedFeaturePerceptron : public FeatureScorer {
            util::ConstSliceable<u32> features) const override;
   Status load(const model::ModelInfo& model) override;
 
+  /**
+   * When false, loaded weights are used directly from the model data
+   * instead of being copied into huge page backed memory.
+   * Must be set before calling load.
+   */
+  void setCopyWeights(bool copyWeights) { copyWeights_ = copyWeights; }
+
   void setWeightsTo(util::ArraySlice<float> weights);
 
   const WeightBuffer& weights() const override;
+  float maxWeight() const override;
+};
+
+/**
+ * Float weights of the linear model from the model file.
+ */
+Status readPerceptronWeights(const model::ModelInfo& model,
+                             PerceptronInfo* info,
+                             util::ArraySlice<float>* weights);
+
+/**
+ * Weights of the linear model quantized to 8 or 16 bits,
+ * with a scale per block of WeightBlockSize weights.
+ * They are stored in the model alongside the float weights and are
+ * used directly by binaries which were built with the same JPP_WEIGHT_BITS.
+ * Other binaries ignore this model part.
+ */
+class QuantizedPerceptronPart {
+  util::CodedBuffer header_;
+  std::vector<char> data_;
+  std::vector<float> scales_;
+
+ public:
+  Status build(const model::ModelInfo& model, i32 bits);
+  void fill(model::ModelPart* part) const;
 };
 
+constexpr size_t WeightBlockSize = util::BlockQuantizedWeights<i8>::BlockSize;
+
+Status readQuantizedPerceptron(const model::ModelPart& part,
+                               QuantizedPerceptronInfo* info,
+                               StringPiece* data, StringPiece* scales);
+
 }  // namespace analysis
 }  // namespace core
 }  // namespace jumanpp
@@ -3,11 +3,16 @@
 //
 
 #include "perceptron.h"
+#include "core/impl/model_io.h"
+#include "core/impl/perceptron_io.h"
 #include "testing/standalone_test.h"
+#include "util/coded_io.h"
+#include "util/serialization.h"
 
 using namespace jumanpp;
 using namespace jumanpp::core::analysis;
 
+#if JPP_WEIGHT_BITS == 32
 TEST_CASE("perceptron impl computes simple sums") {
   float weights[] = {
       0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f,
@@ -42,4 +47,105 @@ TEST_CASE("perceptron impl computes positioned sums") {
   CHECK(compute({1, 2, 3}) == Approx(1110.f));
   CHECK(compute({6, 7, 5, 9}) == Approx(10111'00000.f));
   CHECK(compute({8, 7, 5, 9, 3}) == Approx(11101'01000.f));
-}
\ No newline at end of file
+}
+#endif  // JPP_WEIGHT_BITS == 32
+
+namespace {
+struct SavedPerceptron {
+  float weights[16] = {0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f,
+                       8.5f, 9.5f, 10.5f, 11.5f, 12.5f, 13.5f, 14.5f, 15.5f};
+  util::CodedBuffer header;
+  TempFile file;
+  core::model::FilesystemModel model;
+  core::model::ModelInfo info;
+
+  SavedPerceptron() {
+    util::serialization::Saver svr{&header};
+    core::PerceptronInfo pi{4};
+    svr.save(pi);
+
+    core::model::ModelInfo toSave;
+    toSave.parts.emplace_back();
+    auto& part = toSave.parts.back();
+    part.kind = core::model::ModelPartKind::Perceprton;
+    part.data.push_back(header.contents());
+    auto charPtr = reinterpret_cast<const char*>(weights);
+    part.data.push_back(StringPiece{charPtr, charPtr + sizeof(weights)});
+
+    core::model::ModelSaver saver;
+    REQUIRE_OK(saver.open(file.name()));
+    REQUIRE_OK(saver.save(toSave));
+    REQUIRE_OK(model.open(file.name()));
+    REQUIRE_OK(model.load(&info));
+  }
+
+  const float* mappedWeights() const {
+    auto part = info.firstPartOf(core::model::ModelPartKind::Perceprton);
+    return reinterpret_cast<const float*>(part->data[1].begin());
+  }
+};
+}  // namespace
+
+#if JPP_WEIGHT_BITS == 32
+TEST_CASE("perceptron can use weights directly from the mapped model") {
+  SavedPerceptron saved;
+  HashedFeaturePerceptron perc;
+  perc.setCopyWeights(false);
+  REQUIRE_OK(perc.load(saved.info));
+  auto& w = perc.weights();
+  REQUIRE(w.size() == 16);
+  CHECK(w.weights.data() == saved.mappedWeights());
+  CHECK(w.at(5) == 5.5f);
+}
+
+TEST_CASE("perceptron loads the same weights when copying them") {
+  SavedPerceptron saved;
+  HashedFeaturePerceptron perc;
+  REQUIRE_OK(perc.load(saved.info));
+  auto& w = perc.weights();
+  REQUIRE(w.size() == 16);
+  for (int i = 0; i < 16; ++i) {
+    CHECK(w.at(i) == saved.weights[i]);
+  }
+}
+#endif  // JPP_WEIGHT_BITS == 32
+
+TEST_CASE("perceptron weights can be quantized into a model part") {
+  SavedPerceptron saved;
+  for (int bits : {8, 16}) {
+    QuantizedPerceptronPart qpart;
+    REQUIRE_OK(qpart.build(saved.info, bits));
+    core::model::ModelPart part;
+    qpart.fill(&part);
+    CHECK(part.kind == core::model::ModelPartKind::QuantizedPerceptron);
+    core::QuantizedPerceptronInfo qi{};
+    StringPiece data;
+    StringPiece scales;
+    REQUIRE_OK(readQuantizedPerceptron(part, &qi, &data, &scales));
+    CHECK(qi.bits == bits);
+    CHECK(qi.modelSizeExponent == 4);
+    CHECK(qi.blockSize == WeightBlockSize);
+    CHECK(data.size() == 16 * bits / 8);
+    CHECK(scales.size() == sizeof(float));
+  }
+  QuantizedPerceptronPart qpart;
+  CHECK_FALSE(qpart.build(saved.info, 4));
+}
+
+TEST_CASE("perceptron uses quantized weights stored in the model") {
+  SavedPerceptron saved;
+  QuantizedPerceptronPart qpart;
+  REQUIRE_OK(qpart.build(saved.info, JPP_WEIGHT_BITS == 16 ? 16 : 8));
+  auto info = saved.info;
+  info.parts.emplace_back();
+  qpart.fill(&info.parts.back());
+
+  HashedFeaturePerceptron perc;
+  REQUIRE_OK(perc.load(info));
+  auto& w = perc.weights();
+  REQUIRE(w.size() == 16);
+  for (int i = 0; i < 16; ++i) {
+    // all weights are in one block, its scale is 15.5 / 127
+    CHECK(w.at(i) == Approx(saved.weights[i]).margin(0.062));
+  }
+}
@@ -0,0 +1,87 @@
+#include "result_cache.h"
+#include <algorithm>
+#include "util/hashing.h"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+size_t ResultCacheKeyHash::operator()(const ResultCacheKey& key) const {
+  std::hash<StringPiece> hasher;
+  return util::hashing::hashCtSeq(0xfeed5eedULL, hasher(StringPiece{key.text}));
+}
+
+ResultCache::ResultCache(size_t maxEntries, size_t maxEntryBytes,
+                         u32 numShards)
+    : maxEntryBytes_{maxEntryBytes} {
+  maxEntries = std::max<size_t>(maxEntries, 1);
+  numShards = static_cast<u32>(
+      std::min<size_t>(std::max<u32>(numShards, 1), maxEntries));
+  auto perShard = maxEntries / numShards;
+  // a double barrel LRU of capacity C holds up to 2 * C - 1 entries
+  auto capacity = (perShard + 1) / 2;
+  for (u32 i = 0; i < numShards; ++i) {
+    shards_.emplace_back(new Shard{capacity});
+  }
+}
+
+void ResultCache::makeKey(StringPiece input, StringPiece comment,
+                          ResultCacheKey* key) {
+  key->text.clear();
+  key->text.reserve(input.size() + comment.size() + 1);
+  key->text.append(comment.begin(), comment.end());
+  // neither a comment nor an input can contain a line break
+  key->text.push_back('\n');
+  key->text.append(input.begin(), input.end());
+}
+
+ResultCache::Shard& ResultCache::shardFor(const ResultCacheKey& key) {
+  // lower bits are used by the shard hash map, so use the upper ones
+  auto hash = static_cast<u64>(ResultCacheKeyHash{}(key));
+  return *shards_[(hash >> 40) % shards_.size()];
+}
+
+bool ResultCache::tryGet(const ResultCacheKey& key, std::string* result) {
+  auto& shard = shardFor(key);
+  Value value;
+  bool found;
+  {
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    found = shard.cache.tryFind(key, &value);
+  }
+  if (!found) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  result->assign(value->begin(), value->end());
+  return true;
+}
+
+void ResultCache::put(const ResultCacheKey& key, StringPiece result) {
+  if (key.text.size() + result.size() > maxEntryBytes_) {
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto value = std::make_shared<const std::string>(result.begin(),
+                                                   result.end());
+  auto& shard = shardFor(key);
+  {
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    shard.cache.insert(key, value);
+  }
+  insertions_.fetch_add(1, std::memory_order_relaxed);
+}
+
+ResultCacheStats ResultCache::stats() const {
+  ResultCacheStats result;
+  result.hits = hits_.load(std::memory_order_relaxed);
+  result.misses = misses_.load(std::memory_order_relaxed);
+  result.insertions = insertions_.load(std::memory_order_relaxed);
+  result.rejected = rejected_.load(std::memory_order_relaxed);
+  return result;
+}
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,96 @@
+#ifndef JUMANPP_RESULT_CACHE_H
+#define JUMANPP_RESULT_CACHE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "util/lru_cache.h"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+struct ResultCacheKey {
+  // comment and input of an example
+  std::string text;
+
+  bool operator==(const ResultCacheKey& o) const { return text == o.text; }
+};
+
+struct ResultCacheKeyHash {
+  size_t operator()(const ResultCacheKey& key) const;
+};
+
+struct ResultCacheStats {
+  u64 hits = 0;
+  u64 misses = 0;
+  u64 insertions = 0;
+  // results which were too large to be cached
+  u64 rejected = 0;
+
+  double hitRatio() const {
+    auto total = hits + misses;
+    return total == 0 ? 0.0 : static_cast<double>(hits) / total;
+  }
+};
+
+/**
+ * Thread-safe cache of formatted analysis results.
+ *
+ * Lookups are done by the raw bytes of an example (comment and input).
+ * A cache must be used only with a single analyzer configuration:
+ * it must be recreated when the model, beams or the output format change.
+ *
+ * The cache is split into at most maxEntries shards with a lock and
+ * a double barrel LRU each. The number of entries is bounded by maxEntries
+ * and only results whose key and value are not larger than maxEntryBytes
+ * are stored, so the memory usage is bounded by roughly
+ * maxEntries * maxEntryBytes.
+ */
+class ResultCache {
+  using Value = std::shared_ptr<const std::string>;
+  using Lru = util::LruCache<ResultCacheKey, Value, ResultCacheKeyHash>;
+
+  struct Shard {
+    std::mutex mutex;
+    Lru cache;
+    explicit Shard(size_t capacity) : cache{capacity} {}
+  };
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  size_t maxEntryBytes_;
+
+  std::atomic<u64> hits_{0};
+  std::atomic<u64> misses_{0};
+  std::atomic<u64> insertions_{0};
+  std::atomic<u64> rejected_{0};
+
+  Shard& shardFor(const ResultCacheKey& key);
+
+ public:
+  explicit ResultCache(size_t maxEntries, size_t maxEntryBytes = 64 * 1024,
+                       u32 numShards = 16);
+  ResultCache(const ResultCache&) = delete;
+
+  static void makeKey(StringPiece input, StringPiece comment,
+                      ResultCacheKey* key);
+
+  /**
+   * Copy the cached result into the passed string.
+   * @return false if nothing was cached for the key
+   */
+  bool tryGet(const ResultCacheKey& key, std::string* result);
+  void put(const ResultCacheKey& key, StringPiece result);
+
+  ResultCacheStats stats() const;
+};
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_RESULT_CACHE_H
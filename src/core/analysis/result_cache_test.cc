@@ -0,0 +1,116 @@
+#include "result_cache.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core::analysis;
+
+TEST_CASE("result cache returns stored results") {
+  ResultCache cache{100};
+  ResultCacheKey key;
+  std::string result;
+  ResultCache::makeKey("input", "", &key);
+  CHECK_FALSE(cache.tryGet(key, &result));
+  cache.put(key, "output");
+  CHECK(cache.tryGet(key, &result));
+  CHECK(result == "output");
+  auto stats = cache.stats();
+  CHECK(stats.hits == 1);
+  CHECK(stats.misses == 1);
+  CHECK(stats.insertions == 1);
+  CHECK(stats.hitRatio() == Approx(0.5));
+}
+
+TEST_CASE("result cache keys contain the comment") {
+  ResultCache cache{100};
+  ResultCacheKey key;
+  std::string result;
+  ResultCache::makeKey("input", "", &key);
+  cache.put(key, "output");
+  ResultCache::makeKey("input", "comment", &key);
+  CHECK_FALSE(cache.tryGet(key, &result));
+  ResultCache::makeKey("", "input", &key);
+  CHECK_FALSE(cache.tryGet(key, &result));
+}
+
+TEST_CASE("result cache does not store large results") {
+  ResultCache cache{100, 10};
+  ResultCacheKey key;
+  std::string result;
+  ResultCache::makeKey("input", "", &key);
+  cache.put(key, "a very long output");
+  CHECK_FALSE(cache.tryGet(key, &result));
+  CHECK(cache.stats().rejected == 1);
+}
+
+TEST_CASE("result cache is bounded") {
+  ResultCache cache{16, 1024, 1};
+  ResultCacheKey key;
+  std::string result;
+  for (int i = 0; i < 1000; ++i) {
+    auto s = std::to_string(i);
+    ResultCache::makeKey(s, "", &key);
+    cache.put(key, s);
+  }
+  int found = 0;
+  for (int i = 0; i < 1000; ++i) {
+    ResultCache::makeKey(std::to_string(i), "", &key);
+    if (cache.tryGet(key, &result)) {
+      CHECK(result == std::to_string(i));
+      found += 1;
+    }
+  }
+  CHECK(found <= 16);
+  CHECK(found >= 8);
+  ResultCache::makeKey("999", "", &key);
+  CHECK(cache.tryGet(key, &result));
+}
+
+TEST_CASE("result cache with fewer entries than shards is bounded") {
+  for (size_t size = 1; size < 16; ++size) {
+    ResultCache cache{size};
+    ResultCacheKey key;
+    std::string result;
+    for (int i = 0; i < 1000; ++i) {
+      ResultCache::makeKey(std::to_string(i), "", &key);
+      cache.put(key, "value");
+    }
+    size_t found = 0;
+    for (int i = 0; i < 1000; ++i) {
+      ResultCache::makeKey(std::to_string(i), "", &key);
+      found += cache.tryGet(key, &result);
+    }
+    CHECK(found <= size);
+    CHECK(found > 0);
+  }
+}
+
+TEST_CASE("result cache can be used from several threads") {
+  ResultCache cache{64, 1024, 4};
+  std::atomic<int> wrong{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, &wrong]() {
+      ResultCacheKey key;
+      std::string result;
+      for (int i = 0; i < 10000; ++i) {
+        auto s = std::to_string(i % 100);
+        ResultCache::makeKey(s, "", &key);
+        if (cache.tryGet(key, &result)) {
+          wrong += (result != s);
+        } else {
+          cache.put(key, s);
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  CHECK(wrong == 0);
+  auto stats = cache.stats();
+  CHECK(stats.hits + stats.misses == 40000);
+  CHECK(stats.hits > 0);
+}
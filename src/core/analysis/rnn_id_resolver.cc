@@ -151,9 +151,94 @@ Status RnnIdResolver::build(const dic::DictionaryHolder& dic,
   unkId_ = bldr.unkId;
   knownIndex_.plunder(&bldr.knownBuilder);
   unkIndex_.plunder(&bldr.unkBuilder);
+  return entryIds_.build(dic.entries(), *this);
+}
+
+i32 RnnIdResolver::knownId(StringPiece repr) const {
+  auto trav = knownIndex_.traversal();
+  if (trav.step(repr) == dic::TraverseStatus::Ok) {
+    return trav.value();
+  }
+  return unkId_;
+}
+
+Status RnnEntryIdTable::build(const dic::DictionaryEntries& entries,
+                              const RnnIdResolver& resolver) {
+  std::vector<u32> ptrs;
+  auto& lists = entries.entryPointers();
+  size_t position = 0;
+  while (position < lists.size()) {
+    auto list = lists.listAt(static_cast<i32>(position));
+    i32 ptr = 0;
+    for (i32 i = 0; i < list.size(); ++i) {
+      if (!list.readOneCumulative(&ptr)) {
+        return JPPS_INVALID_STATE << "failed to read entry pointer list at "
+                                  << position;
+      }
+      ptrs.push_back(static_cast<u32>(ptr));
+    }
+    position += list.numReadBytes();
+  }
+  util::sort(ptrs);
+  ptrs.erase(std::unique(ptrs.begin(), ptrs.end()), ptrs.end());
+
+  keyStorage_.clear();
+  idStorage_.clear();
+  std::vector<i32> features(static_cast<size_t>(entries.numFeatures()));
+  RnnReprBuilder repr;
+  for (auto ptr : ptrs) {
+    auto eptr = EntryPtr{static_cast<i32>(ptr)};
+    entries.entryAtPtr(eptr).fill(features, features.size());
+    repr.reset();
+    bool hasStrings = true;
+    for (auto fld : resolver.targets()) {
+      auto value = features.at(fld);
+      if (value < 0) {
+        hasStrings = false;
+        break;
+      }
+      repr.addInt(value);
+    }
+    if (!hasStrings) {
+      continue;
+    }
+    auto id = resolver.knownId(repr.repr());
+    if (id != resolver.unkId()) {
+      keyStorage_.push_back(ptr);
+      idStorage_.push_back(id);
+    }
+  }
+
+  keys_ = keyStorage_;
+  ids_ = idStorage_;
+  // raw pointers contain the offset shifted by one bit
+  limit_ = static_cast<u32>(entries.entryData().size() * 2);
   return Status::Ok();
 }
 
+Status RnnEntryIdTable::load(u32 limit, StringPiece keys, StringPiece ids) {
+  if (keys.size() % sizeof(u32) != 0 || keys.size() != ids.size()) {
+    return JPPS_INVALID_PARAMETER << "invalid RNN entry id table: key size="
+                                  << keys.size() << " id size=" << ids.size();
+  }
+  auto count = keys.size() / sizeof(u32);
+  keys_ = util::ArraySlice<u32>{reinterpret_cast<const u32*>(keys.data()),
+                                count};
+  ids_ = util::ArraySlice<i32>{reinterpret_cast<const i32*>(ids.data()), count};
+  limit_ = limit;
+  return Status::Ok();
+}
+
+StringPiece RnnEntryIdTable::keyData() const {
+  return StringPiece{reinterpret_cast<StringPiece::pointer_t>(keys_.data()),
+                     keys_.size() * sizeof(u32)};
+}
+
+StringPiece RnnEntryIdTable::idData() const {
+  return StringPiece{reinterpret_cast<StringPiece::pointer_t>(ids_.data()),
+                     ids_.size() * sizeof(i32)};
+}
+
 StringPiece RnnIdResolver::reprOf(RnnReprBuilder* bldr, EntryPtr eptr,
                                   util::ArraySlice<i32> features,
                                   const ExtraNodesContext* xtra) const {
@@ -284,21 +369,18 @@ const RnnCoordinate& RnnIdContainer::resolveId(const RnnIdResolver* resolver,
     auto starts = bnd->starts();
     auto& ninfo = starts->nodeInfo().at(node->right);
     auto eptr = ninfo.entryPtr();
-    auto values = starts->entryData().row(node->right);
-    auto repr = resolver->reprOf(&reprBldr_, eptr, values, xtra);
-    if (eptr.isDic()) {
-      auto t1 = resolver->knownIndex_.traversal();
-      if (t1.step(repr) == dic::TraverseStatus::Ok) {
-        iter.first->second.rnnId = t1.value();
-      } else {
-        iter.first->second.rnnId = resolver->unkId();
-      }
-    } else {
-      auto t2 = resolver->unkIndex_.traversal();
-      if (t2.step(repr) == dic::TraverseStatus::Ok) {
-        iter.first->second.rnnId = t2.value();
+    auto& rnnId = iter.first->second.rnnId;
+    // dictionary entries usually have precomputed ids
+    if (!eptr.isDic() ||
+        !resolver->entryIds_.find(eptr, resolver->unkId(), &rnnId)) {
+      auto values = starts->entryData().row(node->right);
+      auto repr = resolver->reprOf(&reprBldr_, eptr, values, xtra);
+      auto& index = eptr.isDic() ? resolver->knownIndex_ : resolver->unkIndex_;
+      auto trav = index.traversal();
+      if (trav.step(repr) == dic::TraverseStatus::Ok) {
+        rnnId = trav.value();
       } else {
-        iter.first->second.rnnId = resolver->unkId();
+        rnnId = resolver->unkId();
       }
     }
     iter.first->second.length = static_cast<u16>(ninfo.numCodepoints());
@@ -337,6 +419,8 @@ void RnnIdContainer::addBos() {
   bos0->nextInBnd = nullptr;
   auto bos1 = alloc_->allocate<RnnNode>();
   bos1->hash = 0xdeadbeef0000;
+  // BOS context is not cached and has a reserved stamp
+  bos1->contextStamp = 0;
   bos1->id = 0;
   bos1->idx = 0;
   bos1->boundary = 1;
@@ -5,6 +5,7 @@
 #ifndef JUMANPP_RNN_ID_RESOLVER_H
 #define JUMANPP_RNN_ID_RESOLVER_H
 
+#include <algorithm>
 #include "core/analysis/extra_nodes.h"
 #include "core/analysis/lattice_types.h"
 #include "core/analysis/rnn_scorer.h"
@@ -33,12 +34,57 @@ class RnnReprBuilder {
 };
 
 class RnnIdContainer;
+class RnnIdResolver;
+
+/**
+ * RNN ids of dictionary entries, computed once when building a model.
+ *
+ * Entry pointers are sparse offsets into the entry data, so the table
+ * consists of sorted raw pointers of entries which are in the RNN vocabulary
+ * and their ids. Other entries below the limit have the unk id.
+ * Pointers above the limit (e.g. from user dictionaries) are not covered
+ * and should be resolved using string representations.
+ */
+class RnnEntryIdTable {
+  std::vector<u32> keyStorage_;
+  std::vector<i32> idStorage_;
+  util::ArraySlice<u32> keys_;
+  util::ArraySlice<i32> ids_;
+  u32 limit_ = 0;
+
+ public:
+  Status build(const dic::DictionaryEntries& entries,
+               const RnnIdResolver& resolver);
+  Status load(u32 limit, StringPiece keys, StringPiece ids);
+
+  /**
+   * @return false if the entry is not covered by the table
+   */
+  inline bool find(EntryPtr eptr, i32 unkId, i32* result) const {
+    auto raw = static_cast<u32>(eptr.rawValue());
+    if (raw >= limit_) {
+      return false;
+    }
+    auto it = std::lower_bound(keys_.begin(), keys_.end(), raw);
+    if (it != keys_.end() && *it == raw) {
+      *result = ids_.at(it - keys_.begin());
+    } else {
+      *result = unkId;
+    }
+    return true;
+  }
+
+  u32 limit() const { return limit_; }
+  StringPiece keyData() const;
+  StringPiece idData() const;
+};
 
 class RnnIdResolver {
   std::vector<u32> fields_;
   dic::DoubleArray knownIndex_;
   dic::DoubleArray unkIndex_;
   i32 unkId_ = 0;
+  RnnEntryIdTable entryIds_;
 
  public:
   StringPiece reprOf(RnnReprBuilder* bldr, EntryPtr eptr,
@@ -50,6 +96,11 @@ class RnnIdResolver {
                            const ExtraNodesContext* xtra) const;
   Status build(const dic::DictionaryHolder& dic, const RnnInferenceConfig& cfg,
                util::ArraySlice<StringPiece> rnndic);
+  Status setEntryTable(u32 limit, StringPiece keys, StringPiece ids) {
+    return entryIds_.load(limit, keys, ids);
+  }
+  const RnnEntryIdTable& entryTable() const { return entryIds_; }
+  i32 knownId(StringPiece repr) const;
   util::ArraySlice<u32> targets() const { return fields_; }
   i32 unkId() const { return unkId_; }
 
@@ -108,6 +159,8 @@ struct RnnNode {
   RnnNode* prev;
   RnnNode* nextInBnd;
   u64 hash;
+  // stamp of the cached context, is set when computing the context
+  u64 contextStamp;
 };
 
 struct RnnScorePtr {
@@ -16,7 +16,7 @@ class RnnIdTestEnv {
   core::analysis::ScorerDef sdef;
 
  public:
-  RnnIdTestEnv(StringPiece dic) {
+  RnnIdTestEnv(StringPiece dic, bool loadRnn = true) {
     env.beamSize = 3;
     env.spec([](core::spec::dsl::ModelSpecBuilder& bldr) {
       auto& a = bldr.field(1, "a").strings().trieIndex();
@@ -25,8 +25,10 @@ class RnnIdTestEnv {
       bldr.unigram({a, b});
     });
     env.importDic(dic);
-    REQUIRE(rnn.open("rnn/testlm"));
-    REQUIRE(rnn.parse());
+    if (loadRnn) {
+      REQUIRE(rnn.open("rnn/testlm"));
+      REQUIRE(rnn.parse());
+    }
     sdef.feature = &hfp;
     sdef.scoreWeights.push_back(1.0f);
     REQUIRE(env.analyzer->setGlobalBeam(3, 1, 3));
@@ -75,4 +77,41 @@ TEST_CASE("can build a rnn") {
   CHECK(cont.rnnBoundary(1).nodeCnt == 1);
   CHECK(cont.rnnBoundary(2).nodeCnt == 1);
   CHECK(cont.rnnBoundary(17).nodeCnt == 3);
-}
\ No newline at end of file
+}
+TEST_CASE("entry id table contains the same ids as string indices") {
+  StringPiece dic{
+      "test,a,\nte,a,\nno,a,\ngust,a,\nst,a,\nnow,a,\nhere,a,\nnowhere,a,"
+      "\nwhere,a,\n"};
+  RnnIdTestEnv env{dic, false};
+  core::analysis::rnn::RnnIdResolver res;
+  core::analysis::rnn::RnnInferenceConfig ric;
+  ric.rnnFields = {"a"};
+  StringPiece words[] = {"</s>", "test", "<unk>", "now", "here", "xyz"};
+  REQUIRE(res.build(env.core().dic(), ric, words));
+  env.analyze("gusttestnowhere");
+  auto lat = env.analyzer()->lattice();
+  auto& table = res.entryTable();
+  core::analysis::rnn::RnnReprBuilder bldr;
+  i32 numDicNodes = 0;
+  i32 numKnown = 0;
+  for (u32 bndIdx = 2; bndIdx < lat->createdBoundaryCount() - 1; ++bndIdx) {
+    auto starts = lat->boundary(bndIdx)->starts();
+    for (u32 i = 0; i < starts->numEntries(); ++i) {
+      auto eptr = starts->nodeInfo().at(i).entryPtr();
+      if (!eptr.isDic()) {
+        continue;
+      }
+      CAPTURE(eptr.rawValue());
+      auto repr = res.reprOf(&bldr, eptr, starts->entryData().row(i), nullptr);
+      i32 tableId = -1;
+      REQUIRE(table.find(eptr, res.unkId(), &tableId));
+      CHECK(tableId == res.knownId(repr));
+      numDicNodes += 1;
+      numKnown += tableId != res.unkId();
+    }
+  }
+  CHECK(numDicNodes > 0);
+  CHECK(numKnown == 3);
+  CHECK(!table.find(core::EntryPtr{static_cast<i32>(table.limit())},
+                    res.unkId(), nullptr));
+}
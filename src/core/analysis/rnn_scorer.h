@@ -26,6 +26,8 @@ struct RnnInferenceConfig {
   util::Cfg<std::string> unkSymbol{"<unk>"};
   util::Cfg<std::vector<std::string>> rnnFields;
   util::Cfg<std::string> fieldSeparator{"_"};
+  // number of cached RNN contexts per analyzer, 0 disables the cache
+  util::Cfg<i32> stateCacheSize = 0;
 
   bool operator==(const RnnInferenceConfig &other) const;
   bool isDefault() const;
@@ -39,6 +41,7 @@ struct RnnInferenceConfig {
     unkSymbol.mergeWith(o.unkSymbol);
     rnnFields.mergeWith(o.rnnFields);
     fieldSeparator.mergeWith(o.fieldSeparator);
+    stateCacheSize.mergeWith(o.stateCacheSize);
   }
 
   friend std::ostream &operator<<(std::ostream &os,
@@ -3,8 +3,11 @@
 //
 
 #include "rnn_scorer_gbeam.h"
+#include "core/analysis/analysis_stats.h"
 #include "rnn/mikolov_rnn.h"
 #include "rnn_id_resolver.h"
+#include "util/fast_hash.h"
+#include "util/flatmap.h"
 #include "util/logging.hpp"
 #include "util/stl_util.h"
 
@@ -12,6 +15,81 @@ namespace jumanpp {
 namespace core {
 namespace analysis {
 
+/**
+ * RNN embedding rows stored as 8 or 16-bit integers with a scale per row.
+ * Rows are dequantized while gathering them into batch buffers,
+ * so only a quarter or a half of the float embedding memory is touched.
+ */
+struct QuantizedRnnRows {
+  i32 bits = 0;
+  util::RowQuantizedWeights<i8> rows8;
+  util::RowQuantizedWeights<i16> rows16;
+
+  Status load(i32 nbits, StringPiece data, StringPiece scales, size_t rowSize,
+              size_t numRows) {
+    auto elemSize = static_cast<size_t>(nbits / 8);
+    if (data.size() != rowSize * numRows * elemSize) {
+      return JPPS_INVALID_PARAMETER << "quantized rows had size "
+                                    << data.size() << ", expected "
+                                    << rowSize * numRows * elemSize;
+    }
+    if (scales.size() != numRows * sizeof(float)) {
+      return JPPS_INVALID_PARAMETER << "quantized row scales had size "
+                                    << scales.size() << ", expected "
+                                    << numRows * sizeof(float);
+    }
+    auto scalePtr = reinterpret_cast<const float*>(scales.data());
+    bits = nbits;
+    if (bits == 8) {
+      rows8 = {data.char_begin(), scalePtr, rowSize, numRows};
+    } else {
+      rows16 = {data.char_begin(), scalePtr, rowSize, numRows};
+    }
+    return Status::Ok();
+  }
+
+  void dequantizeRow(size_t row, util::MutableArraySlice<float> result) const {
+    if (bits == 8) {
+      rows8.dequantizeRow(row, result);
+    } else {
+      rows16.dequantizeRow(row, result);
+    }
+  }
+};
+
+/**
+ * Buffers of quantized weights which are embedded into a model.
+ */
+struct QuantizedRnnBuffer {
+  std::vector<char> data;
+  std::vector<float> scales;
+
+  void build(util::ArraySlice<float> weights, size_t rowSize, i32 bits) {
+    auto numRows = util::numQuantizedRows(weights.size(), rowSize);
+    scales.resize(numRows);
+    if (bits == 8) {
+      data.resize(weights.size());
+      util::MutableArraySlice<i8> slice{reinterpret_cast<i8*>(data.data()),
+                                        weights.size()};
+      util::quantizeRows<i8>(weights, rowSize, slice, &scales);
+    } else {
+      data.resize(weights.size() * sizeof(i16));
+      util::MutableArraySlice<i16> slice{reinterpret_cast<i16*>(data.data()),
+                                         weights.size()};
+      util::quantizeRows<i16>(weights, rowSize, slice, &scales);
+    }
+  }
+
+  StringPiece dataPiece() const {
+    return StringPiece{data.data(), data.size()};
+  }
+
+  StringPiece scalePiece() const {
+    return StringPiece{reinterpret_cast<StringPiece::pointer_t>(scales.data()),
+                       scales.size() * sizeof(float)};
+  }
+};
+
 struct GbeamRnnFactoryState {
   rnn::RnnIdResolver resolver;
   jumanpp::rnn::mikolov::MikolovRnn rnn;
@@ -20,15 +98,28 @@ struct GbeamRnnFactoryState {
   rnn::RnnInferenceConfig config;
   jumanpp::rnn::mikolov::MikolovModelReader rnnReader;
   util::CodedBuffer codedBuf_;
+  util::CodedBuffer entryTableBuf_;
+  util::CodedBuffer quantizationBuf_;
+  QuantizedRnnRows quantizedEmbeddings;
+  QuantizedRnnRows quantizedNceEmbeddings;
+  QuantizedRnnBuffer quantizedBuffers_[3];
 
   u32 embedSize() const { return rnn.modelHeader().layerSize; }
 
-  util::ArraySlice<float> embedOf(size_t idx) const {
-    return embeddings.row(idx);
+  void embedInto(size_t idx, util::MutableArraySlice<float> result) const {
+    if (quantizedEmbeddings.bits != 0) {
+      quantizedEmbeddings.dequantizeRow(idx, result);
+    } else {
+      util::copy_buffer(embeddings.row(idx), result);
+    }
   }
 
-  util::ArraySlice<float> nceEmbedOf(size_t idx) const {
-    return nceEmbeddings.row(idx);
+  void nceEmbedInto(size_t idx, util::MutableArraySlice<float> result) const {
+    if (quantizedNceEmbeddings.bits != 0) {
+      quantizedNceEmbeddings.dequantizeRow(idx, result);
+    } else {
+      util::copy_buffer(nceEmbeddings.row(idx), result);
+    }
   }
 
   util::memory::Manager mgr{64 * 1024};
@@ -39,12 +130,30 @@ struct GbeamRnnFactoryState {
     auto zeros = alloc->allocate2d<float>(1, embedSize(), 64);
     util::fill(zeros, 0);
     bosState = alloc->allocate2d<float>(1, embedSize(), 64);
-    auto embed = embeddings.row(bosId);
-    util::ConstSliceable<float> embedSlice{embed, embedSize(), 1};
-    jumanpp::rnn::mikolov::ParallelContextData pcd{zeros, embedSlice, bosState};
+    auto embed = alloc->allocate2d<float>(1, embedSize(), 64);
+    embedInto(bosId, embed.row(0));
+    jumanpp::rnn::mikolov::ParallelContextData pcd{zeros, embed, bosState};
     rnn.computeNewParCtx(&pcd);
   }
 
+  bool useBosState(StringPiece data) {
+    if (data.size() != embedSize() * sizeof(float) ||
+        reinterpret_cast<uintptr_t>(data.begin()) % 64 != 0) {
+      return false;
+    }
+    // the state is only read by scorers
+    auto ptr = const_cast<float*>(reinterpret_cast<const float*>(data.begin()));
+    bosState = util::Sliceable<float>{
+        util::MutableArraySlice<float>{ptr, embedSize()}, embedSize(), 1};
+    return true;
+  }
+
+  StringPiece bosStateData() const {
+    return StringPiece{
+        reinterpret_cast<StringPiece::pointer_t>(bosState.begin()),
+        bosState.size() * sizeof(float)};
+  }
+
   StringPiece rnnMatrix() const { return rnn.matrixAsStringpiece(); }
 
   StringPiece embeddingData() const {
@@ -64,6 +173,99 @@ struct GbeamRnnFactoryState {
   }
 };
 
+struct RnnContextKey {
+  // stamp of the previous context
+  u64 prev;
+  i32 id;
+};
+
+struct RnnContextKeyHasher {
+  size_t operator()(const RnnContextKey& key) const noexcept {
+    return util::hashing::FastHash1{key.prev}
+        .mix(static_cast<u32>(key.id))
+        .result();
+  }
+
+  bool operator()(const RnnContextKey& k1, const RnnContextKey& k2) const
+      noexcept {
+    return k1.prev == k2.prev && k1.id == k2.id;
+  }
+};
+
+/**
+ * Bounded cache of RNN contexts.
+ *
+ * A context depends only on the word ids of a path starting from BOS.
+ * Every cached context gets a unique stamp, which is never reused,
+ * and contexts are keyed by the stamp of the previous context and
+ * the word id. A stamp identifies the whole id history of a context,
+ * so hits are exact: keys are compared in full, not only by their hashes.
+ * Contexts can be reused for other paths of the same sentence and
+ * for the following sentences.
+ * When the cache is full, the oldest entries are replaced.
+ * Keys which refer to replaced contexts can not be found anymore.
+ */
+struct RnnContextCache {
+  // stamp of the BOS context, which is not stored in the cache
+  static constexpr u64 BosStamp = 0;
+
+  std::unique_ptr<util::memory::Manager> manager;
+  util::Sliceable<float> contexts;
+  std::vector<RnnContextKey> keys;
+  std::vector<u64> stamps;
+  util::FlatMap<RnnContextKey, u32, RnnContextKeyHasher, RnnContextKeyHasher>
+      index;
+  u32 capacity = 0;
+  u32 next = 0;
+  u64 lastStamp = BosStamp;
+
+  void initialize(u32 size, u32 embedSize) {
+    auto rowBytes = util::memory::Align(embedSize * sizeof(float), 64);
+    manager.reset(new util::memory::Manager{size * rowBytes + 64 * 1024});
+    auto alloc = manager->core();
+    contexts = alloc->allocate2d<float>(size, embedSize, 64);
+    keys.resize(size);
+    stamps.resize(size);
+    index.reserve(size);
+    capacity = size;
+  }
+
+  bool enabled() const { return capacity != 0; }
+
+  bool find(const RnnContextKey& key, util::MutableArraySlice<float> result,
+            u64* stamp) const {
+    auto it = index.find(key);
+    if (it == index.end()) {
+      return false;
+    }
+    util::copy_buffer(contexts.row(it->second), result);
+    *stamp = stamps[it->second];
+    return true;
+  }
+
+  /**
+   * @return stamp of the context
+   */
+  u64 insert(const RnnContextKey& key, util::ArraySlice<float> context) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+      return stamps[it->second];
+    }
+    auto slot = next;
+    next = (next + 1) % capacity;
+    if (index.size() == capacity) {
+      index.erase(keys[slot]);
+    }
+    lastStamp += 1;
+    keys[slot] = key;
+    stamps[slot] = lastStamp;
+    index[key] = slot;
+    auto row = contexts.row(slot);
+    util::copy_buffer(context, row);
+    return lastStamp;
+  }
+};
+
 struct GbeamRnnState {
   const GbeamRnnFactoryState* shared;
   util::memory::Manager manager{2 * 1024 * 1024};  // 2M
@@ -81,6 +283,20 @@ struct GbeamRnnState {
   util::MutableArraySlice<float> scoreBuf;
   util::MutableArraySlice<util::Sliceable<float>> contexts;
 
+  // batched scoring state
+  util::FlatMap<const rnn::RnnNode*, u32> prevIdx;
+  util::FlatMap<i32, u32> wordIdx;
+  util::MutableArraySlice<u32> itemCtxBuf;
+  util::MutableArraySlice<u32> itemWordBuf;
+  util::Sliceable<float> nceBuf;
+  util::Sliceable<float> scoreMatrixBuf;
+  util::Sliceable<u64> maxentIdxBuf;
+
+  RnnContextCache cache;
+  util::MutableArraySlice<rnn::RnnNode*> missBuf;
+  u64 numContexts = 0;
+  u64 numContextHits = 0;
+
   void allocateState() {
     auto numBnd = lat->createdBoundaryCount();
     auto gbeamSize = lat->config().globalBeamSize;
@@ -92,6 +308,13 @@ struct GbeamRnnState {
     contextBuf = alloc->allocate2d<float>(gbeamSize, embedSize, 64);
     embBuf = alloc->allocate2d<float>(gbeamSize, embedSize, 64);
     scoreBuf = alloc->allocateBuf<float>(gbeamSize, 64);
+    itemCtxBuf = alloc->allocateBuf<u32>(gbeamSize);
+    itemWordBuf = alloc->allocateBuf<u32>(gbeamSize);
+    nceBuf = alloc->allocate2d<float>(gbeamSize, embedSize, 64);
+    scoreMatrixBuf = alloc->allocate2d<float>(gbeamSize, gbeamSize, 64);
+    maxentIdxBuf = alloc->allocate2d<u64>(
+        gbeamSize, shared->rnn.modelHeader().maxentOrder);
+    missBuf = alloc->allocateBuf<rnn::RnnNode*>(gbeamSize);
     contexts.at(1) = shared->bosState;
   }
 
@@ -126,9 +349,7 @@ struct GbeamRnnState {
       if (embedId == -1) {
         embedId = 0;
       }
-      auto embed = shared->embedOf(embedId);
-      auto target = subset.row(i);
-      util::copy_buffer(embed, target);
+      shared->embedInto(embedId, subset.row(i));
     }
     return subset;
   }
@@ -144,6 +365,10 @@ struct GbeamRnnState {
     if (rbnd.nodeCnt == 0) {
       return Status::Ok();
     }
+    numContexts += rbnd.nodeCnt;
+    if (cache.enabled()) {
+      return computeContextCached(bndIdx, rbnd);
+    }
 
     auto rnnIds = gatherIds(rbnd);
     auto inCtx = gatherContext(rbnd);
@@ -155,66 +380,105 @@ struct GbeamRnnState {
     return Status::Ok();
   }
 
-  util::ArraySlice<i32> gatherScoreIds(const rnn::RnnBoundary& rbnd) {
-    size_t scoreCnt = static_cast<size_t>(rbnd.scoreCnt);
-    util::MutableArraySlice<i32> subset{rightIdBuf, 0, scoreCnt};
-    u32 scoreIdx = 0;
-    for (auto sc = rbnd.scores; sc != nullptr; sc = sc->next) {
-      auto node = sc->rnn;
-      subset.at(scoreIdx) = node->id;
-      scoreIdx += 1;
+  Status computeContextCached(u32 bndIdx, const rnn::RnnBoundary& rbnd) {
+    auto outCtx = allocContext(bndIdx, static_cast<size_t>(rbnd.nodeCnt));
+    u32 numMisses = 0;
+    for (auto node = rbnd.node; node != nullptr; node = node->nextInBnd) {
+      auto prev = node->prev;
+      JPP_DCHECK_NE(prev, nullptr);
+      RnnContextKey key{prev->contextStamp, node->id};
+      if (cache.find(key, outCtx.row(node->idx), &node->contextStamp)) {
+        numContextHits += 1;
+      } else {
+        missBuf.at(numMisses) = node;
+        numMisses += 1;
+      }
     }
-    JPP_DCHECK_EQ(scoreIdx, scoreCnt);
-    return subset;
-  }
 
-  util::ConstSliceable<i32> gatherPrevStateIds(const rnn::RnnBoundary& rbnd) {
-    auto subset = ctxIdBuf.topRows(rbnd.scoreCnt);
-    auto cnt = ctxIdBuf.rowSize();
-    u32 scoreIdx = 0;
-    for (auto sc = rbnd.scores; sc != nullptr; sc = sc->next) {
-      auto node = sc->rnn;
-      int idx = 0;
-      auto row = subset.row(scoreIdx);
+    if (numMisses == 0) {
+      return Status::Ok();
+    }
+
+    auto inCtx = contextBuf.topRows(numMisses);
+    auto embs = embBuf.topRows(numMisses);
+    for (u32 i = 0; i < numMisses; ++i) {
+      auto node = missBuf.at(i);
       auto prev = node->prev;
-      for (; idx < cnt; ++idx) {
-        JPP_DCHECK_NE(prev, nullptr);
-        row.at(idx) = prev->id;
-      }
-      scoreIdx += 1;
+      auto ctxRow = inCtx.row(i);
+      util::copy_buffer(contexts.at(prev->boundary).row(prev->idx), ctxRow);
+      auto embedId = node->id == -1 ? 0 : node->id;
+      shared->embedInto(embedId, embs.row(i));
     }
-    JPP_DCHECK_EQ(scoreIdx, rbnd.scoreCnt);
-    return subset;
+    auto computed =
+        alloc->allocate2d<float>(numMisses, shared->embedSize(), 64);
+    jumanpp::rnn::mikolov::ParallelContextData pcd{inCtx, embs, computed};
+    shared->rnn.computeNewParCtx(&pcd);
+
+    for (u32 i = 0; i < numMisses; ++i) {
+      auto node = missBuf.at(i);
+      auto result = computed.row(i);
+      auto outRow = outCtx.row(node->idx);
+      util::copy_buffer(result, outRow);
+      RnnContextKey key{node->prev->contextStamp, node->id};
+      node->contextStamp = cache.insert(key, result);
+    }
+    return Status::Ok();
   }
 
-  util::ConstSliceable<float> gatherScoreContext(const rnn::RnnBoundary& rbnd) {
-    auto subset = contextBuf.topRows(rbnd.scoreCnt);
-    u32 idx = 0;
+  /**
+   * Deduplicate previous states and words of the boundary score items.
+   * Every unique previous state gets a context column and every unique word
+   * gets an NCE embedding column, score items refer to them by index.
+   */
+  jumanpp::rnn::mikolov::BatchedStepData gatherBatch(
+      const rnn::RnnBoundary& rbnd) {
+    prevIdx.clear_no_resize();
+    wordIdx.clear_no_resize();
+    auto ctxIdCnt = ctxIdBuf.rowSize();
+    u32 numCtx = 0;
+    u32 numWords = 0;
+    u32 scoreIdx = 0;
     for (auto sc = rbnd.scores; sc != nullptr; sc = sc->next) {
       auto node = sc->rnn;
       auto prev = node->prev;
       JPP_DCHECK_NE(prev, nullptr);
-      auto ctxRow = subset.row(idx);
-      auto present = contexts.at(prev->boundary).row(prev->idx);
-      util::copy_buffer(present, ctxRow);
-      idx += 1;
+      auto ctx = prevIdx.findOrInsert(prev, [&]() {
+        auto ctxRow = contextBuf.row(numCtx);
+        auto present = contexts.at(prev->boundary).row(prev->idx);
+        util::copy_buffer(present, ctxRow);
+        auto ids = ctxIdBuf.row(numCtx);
+        for (int idx = 0; idx < ctxIdCnt; ++idx) {
+          ids.at(idx) = prev->id;
+        }
+        return numCtx++;
+      });
+      auto word = wordIdx.findOrInsert(node->id, [&]() {
+        auto embedId = node->id;
+        if (embedId == -1) {
+          embedId = 0;
+        }
+        shared->nceEmbedInto(embedId, nceBuf.row(numWords));
+        rightIdBuf.at(numWords) = node->id;
+        return numWords++;
+      });
+      itemCtxBuf.at(scoreIdx) = ctx;
+      itemWordBuf.at(scoreIdx) = word;
+      scoreIdx += 1;
     }
-    JPP_DCHECK_EQ(idx, rbnd.scoreCnt);
-    return subset;
-  }
+    JPP_DCHECK_EQ(scoreIdx, rbnd.scoreCnt);
 
-  util::ConstSliceable<float> gatherNceEmbeds(util::ArraySlice<i32> ids) {
-    auto subset = embBuf.topRows(ids.size());
-    for (int i = 0; i < ids.size(); ++i) {
-      auto embedId = ids[i];
-      if (embedId == -1) {
-        embedId = 0;
-      }
-      auto embed = shared->nceEmbedOf(embedId);
-      auto target = subset.row(i);
-      util::copy_buffer(embed, target);
-    }
-    return subset;
+    util::MutableArraySlice<float> matrixData{scoreMatrixBuf.data(), 0,
+                                              numWords * numCtx};
+    util::Sliceable<float> scoreMatrix{matrixData, numWords, numCtx};
+    return {ctxIdBuf.topRows(numCtx),
+            util::ArraySlice<i32>{rightIdBuf, 0, numWords},
+            contextBuf.topRows(numCtx),
+            nceBuf.topRows(numWords),
+            util::ArraySlice<u32>{itemCtxBuf, 0, scoreIdx},
+            util::ArraySlice<u32>{itemWordBuf, 0, scoreIdx},
+            scoreMatrix,
+            maxentIdxBuf.topRows(numCtx),
+            resizeScores(rbnd.scoreCnt)};
   }
 
   util::MutableArraySlice<float> resizeScores(i32 size) {
@@ -252,16 +516,9 @@ struct GbeamRnnState {
       return Status::Ok();
     }
 
-    auto rnnIds = gatherScoreIds(rbnd);
-    auto scores = resizeScores(rbnd.scoreCnt);
-
-    jumanpp::rnn::mikolov::ParallelStepData psd{
-        gatherPrevStateIds(rbnd), rnnIds, gatherScoreContext(rbnd),
-        gatherNceEmbeds(rnnIds), scores};
-
-    shared->rnn.applyParallel(&psd);
-
-    copyScoresToLattice(scores, rbnd, bndIdx);
+    auto batch = gatherBatch(rbnd);
+    shared->rnn.applyBatched(&batch);
+    copyScoresToLattice(batch.scores, rbnd, bndIdx);
 
     return Status::Ok();
   }
@@ -272,6 +529,8 @@ struct GbeamRnnState {
     manager.reset();
     alloc->reset();
     auto numBnd = l->createdBoundaryCount() - 1;
+    numContexts = 0;
+    numContextHits = 0;
     allocateState();
     JPP_RETURN_IF_ERROR(
         shared->resolver.resolveIdsAtGbeam(&container, l, xtra));
@@ -293,6 +552,11 @@ Status RnnScorerGbeam::scoreLattice(Lattice* l, const ExtraNodesContext* xtra,
   return state_->scoreLattice(l, xtra);
 }
 
+void RnnScorerGbeam::addStats(AnalysisStats* stats) const {
+  stats->rnnContexts += state_->numContexts;
+  stats->rnnContextHits += state_->numContextHits;
+}
+
 RnnScorerGbeam::~RnnScorerGbeam() = default;
 
 RnnScorerGbeamFactory::RnnScorerGbeamFactory() = default;
@@ -306,6 +570,11 @@ Status RnnScorerGbeamFactory::makeInstance(
   result->reset(ptr);
   ptr->state_.reset(new GbeamRnnState);
   ptr->state_->shared = state_.get();
+  auto cacheSize = config().stateCacheSize.value();
+  if (cacheSize > 0) {
+    ptr->state_->cache.initialize(static_cast<u32>(cacheSize),
+                                  state_->embedSize());
+  }
   return Status::Ok();
 }
 
@@ -333,6 +602,11 @@ Status RnnScorerGbeamFactory::make(StringPiece rnnModelPath,
   return Status::Ok();
 }
 
+StringPiece RnnScorerGbeamFactory::bosStateData() const {
+  JPP_DCHECK(state_);
+  return state_->bosStateData();
+}
+
 const rnn::RnnInferenceConfig& RnnScorerGbeamFactory::config() const {
   return state_->config;
 }
@@ -372,14 +646,43 @@ void Serialize(Arch& a, RnnModelHeader& o) {
   a& o.rnnHeader.nceLnz;
 }
 
+struct RnnEntryTableInfo {
+  u32 limit;
+};
+
+template <typename Arch>
+void Serialize(Arch& a, RnnEntryTableInfo& o) {
+  a& o.limit;
+}
+
+struct RnnQuantizationInfo {
+  i32 bits;
+  u32 maxentBlock;
+};
+
+template <typename Arch>
+void Serialize(Arch& a, RnnQuantizationInfo& o) {
+  a& o.bits;
+  a& o.maxentBlock;
+}
+
 Status RnnScorerGbeamFactory::makeInfo(model::ModelInfo* info,
-                                       StringPiece comment) {
+                                       StringPiece comment, i32 quantizeBits) {
   if (!state_) {
     return JPPS_INVALID_STATE << "RnnScorerGbeamFactory was not initialized";
   }
+  if (quantizeBits != 0 && quantizeBits != 8 && quantizeBits != 16) {
+    return JPPS_INVALID_PARAMETER << "rnn can be quantized only to 8 or 16 "
+                                     "bits, was requested: "
+                                  << quantizeBits;
+  }
   RnnModelHeader header{
       state_->config, state_->resolver.unkId(), {}, state_->rnn.modelHeader()};
   util::copy_insert(state_->resolver.targets(), header.fields);
+  // buffers are reused, the model info of a previous call becomes invalid
+  state_->codedBuf_.reset();
+  state_->entryTableBuf_.reset();
+  state_->quantizationBuf_.reset();
   util::serialization::Saver s{&state_->codedBuf_};
   s.save(header);
 
@@ -395,6 +698,38 @@ Status RnnScorerGbeamFactory::makeInfo(model::ModelInfo* info,
   part.data.push_back(state_->nceEmbedData());
   part.data.push_back(state_->maxentWeightData());
 
+  auto& entryTable = state_->resolver.entryTable();
+  RnnEntryTableInfo tableInfo{entryTable.limit()};
+  util::serialization::Saver ts{&state_->entryTableBuf_};
+  ts.save(tableInfo);
+  part.data.push_back(ts.result());
+  part.data.push_back(entryTable.keyData());
+  part.data.push_back(entryTable.idData());
+
+  // float weights are kept for older readers
+  if (quantizeBits != 0) {
+    auto maxentBlock = jumanpp::rnn::mikolov::QuantizedMaxent8::BlockSize;
+    RnnQuantizationInfo qi{quantizeBits, static_cast<u32>(maxentBlock)};
+    util::serialization::Saver qs{&state_->quantizationBuf_};
+    qs.save(qi);
+    part.data.push_back(qs.result());
+
+    auto& rnn = state_->rnn;
+    util::ArraySlice<float> maxent{
+        reinterpret_cast<const float*>(state_->maxentWeightData().data()),
+        rnn.modelHeader().maxentSize};
+    auto buffers = state_->quantizedBuffers_;
+    buffers[0].build(state_->embeddings.data(), state_->embedSize(),
+                     quantizeBits);
+    buffers[1].build(state_->nceEmbeddings.data(), state_->embedSize(),
+                     quantizeBits);
+    buffers[2].build(maxent, maxentBlock, quantizeBits);
+    for (int i = 0; i < 3; ++i) {
+      part.data.push_back(buffers[i].dataPiece());
+      part.data.push_back(buffers[i].scalePiece());
+    }
+  }
+
   return Status::Ok();
 }
 
@@ -423,6 +758,51 @@ Status arr1d(StringPiece data, size_t expected,
   return Status::Ok();
 }
 
+Status loadQuantized(
+    GbeamRnnFactoryState* state, const model::ModelPart& part,
+    const jumanpp::rnn::mikolov::MikolovRnnModelHeader& header) {
+  auto& data = part.data;
+  RnnQuantizationInfo qi{};
+  util::serialization::Loader l{data[10]};
+  if (!l.load(&qi)) {
+    return JPPS_INVALID_PARAMETER << "failed to read the header";
+  }
+  if (qi.bits != 8 && qi.bits != 16) {
+    return JPPS_INVALID_PARAMETER << "unsupported bits " << qi.bits;
+  }
+  using jumanpp::rnn::mikolov::QuantizedMaxent8;
+  using jumanpp::rnn::mikolov::QuantizedMaxent16;
+  if (qi.maxentBlock != QuantizedMaxent8::BlockSize) {
+    return JPPS_INVALID_PARAMETER << "unsupported maxent block size "
+                                  << qi.maxentBlock;
+  }
+
+  auto embedSize = header.layerSize;
+  auto vocabSize = static_cast<size_t>(header.vocabSize);
+  JPP_RIE_MSG(state->quantizedEmbeddings.load(qi.bits, data[11], data[12],
+                                               embedSize, vocabSize),
+              "embeddings");
+  JPP_RIE_MSG(state->quantizedNceEmbeddings.load(
+                  qi.bits, data[13], data[14], embedSize, vocabSize),
+              "NCE embeddings");
+
+  auto maxentSize = static_cast<size_t>(header.maxentSize);
+  auto numBlocks = util::numQuantizedRows(maxentSize, qi.maxentBlock);
+  if (data[15].size() != maxentSize * (qi.bits / 8) ||
+      data[16].size() != numBlocks * sizeof(float)) {
+    return JPPS_INVALID_PARAMETER << "maxent weights had invalid size";
+  }
+  auto scales = reinterpret_cast<const float*>(data[16].data());
+  if (qi.bits == 8) {
+    state->rnn.useQuantizedMaxent(
+        QuantizedMaxent8{data[15].char_begin(), scales, maxentSize});
+  } else {
+    state->rnn.useQuantizedMaxent(
+        QuantizedMaxent16{data[15].char_begin(), scales, maxentSize});
+  }
+  return Status::Ok();
+}
+
 Status RnnScorerGbeamFactory::load(const model::ModelInfo& model) {
   state_.reset(new GbeamRnnFactoryState);
   auto p = model.firstPartOf(model::ModelPartKind::Rnn);
@@ -443,6 +823,16 @@ Status RnnScorerGbeamFactory::load(const model::ModelInfo& model) {
 
   JPP_RETURN_IF_ERROR(state_->resolver.setState(header.fields, p->data[1],
                                                 p->data[2], header.unkIdx));
+  // models built before entry id tables resolve all ids using strings
+  if (p->data.size() >= 10) {
+    RnnEntryTableInfo tableInfo{};
+    util::serialization::Loader tl{p->data[7]};
+    if (!tl.load(&tableInfo)) {
+      return JPPS_INVALID_PARAMETER << "failed to read RNN entry id table";
+    }
+    JPP_RETURN_IF_ERROR(state_->resolver.setEntryTable(
+        tableInfo.limit, p->data[8], p->data[9]));
+  }
   auto& rnnhdr = header.rnnHeader;
 
   util::ArraySlice<float> rnnMatrix;
@@ -461,7 +851,13 @@ Status RnnScorerGbeamFactory::load(const model::ModelInfo& model) {
               "failed to read NCE embeddings");
 
   JPP_RETURN_IF_ERROR(state_->rnn.init(rnnhdr, rnnMatrix, maxentWeights));
-  state_->computeBosState(0);
+  if (p->data.size() >= 17) {
+    JPP_RIE_MSG(loadQuantized(state_.get(), *p, rnnhdr),
+                "failed to read quantized RNN");
+  }
+  if (!state_->useBosState(prebuiltBosState_)) {
+    state_->computeBosState(0);
+  }
   if (config().rnnWeight.defined()) {
     state_->rnn.setNceConstant(config().rnnWeight);
   }
@@ -24,6 +24,7 @@ class ExtraNodesContext;
 
 class RnnScorerGbeamFactory : public ScorerFactory {
   std::unique_ptr<GbeamRnnFactoryState> state_;
+  StringPiece prebuiltBosState_;
 
  public:
   RnnScorerGbeamFactory();
@@ -31,9 +32,23 @@ class RnnScorerGbeamFactory : public ScorerFactory {
   Status make(StringPiece rnnModelPath, const dic::DictionaryHolder& dic,
               const rnn::RnnInferenceConfig& config);
   Status load(const model::ModelInfo& model) override;
-  Status makeInfo(model::ModelInfo* info, StringPiece comment);
+  /**
+   * Embed the RNN into a model.
+   * When quantizeBits is 8 or 16, the embeddings and maxent weights are
+   * embedded quantized as well and the scorer uses the quantized copies.
+   */
+  Status makeInfo(model::ModelInfo* info, StringPiece comment,
+                  i32 quantizeBits = 0);
   Status makeInstance(std::unique_ptr<ScoreComputer>* result) override;
   void setConfig(const rnn::RnnInferenceConfig& config);
+
+  /**
+   * The initial RNN state is used from this memory instead of computing it
+   * when loading the RNN from a model (see RuntimeImage).
+   * The data must be alive while the factory is used.
+   */
+  void setPrebuiltBosState(StringPiece data) { prebuiltBosState_ = data; }
+  StringPiece bosStateData() const;
   const rnn::RnnInferenceConfig& config() const;
 };
 
@@ -41,7 +56,9 @@ class RnnScorerGbeam : public ScoreComputer {
   std::unique_ptr<GbeamRnnState> state_;
 
  public:
-  Status scoreLattice(Lattice* l, const ExtraNodesContext* xtra, u32 scorerIdx);
+  Status scoreLattice(Lattice* l, const ExtraNodesContext* xtra,
+                      u32 scorerIdx) override;
+  void addStats(AnalysisStats* stats) const override;
   RnnScorerGbeam();
   ~RnnScorerGbeam();
 
@@ -4,6 +4,7 @@
 
 #include "rnn_scorer.h"
 #include <fstream>
+#include "core/analysis/analysis_stats.h"
 #include "core/env.h"
 #include "core/impl/graphviz_format.h"
 #include "rnn/mikolov_rnn.h"
@@ -241,3 +242,99 @@ TEST_CASE("RNN holder serializes and deserializes") {
   a::RnnScorerGbeamFactory rnnHolder2;
   REQUIRE_OK(rnnHolder2.load(modelInfo));
 }
+
+TEST_CASE("RNN state cache does not change scores") {
+  RnnScorerEnv env{
+      "newsan,12\nn,14\newsan,13\nnew,1\nnews,2\nsan,3\na,4\nan,5\n"
+      "apple,6\news,7\nne,20\npple,8\nwsa,9\np,10\nle,11\n"};
+  a::RnnScorerGbeamFactory rnnHolder;
+  core::analysis::rnn::RnnInferenceConfig ric;
+  ric.rnnFields = {"a"};
+  ric.fieldSeparator = ",";
+  REQUIRE_OK(rnnHolder.make("rnn/testlm", env.jppEnv.coreHolder()->dic(), ric));
+  a::RnnScorerGbeamFactory cachedHolder;
+  ric.stateCacheSize = 100;
+  REQUIRE_OK(
+      cachedHolder.make("rnn/testlm", env.jppEnv.coreHolder()->dic(), ric));
+
+  a::ScorerDef scorerDef1{};
+  scorerDef1.scoreWeights.push_back(1.0f);
+  scorerDef1.scoreWeights.push_back(1.0f);
+  scorerDef1.feature = &env.perceptron;
+  scorerDef1.others.push_back(&rnnHolder);
+  a::AnalyzerImpl impl1{env.jppEnv.coreHolder(), env.scoreCfg, env.anaCfg};
+  REQUIRE_OK(impl1.initScorers(scorerDef1));
+
+  a::ScorerDef scorerDef2 = scorerDef1;
+  scorerDef2.others[0] = &cachedHolder;
+  a::AnalyzerImpl impl2{env.jppEnv.coreHolder(), env.scoreCfg, env.anaCfg};
+  REQUIRE_OK(impl2.initScorers(scorerDef2));
+
+  auto analyze = [](a::AnalyzerImpl* impl, const a::ScorerDef* sdef,
+                    StringPiece input) {
+    REQUIRE(impl->resetForInput(input));
+    REQUIRE_OK(impl->prepareNodeSeeds());
+    REQUIRE_OK(impl->buildLattice());
+    REQUIRE_OK(impl->bootstrapAnalysis());
+    REQUIRE_OK(impl->computeScores(sdef));
+    auto lat = impl->lattice();
+    auto eos = lat->boundary(lat->createdBoundaryCount() - 1);
+    return eos->starts()->beamData().at(0).totalScore;
+  };
+
+  StringPiece inputs[] = {"newsanapple", "newsan", "newsanapple"};
+  for (auto input : inputs) {
+    CAPTURE(input);
+    auto expected = analyze(&impl1, &scorerDef1, input);
+    CHECK(impl1.stats().rnnContextHits == 0);
+    auto actual = analyze(&impl2, &scorerDef2, input);
+    CHECK(expected == Approx(actual));
+  }
+  if (a::AnalysisStatsEnabled) {
+    CHECK(impl2.stats().rnnContexts == impl1.stats().rnnContexts);
+    CHECK(impl2.stats().rnnContextHits == impl2.stats().rnnContexts);
+  }
+}
+
+TEST_CASE("RNN holder with quantized weights has close scores") {
+  RnnScorerEnv env{
+      "newsan,12\nn,14\newsan,13\nnew,1\nnews,2\nsan,3\na,4\nan,5\n"
+      "apple,6\news,7\nne,20\npple,8\nwsa,9\np,10\nle,11\n"};
+  a::RnnScorerGbeamFactory rnnHolder;
+  core::analysis::rnn::RnnInferenceConfig ric;
+  ric.rnnFields = {"a"};
+  ric.fieldSeparator = ",";
+  REQUIRE_OK(rnnHolder.make("rnn/testlm", env.jppEnv.coreHolder()->dic(), ric));
+
+  core::model::ModelInfo badInfo{};
+  CHECK_FALSE(rnnHolder.makeInfo(&badInfo, EMPTY_SP, 4));
+
+  auto analyze = [&](a::RnnScorerGbeamFactory* holder) {
+    a::ScorerDef scorerDef{};
+    scorerDef.scoreWeights.push_back(1.0f);
+    scorerDef.scoreWeights.push_back(1.0f);
+    scorerDef.feature = &env.perceptron;
+    scorerDef.others.push_back(holder);
+    a::AnalyzerImpl impl{env.jppEnv.coreHolder(), env.scoreCfg, env.anaCfg};
+    REQUIRE_OK(impl.initScorers(scorerDef));
+    REQUIRE(impl.resetForInput("newsanapple"));
+    REQUIRE_OK(impl.prepareNodeSeeds());
+    REQUIRE_OK(impl.buildLattice());
+    REQUIRE_OK(impl.bootstrapAnalysis());
+    REQUIRE_OK(impl.computeScores(&scorerDef));
+    auto lat = impl.lattice();
+    auto eos = lat->boundary(lat->createdBoundaryCount() - 1);
+    return eos->starts()->beamData().at(0).totalScore;
+  };
+
+  auto expected = analyze(&rnnHolder);
+  for (i32 bits : {8, 16}) {
+    CAPTURE(bits);
+    core::model::ModelInfo modelInfo{};
+    REQUIRE_OK(rnnHolder.makeInfo(&modelInfo, EMPTY_SP, bits));
+    a::RnnScorerGbeamFactory quantized;
+    REQUIRE_OK(quantized.load(modelInfo));
+    auto actual = analyze(&quantized);
+    CHECK(actual == Approx(expected).epsilon(bits == 8 ? 0.05 : 0.005));
+  }
+}
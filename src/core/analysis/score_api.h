@@ -8,6 +8,7 @@
 #include <memory>
 #include "core/analysis/lattice_config.h"
 #include "core/impl/model_format.h"
+#include "core_config.h"
 #include "util/array_slice.h"
 #include "util/quantized_weights.h"
 #include "util/sliceable_array.h"
@@ -19,6 +20,7 @@ namespace analysis {
 
 class Lattice;
 class ExtraNodesContext;
+struct AnalysisStats;
 
 class ScorerBase {
  public:
@@ -38,8 +40,19 @@ struct FloatBufferWeights {
   }
 };
 
-// using WeightBuffer = util::Float8BitLinearQ;
+// Quantized weights take less memory, so more of them stay in cache.
+// They have a scale per block of weights, so a few large weights
+// do not make the rest of them coarse.
+// Models can not be trained with quantized weights.
+#if JPP_WEIGHT_BITS == 8
+using WeightBuffer = util::BlockQuantizedWeights<i8>;
+#elif JPP_WEIGHT_BITS == 16
+using WeightBuffer = util::BlockQuantizedWeights<i16>;
+#elif JPP_WEIGHT_BITS == 32
 using WeightBuffer = FloatBufferWeights;
+#else
+#error "JPP_WEIGHT_BITS must be one of 8, 16 or 32"
+#endif
 
 class FeatureScorer : public ScorerBase {
  public:
@@ -49,6 +62,13 @@ class FeatureScorer : public ScorerBase {
                    util::MutableArraySlice<float> result,
                    util::ConstSliceable<u32> features) const = 0;
   virtual const WeightBuffer& weights() const = 0;
+
+  /**
+   * The largest weight: an upper bound of a single feature contribution
+   * to a score. It is computed on the first call, so it does not follow
+   * later in-place modifications of the weights (e.g. training).
+   */
+  virtual float maxWeight() const = 0;
 };
 
 class ScoreComputer {
@@ -56,6 +76,10 @@ class ScoreComputer {
   virtual ~ScoreComputer() = default;
   virtual Status scoreLattice(Lattice* l, const ExtraNodesContext* xtra,
                               u32 scorerIdx) = 0;
+  /**
+   * Add statistics of the last scoreLattice call
+   */
+  virtual void addStats(AnalysisStats* stats) const {}
 };
 
 class ScorerFactory : public ScorerBase {
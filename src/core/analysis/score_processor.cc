@@ -3,6 +3,8 @@
 //
 
 #include "score_processor.h"
+#include <algorithm>
+#include <limits>
 #include <numeric>
 #include "core/analysis/analyzer_impl.h"
 #include "core/analysis/lattice_types.h"
@@ -66,6 +68,13 @@ ScoreProcessor::ScoreProcessor(AnalyzerImpl *analyzer)
       t0cutoffBuffer_ = alloc->allocateBuf<Score>(maxNodes);
       t0cutoffIdxBuffer_ = alloc->allocateBuf<u32>(maxNodes);
     }
+    if (cfg_->trigramPruning) {
+      biScoreBuf_ = alloc->allocateBuf<Score>(globalBeamSize_);
+      partialScoreBuf_ = alloc->allocateBuf<Score>(globalBeamSize_);
+      pruneOrderBuf_ = alloc->allocateBuf<u32>(globalBeamSize_);
+      prunedMaskBuf_ = alloc->allocateBuf<u8>(globalBeamSize_);
+      pruneBeamBuf_ = alloc->allocateBuf<Score>(lcfg.beamSize);
+    }
   }
 
   patternStatic_ = analyzer->core().features().patternStatic.get();
@@ -109,6 +118,7 @@ void ScoreProcessor::resolveBeamAt(i32 boundary, i32 position) {
 }
 
 void ScoreProcessor::startBoundary(u32 currentNodes) {
+  currentNodes_ = currentNodes;
   scores_.newBoundary(currentNodes);
 }
 
@@ -116,6 +126,7 @@ void ScoreProcessor::applyT0(i32 boundary, FeatureScorer *features) {
   auto patterns = lattice_->boundary(boundary)->starts()->patternFeatureData();
   ngramApply_->applyUni(&featureBuffer_, patterns, features,
                         scores_.bufferT0());
+  featuresHashed_ += u64{ngramApply_->numUnigrams()} * patterns.numRows();
   ngramApply_->applyBiStep1(&featureBuffer_, patterns);
   ngramApply_->applyTriStep1(&featureBuffer_, patterns);
 }
@@ -131,6 +142,7 @@ void ScoreProcessor::computeT0All(
   patternStatic_->patternsAndUnigramsApply(
       pfc, nodeInfo, nodeFeatures, &featureBuffer_, bnd->patternFeatureData(),
       features, scores);
+  featuresHashed_ += u64{ngramApply_->numUnigrams()} * bnd->numEntries();
 }
 
 void ScoreProcessor::applyT1(i32 boundary, i32 position,
@@ -141,6 +153,7 @@ void ScoreProcessor::applyT1(i32 boundary, i32 position,
       position);
   ngramApply_->applyBiStep2(&featureBuffer_, item, features, result);
   ngramApply_->applyTriStep2(&featureBuffer_, item);
+  featuresHashed_ += u64{ngramApply_->numBigrams()} * currentNodes_;
 }
 
 void ScoreProcessor::applyT2(i32 beamIdx, FeatureScorer *features) {
@@ -153,6 +166,8 @@ void ScoreProcessor::applyT2(i32 beamIdx, FeatureScorer *features) {
   auto result = scores_.bufferT2();
   util::copy_buffer(scores_.bufferT1(), result);
   ngramApply_->applyTriStep3(&featureBuffer_, item, features, result);
+  scoredConnections_ += currentNodes_;
+  featuresHashed_ += u64{ngramApply_->numTrigrams()} * currentNodes_;
 }
 
 std::ostream &operator<<(std::ostream &os, BeamCandidate bc) {
@@ -205,6 +220,21 @@ util::ArraySlice<BeamCandidate> processBeamCandidates(
   return util::ArraySlice<BeamCandidate>{candidates, 0, size};
 }
 
+// Candidates must be sorted by score in descending order.
+// Keeps candidates which are within the margin from the best one.
+util::ArraySlice<BeamCandidate> adaptiveBeamPrefix(
+    util::ArraySlice<BeamCandidate> sorted, float margin, u32 minSize) {
+  if (sorted.size() <= minSize) {
+    return sorted;
+  }
+  auto threshold = sorted.at(0).score() - margin;
+  auto end = std::partition_point(
+      sorted.begin() + minSize, sorted.end(),
+      [threshold](const BeamCandidate &c) { return c.score() >= threshold; });
+  auto size = static_cast<size_t>(std::distance(sorted.begin(), end));
+  return util::ArraySlice<BeamCandidate>{sorted, 0, size};
+}
+
 }  // namespace
 
 void ScoreProcessor::makeBeams(i32 boundary, LatticeBoundary *bnd,
@@ -265,6 +295,10 @@ util::ArraySlice<BeamCandidate> ScoreProcessor::makeGlobalBeam(i32 bndIdx,
   }
   util::MutableArraySlice<BeamCandidate> slice{globalBeam_, 0, count};
   auto res = processBeamCandidates(slice, maxElems);
+  if (cfg_->adaptiveBeamMargin > 0) {
+    res = adaptiveBeamPrefix(res, cfg_->adaptiveBeamMargin,
+                             static_cast<u32>(cfg_->adaptiveGlobalBeamMin));
+  }
   // std::cerr << maxElems << ":" << VOut(slice) << "\n";
   auto gbptrs = ends->globalBeam();
   if (gbptrs.size() > 0) {
@@ -292,6 +326,12 @@ void ScoreProcessor::computeGbeamScores(i32 bndIdx,
   auto right = bnd->starts();
   auto t0data = right->patternFeatureData();
   util::MutableArraySlice<Score> result{gbeamScoreBuf_, 0, gbeam.size()};
+  bool pruneTrigrams = trigramPruningEnabled();
+  util::MutableArraySlice<u8> pruned;
+  if (pruneTrigrams) {
+    pruned = util::MutableArraySlice<u8>{prunedMaskBuf_, 0, gbeam.size()};
+    std::fill(pruned.begin(), pruned.end(), 0);
+  }
 
   if (cfg_->rightGbeamCheck > 0) {
     // we cut off right elements as well
@@ -308,13 +348,21 @@ void ScoreProcessor::computeGbeamScores(i32 bndIdx,
     auto t2Tail = t2data.rows(fullBeamApplySize, t2data.numRows());
     util::MutableArraySlice<Score> resultTail{result, fullBeamApplySize,
                                               remainingItems};
+    util::MutableArraySlice<u8> prunedTail;
+    if (pruneTrigrams) {
+      prunedTail = util::MutableArraySlice<u8>{pruned, fullBeamApplySize,
+                                               remainingItems};
+    }
     util::ArraySlice<BeamCandidate> gbeamHead{gbeam, 0, fullBeamApplySize};
     util::ArraySlice<BeamCandidate> gbeamTail{gbeam, fullBeamApplySize,
                                               remainingItems};
 
     computeT0Prescores(gbeam, features);
     applyPluginToPrescores(bndIdx, gbeamHead);
-    makeT0cutoffBeam(static_cast<u32>(fullBeamApplySize), toKeep);
+    toKeep = makeT0cutoffBeam(static_cast<u32>(fullBeamApplySize),
+                              static_cast<u32>(toKeep));
+    scoredConnections_ +=
+        fullBeamApplySize * t0data.numRows() + toKeep * remainingItems;
 
     auto t0pos = 0;
     // first, we process elements which require feature/score computation
@@ -327,12 +375,22 @@ void ScoreProcessor::computeGbeamScores(i32 bndIdx,
       copyT0Scores(bndIdx, t0idx, gbeamHead, result, 0);
       if (t1PtrTail.size() > 0) {
         auto t0Score = scores_.bufferT0().at(t0idx);
-        ngramApply_->applyBiTri(&featureBuffer_, t0idx, t0, t1data, t2Tail,
-                                t1PtrTail, features, resultTail);
+        if (pruneTrigrams) {
+          // beam elements from the head already have their total scores
+          util::ArraySlice<Score> headScores{result, 0, fullBeamApplySize};
+          applyBiTriPruned(t0idx, t1data, t2Tail, t1PtrTail, gbeamTail,
+                           t0Score, headScores, features, resultTail,
+                           prunedTail);
+        } else {
+          ngramApply_->applyBiTri(&featureBuffer_, t0idx, t0, t1data, t2Tail,
+                                  t1PtrTail, features, resultTail);
+          countBiTriHashes(t1data.numRows(), t2Tail.numRows());
+        }
         applyPluginToGbeam(bndIdx, t0idx, gbeamTail, resultTail);
-        copyT0Scores(bndIdx, t0idx, gbeamTail, resultTail, t0Score);
+        copyT0Scores(bndIdx, t0idx, gbeamTail, resultTail, t0Score,
+                     prunedTail);
       }
-      makeT0Beam(bndIdx, t0idx, gbeam, result);
+      makeT0Beam(bndIdx, t0idx, gbeam, result, pruned);
     }
 
     // then we form beams for the remaining items
@@ -347,15 +405,22 @@ void ScoreProcessor::computeGbeamScores(i32 bndIdx,
 
   } else {
     // we score all gbeam <-> right pairs
+    scoredConnections_ += gbeam.size() * t0data.numRows();
     for (auto t0idx = 0; t0idx < t0data.numRows(); ++t0idx) {
       JPP_CAPTURE(t0idx);
       auto t0 = t0data.row(t0idx);
-      ngramApply_->applyBiTri(&featureBuffer_, t0idx, t0, t1data, t2data,
-                              t1Ptrs, features, result);
       auto t0Score = scores_.bufferT0().at(t0idx);
+      if (pruneTrigrams) {
+        applyBiTriPruned(t0idx, t1data, t2data, t1Ptrs, gbeam, t0Score, {},
+                         features, result, pruned);
+      } else {
+        ngramApply_->applyBiTri(&featureBuffer_, t0idx, t0, t1data, t2data,
+                                t1Ptrs, features, result);
+        countBiTriHashes(t1data.numRows(), t2data.numRows());
+      }
       applyPluginToGbeam(bndIdx, t0idx, gbeam, result);
-      copyT0Scores(bndIdx, t0idx, gbeam, result, t0Score);
-      makeT0Beam(bndIdx, t0idx, gbeam, result);
+      copyT0Scores(bndIdx, t0idx, gbeam, result, t0Score, pruned);
+      makeT0Beam(bndIdx, t0idx, gbeam, result, pruned);
     }
   }
 }
@@ -408,13 +473,95 @@ util::Sliceable<u64> ScoreProcessor::gatherT2(
   return result;
 }
 
+void ScoreProcessor::countBiTriHashes(u64 bigramRows, u64 trigramRows) {
+  featuresHashed_ += ngramApply_->numBigrams() * bigramRows +
+                     ngramApply_->numTrigrams() * trigramRows;
+}
+
+bool ScoreProcessor::trigramPruningEnabled() const {
+  // score plugins can change scores by arbitrary values,
+  // feature plugins compute the same scores as dynamic features
+  return cfg_->trigramPruning && plugin_ == nullptr &&
+         ngramApply_->numTrigrams() > 0;
+}
+
+void ScoreProcessor::applyBiTriPruned(
+    i32 t0idx, util::ConstSliceable<u64> t1data,
+    util::ConstSliceable<u64> t2data, util::ArraySlice<u32> t1idxes,
+    util::ArraySlice<BeamCandidate> gbeam, Score t0Score,
+    util::ArraySlice<Score> knownScores, FeatureScorer *features,
+    util::MutableArraySlice<Score> result, util::MutableArraySlice<u8> pruned) {
+  auto numElems = static_cast<u32>(gbeam.size());
+  util::MutableArraySlice<Score> biScores{biScoreBuf_, 0, t1data.numRows()};
+  ngramApply_->applyBi(&featureBuffer_, t0idx, t1data, features, biScores);
+
+  // partial scores contain everything except trigram features
+  util::MutableArraySlice<Score> partial{partialScoreBuf_, 0, numElems};
+  for (u32 i = 0; i < numElems; ++i) {
+    result.at(i) = biScores.at(t1idxes.at(i));
+    partial.at(i) = result.at(i) + t0Score + gbeam.at(i).score();
+  }
+  util::MutableArraySlice<u32> order{pruneOrderBuf_, 0, numElems};
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&partial](u32 a, u32 b) {
+    return partial.at(a) > partial.at(b);
+  });
+
+  // min-heap of the best total scores in the beam of t0idx
+  auto maxBeam = lattice_->config().beamSize;
+  auto beam = pruneBeamBuf_;
+  u32 beamSize = 0;
+  auto comp = std::greater<Score>();
+  auto pushScore = [&](Score s) {
+    if (beamSize < maxBeam) {
+      beam.at(beamSize) = s;
+      ++beamSize;
+      std::push_heap(beam.begin(), beam.begin() + beamSize, comp);
+    } else if (s > beam.at(0)) {
+      std::pop_heap(beam.begin(), beam.begin() + beamSize, comp);
+      beam.at(beamSize - 1) = s;
+      std::push_heap(beam.begin(), beam.begin() + beamSize, comp);
+    }
+  };
+  for (auto s : knownScores) {
+    pushScore(s);
+  }
+
+  auto triBound = features->maxWeight() * ngramApply_->numTrigrams();
+  u32 pos = 0;
+  for (; pos < numElems; ++pos) {
+    auto idx = order.at(pos);
+    if (beamSize == maxBeam) {
+      // allow for rounding differences of float sums
+      auto minScore = beam.at(0);
+      auto slack = 1e-4f * (std::abs(minScore) + 1);
+      if (partial.at(idx) + triBound + slack < minScore) {
+        // partial scores are sorted, all remaining elements fail as well
+        break;
+      }
+    }
+    util::ArraySlice<u32> row{order, pos, 1};
+    ngramApply_->applyTri(&featureBuffer_, t0idx, t1data, t2data, t1idxes, row,
+                          features, result);
+    pushScore(result.at(idx) + t0Score + gbeam.at(idx).score());
+  }
+  countBiTriHashes(t1data.numRows(), pos);
+  prunedConnections_ += numElems - pos;
+  for (; pos < numElems; ++pos) {
+    pruned.at(order.at(pos)) = 1;
+  }
+}
+
 void ScoreProcessor::copyT0Scores(i32 bndIdx, i32 t0idx,
                                   util::ArraySlice<BeamCandidate> gbeam,
                                   util::MutableArraySlice<Score> scores,
-                                  Score t0Score) {
+                                  Score t0Score, util::ArraySlice<u8> pruned) {
   auto sholder = lattice_->boundary(bndIdx)->scores();
   auto nscores = sholder->nodeScores(t0idx);
   for (int i = 0; i < gbeam.size(); ++i) {
+    if (!pruned.empty() && pruned.at(i) != 0) {
+      continue;
+    }
     auto &v = scores.at(i);
     v += t0Score;
     auto &gb = gbeam.at(i);
@@ -425,10 +572,23 @@ void ScoreProcessor::copyT0Scores(i32 bndIdx, i32 t0idx,
 
 void ScoreProcessor::makeT0Beam(i32 bndIdx, i32 t0idx,
                                 util::ArraySlice<BeamCandidate> gbeam,
-                                util::MutableArraySlice<Score> scores) {
+                                util::MutableArraySlice<Score> scores,
+                                util::ArraySlice<u8> pruned) {
   auto maxBeam = lattice_->config().beamSize;
   util::MutableArraySlice<u32> idxes{beamIdxBuffer_, 0, gbeam.size()};
-  std::iota(idxes.begin(), idxes.end(), 0);
+  if (pruned.empty()) {
+    std::iota(idxes.begin(), idxes.end(), 0);
+  } else {
+    // connections without trigram scores never enter the beam
+    u32 numIdxes = 0;
+    for (u32 i = 0; i < gbeam.size(); ++i) {
+      if (pruned.at(i) == 0) {
+        idxes.at(numIdxes) = i;
+        ++numIdxes;
+      }
+    }
+    idxes = util::MutableArraySlice<u32>{beamIdxBuffer_, 0, numIdxes};
+  }
   auto comp = [&scores](u32 i1, u32 i2) { return scores[i1] > scores[i2]; };
   auto itr = idxes.end();
   auto partitionBoundary = maxBeam * 4 / 3;
@@ -468,30 +628,50 @@ void ScoreProcessor::makeT0Beam(i32 bndIdx, i32 t0idx,
   }
 }
 
-void ScoreProcessor::makeT0cutoffBeam(u32 fullAnalysis, u32 rightBeam) {
+u32 ScoreProcessor::makeT0cutoffBeam(u32 fullAnalysis, u32 rightBeam) {
   auto slice = t0prescores_.topRows(fullAnalysis);
   auto curElemCnt = featureBuffer_.currentElems;
 
   util::MutableArraySlice<u32> idxBuf{t0cutoffIdxBuffer_, 0, curElemCnt};
   std::iota(idxBuf.begin(), idxBuf.end(), 0);
 
-  if (curElemCnt <= rightBeam) {
-    return;
+  bool adaptive = cfg_->adaptiveBeamMargin > 0;
+  if (curElemCnt <= rightBeam && !adaptive) {
+    return curElemCnt;
   }
 
   util::MutableArraySlice<Score> cutoffScores{t0cutoffBuffer_, 0, curElemCnt};
+  Score best = std::numeric_limits<Score>::lowest();
   for (int i = 0; i < curElemCnt; ++i) {
     Score s = 0;
     for (int j = 0; j < fullAnalysis; ++j) {
       s += slice.row(j).at(i);
     }
     cutoffScores.at(i) = s;
+    best = std::max(best, s);
+  }
+
+  if (adaptive) {
+    // cutoff scores are sums over fullAnalysis left elements
+    auto threshold = best - cfg_->adaptiveBeamMargin * fullAnalysis;
+    auto inMargin = std::count_if(
+        cutoffScores.begin(), cutoffScores.end(),
+        [threshold](Score s) { return s >= threshold; });
+    auto minSize = static_cast<u32>(cfg_->adaptiveRightBeamMin);
+    rightBeam = std::min<u32>(
+        rightBeam, std::max<u32>(static_cast<u32>(inMargin), minSize));
   }
+
+  if (curElemCnt <= rightBeam) {
+    return curElemCnt;
+  }
+
   auto comp = [&](u32 a, u32 b) {
     return cutoffScores.at(a) > cutoffScores.at(b);
   };
   std::nth_element(idxBuf.begin(), idxBuf.begin() + rightBeam, idxBuf.end(),
                    comp);
+  return rightBeam;
 }
 
 void ScoreProcessor::computeT0Prescores(util::ArraySlice<BeamCandidate> gbeam,
@@ -507,6 +687,7 @@ void ScoreProcessor::computeT0Prescores(util::ArraySlice<BeamCandidate> gbeam,
     ngramApply_->applyTriStep2(&featureBuffer_, t1);
     ngramApply_->applyBiStep2(&featureBuffer_, t1, scorer, scores);
     ngramApply_->applyTriStep3(&featureBuffer_, t2, scorer, scores);
+    countBiTriHashes(scores.size(), scores.size());
   }
 }
 
@@ -141,6 +141,18 @@ struct ScoreProcessor {
   util::Sliceable<Score> t0prescores_;
   util::MutableArraySlice<Score> t0cutoffBuffer_;
   util::MutableArraySlice<u32> t0cutoffIdxBuffer_;
+  util::MutableArraySlice<Score> biScoreBuf_;
+  util::MutableArraySlice<Score> partialScoreBuf_;
+  util::MutableArraySlice<u32> pruneOrderBuf_;
+  util::MutableArraySlice<u8> prunedMaskBuf_;
+  util::MutableArraySlice<Score> pruneBeamBuf_;
+  u32 currentNodes_ = 0;
+  // number of (left beam element, right node) pairs which were scored
+  u64 scoredConnections_ = 0;
+  // number of scored pairs which skipped trigram features
+  u64 prunedConnections_ = 0;
+  // number of ngram feature values which were looked up in the weights
+  u64 featuresHashed_ = 0;
 
   explicit ScoreProcessor(AnalyzerImpl* analyzer);
 
@@ -148,6 +160,9 @@ struct ScoreProcessor {
   static std::pair<Status, ScoreProcessor*> make(AnalyzerImpl* impl);
 
   i32 activeBeamSize() const { return beamSize_; }
+  u64 scoredConnections() const { return scoredConnections_; }
+  u64 prunedConnections() const { return prunedConnections_; }
+  u64 featuresHashed() const { return featuresHashed_; }
 
   void resolveBeamAt(i32 boundary, i32 position);
   void startBoundary(u32 currentNodes);
@@ -170,15 +185,44 @@ struct ScoreProcessor {
   util::Sliceable<u64> gatherT1();
   util::Sliceable<u64> gatherT2(i32 bndIdx,
                                 util::ArraySlice<BeamCandidate> gbeam);
+  void countBiTriHashes(u64 bigramRows, u64 trigramRows);
+  bool trigramPruningEnabled() const;
+  /**
+   * Same result as applyBiTri for the beam of t0idx, but skips trigram
+   * features of elements which can not enter the beam.
+   * Scores of skipped elements are incomplete, they are marked in pruned
+   * and must not be stored in the lattice.
+   * @param knownScores total scores of other elements of the beam
+   * @param pruned is set to 1 for skipped elements, other values are kept
+   */
+  void applyBiTriPruned(i32 t0idx, util::ConstSliceable<u64> t1data,
+                        util::ConstSliceable<u64> t2data,
+                        util::ArraySlice<u32> t1idxes,
+                        util::ArraySlice<BeamCandidate> gbeam, Score t0Score,
+                        util::ArraySlice<Score> knownScores,
+                        FeatureScorer* features,
+                        util::MutableArraySlice<Score> result,
+                        util::MutableArraySlice<u8> pruned);
+  /**
+   * Elements marked in pruned (if it is not empty) are skipped
+   * in this and the next function.
+   */
   void copyT0Scores(i32 bndIdx, i32 t0idx,
                     util::ArraySlice<BeamCandidate> gbeam,
-                    util::MutableArraySlice<Score> scores, Score t0Score);
+                    util::MutableArraySlice<Score> scores, Score t0Score,
+                    util::ArraySlice<u8> pruned = {});
   void makeT0Beam(i32 bndIdx, i32 t0idx, util::ArraySlice<BeamCandidate> gbeam,
-                  util::MutableArraySlice<Score> scores);
+                  util::MutableArraySlice<Score> scores,
+                  util::ArraySlice<u8> pruned = {});
 
   void computeT0Prescores(util::ArraySlice<BeamCandidate> gbeam,
                           FeatureScorer* scorer);
-  void makeT0cutoffBeam(u32 fullAnalysis, u32 rightBeam);
+  /**
+   * Select right nodes which are scored with the whole global beam.
+   * @return number of selected nodes, they are the first ones of
+   * t0cutoffIdxBuffer_
+   */
+  u32 makeT0cutoffBeam(u32 fullAnalysis, u32 rightBeam);
   bool patternIsStatic() const { return patternStatic_ != nullptr; }
   void computeUniOnlyPatterns(i32 bndIdx,
                               features::impl::PrimitiveFeatureContext* pfc);
@@ -0,0 +1,203 @@
+#define BENCHPRESS_CONFIG_MAIN
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "benchpress/benchpress.hpp"
+#include "core/dic/dic_builder.h"
+#include "core/dic/progress.h"
+#include "core/spec/spec_dsl.h"
+#include "core/spec/spec_parser.h"
+#include "util/mmap.h"
+
+using context = benchpress::context;
+using namespace jumanpp;
+
+namespace {
+
+// A real dictionary is indexed when both of them are set:
+// JPP_BENCH_SPEC=jumandic.spec JPP_BENCH_DIC=jumandic.csv dic_build_bench
+// Synthetic dictionary is used otherwise.
+const char* specPath() { return std::getenv("JPP_BENCH_SPEC"); }
+const char* dicPath() { return std::getenv("JPP_BENCH_DIC"); }
+
+void checkOk(const Status& s) {
+  if (!s) {
+    std::cerr << s << "\n";
+    std::exit(1);
+  }
+}
+
+class SyntheticDictionary {
+  std::minstd_rand rng_{42};
+  std::geometric_distribution<int> charDist_{0.01};
+  std::discrete_distribution<int> lengthDist_{0, 20, 35, 25, 12, 5, 3};
+
+  void word(std::string* result) {
+    auto length = lengthDist_(rng_);
+    for (int i = 0; i < length; ++i) {
+      // hiragana and kanji
+      char32_t cp = 0x3041 + static_cast<char32_t>(charDist_(rng_) % 0x6000);
+      result->push_back(static_cast<char>(0xe0 | (cp >> 12)));
+      result->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+      result->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+  }
+
+  void tag(int numValues, std::string* result) {
+    *result += "t";
+    *result += std::to_string(charDist_(rng_) % numValues);
+  }
+
+ public:
+  void spec(core::spec::AnalysisSpec* result) {
+    core::spec::dsl::ModelSpecBuilder bldr;
+    auto& surface = bldr.field(1, "surface").strings().trieIndex();
+    auto& reading = bldr.field(2, "reading").strings();
+    auto& baseform = bldr.field(3, "baseform").strings();
+    auto& pos = bldr.field(4, "pos").strings();
+    auto& subpos = bldr.field(5, "subpos").strings();
+    auto& conjType = bldr.field(6, "conjtype").strings();
+    auto& conjForm = bldr.field(7, "conjform").strings();
+    bldr.field(8, "features").kvLists();
+    bldr.unigram({surface, reading});
+    bldr.unigram({baseform});
+    bldr.unigram({pos, subpos});
+    bldr.unigram({conjType, conjForm});
+    checkOk(bldr.build(result));
+  }
+
+  std::string csv(int numLines) {
+    std::string result;
+    for (int i = 0; i < numLines; ++i) {
+      word(&result);
+      result += ',';
+      word(&result);
+      result += ',';
+      word(&result);
+      for (int numValues : {16, 64, 32, 64}) {
+        result += ',';
+        tag(numValues, &result);
+      }
+      result += ",";
+      tag(1000, &result);
+      result += ":";
+      word(&result);
+      result += '\n';
+    }
+    return result;
+  }
+};
+
+struct BenchData {
+  core::spec::AnalysisSpec spec;
+  util::FullyMappedFile file;
+  std::string synthetic;
+  StringPiece csv;
+
+  BenchData() {
+    if (specPath() != nullptr && dicPath() != nullptr) {
+      checkOk(core::spec::parseFromFile(StringPiece::fromCString(specPath()),
+                                        &spec));
+      checkOk(file.open(StringPiece::fromCString(dicPath()),
+                        util::MMapType::ReadOnly));
+      csv = file.contents();
+    } else {
+      SyntheticDictionary dic;
+      dic.spec(&spec);
+      synthetic = dic.csv(300000);
+      csv = synthetic;
+    }
+    std::cerr << "dictionary: " << csv.size() << " bytes\n";
+  }
+};
+
+BenchData& data() {
+  static BenchData instance;
+  return instance;
+}
+
+/**
+ * Wall time of dictionary build steps.
+ * Only the first two steps use several threads, so their share of
+ * the single-threaded time bounds the speedup on more cores.
+ */
+class StepTimes : public core::ProgressCallback {
+  using clock = std::chrono::steady_clock;
+  std::vector<std::pair<std::string, double>> steps_;
+  clock::time_point start_;
+  size_t current_ = 0;
+
+  void finishStep() {
+    auto now = clock::now();
+    if (current_ != 0) {
+      std::chrono::duration<double, std::milli> elapsed = now - start_;
+      steps_[current_ - 1].second += elapsed.count();
+    }
+    start_ = now;
+  }
+
+ public:
+  void report(u64 current, u64 total) override {}
+  void recordName(StringPiece name) override {
+    finishStep();
+    auto it = std::find_if(steps_.begin(), steps_.end(),
+                           [&](const std::pair<std::string, double>& s) {
+                             return s.first == name;
+                           });
+    if (it == steps_.end()) {
+      steps_.emplace_back(name.str(), 0.0);
+      it = steps_.end() - 1;
+    }
+    current_ = static_cast<size_t>(it - steps_.begin()) + 1;
+  }
+
+  void endBuild() {
+    finishStep();
+    current_ = 0;
+  }
+
+  void print(u32 numThreads, size_t numBuilds) const {
+    for (auto& s : steps_) {
+      std::cerr << "threads " << numThreads << ": " << std::setw(30) << s.first
+                << std::fixed << std::setprecision(1) << std::setw(10)
+                << s.second / numBuilds << " ms\n";
+    }
+  }
+};
+
+void buildWithThreads(context* ctx, u32 numThreads) {
+  auto& d = data();
+  StepTimes times;
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    core::dic::DictionaryBuilder builder;
+    builder.setNumThreads(numThreads);
+    builder.setProgress(&times);
+    checkOk(builder.importSpec(&d.spec));
+    checkOk(builder.importCsv("bench", d.csv));
+    times.endBuild();
+    benchpress::escape(&builder);
+  }
+  ctx->stop_timer();
+  times.print(numThreads, ctx->num_iterations());
+}
+
+BENCHMARK("dic-build/threads-1", [](context* ctx) { buildWithThreads(ctx, 1); });
+
+BENCHMARK("dic-build/threads-2", [](context* ctx) { buildWithThreads(ctx, 2); });
+
+BENCHMARK("dic-build/threads-4", [](context* ctx) { buildWithThreads(ctx, 4); });
+
+BENCHMARK("dic-build/threads-all", [](context* ctx) {
+  buildWithThreads(ctx, std::max(std::thread::hardware_concurrency(), 1u));
+});
+
+}  // namespace
@@ -0,0 +1,108 @@
+#define BENCHPRESS_CONFIG_MAIN
+
+#include <random>
+#include <vector>
+#include "benchpress/benchpress.hpp"
+#include "core/analysis/perceptron.h"
+#include "util/quantized_weights.h"
+
+using context = benchpress::context;
+using namespace jumanpp;
+
+namespace {
+
+// Hashed feature lookups: random accesses into a large weight table.
+// Quantized tables are 2-4 times smaller so more of them stay in cache.
+constexpr size_t NumWeights = 4 * 1024 * 1024;
+constexpr size_t NumIndices = 64 * 1024;
+
+struct WeightData {
+  std::vector<float> floats;
+  std::vector<u8> bytes;
+  std::vector<u16> shorts;
+  util::LinearQuantization q8;
+  util::LinearQuantization q16;
+  std::vector<i8> blockBytes;
+  std::vector<i16> blockShorts;
+  std::vector<float> scales8;
+  std::vector<float> scales16;
+  std::vector<u32> indices;
+
+  WeightData()
+      : floats(NumWeights),
+        bytes(NumWeights),
+        shorts(NumWeights),
+        blockBytes(NumWeights),
+        blockShorts(NumWeights),
+        scales8(NumWeights / core::analysis::WeightBlockSize),
+        scales16(NumWeights / core::analysis::WeightBlockSize),
+        indices(NumIndices) {
+    std::minstd_rand rng{42};
+    std::normal_distribution<float> weightDist{0, 0.05f};
+    for (auto& w : floats) {
+      w = weightDist(rng);
+    }
+    q8 = util::quantizeLinear<u8>(floats, &bytes);
+    q16 = util::quantizeLinear<u16>(floats, &shorts);
+    util::quantizeRows<i8>(floats, core::analysis::WeightBlockSize,
+                           &blockBytes, &scales8);
+    util::quantizeRows<i16>(floats, core::analysis::WeightBlockSize,
+                            &blockShorts, &scales16);
+    std::uniform_int_distribution<u32> idxDist{0, NumWeights - 1};
+    for (auto& i : indices) {
+      i = idxDist(rng);
+    }
+  }
+};
+
+WeightData& data() {
+  static WeightData instance;
+  return instance;
+}
+
+template <typename Weights>
+void lookup(context* ctx, const Weights& weights) {
+  util::ArraySlice<u32> indices{data().indices};
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    float result = core::analysis::impl::computeUnrolled4RawPerceptron(
+        weights, indices);
+    benchpress::escape(&result);
+  }
+}
+
+template <typename Storage>
+util::LinearQuantizedWeights<Storage> quantized(
+    const std::vector<Storage>& storage, const util::LinearQuantization& q) {
+  return {reinterpret_cast<const char*>(storage.data()), storage.size(), q.min,
+          q.step};
+}
+
+template <typename Storage>
+util::BlockQuantizedWeights<Storage> blockQuantized(
+    const std::vector<Storage>& storage, const std::vector<float>& scales) {
+  return {reinterpret_cast<const char*>(storage.data()), scales.data(),
+          storage.size()};
+}
+
+BENCHMARK("lookup/float", [](context* ctx) {
+  lookup(ctx, core::analysis::FloatBufferWeights{data().floats});
+});
+
+BENCHMARK("lookup/16bit", [](context* ctx) {
+  lookup(ctx, quantized(data().shorts, data().q16));
+});
+
+BENCHMARK("lookup/8bit", [](context* ctx) {
+  lookup(ctx, quantized(data().bytes, data().q8));
+});
+
+BENCHMARK("lookup/16bit-block", [](context* ctx) {
+  lookup(ctx, blockQuantized(data().blockShorts, data().scales16));
+});
+
+BENCHMARK("lookup/8bit-block", [](context* ctx) {
+  lookup(ctx, blockQuantized(data().blockBytes, data().scales8));
+});
+
+}  // namespace
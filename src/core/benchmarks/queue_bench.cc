@@ -0,0 +1,72 @@
+#define BENCHPRESS_CONFIG_MAIN
+
+#include <thread>
+#include <vector>
+#include "benchpress/benchpress.hpp"
+#include "util/bounded_queue.h"
+#include "util/lockfree_queue.h"
+
+using context = benchpress::context;
+using namespace jumanpp;
+
+namespace {
+
+constexpr unsigned int QueueSize = 1024;
+
+// Items are passed from nthreads producers to nthreads consumers.
+// Every producer and consumer handles an equal share of items.
+template <typename Queue>
+void passItems(context* ctx, u32 nthreads) {
+  Queue queue{QueueSize};
+  auto total = ctx->num_iterations();
+  auto share = [&](u32 idx) {
+    auto base = total / nthreads;
+    return base + (idx < total % nthreads ? 1 : 0);
+  };
+
+  std::vector<std::thread> threads;
+  ctx->reset_timer();
+  for (u32 t = 0; t < nthreads; ++t) {
+    auto items = share(t);
+    threads.emplace_back([&queue, items]() {
+      for (size_t i = 0; i < items; ++i) {
+        u64 item = i + 1;
+        while (!queue.offer(std::move(item))) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&queue, items]() {
+      u64 sum = 0;
+      for (size_t i = 0; i < items; ++i) {
+        sum += queue.waitFor();
+      }
+      benchpress::escape(&sum);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+template <typename Queue>
+void registerAll(const std::string& name) {
+  for (u32 threads : {1, 2, 4, 8, 16, 32, 64}) {
+    benchpress::auto_register{
+        name + "/" + std::to_string(threads),
+        [threads](context* ctx) { passItems<Queue>(ctx, threads); }};
+  }
+}
+
+struct Registrar {
+  Registrar() {
+    registerAll<util::bounded_queue<u64>>("mutex");
+    registerAll<util::mpmc_bounded_queue<u64>>("mpmc");
+    benchpress::auto_register{"spsc/1", [](context* ctx) {
+                                passItems<util::spsc_bounded_queue<u64>>(ctx,
+                                                                         1);
+                              }};
+  }
+} registrar;
+
+}  // namespace
@@ -0,0 +1,86 @@
+#define BENCHPRESS_CONFIG_MAIN
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include "benchpress/benchpress.hpp"
+#include "core/env.h"
+
+using context = benchpress::context;
+using namespace jumanpp;
+
+namespace {
+
+// The model to benchmark is passed through the environment:
+// JPP_BENCH_MODEL=/path/to/jumandic.jppmdl startup_bench
+const char* modelPath() { return std::getenv("JPP_BENCH_MODEL"); }
+
+enum class Phase { LoadModel, InitFeatures, MakeAnalyzer, FirstSentence };
+
+void checkOk(const Status& s) {
+  if (!s) {
+    std::cerr << s << "\n";
+    std::exit(1);
+  }
+}
+
+// Runs startup up to and including the passed phase.
+// Phases are measured cumulatively, so the cost of a single phase
+// is the difference with the previous one.
+// Timing only a single phase makes benchpress run the untimed part
+// for too many iterations.
+void runUntil(context* ctx, Phase phase, core::model::ModelLoadMode mode) {
+  auto path = StringPiece::fromCString(modelPath());
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    std::unique_ptr<core::JumanppEnv> env{new core::JumanppEnv};
+    std::unique_ptr<core::analysis::Analyzer> analyzer{
+        new core::analysis::Analyzer};
+    env->setModelLoadMode(mode);
+    checkOk(env->loadModel(path));
+    if (phase >= Phase::InitFeatures) {
+      checkOk(env->initFeatures(nullptr));
+    }
+    if (phase >= Phase::MakeAnalyzer) {
+      checkOk(env->makeAnalyzer(analyzer.get()));
+    }
+    if (phase >= Phase::FirstSentence) {
+      checkOk(analyzer->analyze("外国人参政権について議論する"));
+    }
+    ctx->stop_timer();
+    analyzer.reset();
+    env.reset();
+    ctx->start_timer();
+  }
+}
+
+struct Registrar {
+  Registrar() {
+    if (modelPath() == nullptr) {
+      std::cerr << "set JPP_BENCH_MODEL to a model file to run "
+                   "startup benchmarks\n";
+      return;
+    }
+
+    using core::model::ModelLoadMode;
+    std::pair<const char*, Phase> phases[] = {
+        {"load-model", Phase::LoadModel},
+        {"init-features", Phase::InitFeatures},
+        {"make-analyzer", Phase::MakeAnalyzer},
+        {"first-sentence", Phase::FirstSentence}};
+    std::pair<const char*, ModelLoadMode> modes[] = {
+        {"default", ModelLoadMode::Default},
+        {"mapped", ModelLoadMode::Mapped}};
+    for (auto& mode : modes) {
+      for (auto& phase : phases) {
+        auto name =
+            std::string{"startup/"} + mode.first + "/until-" + phase.first;
+        auto p = phase.second;
+        auto m = mode.second;
+        benchpress::auto_register{
+            name, [p, m](context* ctx) { runUntil(ctx, p, m); }};
+      }
+    }
+  }
+} registrar;
+
+}  // namespace
@@ -0,0 +1,264 @@
+#define BENCHPRESS_CONFIG_MAIN
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+#include "benchpress/benchpress.hpp"
+#include "core/dic/codepoint_trie.h"
+#include "core/dic/darts_trie.h"
+#include "core/dic/first_codepoint_index.h"
+#include "util/characters.h"
+#include "util/csv_reader.h"
+
+using context = benchpress::context;
+using namespace jumanpp;
+using core::dic::TraverseStatus;
+
+namespace {
+
+// Keys are taken from the first column of a dictionary csv:
+// JPP_BENCH_DIC=jumandic.csv trie_lookup_bench
+// Analyzed text is taken from JPP_BENCH_INPUT.
+// Synthetic dictionary and text are used when they are not set.
+const char* dicPath() { return std::getenv("JPP_BENCH_DIC"); }
+const char* inputPath() { return std::getenv("JPP_BENCH_INPUT"); }
+
+void checkOk(const Status& s) {
+  if (!s) {
+    std::cerr << s << "\n";
+    std::exit(1);
+  }
+}
+
+void appendUtf8(char32_t cp, std::string* result) {
+  if (cp < 0x80) {
+    result->push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    result->push_back(static_cast<char>(0xc0 | (cp >> 6)));
+    result->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  } else {
+    result->push_back(static_cast<char>(0xe0 | (cp >> 12)));
+    result->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+    result->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  }
+}
+
+// Japanese-like text: kana and frequent kanji dominate
+class SyntheticText {
+  std::minstd_rand rng_{42};
+  std::vector<char32_t> alphabet_;
+  std::geometric_distribution<size_t> charDist_{0.004};
+  std::discrete_distribution<int> lengthDist_{0, 20, 35, 25, 12, 5, 3};
+
+ public:
+  SyntheticText() {
+    for (char32_t c = 0x3041; c <= 0x3093; ++c) alphabet_.push_back(c);
+    for (char32_t c = 0x30a1; c <= 0x30f3; ++c) alphabet_.push_back(c);
+    for (char32_t c = 0x4e00; c < 0x4e00 + 3000; ++c) alphabet_.push_back(c);
+    for (char32_t c = 'a'; c <= 'z'; ++c) alphabet_.push_back(c);
+    std::shuffle(alphabet_.begin() + 80, alphabet_.end(), rng_);
+  }
+
+  std::string word() {
+    std::string result;
+    auto length = lengthDist_(rng_);
+    for (int i = 0; i < length; ++i) {
+      auto idx = std::min(charDist_(rng_), alphabet_.size() - 1);
+      appendUtf8(alphabet_[idx], &result);
+    }
+    return result;
+  }
+};
+
+struct TrieData {
+  std::vector<std::string> keys;
+  std::string input;
+  core::dic::DoubleArrayBuilder daBuilder;
+  core::dic::FirstCodepointIndexBuilder indexBuilder;
+  core::dic::CodepointTrieBuilder cpBuilder;
+  core::dic::DoubleArray da;
+  core::dic::FirstCodepointIndex index;
+  core::dic::CodepointTrie cpTrie;
+  std::vector<chars::InputCodepoint> codepoints;
+  // codepoint trie codes of the input, computed once per sentence in jumanpp
+  std::vector<u32> codes;
+
+  void readKeys() {
+    std::set<std::string> unique;
+    if (dicPath() != nullptr) {
+      util::CsvReader csv;
+      checkOk(csv.open(StringPiece::fromCString(dicPath())));
+      while (csv.nextLine()) {
+        unique.insert(csv.field(0).str());
+      }
+    } else {
+      SyntheticText text;
+      while (unique.size() < 300000) {
+        unique.insert(text.word());
+      }
+    }
+    keys.assign(unique.begin(), unique.end());
+  }
+
+  void readInput() {
+    if (inputPath() != nullptr) {
+      util::CsvReader lines{'\t', '\0'};
+      checkOk(lines.open(StringPiece::fromCString(inputPath())));
+      while (lines.nextLine() && input.size() < (1 << 20)) {
+        input.append(lines.line().char_begin(), lines.line().char_end());
+      }
+    } else {
+      SyntheticText text;
+      std::minstd_rand rng{1};
+      std::uniform_int_distribution<size_t> keyDist{0, keys.size() - 1};
+      while (input.size() < 256 * 1024) {
+        if (rng() % 4 == 0) {
+          input += text.word();
+        } else {
+          input += keys[keyDist(rng)];
+        }
+      }
+    }
+    if (!chars::preprocessRawData(input, &codepoints)) {
+      std::cerr << "input was not valid utf-8\n";
+      std::exit(1);
+    }
+  }
+
+  TrieData() {
+    readKeys();
+    for (i32 i = 0; i < keys.size(); ++i) {
+      daBuilder.add(keys[i], i);
+      indexBuilder.add(keys[i]);
+      cpBuilder.add(keys[i], i);
+    }
+    checkOk(daBuilder.build());
+    checkOk(indexBuilder.build(daBuilder.result()));
+    checkOk(cpBuilder.build());
+    checkOk(da.loadFromMemory(daBuilder.result()));
+    checkOk(index.load(indexBuilder.result()));
+    checkOk(cpTrie.load(cpBuilder.result()));
+    if (!cpTrie.loaded()) {
+      std::cerr << "keys can not be stored in a codepoint trie\n";
+      std::exit(1);
+    }
+    readInput();
+    for (auto& cp : codepoints) {
+      codes.push_back(cpTrie.codeOf(cp));
+    }
+    std::cerr << "keys: " << keys.size()
+              << ", double array: " << daBuilder.result().size()
+              << " bytes, codepoint trie: " << cpBuilder.result().size()
+              << " bytes (" << cpTrie.numCodes() << " codes), input: "
+              << codepoints.size() << " codepoints\n";
+  }
+};
+
+TrieData& data() {
+  static TrieData instance;
+  return instance;
+}
+
+// Count keys which start at every input position,
+// the same access pattern as the dictionary node creator has.
+template <typename Traversal, typename Input, typename Step>
+i64 lookupFrom(size_t begin, Traversal trav, const std::vector<Input>& cps,
+               Step step) {
+  i64 found = 0;
+  for (size_t pos = begin; pos < cps.size(); ++pos) {
+    auto status = step(trav, cps[pos]);
+    if (status == TraverseStatus::Ok) {
+      found += trav.value();
+    } else if (status == TraverseStatus::NoNode) {
+      break;
+    }
+  }
+  return found;
+}
+
+auto byteStep = [](core::dic::DoubleArrayTraversal& trav,
+                   const chars::InputCodepoint& cp) {
+  return trav.step(cp.bytes);
+};
+
+auto codeStep = [](core::dic::CodepointTrieTraversal& trav, u32 code) {
+  return trav.step(code);
+};
+
+BENCHMARK("lookup/double-array", [](context* ctx) {
+  auto& d = data();
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    i64 found = 0;
+    for (size_t begin = 0; begin < d.codepoints.size(); ++begin) {
+      found += lookupFrom(begin, d.da.traversal(), d.codepoints, byteStep);
+    }
+    benchpress::escape(&found);
+  }
+});
+
+BENCHMARK("lookup/double-array+first-codepoint-index", [](context* ctx) {
+  auto& d = data();
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    i64 found = 0;
+    for (size_t begin = 0; begin < d.codepoints.size(); ++begin) {
+      auto info = d.index.find(d.codepoints[begin].codepoint);
+      if (info == nullptr) {
+        continue;
+      }
+      if (info->value >= 0) {
+        found += info->value;
+      }
+      found +=
+          lookupFrom(begin + 1, d.da.traversalAt(info->nodePos, info->value),
+                     d.codepoints, byteStep);
+    }
+    benchpress::escape(&found);
+  }
+});
+
+BENCHMARK("lookup/codepoint-trie", [](context* ctx) {
+  auto& d = data();
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    i64 found = 0;
+    for (size_t begin = 0; begin < d.codes.size(); ++begin) {
+      if (d.codes[begin] == 0) {
+        continue;
+      }
+      found += lookupFrom(begin, d.cpTrie.traversal(), d.codes, codeStep);
+    }
+    benchpress::escape(&found);
+  }
+});
+
+BENCHMARK("lookup/codepoint-trie+first-codepoint-index", [](context* ctx) {
+  auto& d = data();
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    i64 found = 0;
+    for (size_t begin = 0; begin < d.codes.size(); ++begin) {
+      auto info = d.index.find(d.codepoints[begin].codepoint);
+      if (info == nullptr) {
+        continue;
+      }
+      auto trav = d.cpTrie.traversal();
+      auto limit = std::min<size_t>(d.codes.size(), begin + info->maxLength);
+      for (size_t pos = begin; pos < limit; ++pos) {
+        auto status = trav.step(d.codes[pos]);
+        if (status == TraverseStatus::Ok) {
+          found += trav.value();
+        } else if (status == TraverseStatus::NoNode) {
+          break;
+        }
+      }
+    }
+    benchpress::escape(&found);
+  }
+});
+
+}  // namespace
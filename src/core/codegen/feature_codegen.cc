@@ -225,6 +225,25 @@ Status StaticFeatureCodegen::writeSource(const std::string& filename) {
 
   p << "\n} //jumanpp_generated namespace";
 
+  if (config_.pluginEntry) {
+    p << "\n\nextern \"C\" JPP_PLUGIN_EXPORT\n"
+      << JPP_TEXT(const jumanpp::core::features::StaticFeatureFactory*) " "
+      << JPP_TEXT(JPP_FEATURE_PLUGIN_ENTRY) "(::jumanpp::u32 abi, "
+      << "const char* buildId) {";
+    {
+      i::Indent io{p, 2};
+      p << "\nif (abi != ::jumanpp::core::features::FeaturePluginAbi ||";
+      p << "\n    ::jumanpp::StringPiece::fromCString(buildId) != "
+        << "JPP_PLUGIN_BUILD_ID) {";
+      p << "\n  return nullptr;";
+      p << "\n}";
+      p << "\nstatic const jumanpp_generated::" << config_.className
+        << " factory{};";
+      p << "\nreturn &factory;";
+    }
+    p << "\n}";
+  }
+
   try {
     std::ofstream ofs(filename);
     ofs << p.result();
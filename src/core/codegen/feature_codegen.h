@@ -18,6 +18,8 @@ struct FeatureCodegenConfig {
   std::string filename;
   std::string className;
   std::string baseDirectory;
+  // export a feature plugin entry function from the generated source
+  bool pluginEntry = false;
 };
 
 class StaticFeatureCodegen {
@@ -307,9 +307,12 @@ void InNodeComputationsCodegen::generateLoop(i::Printer &p) {
     generateLoopBody(p);
   }
   p << "\n}";
-  p << "\nscores.at(numItems - 1) = "
+  // boundaries without starting nodes have nothing to publish
+  p << "\nif (JPP_LIKELY(numItems > 0)) {";
+  p << "\n  scores.at(numItems - 1) = "
     << JPP_TEXT(::jumanpp::core::analysis::impl::computeUnrolled4RawPerceptron)
     << "(weights, buf1);";
+  p << "\n}";
 }
 
 InNodeComputationsCodegen::InNodeComputationsCodegen(
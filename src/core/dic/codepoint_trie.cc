@@ -0,0 +1,206 @@
+#include "codepoint_trie.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace jumanpp {
+namespace core {
+namespace dic {
+
+namespace {
+
+constexpr u32 TrieMagic = 0x5450434a;  // JCPT
+constexpr u32 TrieVersion = 1;
+
+struct TrieHeader {
+  u32 magic;
+  u32 version;
+  u32 numCodes;
+  u32 numPages;
+  u32 trieSize;
+};
+
+// sizes of data sections in bytes, every section is padded to 4 bytes
+struct TrieLayout {
+  size_t pageIndex;
+  size_t pages;
+  size_t trie;
+
+  explicit TrieLayout(const TrieHeader& h)
+      : pageIndex{pad(sizeof(u16) * CodepointTrie::NumPages)},
+        pages{sizeof(u32) * CodepointTrie::PageSize * h.numPages},
+        trie{pad(h.trieSize)} {}
+
+  static size_t pad(size_t size) { return (size + 3) & ~size_t{3}; }
+
+  size_t total() const { return sizeof(TrieHeader) + pageIndex + pages + trie; }
+};
+
+}  // namespace
+
+constexpr u32 CodepointTrie::PageBits;
+constexpr u32 CodepointTrie::PageSize;
+constexpr u32 CodepointTrie::NumPages;
+constexpr u32 CodepointTrie::TwoByteLead;
+constexpr u32 CodepointTrie::ThreeByteLead;
+constexpr u32 CodepointTrie::TrailBase;
+constexpr u32 CodepointTrie::MaxCodes;
+
+void CodepointTrieBuilder::add(StringPiece key, i32 value) {
+  if (!valid_) {
+    return;
+  }
+  if (key.size() == 0) {
+    valid_ = false;
+    return;
+  }
+
+  auto it = key.ubegin();
+  auto end = key.uend();
+  while (it < end) {
+    auto info = chars::getCodepoint(it, end);
+    if (info.utf8Length == 0 || info.codepoint >= 0x110000 ||
+        info.utf8Length != CodepointTrie::utf8Length(info.codepoint)) {
+      valid_ = false;
+      return;
+    }
+    counts_[info.codepoint] += 1;
+    it += info.utf8Length;
+  }
+  keys_.emplace_back(key, value);
+}
+
+Status CodepointTrieBuilder::build(ProgressCallback* progress) {
+  result_.clear();
+  if (!valid_ || keys_.empty()) {
+    return Status::Ok();
+  }
+
+  if (counts_.size() > CodepointTrie::MaxCodes) {
+    return Status::Ok();
+  }
+
+  // the most frequent codepoints get the shortest codes
+  std::vector<std::pair<char32_t, u32>> byCount;
+  for (auto& p : counts_) {
+    byCount.emplace_back(p.first, p.second);
+  }
+  std::sort(byCount.begin(), byCount.end(),
+            [](const std::pair<char32_t, u32>& a,
+               const std::pair<char32_t, u32>& b) {
+              if (a.second != b.second) {
+                return a.second > b.second;
+              }
+              return a.first < b.first;
+            });
+  util::FlatMap<char32_t, u32, chars::CodepointHash> codes;
+  for (u32 i = 0; i < byCount.size(); ++i) {
+    codes[byCount[i].first] = CodepointTrie::makeCode(i + 1);
+  }
+
+  std::vector<std::string> encoded;
+  encoded.reserve(keys_.size());
+  for (auto& key : keys_) {
+    std::string code;
+    auto it = key.first.ubegin();
+    auto end = key.first.uend();
+    while (it < end) {
+      auto info = chars::getCodepoint(it, end);
+      CodepointTrie::appendCode(codes[info.codepoint], &code);
+      it += info.utf8Length;
+    }
+    encoded.push_back(std::move(code));
+  }
+
+  DoubleArrayBuilder trie;
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    trie.add(encoded[i], keys_[i].second);
+  }
+  JPP_RETURN_IF_ERROR(trie.build(progress));
+  auto trieData = trie.result();
+
+  std::vector<u16> pageIndex(CodepointTrie::NumPages, 0);
+  std::sort(byCount.begin(), byCount.end());
+  u32 numPages = 0;
+  for (auto& p : byCount) {
+    auto& page = pageIndex[p.first >> CodepointTrie::PageBits];
+    if (page == 0) {
+      page = static_cast<u16>(++numPages);
+    }
+  }
+  std::vector<u32> pages(numPages * CodepointTrie::PageSize, 0);
+  for (auto& p : byCount) {
+    auto cp = p.first;
+    auto page = pageIndex[cp >> CodepointTrie::PageBits] - 1;
+    auto pos = page * CodepointTrie::PageSize +
+               (cp & (CodepointTrie::PageSize - 1));
+    pages[pos] = codes[cp];
+  }
+
+  TrieHeader header{TrieMagic, TrieVersion, static_cast<u32>(byCount.size()),
+                    numPages, static_cast<u32>(trieData.size())};
+  TrieLayout layout{header};
+  result_.assign(layout.total() / sizeof(u32), 0);
+  auto out = reinterpret_cast<char*>(result_.data());
+  auto write = [&](const void* data, size_t size, size_t padded) {
+    std::memcpy(out, data, size);
+    out += padded;
+  };
+  write(&header, sizeof(header), sizeof(header));
+  write(pageIndex.data(), pageIndex.size() * sizeof(u16), layout.pageIndex);
+  write(pages.data(), pages.size() * sizeof(u32), layout.pages);
+  write(trieData.begin(), trieData.size(), layout.trie);
+  return Status::Ok();
+}
+
+Status CodepointTrie::load(StringPiece data) {
+  pages_ = nullptr;
+  copy_.clear();
+  if (data.size() == 0) {
+    return Status::Ok();
+  }
+  if (reinterpret_cast<uintptr_t>(data.begin()) % alignof(u32) != 0) {
+    copy_.resize((data.size() + sizeof(u32) - 1) / sizeof(u32));
+    std::memcpy(copy_.data(), data.begin(), data.size());
+    auto ptr = reinterpret_cast<StringPiece::pointer_t>(copy_.data());
+    return loadAligned(StringPiece{ptr, data.size()});
+  }
+  return loadAligned(data);
+}
+
+Status CodepointTrie::loadAligned(StringPiece data) {
+  TrieHeader header;
+  if (data.size() < sizeof(header)) {
+    return JPPS_INVALID_PARAMETER << "codepoint trie was too small";
+  }
+  std::memcpy(&header, data.begin(), sizeof(header));
+  if (header.magic != TrieMagic || header.version != TrieVersion) {
+    return JPPS_INVALID_PARAMETER << "unsupported codepoint trie format";
+  }
+  TrieLayout layout{header};
+  if (header.numPages > NumPages || layout.total() != data.size()) {
+    return JPPS_INVALID_PARAMETER << "codepoint trie had invalid size";
+  }
+
+  auto ptr = data.begin() + sizeof(header);
+  auto pageIndex = reinterpret_cast<const u16*>(ptr);
+  ptr += layout.pageIndex;
+  auto pages = reinterpret_cast<const u32*>(ptr);
+  ptr += layout.pages;
+  for (u32 i = 0; i < NumPages; ++i) {
+    if (pageIndex[i] > header.numPages) {
+      return JPPS_INVALID_PARAMETER << "codepoint trie had invalid page";
+    }
+  }
+
+  JPP_RETURN_IF_ERROR(
+      trie_.loadFromMemory(StringPiece{ptr, ptr + header.trieSize}));
+  pageIndex_ = pageIndex;
+  pages_ = pages;
+  numCodes_ = header.numCodes;
+  return Status::Ok();
+}
+
+}  // namespace dic
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,189 @@
+#ifndef JUMANPP_CODEPOINT_TRIE_H
+#define JUMANPP_CODEPOINT_TRIE_H
+
+#include <string>
+#include <vector>
+#include "core/dic/darts_trie.h"
+#include "util/characters.h"
+#include "util/common.hpp"
+#include "util/flatmap.h"
+#include "util/status.hpp"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace dic {
+
+class CodepointTrieTraversal;
+
+/**
+ * Dictionary trie which is keyed by codepoint codes instead of UTF-8.
+ * It is computed when building a dictionary and stored in the model.
+ *
+ * Codepoints of dictionary keys are ordered by frequency and
+ * get variable length codes: the most frequent ones are encoded in one
+ * byte, the following ones in two and the rest in three bytes.
+ * Common kana and kanji take a single double array transition
+ * instead of three UTF-8 ones and the trie itself becomes smaller,
+ * so more of it stays in cache.
+ *
+ * The trie is the same darts double array as DoubleArray, with
+ * base, check and leaf flag packed into a single 32-bit unit.
+ * Lookups encode input codepoints once and then step by codes.
+ */
+class CodepointTrie {
+ public:
+  static constexpr u32 PageBits = 8;
+  static constexpr u32 PageSize = 1u << PageBits;
+  static constexpr u32 NumPages = 0x110000u >> PageBits;
+
+  // first bytes of the codes which are two and three bytes long
+  static constexpr u32 TwoByteLead = 240;
+  static constexpr u32 ThreeByteLead = 255;
+  // code bytes never contain 0, it terminates keys in the double array
+  static constexpr u32 TrailBase = 255;
+  static constexpr u32 MaxCodes = (TwoByteLead - 1) +
+                                  (ThreeByteLead - TwoByteLead) * TrailBase +
+                                  TrailBase * TrailBase;
+
+ private:
+  const u16* pageIndex_ = nullptr;
+  const u32* pages_ = nullptr;
+  DoubleArray trie_;
+  u32 numCodes_ = 0;
+  // used only when the data is not aligned
+  std::vector<u32> copy_;
+
+  Status loadAligned(StringPiece data);
+
+ public:
+  /**
+   * Empty data (e.g. models which were built before the trie existed)
+   * leave the trie unloaded.
+   * Loaded trie references the passed memory.
+   */
+  Status load(StringPiece data);
+
+  bool loaded() const { return pages_ != nullptr; }
+  u32 numCodes() const { return numCodes_; }
+  StringPiece trieContents() const { return trie_.contents(); }
+
+  static constexpr size_t utf8Length(char32_t codepoint) noexcept {
+    return codepoint < 0x80 ? 1
+                            : codepoint < 0x800 ? 2
+                                                : codepoint < 0x10000 ? 3 : 4;
+  }
+
+  /**
+   * Code of n-th most frequent codepoint (starting from 1)
+   * with the bytes packed from the lowest one.
+   */
+  static u32 makeCode(u32 rank) noexcept {
+    if (rank < TwoByteLead) {
+      return rank;
+    }
+    rank -= TwoByteLead;
+    if (rank < (ThreeByteLead - TwoByteLead) * TrailBase) {
+      return (TwoByteLead + rank / TrailBase) | ((1 + rank % TrailBase) << 8);
+    }
+    rank -= (ThreeByteLead - TwoByteLead) * TrailBase;
+    return ThreeByteLead | ((1 + rank / TrailBase) << 8) |
+           ((1 + rank % TrailBase) << 16);
+  }
+
+  static u32 codeLength(u32 code) noexcept {
+    auto lead = code & 0xff;
+    return lead < TwoByteLead ? 1 : lead < ThreeByteLead ? 2 : 3;
+  }
+
+  static void appendCode(u32 code, std::string* result) {
+    auto len = codeLength(code);
+    for (u32 i = 0; i < len; ++i) {
+      result->push_back(static_cast<char>((code >> (i * 8)) & 0xff));
+    }
+  }
+
+  /**
+   * @return code of the codepoint or 0 if no key contains it
+   */
+  u32 codeOf(char32_t codepoint) const noexcept {
+    auto page = static_cast<u32>(codepoint) >> PageBits;
+    if (JPP_UNLIKELY(page >= NumPages)) {
+      return 0;
+    }
+    u32 pageIdx = pageIndex_[page];
+    if (pageIdx == 0) {
+      return 0;
+    }
+    return pages_[(pageIdx - 1) * PageSize + (codepoint & (PageSize - 1))];
+  }
+
+  /**
+   * Codepoints which were not encoded in the shortest form
+   * do not match, the same as with UTF-8 keyed DoubleArray.
+   */
+  u32 codeOf(const chars::InputCodepoint& cp) const noexcept {
+    if (JPP_UNLIKELY(cp.bytes.size() != utf8Length(cp.codepoint))) {
+      return 0;
+    }
+    return codeOf(cp.codepoint);
+  }
+
+  CodepointTrieTraversal traversal() const;
+};
+
+class CodepointTrieTraversal {
+  DoubleArrayTraversal da_;
+
+ public:
+  explicit CodepointTrieTraversal(DoubleArrayTraversal da) noexcept
+      : da_{da} {}
+
+  i32 value() const noexcept { return da_.value(); }
+
+  /**
+   * @param code code of the next codepoint, 0 never matches
+   */
+  TraverseStatus step(u32 code) noexcept {
+    if (code == 0) {
+      return TraverseStatus::NoNode;
+    }
+    char bytes[4] = {static_cast<char>(code & 0xff),
+                     static_cast<char>((code >> 8) & 0xff),
+                     static_cast<char>((code >> 16) & 0xff), 0};
+    return da_.step(StringPiece{bytes, CodepointTrie::codeLength(code)});
+  }
+};
+
+inline CodepointTrieTraversal CodepointTrie::traversal() const {
+  return CodepointTrieTraversal{trie_.traversal()};
+}
+
+class CodepointTrieBuilder {
+  util::FlatMap<char32_t, u32, chars::CodepointHash> counts_;
+  std::vector<std::pair<StringPiece, i32>> keys_;
+  std::vector<u32> result_;
+  bool valid_ = true;
+
+ public:
+  void add(StringPiece key, i32 value);
+
+  /**
+   * Keys which are not valid UTF-8 produce an empty result,
+   * lookups use DoubleArray then.
+   * Added keys must be alive until the build finishes.
+   */
+  Status build(ProgressCallback* progress = nullptr);
+
+  StringPiece result() const {
+    auto ptr = reinterpret_cast<StringPiece::pointer_t>(result_.data());
+    return StringPiece{ptr, result_.size() * sizeof(u32)};
+  }
+};
+
+}  // namespace dic
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_CODEPOINT_TRIE_H
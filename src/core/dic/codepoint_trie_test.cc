@@ -0,0 +1,199 @@
+#include "codepoint_trie.h"
+#include <testing/standalone_test.h>
+#include <random>
+#include <set>
+#include <string>
+
+namespace c = jumanpp::core::dic;
+namespace j = jumanpp;
+
+namespace {
+
+struct TrieEnv {
+  c::DoubleArrayBuilder daBldr;
+  c::CodepointTrieBuilder cpBldr;
+  c::DoubleArray da;
+  c::CodepointTrie trie;
+
+  void add(j::StringPiece key, int value) {
+    daBldr.add(key, value);
+    cpBldr.add(key, value);
+  }
+
+  void build() {
+    REQUIRE_OK(daBldr.build());
+    REQUIRE_OK(cpBldr.build());
+    REQUIRE_OK(da.loadFromMemory(daBldr.result()));
+    REQUIRE_OK(trie.load(cpBldr.result()));
+  }
+
+  void checkSame(j::StringPiece str) {
+    CAPTURE(str);
+    std::vector<j::chars::InputCodepoint> cps;
+    REQUIRE(j::chars::preprocessRawData(str, &cps));
+    for (size_t begin = 0; begin < cps.size(); ++begin) {
+      auto t1 = da.traversal();
+      auto t2 = trie.traversal();
+      for (size_t pos = begin; pos < cps.size(); ++pos) {
+        CAPTURE(begin);
+        CAPTURE(pos);
+        auto s1 = t1.step(cps[pos].bytes);
+        auto s2 = t2.step(trie.codeOf(cps[pos]));
+        REQUIRE(s1 == s2);
+        if (s1 == c::TraverseStatus::NoNode) {
+          break;
+        }
+        if (s1 == c::TraverseStatus::Ok) {
+          CHECK(t1.value() == t2.value());
+        }
+      }
+    }
+  }
+};
+
+}  // namespace
+
+TEST_CASE("codepoint trie finds keys") {
+  TrieEnv env;
+  env.add("東", 1);
+  env.add("東京", 2);
+  env.add("東京都", 3);
+  env.add("京都", 4);
+  env.add("a", 5);
+  env.add("abc", 6);
+  env.add("𠮷野家", 7);
+  env.build();
+  REQUIRE(env.trie.loaded());
+  CHECK(env.trie.numCodes() == 9);
+
+  auto step = [&](c::CodepointTrieTraversal& t, char32_t cp) {
+    return t.step(env.trie.codeOf(cp));
+  };
+  auto t = env.trie.traversal();
+  CHECK(step(t, U'東') == c::TraverseStatus::Ok);
+  CHECK(t.value() == 1);
+  CHECK(step(t, U'京') == c::TraverseStatus::Ok);
+  CHECK(t.value() == 2);
+  CHECK(step(t, U'都') == c::TraverseStatus::Ok);
+  CHECK(t.value() == 3);
+  CHECK(step(t, U'府') == c::TraverseStatus::NoNode);
+
+  auto t2 = env.trie.traversal();
+  CHECK(step(t2, U'a') == c::TraverseStatus::Ok);
+  CHECK(step(t2, U'b') == c::TraverseStatus::NoLeaf);
+  CHECK(step(t2, U'c') == c::TraverseStatus::Ok);
+  CHECK(t2.value() == 6);
+  CHECK(step(t2, U'a') == c::TraverseStatus::NoNode);
+
+  auto t3 = env.trie.traversal();
+  CHECK(step(t3, U'京') == c::TraverseStatus::NoLeaf);
+  CHECK(step(t3, U'東') == c::TraverseStatus::NoNode);
+  CHECK(env.trie.codeOf(U'x') == 0);
+  CHECK(env.trie.codeOf(char32_t{0x10ffff}) == 0);
+  CHECK(env.trie.codeOf(char32_t{0x110000}) == 0);
+  // 京 and 東 are the most frequent codepoints
+  CHECK(env.trie.codeOf(U'京') == 1);
+  CHECK(env.trie.codeOf(U'東') == 2);
+
+  env.checkSame("東京都の京都にabcな𠮷野家がある");
+}
+
+TEST_CASE("codepoint trie rejects non-shortest encoding") {
+  TrieEnv env;
+  env.add("a", 1);
+  env.build();
+  // overlong encoding of 'a'
+  const char bytes[] = {'\xc1', '\xa1', 0};
+  j::chars::InputCodepoint cp{U'a', j::chars::CharacterClass::ALPH,
+                              j::StringPiece{bytes, 2}};
+  CHECK(env.trie.codeOf(cp) == 0);
+  j::chars::InputCodepoint plain{j::StringPiece{"a"}};
+  CHECK(env.trie.traversal().step(env.trie.codeOf(plain)) ==
+        c::TraverseStatus::Ok);
+}
+
+TEST_CASE("codepoint codes are unique and do not contain zero bytes") {
+  std::set<j::u32> codes;
+  std::set<std::string> encoded;
+  for (j::u32 rank = 1; rank <= c::CodepointTrie::MaxCodes; ++rank) {
+    auto code = c::CodepointTrie::makeCode(rank);
+    std::string bytes;
+    c::CodepointTrie::appendCode(code, &bytes);
+    CAPTURE(rank);
+    REQUIRE(bytes.size() == c::CodepointTrie::codeLength(code));
+    CHECK(bytes.find('\0') == std::string::npos);
+    codes.insert(code);
+    encoded.insert(bytes);
+  }
+  CHECK(codes.size() == c::CodepointTrie::MaxCodes);
+  CHECK(encoded.size() == c::CodepointTrie::MaxCodes);
+  CHECK(c::CodepointTrie::codeLength(c::CodepointTrie::makeCode(239)) == 1);
+  CHECK(c::CodepointTrie::codeLength(c::CodepointTrie::makeCode(240)) == 2);
+  CHECK(c::CodepointTrie::codeLength(c::CodepointTrie::makeCode(4064)) == 2);
+  CHECK(c::CodepointTrie::codeLength(c::CodepointTrie::makeCode(4065)) == 3);
+}
+
+TEST_CASE("codepoint trie is empty for invalid keys") {
+  c::CodepointTrieBuilder bldr;
+  bldr.add("a", 1);
+  const char bytes[] = {'\xe3', '\x81', 0};
+  bldr.add(j::StringPiece{bytes, 2}, 2);
+  REQUIRE_OK(bldr.build());
+  CHECK(bldr.result().size() == 0);
+  c::CodepointTrie trie;
+  REQUIRE_OK(trie.load(bldr.result()));
+  CHECK_FALSE(trie.loaded());
+}
+
+TEST_CASE("codepoint trie works the same as double array") {
+  std::minstd_rand rng{42};
+  const char32_t alphabet[] = {U'a', U'b', U'c', U'あ', U'い', U'う',
+                               U'東', U'京', U'都', U'府', U'𠮷', U'ー'};
+  std::uniform_int_distribution<size_t> chars{
+      0, sizeof(alphabet) / sizeof(alphabet[0]) - 1};
+  std::uniform_int_distribution<int> lengths{1, 5};
+  auto randomString = [&](int length) {
+    std::u32string s;
+    for (int i = 0; i < length; ++i) {
+      s.push_back(alphabet[chars(rng)]);
+    }
+    return s;
+  };
+  auto toUtf8 = [](const std::u32string& s) {
+    std::string result;
+    for (auto cp : s) {
+      if (cp < 0x80) {
+        result.push_back(static_cast<char>(cp));
+      } else if (cp < 0x800) {
+        result.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+        result.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+      } else if (cp < 0x10000) {
+        result.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+        result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+        result.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+      } else {
+        result.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+        result.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+        result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+        result.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+      }
+    }
+    return result;
+  };
+
+  std::set<std::string> keys;
+  for (int i = 0; i < 2000; ++i) {
+    keys.insert(toUtf8(randomString(lengths(rng))));
+  }
+  TrieEnv env;
+  int value = 0;
+  for (auto& k : keys) {
+    env.add(k, value);
+    value += 3;
+  }
+  env.build();
+  REQUIRE(env.trie.loaded());
+  for (int i = 0; i < 50; ++i) {
+    env.checkSame(toUtf8(randomString(30)));
+  }
+}
@@ -75,9 +75,14 @@ class DoubleArrayTraversal {
   DoubleArrayTraversal(const impl::DoubleArrayCore *base_) noexcept
       : base_(base_) {}
 
+  DoubleArrayTraversal(const impl::DoubleArrayCore *base_, size_t nodePos,
+                       i32 value) noexcept
+      : base_(base_), node_pos_{nodePos}, value_{value} {}
+
   DoubleArrayTraversal(const DoubleArrayTraversal &) noexcept = default;
 
   i32 value() const { return value_; }
+  size_t nodePosition() const { return node_pos_; }
   TraverseStatus step(StringPiece data);
 
   bool operator==(const DoubleArrayTraversal &o) const {
@@ -100,6 +105,14 @@ class DoubleArray {
     return DoubleArrayTraversal(underlying_.get());
   }
 
+  /**
+   * Continue a traversal from a node which was recorded earlier
+   * with DoubleArrayTraversal::nodePosition()
+   */
+  DoubleArrayTraversal traversalAt(size_t nodePos, i32 value) const {
+    return DoubleArrayTraversal(underlying_.get(), nodePos, value);
+  }
+
   StringPiece contents() const;
   std::string describe() const;
 
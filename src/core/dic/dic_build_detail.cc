@@ -4,6 +4,9 @@
 
 #include "dic_build_detail.h"
 #include "dic_builder.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 namespace jumanpp {
 namespace core {
@@ -22,6 +25,8 @@ void DictionaryBuilderStorage::fillResult(BuiltDictionary* dic_) {
   dic_->trieContent = entries.trieBuilder.daBuilder.result();
   dic_->entryPointers = entries.trieBuilder.entryPtrBuffer.contents();
   dic_->entryData = entries.entryDataBuffer.contents();
+  dic_->firstCodepointIndex = entries.trieBuilder.firstCodepoints.result();
+  dic_->codepointTrie = entries.trieBuilder.codepointTrie.result();
   auto& flds = dic_->fieldData;
   for (auto& i : importers) {
     BuiltField fld;
@@ -63,30 +68,119 @@ void DictionaryBuilderStorage::fillResult(BuiltDictionary* dic_) {
   }
 }
 
+namespace {
+
+struct CsvChunk {
+  StringPiece data;
+  // number of lines before the chunk
+  i64 firstLine;
+};
+
+/**
+ * Split csv data into approximately equal chunks on line boundaries.
+ * Newlines inside quoted fields do not end lines.
+ */
+std::vector<CsvChunk> splitCsv(StringPiece data, char quote, u32 numChunks) {
+  std::vector<CsvChunk> result;
+  auto begin = data.char_begin();
+  auto end = data.char_end();
+  auto chunkStart = begin;
+  i64 chunkLine = 0;
+  i64 lines = 0;
+  bool quoted = false;
+  for (auto pos = begin; pos < end; ++pos) {
+    auto ch = *pos;
+    if (ch == quote) {
+      quoted = !quoted;
+    } else if (ch == '\n' && !quoted) {
+      ++lines;
+      auto next = pos + 1;
+      // the same as csv reader, \n\r is a single line end
+      if (next < end && *next == '\r') {
+        ++next;
+      }
+      auto target = data.size() * (result.size() + 1) / numChunks;
+      if (next - begin >= target && next != end) {
+        result.push_back({StringPiece{chunkStart, next}, chunkLine});
+        chunkStart = next;
+        chunkLine = lines;
+      }
+    }
+  }
+  if (chunkStart != end || result.empty()) {
+    result.push_back({StringPiece{chunkStart, end}, chunkLine});
+  }
+  return result;
+}
+
+template <typename Fn>
+void parallelFor(u32 numThreads, size_t count, Fn fn) {
+  std::atomic<size_t> next{0};
+  auto worker = [&](bool isMain) {
+    for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+      fn(i, isMain);
+    }
+  };
+  std::vector<std::thread> threads;
+  auto numWorkers = std::min<size_t>(numThreads, count);
+  for (size_t i = 1; i < numWorkers; ++i) {
+    threads.emplace_back(worker, false);
+  }
+  worker(true);
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+struct ChunkStats {
+  std::vector<impl::StringStorage> storage;
+  std::vector<ColumnImportContext> importers;
+  impl::StringStorage surfaces;
+  Status status = Status::Ok();
+  // false if csv parsing stopped before the end of the chunk
+  bool complete = false;
+};
+
+}  // namespace
+
 Status DictionaryBuilderStorage::computeStats(StringPiece name,
-                                              util::CsvReader* csv,
+                                              StringPiece data,
                                               ProgressCallback* callback) {
+  if (numThreads > 1) {
+    return computeStatsParallel(name, data, callback);
+  }
+  util::CsvReader csv;
+  JPP_RETURN_IF_ERROR(csv.initFromMemory(data));
+  return importColumnStats(name, &csv, 0, &importers, &entries.surfaceCounter_,
+                           callback);
+}
+
+Status DictionaryBuilderStorage::importColumnStats(
+    StringPiece name, util::CsvReader* csv, i64 firstLine,
+    std::vector<ColumnImportContext>* columns, impl::StringStorage* surfaces,
+    ProgressCallback* callback) const {
   u64 numLine = 1;
   while (csv->nextLine()) {
     auto ncols = csv->numFields();
     if (maxUsedCol >= ncols) {
       return Status::InvalidParameter()
              << "when processing file: " << name << ", on line "
-             << csv->lineNumber() << " there were " << ncols
+             << firstLine + csv->lineNumber() << " there were " << ncols
              << " columns, however field " << maxFieldName
              << " is defined as column #" << maxUsedCol + 1;
     }
 
-    for (auto& imp : importers) {
+    for (auto& imp : *columns) {
       if (!imp.importFieldValue(*csv)) {
         return Status::InvalidState()
                << "when processing dictionary file " << name
                << " import failed when importing column number "
                << imp.descriptor->position << " named " << imp.descriptor->name
-               << " line #" << csv->lineNumber();
+               << " line #" << firstLine + csv->lineNumber();
       }
       if (imp.isTrieIndexed) {
-        entries.addSurface(csv->field(imp.descriptor->position - 1));
+        surfaces->increaseFieldValueCount(
+            csv->field(imp.descriptor->position - 1));
       }
     }
     if (callback != nullptr && numLine % 4096 == 0) {
@@ -98,12 +192,83 @@ Status DictionaryBuilderStorage::computeStats(StringPiece name,
   return Status::Ok();
 }
 
+Status DictionaryBuilderStorage::computeStatsParallel(
+    StringPiece name, StringPiece data, ProgressCallback* callback) {
+  auto chunks = splitCsv(data, '"', numThreads);
+  std::vector<ChunkStats> stats(chunks.size());
+
+  parallelFor(numThreads, chunks.size(), [&](size_t idx, bool isMain) {
+    auto& chunk = chunks[idx];
+    auto& result = stats[idx];
+    result.storage.resize(storage.size());
+    result.importers.resize(importers.size());
+    for (int i = 0; i < dicSpec->fields.size(); ++i) {
+      result.status = result.importers[i].initialize(i, &dicSpec->fields[i],
+                                                     result.storage);
+      if (!result.status) {
+        return;
+      }
+    }
+    util::CsvReader csv;
+    csv.initFromMemory(chunk.data);
+    // chunks have similar sizes, so the progress of one of them
+    // approximates the progress of the whole pass
+    result.status =
+        importColumnStats(name, &csv, chunk.firstLine, &result.importers,
+                          &result.surfaces, isMain ? callback : nullptr);
+    result.complete = csv.bytePosition() == csv.byteSize();
+  });
+
+  // the data after a line which could not be parsed is ignored,
+  // the same as in the sequential import
+  size_t numUsed = 0;
+  while (numUsed < stats.size()) {
+    auto& s = stats[numUsed];
+    JPP_RETURN_IF_ERROR(std::move(s.status));
+    ++numUsed;
+    if (!s.complete) {
+      break;
+    }
+  }
+
+  // merge counts for each storage in chunk order
+  std::vector<char> mergeOk(storage.size() + 1, 0);
+  parallelFor(numThreads, storage.size() + 1, [&](size_t idx, bool) {
+    bool ok = true;
+    for (size_t chunk = 0; chunk < numUsed; ++chunk) {
+      if (idx == storage.size()) {
+        ok = ok && entries.surfaceCounter_.mergeCounts(stats[chunk].surfaces);
+      } else {
+        ok = ok && storage[idx].mergeCounts(stats[chunk].storage[idx]);
+      }
+    }
+    mergeOk[idx] = ok;
+  });
+  for (auto ok : mergeOk) {
+    if (!ok) {
+      return JPPS_INVALID_STATE << "failed to merge column contents of "
+                                << name;
+    }
+  }
+
+  return Status::Ok();
+}
+
 Status DictionaryBuilderStorage::makeStorage(ProgressCallback* callback) {
-  for (int i = 0; i < storage.size(); ++i) {
-    JPP_RETURN_IF_ERROR(storage[i].makeStorage(&stringBuffers[i]));
-    if (callback != nullptr) {
-      callback->report(static_cast<u64>(i), storage.size());
+  std::vector<Status> results;
+  for (size_t i = 0; i < storage.size(); ++i) {
+    results.emplace_back(Status::Ok());
+  }
+  std::atomic<u64> numDone{0};
+  parallelFor(numThreads, storage.size(), [&](size_t idx, bool isMain) {
+    results[idx] = storage[idx].makeStorage(&stringBuffers[idx]);
+    auto done = numDone.fetch_add(1) + 1;
+    if (isMain && callback != nullptr) {
+      callback->report(done, storage.size());
     }
+  });
+  for (auto& s : results) {
+    JPP_RETURN_IF_ERROR(std::move(s));
   }
 
   for (auto& imp : importers) {
@@ -112,7 +277,11 @@ Status DictionaryBuilderStorage::makeStorage(ProgressCallback* callback) {
     auto intNum = descriptor->intStorage;
     if (intNum != spec::InvalidInt) {
       auto buffer = &intBuffers[intNum];
-      imp.importer->injectFieldBuffer(buffer);
+      i32 start = 0;
+      if (base != nullptr) {
+        start = static_cast<i32>(base->intStorages[intNum].size());
+      }
+      imp.importer->injectFieldBuffer(buffer, start);
     }
   }
   return Status::Ok();
@@ -140,11 +309,13 @@ Status DictionaryBuilderStorage::buildTrie(ProgressCallback* callback) {
   }
   auto storageIdx = importers[indexColumn].descriptor->stringStorage;
   auto& stringBuf = storage[storageIdx];
+  entries.trieBuilder.numThreads = numThreads;
   JPP_RETURN_IF_ERROR(entries.trieBuilder.buildTrie(stringBuf, callback));
   return Status::Ok();
 }
 
 Status DictionaryBuilderStorage::initialize(const s::DictionarySpec& dicSpec) {
+  this->dicSpec = &dicSpec;
   indexColumn = dicSpec.indexColumn;
 
   importers.resize(dicSpec.fields.size());
@@ -168,6 +339,26 @@ Status DictionaryBuilderStorage::initialize(const s::DictionarySpec& dicSpec) {
   return Status::Ok();
 }
 
+Status DictionaryBuilderStorage::initBase(const BuiltDictionary& dic) {
+  if (dic.stringStorages.size() != storage.size() ||
+      dic.intStorages.size() != intBuffers.size()) {
+    return JPPS_INVALID_PARAMETER
+           << "base dictionary had " << dic.stringStorages.size()
+           << " string and " << dic.intStorages.size()
+           << " int storages, spec requires " << storage.size() << " and "
+           << intBuffers.size();
+  }
+
+  // storages contain only new data, its pointers start after the base one
+  for (size_t i = 0; i < storage.size(); ++i) {
+    storage[i].setBase(dic.stringStorages[i]);
+  }
+  entries.entryDataStart = dic.entryData.size();
+
+  base = &dic;
+  return Status::Ok();
+}
+
 Status DictionaryBuilderStorage::initDicFeatures(const FeaturesSpec& dicSpec) {
   DicFeatureContext ctx{storage, importers, stringBuffers, intBuffers};
   JPP_RETURN_IF_ERROR(entries.createFeatures(dicSpec, ctx));
@@ -191,8 +382,11 @@ Status DictionaryBuilderStorage::initGroupingFields(
     entries.dedupIdxes_.push_back(dicIdx);
   }
 
-  for (auto& unk : spec.unkCreators) {
-    entries.ignoredRows[unk.patternRow] = InvalidInt;
+  // pattern rows are the ones of the base dictionary
+  if (base == nullptr) {
+    for (auto& unk : spec.unkCreators) {
+      entries.ignoredRows[unk.patternRow] = InvalidInt;
+    }
   }
 
   return Status::Ok();
@@ -40,11 +40,23 @@ struct DictionaryBuilderStorage {
   i32 maxUsedCol = -1;
   StringPiece maxFieldName;
   i32 indexColumn = -1;
+  const s::DictionarySpec* dicSpec = nullptr;
+  u32 numThreads = 1;
+  // dictionary which is extended by the one being built
+  const BuiltDictionary* base = nullptr;
 
   Status initialize(const s::DictionarySpec& dicSpec);
+  Status initBase(const BuiltDictionary& dic);
   Status initDicFeatures(const s::FeaturesSpec& dicSpec);
-  Status computeStats(StringPiece name, util::CsvReader* csv,
+  Status computeStats(StringPiece name, StringPiece data,
                       ProgressCallback* callback);
+  Status computeStatsParallel(StringPiece name, StringPiece data,
+                              ProgressCallback* callback);
+  Status importColumnStats(StringPiece name, util::CsvReader* csv,
+                           i64 firstLine,
+                           std::vector<ColumnImportContext>* columns,
+                           impl::StringStorage* surfaces,
+                           ProgressCallback* callback) const;
   Status makeStorage(ProgressCallback* callback);
   i32 importActualData(util::CsvReader* csv, ProgressCallback* callback);
   Status buildTrie(ProgressCallback* callback);
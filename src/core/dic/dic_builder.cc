@@ -15,26 +15,40 @@ namespace dic {
 using namespace core::spec;
 
 Status DictionaryBuilder::importCsv(StringPiece name, StringPiece data) {
+  return importCsvImpl(name, data, nullptr);
+}
+
+Status DictionaryBuilder::importOverlayCsv(const BuiltDictionary &base,
+                                           StringPiece name,
+                                           StringPiece data) {
+  return importCsvImpl(name, data, &base);
+}
+
+Status DictionaryBuilder::importCsvImpl(StringPiece name, StringPiece data,
+                                        const BuiltDictionary *base) {
   if (dic_) {
     return Status::InvalidState() << "dictionary was already built or restored";
   }
 
   util::CsvReader csv;
   storage_.reset(new DictionaryBuilderStorage);
+  storage_->numThreads = numThreads_;
 
   JPP_RETURN_IF_ERROR(storage_->initialize(spec_->dictionary));
+  if (base != nullptr) {
+    JPP_RETURN_IF_ERROR(storage_->initBase(*base));
+  }
   JPP_RETURN_IF_ERROR(storage_->initGroupingFields(*spec_));
-  JPP_RETURN_IF_ERROR(csv.initFromMemory(data));
 
-  // first csv pass -- compute stats
+  // first csv pass -- compute stats, in parallel over csv chunks
   newProgressStep("Compiling column contents");
-  JPP_RETURN_IF_ERROR(storage_->computeStats(name, &csv, progress_));
+  JPP_RETURN_IF_ERROR(storage_->computeStats(name, data, progress_));
 
   // build string storage and internal state for the third step
   newProgressStep("Compiling column storage");
   JPP_RETURN_IF_ERROR(storage_->makeStorage(progress_));
 
-  // reinitialize csv for second pass
+  // initialize csv for second pass
   JPP_RETURN_IF_ERROR(csv.initFromMemory(data));
 
   JPP_RETURN_IF_ERROR(storage_->initDicFeatures(spec_->features));
@@ -106,6 +120,8 @@ Status DictionaryBuilder::fillModelPart(model::ModelPart *part,
   for (auto &ib : storage_->builtInts) {
     part->data.push_back(ib);
   }
+  part->data.push_back(dic_->firstCodepointIndex);
+  part->data.push_back(dic_->codepointTrie);
 
   return Status::Ok();
 }
@@ -122,7 +138,9 @@ inline Status fixupDictionary(const model::ModelPart &dicInfo,
   auto spec_ = &dic->spec;
   i32 expectedCount =
       spec_->dictionary.numStringStorage + spec_->dictionary.numIntStorage + 4;
-  if (expectedCount != dicInfo.data.size()) {
+  // the first codepoint index and the codepoint trie are optional
+  i32 numOptional = static_cast<i32>(dicInfo.data.size()) - expectedCount;
+  if (numOptional < 0 || numOptional > 2) {
     return JPPS_INVALID_PARAMETER
            << "model file did not have all dictionary chunks";
   }
@@ -159,6 +177,13 @@ inline Status fixupDictionary(const model::ModelPart &dicInfo,
     dic->intStorages.push_back(dicInfo.data[cnt]);
     ++cnt;
   }
+  if (numOptional >= 1) {
+    dic->firstCodepointIndex = dicInfo.data[cnt];
+    ++cnt;
+  }
+  if (numOptional >= 2) {
+    dic->codepointTrie = dicInfo.data[cnt];
+  }
   if (dic->fieldData.size() != spec_->dictionary.fields.size()) {
     return JPPS_INVALID_PARAMETER << "number of columns in spec was not "
                                      "equal to loaded number of columns";
@@ -34,6 +34,12 @@ struct BuiltDictionary {
   StringPiece trieContent;
   StringPiece entryPointers;
   StringPiece entryData;
+  // can be empty for models built by older versions
+  StringPiece firstCodepointIndex;
+  StringPiece codepointTrie;
+  // prebuilt image of the first codepoint index (see model::RuntimeImage),
+  // it is not a part of the dictionary and is used instead of the index
+  StringPiece firstCodepointImage;
   std::vector<BuiltField> fieldData;
   std::vector<StringPiece> stringStorages;
   std::vector<StringPiece> intStorages;
@@ -50,8 +56,11 @@ class DictionaryBuilder {
   std::unique_ptr<BuiltDictionary> dic_;
   std::unique_ptr<DictionaryBuilderStorage> storage_;
   ProgressCallback* progress_ = nullptr;
+  u32 numThreads_ = 1;
 
   void newProgressStep(StringPiece name);
+  Status importCsvImpl(StringPiece name, StringPiece data,
+                       const BuiltDictionary* base);
 
  public:
   DictionaryBuilder();
@@ -60,9 +69,32 @@ class DictionaryBuilder {
   Status fillModelPart(model::ModelPart* part, StringPiece comment = EMPTY_SP);
   Status importSpec(spec::AnalysisSpec* spec);
   Status importCsv(StringPiece name, StringPiece data);
+
+  /**
+   * Build a dictionary which extends an already built one with entries
+   * from the csv data (e.g. a user dictionary).
+   * The spec must be the one of the base dictionary.
+   *
+   * String, int storages and entry data of the result contain only
+   * new data. Its pointers start after the end of the base data,
+   * so the result is used together with the base dictionary
+   * (see DictionaryHolder::loadOverlay) and base pointers stay valid.
+   * Only values used by the new entries are looked up in the base storages.
+   * The trie contains only the surfaces of the new entries.
+   * The base dictionary must be alive while this builder is used.
+   */
+  Status importOverlayCsv(const BuiltDictionary& base, StringPiece name,
+                          StringPiece data);
   const BuiltDictionary& result() const { return *dic_; }
   const spec::AnalysisSpec& spec() const { return *spec_; }
   void setProgress(ProgressCallback* callback) { progress_ = callback; }
+
+  /**
+   * Column contents and storage are computed using this number of threads.
+   * Built dictionary does not depend on the number of threads.
+   * Entries and trie are always built by a single thread.
+   */
+  void setNumThreads(u32 numThreads) { numThreads_ = numThreads; }
 };
 
 }  // namespace dic
@@ -7,7 +7,9 @@
 
 #include <array>
 #include "core/core_types.h"
+#include "core/dic/codepoint_trie.h"
 #include "core/dic/darts_trie.h"
+#include "core/dic/first_codepoint_index.h"
 #include "core_config.h"
 #include "field_reader.h"
 #include "util/array_slice.h"
@@ -193,6 +195,8 @@ struct EntriesHolder {
   i32 numData;
   impl::IntStorageReader entries;
   impl::IntStorageReader entryPtrs;
+  FirstCodepointIndex firstCodepoints;
+  CodepointTrie codepointTrie;
 
   IndexedEntries entryTraversal(i32 ptr) const {
     auto entries = entryPtrs.listAt(ptr);
@@ -207,6 +211,8 @@ class IndexTraversal {
  public:
   explicit IndexTraversal(const EntriesHolder* dic_)
       : da_(dic_->trie.traversal()), dic_(dic_) {}
+  IndexTraversal(const EntriesHolder* dic_, const FirstCodepointInfo& info)
+      : da_(dic_->trie.traversalAt(info.nodePos, info.value)), dic_(dic_) {}
   TraverseStatus step(StringPiece sp) { return da_.step(sp); }
   IndexedEntries entries() const { return dic_->entryTraversal(da_.value()); }
 };
@@ -221,6 +227,30 @@ class DictionaryEntries {
   i32 numData() const { return static_cast<i32>(data_->numData); }
 
   IndexTraversal traversal() const { return IndexTraversal(data_); }
+
+  const FirstCodepointIndex& firstCodepoints() const {
+    return data_->firstCodepoints;
+  }
+
+  /**
+   * Traversal which has already consumed the first codepoint
+   */
+  IndexTraversal traversalAfter(const FirstCodepointInfo& info) const {
+    return IndexTraversal(data_, info);
+  }
+
+  IndexedEntries entriesOf(const FirstCodepointInfo& info) const {
+    return data_->entryTraversal(info.value);
+  }
+
+  /**
+   * Can be unloaded for models which were built before it existed
+   */
+  const CodepointTrie& codepointTrie() const { return data_->codepointTrie; }
+
+  IndexedEntries entryTraversal(const CodepointTrieTraversal& at) const {
+    return data_->entryTraversal(at.value());
+  }
   DoubleArrayTraversal doubleArrayTraversal() const {
     return data_->trie.traversal();
   }
@@ -241,6 +271,13 @@ class DictionaryEntries {
   }
 
   const impl::IntStorageReader& entryData() const { return data_->entries; }
+
+  /**
+   * Lists of entry pointers for all dictionary keys, stored one after another
+   */
+  const impl::IntStorageReader& entryPointers() const {
+    return data_->entryPtrs;
+  }
 };
 
 }  // namespace dic
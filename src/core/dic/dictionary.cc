@@ -16,10 +16,19 @@ Status fillEntriesHolder(const BuiltDictionary& dic, EntriesHolder* result) {
   result->numData = static_cast<i32>(dic.spec.features.numDicData);
   result->entries = impl::IntStorageReader{dic.entryData};
   result->entryPtrs = impl::IntStorageReader{dic.entryPointers};
+  if (dic.firstCodepointImage.size() != 0) {
+    JPP_RETURN_IF_ERROR(
+        result->firstCodepoints.loadImage(dic.firstCodepointImage));
+  } else if (dic.firstCodepointIndex.size() != 0) {
+    JPP_RETURN_IF_ERROR(
+        result->firstCodepoints.load(dic.firstCodepointIndex));
+  }
+  JPP_RETURN_IF_ERROR(result->codepointTrie.load(dic.codepointTrie));
   return result->trie.loadFromMemory(dic.trieContent);
 }
 
 Status FieldsHolder::load(const BuiltDictionary& dic) {
+  fields_.clear();
   for (i32 index = 0; index < dic.fieldData.size(); ++index) {
     auto& f = dic.fieldData[index];
     auto& sf = dic.spec.dictionary.fields[f.specIndex];
@@ -40,8 +49,51 @@ Status FieldsHolder::load(const BuiltDictionary& dic) {
 }
 
 Status DictionaryHolder::load(const BuiltDictionary& dic) {
-  JPP_RETURN_IF_ERROR(fields_.load(dic));
-  JPP_RETURN_IF_ERROR(fillEntriesHolder(dic, &entries_));
+  JPP_RETURN_IF_ERROR(loadFields(dic));
+  return loadEntries(dic);
+}
+
+Status DictionaryHolder::loadFields(const BuiltDictionary& dic) {
+  return fields_.load(dic);
+}
+
+Status DictionaryHolder::loadEntries(const BuiltDictionary& dic) {
+  return fillEntriesHolder(dic, &entries_);
+}
+
+Status FieldsHolder::loadOverlay(const BuiltDictionary& overlay) {
+  if (overlay.fieldData.size() != fields_.size()) {
+    return JPPS_INVALID_PARAMETER
+           << "overlay dictionary had " << overlay.fieldData.size()
+           << " fields, loaded one has " << fields_.size();
+  }
+  for (i32 index = 0; index < fields_.size(); ++index) {
+    auto& f = overlay.fieldData[index];
+    auto& df = fields_[index];
+    if (f.stringStorageIdx != df.stringStorageIdx) {
+      return JPPS_INVALID_PARAMETER << "overlay field " << df.name
+                                    << " had a different string storage";
+    }
+    df.postions =
+        impl::IntStorageReader{df.postions.data(), f.fieldContent};
+    df.strings = impl::StringStorageReader{
+        df.strings.data(), df.alignPower, f.stringContent};
+  }
+  return Status::Ok();
+}
+
+Status DictionaryHolder::loadOverlay(const BuiltDictionary& overlay) {
+  if (overlay_ != nullptr) {
+    return JPPS_INVALID_STATE << "dictionary already had an overlay";
+  }
+  std::unique_ptr<EntriesHolder> holder{new EntriesHolder};
+  JPP_RETURN_IF_ERROR(fillEntriesHolder(overlay, holder.get()));
+  JPP_RETURN_IF_ERROR(fields_.loadOverlay(overlay));
+  // entries of both tries point into the same data
+  entries_.entries =
+      impl::IntStorageReader{entries_.entries.data(), overlay.entryData};
+  holder->entries = entries_.entries;
+  overlay_ = std::move(holder);
   return Status::Ok();
 }
 
@@ -50,12 +50,18 @@ class FieldsHolder {
 
   Status load(const BuiltDictionary& dic);
 
+  /**
+   * Make field readers use overlay data after the loaded one
+   */
+  Status loadOverlay(const BuiltDictionary& overlay);
+
   u32 totalFields() const { return fields_.size(); }
 };
 
 class DictionaryHolder {
   EntriesHolder entries_;
   FieldsHolder fields_;
+  std::unique_ptr<EntriesHolder> overlay_;
 
  public:
   const DictionaryField* fieldByName(StringPiece name) const {
@@ -66,6 +72,28 @@ class DictionaryHolder {
   DictionaryEntries entries() const { return DictionaryEntries{&entries_}; }
 
   Status load(const BuiltDictionary& dic);
+  /**
+   * Two parts of load: field readers and tries with entry pointers.
+   * They are separate only to measure their startup time.
+   */
+  Status loadFields(const BuiltDictionary& dic);
+  Status loadEntries(const BuiltDictionary& dic);
+
+  /**
+   * Add entries of a dictionary which was built as an overlay of the loaded
+   * one (see DictionaryBuilder::importOverlayCsv).
+   * Readers of fields and entry data use the overlay data for pointers
+   * after the end of the loaded data, so existing pointers stay valid
+   * and the loaded data is not copied.
+   * Needs to be called before creating features and analyzers.
+   * An overlay can be loaded only once, reloading needs a new holder.
+   */
+  Status loadOverlay(const BuiltDictionary& overlay);
+
+  bool hasOverlay() const { return overlay_ != nullptr; }
+  DictionaryEntries overlayEntries() const {
+    return DictionaryEntries{overlay_.get()};
+  }
 };
 
 Status fillEntriesHolder(const BuiltDictionary& dic, EntriesHolder* result);
@@ -3,6 +3,8 @@
 //
 
 #include "dictionary.h"
+#include <algorithm>
+#include <random>
 #include "core/dic/dic_builder.h"
 #include "core/dic/dic_entries.h"
 #include "core/spec/spec_dsl.h"
@@ -18,6 +20,8 @@ class TestStringColumn {
 
  public:
   TestStringColumn(StringPiece data, u32 align) : rdr_{data, align} {}
+  TestStringColumn(StringPiece data, u32 align, StringPiece overlay)
+      : rdr_{data, align, overlay} {}
   StringPiece operator[](i32 pos) {
     StringPiece pc;
     REQUIRE(rdr_.readAt(pos, &pc));
@@ -83,6 +87,16 @@ struct DataTester {
     entrs.reset(new DictionaryEntries{&holder});
   }
 
+  DataTester(const BuiltDictionary& base, const BuiltDictionary& overlay) {
+    for (int i = 0; i < overlay.fieldData.size(); ++i) {
+      columns.emplace_back(base.fieldData[i].stringContent, 0,
+                           overlay.fieldData[i].stringContent);
+    }
+    CHECK_OK(fillEntriesHolder(overlay, &holder));
+    holder.entries = impl::IntStorageReader{base.entryData, overlay.entryData};
+    entrs.reset(new DictionaryEntries{&holder});
+  }
+
   TesterStep operator()() { return TesterStep{columns, entrs->traversal()}; }
 };
 
@@ -118,6 +132,22 @@ TEST_CASE("small dictionary is imported") {
   tester().step("e", TraverseStatus::Ok).fillEntries().strings({"e", "f"});
 }
 
+TEST_CASE("first codepoint index is built only without a codepoint trie") {
+  TesterSpec test;
+  DictionaryBuilder bldr;
+  CHECK_OK(bldr.importSpec(&test.spec));
+  CHECK_OK(bldr.importCsv("data", "a,b\nc,d"));
+  CHECK(bldr.result().codepointTrie.size() != 0);
+  CHECK(bldr.result().firstCodepointIndex.size() == 0);
+
+  // keys which are not valid UTF-8 can not be stored in a codepoint trie
+  DictionaryBuilder invalid;
+  CHECK_OK(invalid.importSpec(&test.spec));
+  CHECK_OK(invalid.importCsv("data", "a\xff,b\nc,d"));
+  CHECK(invalid.result().codepointTrie.size() == 0);
+  CHECK(invalid.result().firstCodepointIndex.size() != 0);
+}
+
 TEST_CASE("small substring-only is imported") {
   TesterSpec test;
   StringPiece data{"abc,b\nab,d\na,f\nabcd,f"};
@@ -236,3 +266,194 @@ TEST_CASE("small dictionary where one of lines is corrupted is not imported") {
   CHECK_THAT(status.message().str(), Catch::Contains("there were 1 columns"));
   CHECK_THAT(status.message().str(), Catch::Contains("on line 2"));
 }
+
+namespace {
+
+std::string makeParallelTestCsv(int numLines) {
+  std::minstd_rand rng{5};
+  std::uniform_int_distribution<int> letters{'a', 'h'};
+  std::uniform_int_distribution<int> lengths{1, 4};
+  auto word = [&]() {
+    std::string result;
+    for (int i = lengths(rng); i > 0; --i) {
+      result.push_back(static_cast<char>(letters(rng)));
+    }
+    return result;
+  };
+
+  std::string csv;
+  for (int line = 0; line < numLines; ++line) {
+    csv += word();
+    csv += ',';
+    if (line % 7 == 0) {
+      // quoted field with a line break
+      csv += "\"" + word() + ",\n" + word() + "\"";
+    } else {
+      csv += word();
+    }
+    csv += ',';
+    csv += word() + " " + word();
+    csv += ',';
+    csv += word() + ":" + word() + " " + word();
+    csv += line % 5 == 0 ? "\r\n" : "\n";
+  }
+  return csv;
+}
+
+void checkSameDictionary(const BuiltDictionary& d1,
+                         const BuiltDictionary& d2) {
+  CHECK(d1.entryCount == d2.entryCount);
+  CHECK(d1.trieContent == d2.trieContent);
+  CHECK(d1.entryPointers == d2.entryPointers);
+  CHECK(d1.entryData == d2.entryData);
+  CHECK(d1.firstCodepointIndex == d2.firstCodepointIndex);
+  CHECK(d1.codepointTrie == d2.codepointTrie);
+  REQUIRE(d1.stringStorages.size() == d2.stringStorages.size());
+  for (int i = 0; i < d1.stringStorages.size(); ++i) {
+    CHECK(d1.stringStorages[i] == d2.stringStorages[i]);
+  }
+  REQUIRE(d1.intStorages.size() == d2.intStorages.size());
+  for (int i = 0; i < d1.intStorages.size(); ++i) {
+    CHECK(d1.intStorages[i] == d2.intStorages[i]);
+  }
+  REQUIRE(d1.fieldData.size() == d2.fieldData.size());
+  for (int i = 0; i < d1.fieldData.size(); ++i) {
+    CHECK(d1.fieldData[i].uniqueValues == d2.fieldData[i].uniqueValues);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("dictionary imported by several threads is the same") {
+  dsl::ModelSpecBuilder mb;
+  auto& fa = mb.field(1, "a").strings().trieIndex();
+  auto& fb = mb.field(2, "b").strings().stringStorage(fa);
+  mb.field(3, "c").stringLists();
+  mb.field(4, "d").kvLists();
+  mb.unigram({fa, fb});
+  AnalysisSpec spec;
+  REQUIRE_OK(mb.build(&spec));
+
+  auto data = makeParallelTestCsv(3000);
+  DictionaryBuilder single;
+  REQUIRE_OK(single.importSpec(&spec));
+  REQUIRE_OK(single.importCsv("data", data));
+
+  for (u32 threads : {2, 3, 8}) {
+    CAPTURE(threads);
+    DictionaryBuilder parallel;
+    parallel.setNumThreads(threads);
+    REQUIRE_OK(parallel.importSpec(&spec));
+    REQUIRE_OK(parallel.importCsv("data", data));
+    checkSameDictionary(single.result(), parallel.result());
+  }
+}
+
+TEST_CASE("dictionary imported by several threads reports error lines") {
+  TesterSpec test;
+  std::string data;
+  for (int i = 0; i < 100; ++i) {
+    data += "a,b\n";
+  }
+  data += "d\n";
+  for (int i = 0; i < 100; ++i) {
+    data += "e,f\n";
+  }
+  DictionaryBuilder bldr;
+  bldr.setNumThreads(4);
+  CHECK_OK(bldr.importSpec(&test.spec));
+  auto status = bldr.importCsv("data", data);
+  CHECK_FALSE(status);
+  CHECK_THAT(status.message().str(), Catch::Contains("on line 101"));
+}
+
+TEST_CASE("overlay dictionary extends the base one") {
+  TesterSpec test;
+  StringPiece baseData{"a,b\nc,d\ne,f"};
+  DictionaryBuilder base;
+  REQUIRE_OK(base.importSpec(&test.spec));
+  REQUIRE_OK(base.importCsv("base", baseData));
+
+  StringPiece data{"c,x\ng,b\ngh,y\ng,d"};
+  DictionaryBuilder overlay;
+  REQUIRE_OK(overlay.importSpec(&test.spec));
+  REQUIRE_OK(overlay.importOverlayCsv(base.result(), "overlay", data));
+  auto& dic = overlay.result();
+  CHECK(dic.entryCount == 4);
+
+  // the overlay contains only new data
+  auto& baseDic = base.result();
+  auto valuesOf = [](StringPiece storage) {
+    std::vector<std::string> result;
+    impl::StringStorageTraversal trav{storage, 0};
+    StringPiece value;
+    while (trav.next(&value)) {
+      result.push_back(value.str());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+  REQUIRE(dic.fieldData.size() == 2);
+  CHECK(valuesOf(dic.fieldData[0].stringContent) ==
+        std::vector<std::string>({"g", "gh"}));
+  CHECK(valuesOf(dic.fieldData[1].stringContent) ==
+        std::vector<std::string>({"x", "y"}));
+
+  // trie of the overlay contains only its own entries
+  DataTester tester{baseDic, dic};
+  tester().step("c", TraverseStatus::Ok).fillEntries().strings({"c", "x"});
+  tester()
+      .step("g", TraverseStatus::Ok)
+      .fillEntries()
+      .strings({"g", "b"})
+      .strings({"g", "d"})
+      .step("h", TraverseStatus::Ok)
+      .fillEntries()
+      .strings({"gh", "y"});
+  tester().step("a", TraverseStatus::NoNode);
+
+  // existing values keep their pointers
+  DataTester baseTester{baseDic};
+  auto baseStep = baseTester();
+  baseStep.step("c", TraverseStatus::Ok).fillEntries().strings({"c", "d"});
+  auto overlayStep = tester();
+  overlayStep.step("g", TraverseStatus::Ok)
+      .fillEntries()
+      .strings({"g", "b"})
+      .strings({"g", "d"});
+  CHECK(overlayStep.entry.features()[1] == baseStep.entry.features()[1]);
+
+  // base entries are readable together with the overlay
+  DictionaryHolder holder;
+  REQUIRE_OK(holder.load(baseDic));
+  REQUIRE_OK(holder.loadOverlay(dic));
+  REQUIRE(holder.hasOverlay());
+  CHECK_FALSE(holder.loadOverlay(dic));
+  auto trav = holder.entries().traversal();
+  REQUIRE(trav.step("e") == TraverseStatus::Ok);
+  auto entries = trav.entries();
+  DicEntryBuffer entry;
+  REQUIRE(entries.readOnePtr());
+  REQUIRE(entries.fillEntryData(&entry));
+  StringPiece value;
+  REQUIRE(holder.fields().at(0).strings.readAt(entry.features()[0], &value));
+  CHECK(value == "e");
+  REQUIRE(holder.fields().at(1).strings.readAt(entry.features()[1], &value));
+  CHECK(value == "f");
+
+  auto overlayTrav = holder.overlayEntries().traversal();
+  REQUIRE(overlayTrav.step("gh") == TraverseStatus::Ok);
+  auto overlayEntries = overlayTrav.entries();
+  REQUIRE(overlayEntries.readOnePtr());
+  REQUIRE(overlayEntries.fillEntryData(&entry));
+  REQUIRE(holder.fields().at(0).strings.readAt(entry.features()[0], &value));
+  CHECK(value == "gh");
+  REQUIRE(holder.fields().at(1).strings.readAt(entry.features()[1], &value));
+  CHECK(value == "y");
+
+  DictionaryBuilder parallel;
+  parallel.setNumThreads(2);
+  REQUIRE_OK(parallel.importSpec(&test.spec));
+  REQUIRE_OK(parallel.importOverlayCsv(baseDic, "overlay", data));
+  checkSameDictionary(dic, parallel.result());
+}
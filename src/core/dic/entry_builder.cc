@@ -3,6 +3,7 @@
 //
 
 #include "entry_builder.h"
+#include <thread>
 #include "dic_build_detail.h"
 #include "util/logging.hpp"
 
@@ -21,9 +22,37 @@ Status DicTrieBuilder::buildTrie(const impl::StringStorage& strings,
       auto entriesPtr = static_cast<i32>(entryPtrBuffer.position());
       impl::writePtrsAsDeltas(entries, entryPtrBuffer);
       daBuilder.add(key, entriesPtr);
+      codepointTrie.add(key, entriesPtr);
     }
   }
-  return daBuilder.build(progress);
+  // the tries are independent, so the codepoint one can be built
+  // while the main one is being built
+  Status codepointStatus = Status::Ok();
+  std::thread codepointThread;
+  if (numThreads > 1) {
+    codepointThread = std::thread{[this, &codepointStatus]() {
+      codepointStatus = codepointTrie.build();
+    }};
+  }
+  auto status = daBuilder.build(progress);
+  if (codepointThread.joinable()) {
+    codepointThread.join();
+  } else if (status) {
+    codepointStatus = codepointTrie.build();
+  }
+  JPP_RETURN_IF_ERROR(std::move(status));
+  JPP_RETURN_IF_ERROR(std::move(codepointStatus));
+  if (codepointTrie.result().size() != 0) {
+    // lookups use only the codepoint trie when it exists
+    return Status::Ok();
+  }
+
+  for (auto& v : strings) {
+    if (entriesWithField.find(v.second) != entriesWithField.end()) {
+      firstCodepoints.add(v.first);
+    }
+  }
+  return firstCodepoints.build(daBuilder.result());
 }
 
 i32 EntryTableBuilder::importOneLine(std::vector<ColumnImportContext>& columns,
@@ -156,7 +185,7 @@ void DicEntryData::addData(EntryTableBuilder* bldr,
 
 i32 DicEntryData::write(EntryTableBuilder* bldr) {
   auto& buf = bldr->entryDataBuffer;
-  auto ptr = buf.position();
+  u64 ptr = bldr->entryDataStart + buf.position();
   for (auto f : features) {
     buf.writeVarint(static_cast<u32>(f));
   }
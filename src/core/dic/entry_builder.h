@@ -5,8 +5,10 @@
 #ifndef JUMANPP_ENTRY_BUILDER_H
 #define JUMANPP_ENTRY_BUILDER_H
 
+#include "core/dic/codepoint_trie.h"
 #include "core/dic/darts_trie.h"
 #include "core/dic/dic_feature_impl.h"
+#include "core/dic/first_codepoint_index.h"
 #include "core/dic/field_import.h"
 #include "core/dic/progress.h"
 #include "util/coded_io.h"
@@ -25,7 +27,10 @@ struct DicTrieBuilder {
   util::CodedBuffer entryPtrBuffer;
   util::FlatMap<i32, util::InlinedVector<i32, 4>> entriesWithField;
   DoubleArrayBuilder daBuilder;
+  FirstCodepointIndexBuilder firstCodepoints;
+  CodepointTrieBuilder codepointTrie;
   ProgressCallback* callback = nullptr;
+  u32 numThreads = 1;
 
   void addEntry(i32 fieldValue, i32 entryPtr) {
     entriesWithField[fieldValue].push_back(entryPtr);
@@ -67,6 +72,8 @@ struct EntryTableBuilder {
    */
   util::FlatMap<i32, i32> ignoredRows;
   util::CodedBuffer entryDataBuffer;
+  // entry pointers of a dictionary extending another one start after it
+  size_t entryDataStart = 0;
   DicTrieBuilder trieBuilder;
   impl::StringStorage surfaceCounter_;
   DicEntryBag entryBag;
@@ -4,6 +4,7 @@
 
 #include "field_import.h"
 #include <algorithm>
+#include "core/dic/field_reader.h"
 #include "util/memory.hpp"
 
 namespace jumanpp {
@@ -38,7 +39,7 @@ i32 StringListFieldImporter::fieldPointer(const util::CsvReader& csv) {
     sp = StringPiece{space + 1, sp.end()};
   }
 
-  i32 result = static_cast<i32>(buffer_->position());
+  i32 result = bufferStart_ + static_cast<i32>(buffer_->position());
   writePtrsAsDeltas(values_, *buffer_);
   return result;
 }
@@ -61,10 +62,14 @@ bool StringListFieldImporter::importFieldValue(const util::CsvReader& csv) {
   return true;
 }
 
-void StringListFieldImporter::injectFieldBuffer(util::CodedBuffer* buffer) {
+void StringListFieldImporter::injectFieldBuffer(util::CodedBuffer* buffer,
+                                                i32 start) {
   buffer_ = buffer;
-  // put zero (zero length sequence) at the beginning
-  buffer->writeVarint(0);
+  bufferStart_ = start;
+  if (start == 0) {
+    // put zero (zero length sequence) at the beginning
+    buffer->writeVarint(0);
+  }
 }
 
 IntFieldImporter::IntFieldImporter(i32 field)
@@ -85,10 +90,64 @@ bool IntFieldImporter::importString(StringPiece sp) {
   return std::regex_match(sp.char_begin(), sp.char_end(), mr_, re_);
 }
 
+bool StringStorage::mergeCounts(const StringStorage& other) {
+  for (auto sp : other.keys_) {
+    auto count = other.mapping_.find(sp)->second;
+    auto it = mapping_.find(sp);
+    if (it != mapping_.end()) {
+      it->second += count;
+      continue;
+    }
+    JPP_RET_CHECK(contents_.import(&sp));
+    mapping_[sp] = count;
+    keys_.push_back(sp);
+  }
+  return true;
+}
+
+void StringStorage::resolveBaseValues(Mapping* result) const {
+  // the base storage is scanned once without building a map of its values,
+  // only values with the same first byte and length as new ones are looked up
+  constexpr size_t MaxFilterLength = 64;
+  std::vector<u64> filter(256, 0);
+  auto filterBit = [](StringPiece sp) {
+    return u64{1} << std::min(sp.size(), MaxFilterLength - 1);
+  };
+  for (auto& obj : mapping_) {
+    if (obj.first.size() != 0) {
+      filter[static_cast<u8>(obj.first[0])] |= filterBit(obj.first);
+    }
+  }
+
+  // the empty string is always at 0
+  if (mapping_.count(EMPTY_SP) != 0) {
+    result->insert({EMPTY_SP, 0});
+  }
+
+  StringStorageTraversal trav{base_, static_cast<u32>(alignmentPower)};
+  StringPiece value;
+  while (trav.next(&value)) {
+    if (value.size() == 0 ||
+        (filter[static_cast<u8>(value[0])] & filterBit(value)) == 0) {
+      continue;
+    }
+    if (mapping_.count(value) != 0) {
+      result->insert({value, trav.position()});
+    }
+  }
+}
+
 Status StringStorage::makeStorage(util::CodedBuffer* result) {
+  Mapping existing;
+  if (!base_.empty()) {
+    resolveBaseValues(&existing);
+  }
+
   std::vector<std::pair<StringPiece, i32>> forSort;
   for (auto& obj : mapping_) {
-    forSort.emplace_back(obj.first, obj.second);
+    if (existing.count(obj.first) == 0) {
+      forSort.emplace_back(obj.first, obj.second);
+    }
   }
 
   std::sort(forSort.begin(), forSort.end(),
@@ -97,8 +156,15 @@ Status StringStorage::makeStorage(util::CodedBuffer* result) {
   util::CodedBuffer& buf = *result;
 
   using util::memory::Align;
-  // always put empty string at 0
-  buf.writeString("");
+  size_t start = 0;
+  if (base_.empty()) {
+    // always put empty string at 0
+    buf.writeString("");
+  } else {
+    // base storage already has it
+    start = StringStorageReader::overlayStart(
+        base_, static_cast<u32>(alignmentPower));
+  }
 
   for (const auto& obj : forSort) {
     auto position = buf.position();
@@ -106,18 +172,25 @@ Status StringStorage::makeStorage(util::CodedBuffer* result) {
     for (auto i = position; i < alignedPosition; ++i) {
       buf.writeVarint(0);
     }
-    auto ptr = static_cast<i32>(alignedPosition >> alignmentPower);
+    auto ptr = static_cast<i32>((start + alignedPosition) >> alignmentPower);
     mapping_[obj.first] = ptr;
     buf.writeString(obj.first);
   }
 
+  for (auto& obj : existing) {
+    mapping_[obj.first] = obj.second;
+  }
+
   return Status::Ok();
 }
 
 void StringKeyValueListFieldImporter::injectFieldBuffer(
-    util::CodedBuffer* buffer) {
+    util::CodedBuffer* buffer, i32 start) {
   buffer_ = buffer;
-  buffer->writeVarint(0);
+  bufferStart_ = start;
+  if (start == 0) {
+    buffer->writeVarint(0);
+  }
 }
 
 bool StringKeyValueListFieldImporter::importFieldValue(
@@ -223,7 +296,7 @@ i32 StringKeyValueListFieldImporter::fieldPointer(const util::CsvReader& csv) {
   i32 ptr;
   auto serialized = local_.contents();
   if (!positionCache_.tryFind(serialized, &ptr)) {
-    ptr = static_cast<i32>(buffer_->position());
+    ptr = bufferStart_ + static_cast<i32>(buffer_->position());
     buffer_->writeStringDataWithoutLengthPrefix(serialized);
     if (!charBuf_.import(&serialized)) {
       return -1;
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <regex>
+#include <vector>
 #include "util/char_buffer.h"
 #include "util/coded_io.h"
 #include "util/csv_reader.h"
@@ -47,7 +48,12 @@ class FieldImporter {
    * @return
    */
   virtual Status makeStorage(util::CodedBuffer* result) = 0;
-  virtual void injectFieldBuffer(util::CodedBuffer* buffer){};
+  /**
+   * Set the buffer for list values of the field.
+   * Pointers to the values start from the passed position,
+   * which is not 0 when the buffer extends an already built dictionary.
+   */
+  virtual void injectFieldBuffer(util::CodedBuffer* buffer, i32 start){};
   virtual i32 fieldPointer(const util::CsvReader& csv) = 0;
   virtual i32 uniqueValues() const = 0;
   virtual ~FieldImporter() {}
@@ -66,9 +72,15 @@ class StringStorage {
    *
    */
   Mapping mapping_;
+  // keys in the order of their first occurrence
+  std::vector<StringPiece> keys_;
   util::CharBuffer<> contents_;
   i32 alignmentPower = 0;
   size_t alignment = 1;
+  // contents of the storage which this one extends
+  StringPiece base_;
+
+  void resolveBaseValues(Mapping* result) const;
 
  public:
   bool increaseFieldValueCount(StringPiece sp) {
@@ -77,12 +89,32 @@ class StringStorage {
     if (mapping_.count(sp) == 0) {
       JPP_RET_CHECK(contents_.import(&sp));
       mapping_[sp] = 1;
+      keys_.push_back(sp);
     } else {
       mapping_[sp] += 1;
     }
     return true;
   }
 
+  /**
+   * Add value counts of other storage, as if its values were
+   * counted after the values of this one.
+   *
+   * New keys are inserted in the order of their first occurrence,
+   * so the resulting storage is exactly the same as if all values were
+   * counted by a single storage.
+   */
+  bool mergeCounts(const StringStorage& other);
+
+  /**
+   * Make this storage an extension of an already built one.
+   * Values which are present in the base storage get their pointers,
+   * the built storage contains only new values and their pointers start
+   * after the end of the base one (see StringStorageReader).
+   * Base data must be alive while the storage is used.
+   */
+  void setBase(StringPiece data) { base_ = data; }
+
   Status makeStorage(util::CodedBuffer* result);
 
   i32 valueOf(StringPiece sp) const {
@@ -150,6 +182,7 @@ class StringListFieldImporter : public StringFieldImporter {
    * This will hold individual list data
    */
   util::CodedBuffer* buffer_;
+  i32 bufferStart_ = 0;
   std::vector<i32> values_;
 
  public:
@@ -158,13 +191,14 @@ class StringListFieldImporter : public StringFieldImporter {
 
   bool importFieldValue(const util::CsvReader& csv) override;
 
-  void injectFieldBuffer(util::CodedBuffer* buffer) override;
+  void injectFieldBuffer(util::CodedBuffer* buffer, i32 start) override;
 
   i32 fieldPointer(const util::CsvReader& csv) override;
 };
 
 class StringKeyValueListFieldImporter : public StringFieldImporter {
   util::CodedBuffer* buffer_ = nullptr;
+  i32 bufferStart_ = 0;
   util::CodedBuffer local_;
   std::vector<std::pair<i32, i32>> values_{};
   util::CharBuffer<> charBuf_;
@@ -182,7 +216,7 @@ class StringKeyValueListFieldImporter : public StringFieldImporter {
         entrySeparator_{entrySeparator.str()},
         kvSeparator_{kvSeparator.str()} {}
 
-  void injectFieldBuffer(util::CodedBuffer* buffer) override;
+  void injectFieldBuffer(util::CodedBuffer* buffer, i32 start) override;
 
   bool importFieldValue(const util::CsvReader& csv) override;
 
@@ -103,7 +103,7 @@ TEST_CASE("string list field processes input") {
   util::CodedBuffer fieldData;
   StringStorage ss;
   StringListFieldImporter imp{&ss, 0, ""};
-  imp.injectFieldBuffer(&fieldData);
+  imp.injectFieldBuffer(&fieldData, 0);
   util::CsvReader csv;
   CHECK_OK(csv.initFromMemory(testdata));
   CHECK(feedData(csv, imp));
@@ -13,27 +13,53 @@ namespace core {
 namespace dic {
 namespace impl {
 
+/**
+ * Strings of a dictionary field.
+ *
+ * Storages of user dictionaries contain only the strings which
+ * were not present in the model one (overlay).
+ * Their pointers start after the aligned end of the model storage.
+ */
 class StringStorageReader {
   StringPiece data_;
   u32 alignPower_;
+  StringPiece overlay_;
+  size_t overlayStart_;
+
+  StringPiece from(ptrdiff_t realPtr) const noexcept {
+    if (JPP_LIKELY(static_cast<size_t>(realPtr) < data_.size())) {
+      return data_.from(realPtr);
+    }
+    JPP_DCHECK_IN(realPtr - overlayStart_, 0, overlay_.size());
+    return overlay_.from(realPtr - overlayStart_);
+  }
 
  public:
   explicit StringStorageReader(StringPiece obj, u32 alignPower) noexcept
-      : data_{obj}, alignPower_{alignPower} {}
-
+      : StringStorageReader(obj, alignPower, EMPTY_SP) {}
+
+  StringStorageReader(StringPiece obj, u32 alignPower,
+                      StringPiece overlay) noexcept
+      : data_{obj},
+        alignPower_{alignPower},
+        overlay_{overlay},
+        overlayStart_{overlayStart(obj, alignPower)} {}
+
+  /**
+   * Data of the model storage, without the overlay
+   */
   StringPiece data() const noexcept { return data_; }
+  StringPiece overlay() const noexcept { return overlay_; }
 
   bool readAt(i32 ptr, StringPiece* ret) const noexcept {
     ptrdiff_t realPtr = static_cast<ptrdiff_t>(ptr) << alignPower_;
-    JPP_DCHECK_IN(realPtr, 0, data_.size());
-    util::CodedBufferParser parser{data_.from(realPtr)};
+    util::CodedBufferParser parser{from(realPtr)};
     return parser.readStringPiece(ret);
   }
 
   i32 lengthOf(i32 ptr) {
     ptrdiff_t realPtr = static_cast<ptrdiff_t>(ptr) << alignPower_;
-    JPP_DCHECK_IN(realPtr, 0, data_.size());
-    util::CodedBufferParser parser{data_.from(realPtr)};
+    util::CodedBufferParser parser{from(realPtr)};
     i32 value = -1;
     parser.readInt(&value);
     return value;
@@ -41,9 +67,7 @@ class StringStorageReader {
 
   i32 numCodepoints(i32 ptr) {
     ptrdiff_t realPtr = static_cast<ptrdiff_t>(ptr) << alignPower_;
-    JPP_DCHECK_IN(realPtr, 0, data_.size());
-    auto start = data_.from(realPtr);
-    util::CodedBufferParser parser{start};
+    util::CodedBufferParser parser{from(realPtr)};
     StringPiece result;
     if (parser.readStringPiece(&result)) {
       return chars::numCodepoints(result);
@@ -52,6 +76,11 @@ class StringStorageReader {
   }
 
   u32 alignPower() const { return alignPower_; }
+
+  static size_t overlayStart(StringPiece data, u32 alignPower) noexcept {
+    auto alignment = size_t{1} << alignPower;
+    return (data.size() + alignment - 1) & ~(alignment - 1);
+  }
 };
 
 class IntListTraversal {
@@ -151,26 +180,44 @@ class KeyValueListTraversal {
   inline bool hasNext() const noexcept { return position_ < length_; }
 };
 
+/**
+ * Int lists of a dictionary field or dictionary entries.
+ *
+ * The same as for strings, the overlay contains only the data of
+ * user dictionaries and its pointers start after the model data.
+ */
 class IntStorageReader {
   StringPiece data_;
+  StringPiece overlay_;
+
+  StringPiece from(i32 ptr) const noexcept {
+    if (JPP_LIKELY(static_cast<size_t>(ptr) < data_.size())) {
+      return data_.from(ptr);
+    }
+    JPP_DCHECK_IN(ptr - data_.size(), 0, overlay_.size());
+    return overlay_.from(ptr - data_.size());
+  }
 
  public:
   IntStorageReader() noexcept = default;
   explicit IntStorageReader(StringPiece obj) noexcept : data_{obj} {}
+  IntStorageReader(StringPiece obj, StringPiece overlay) noexcept
+      : data_{obj}, overlay_{overlay} {}
 
   IntListTraversal raw() const { return rawWithLimit(0, data_.size()); }
 
   IntListTraversal rawWithLimit(i32 ptr, i32 length) const {
-    JPP_DCHECK_IN(ptr, 0, data_.size());
+    JPP_DCHECK_IN(ptr, 0, size());
     JPP_DCHECK_GE(length, 0);
-    JPP_DCHECK_LE(length, data_.size() - ptr);  // this is a lower bound
-    util::CodedBufferParser parser{data_.from(ptr)};
+    util::CodedBufferParser parser{from(ptr)};
+    // this is a lower bound
+    JPP_DCHECK_LE(length, parser.remaining());
     return IntListTraversal{length, parser};
   }
 
   IntListTraversal listAt(i32 ptr) const noexcept {
-    JPP_DCHECK_IN(ptr, 0, data_.size());
-    util::CodedBufferParser parser{data_.from(ptr)};
+    JPP_DCHECK_IN(ptr, 0, size());
+    util::CodedBufferParser parser{from(ptr)};
     i32 size;
     if (!parser.readInt(&size)) {
       // empty traversal
@@ -182,8 +229,8 @@ class IntStorageReader {
   }
 
   KeyValueListTraversal kvListAt(i32 ptr) const noexcept {
-    JPP_DCHECK_IN(ptr, 0, data_.size());
-    util::CodedBufferParser parser{data_.from(ptr)};
+    JPP_DCHECK_IN(ptr, 0, size());
+    util::CodedBufferParser parser{from(ptr)};
     i32 size;
     if (!parser.readInt(&size)) {
       // empty traversal
@@ -195,36 +242,76 @@ class IntStorageReader {
   }
 
   i32 lengthOf(i32 ptr) const {
-    JPP_DCHECK_IN(ptr, 0, data_.size());
-    util::CodedBufferParser parser{data_.from(ptr)};
+    JPP_DCHECK_IN(ptr, 0, size());
+    util::CodedBufferParser parser{from(ptr)};
     i32 value = -1;
     parser.readInt(&value);
     return value;
   }
 
   void prefetch(i32 ptr) const {
-    util::prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(data_.data() + ptr);
+    util::prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(from(ptr).data());
   }
+
+  /**
+   * Data of the model dictionary, without the overlay
+   */
+  StringPiece data() const noexcept { return data_; }
+  StringPiece overlay() const noexcept { return overlay_; }
+
+  size_t size() const noexcept { return data_.size() + overlay_.size(); }
 };
 
+/**
+ * Traverses all strings of a storage.
+ * Reader-based traversal also includes the strings of the overlay,
+ * positions of which are placed after the model dictionary ones.
+ */
 class StringStorageTraversal {
   util::CodedBufferParser parser_;
+  StringPiece overlay_;
+  i32 overlayStart_;
+  i32 start_ = 0;
   i32 lastPosition_ = 0;
   u32 alignPower_;
   u32 alignment_;
 
+  bool switchToOverlay() noexcept {
+    if (overlay_.empty()) {
+      return false;
+    }
+    parser_.reset(overlay_);
+    overlay_ = EMPTY_SP;
+    start_ = overlayStart_;
+    return true;
+  }
+
  public:
   explicit StringStorageTraversal(StringPiece data, u32 alignPower) noexcept
-      : parser_{data}, alignPower_{alignPower}, alignment_{1u << alignPower} {}
+      : parser_{data},
+        overlayStart_{0},
+        alignPower_{alignPower},
+        alignment_{1u << alignPower} {}
   explicit StringStorageTraversal(const StringStorageReader& rdr) noexcept
-      : StringStorageTraversal(rdr.data(), rdr.alignPower()) {}
+      : StringStorageTraversal(rdr.data(), rdr.alignPower()) {
+    overlay_ = rdr.overlay();
+    overlayStart_ = static_cast<i32>(
+        StringStorageReader::overlayStart(rdr.data(), rdr.alignPower()) >>
+        alignPower_);
+  }
 
-  bool hasNext() const noexcept { return !parser_.atEnd(); }
+  bool hasNext() const noexcept {
+    return !parser_.atEnd() || !overlay_.empty();
+  }
 
   i32 position() const noexcept { return lastPosition_; }
 
   bool next(StringPiece* result) noexcept {
-    lastPosition_ = static_cast<i32>(parser_.numReadBytes() >> alignPower_);
+    if (JPP_UNLIKELY(parser_.atEnd()) && !switchToOverlay()) {
+      return false;
+    }
+    lastPosition_ =
+        start_ + static_cast<i32>(parser_.numReadBytes() >> alignPower_);
     bool ret = parser_.readStringPiece(result);
     if (JPP_LIKELY(ret)) {
       parser_.alignPointer(alignment_);
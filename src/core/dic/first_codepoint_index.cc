@@ -0,0 +1,223 @@
+#include "first_codepoint_index.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "util/characters.h"
+#include "util/serialization.h"
+
+namespace jumanpp {
+namespace core {
+namespace dic {
+
+template <typename Arch>
+void Serialize(Arch& a, FirstCodepointInfo& o) {
+  a& o.codepoint;
+  a& o.byteLength;
+  a& o.maxLength;
+  a& o.value;
+  a& o.nodePos;
+}
+
+void FirstCodepointIndexBuilder::add(StringPiece key) {
+  if (key.size() == 0) {
+    valid_ = false;
+    return;
+  }
+  auto first = chars::getCodepoint(key.ubegin(), key.uend());
+  auto length = chars::numCodepoints(key);
+  if (first.utf8Length == 0 || length <= 0) {
+    valid_ = false;
+    return;
+  }
+
+  auto it = infos_.find(first.codepoint);
+  if (it == infos_.end()) {
+    FirstCodepointInfo info{first.codepoint, static_cast<u32>(first.utf8Length),
+                            static_cast<u32>(length), -1, 0};
+    infos_[first.codepoint] = KeyStart{info, key.slice(0, first.utf8Length)};
+    return;
+  }
+
+  auto& info = it->second.info;
+  if (info.byteLength != first.utf8Length) {
+    // the same codepoint was encoded differently (overlong UTF-8)
+    valid_ = false;
+  }
+  info.maxLength = std::max<u32>(info.maxLength, static_cast<u32>(length));
+}
+
+Status FirstCodepointIndexBuilder::build(StringPiece trieContent) {
+  std::vector<FirstCodepointInfo> result;
+  if (valid_) {
+    DoubleArray trie;
+    JPP_RETURN_IF_ERROR(trie.loadFromMemory(trieContent));
+    for (auto& it : infos_) {
+      auto info = it.second.info;
+      auto trav = trie.traversal();
+      auto status = trav.step(it.second.bytes);
+      if (status == TraverseStatus::NoNode) {
+        return JPPS_INVALID_STATE << "trie does not contain codepoint "
+                                  << static_cast<u32>(info.codepoint);
+      }
+      info.nodePos = trav.nodePosition();
+      if (status == TraverseStatus::Ok) {
+        info.value = trav.value();
+      }
+      result.push_back(info);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const FirstCodepointInfo& a, const FirstCodepointInfo& b) {
+                return a.codepoint < b.codepoint;
+              });
+  }
+
+  buffer_.reset();
+  util::serialization::Saver saver{&buffer_};
+  saver.save(result);
+  return Status::Ok();
+}
+
+namespace {
+
+constexpr u32 IndexMagic = 0x4943464a;  // JFCI
+constexpr u32 IndexVersion = 1;
+
+struct IndexHeader {
+  u32 magic;
+  u32 version;
+  u32 numInfos;
+  u32 numPages;
+};
+
+static_assert(sizeof(FirstCodepointInfo) == 24,
+              "FirstCodepointInfo is a part of the model image");
+
+// sizes of image sections in bytes, every section is padded to 8 bytes
+struct IndexLayout {
+  size_t pageIndex;
+  size_t slots;
+  size_t infos;
+
+  explicit IndexLayout(const IndexHeader& h)
+      : pageIndex{pad(sizeof(u16) * FirstCodepointIndex::NumPages)},
+        slots{pad(sizeof(u32) * FirstCodepointIndex::PageSize * h.numPages)},
+        infos{sizeof(FirstCodepointInfo) * h.numInfos} {}
+
+  static size_t pad(size_t size) { return (size + 7) & ~size_t{7}; }
+
+  size_t total() const {
+    return sizeof(IndexHeader) + pageIndex + slots + infos;
+  }
+};
+
+void makeImage(const std::vector<FirstCodepointInfo>& infos,
+               std::vector<u64>* result) {
+  using Index = FirstCodepointIndex;
+  std::vector<u16> pageIndex(Index::NumPages, 0);
+  u32 numPages = 0;
+  for (auto& info : infos) {
+    auto& page = pageIndex[info.codepoint >> Index::PageBits];
+    if (page == 0) {
+      page = static_cast<u16>(++numPages);
+    }
+  }
+  std::vector<u32> slots(numPages * Index::PageSize, 0);
+  for (u32 i = 0; i < infos.size(); ++i) {
+    auto cp = infos[i].codepoint;
+    auto page = pageIndex[cp >> Index::PageBits] - 1;
+    slots[page * Index::PageSize + (cp & (Index::PageSize - 1))] = i + 1;
+  }
+
+  IndexHeader header{IndexMagic, IndexVersion, static_cast<u32>(infos.size()),
+                     numPages};
+  IndexLayout layout{header};
+  result->assign(layout.total() / sizeof(u64), 0);
+  auto out = reinterpret_cast<char*>(result->data());
+  auto write = [&](const void* data, size_t size, size_t padded) {
+    std::memcpy(out, data, size);
+    out += padded;
+  };
+  write(&header, sizeof(header), sizeof(header));
+  write(pageIndex.data(), pageIndex.size() * sizeof(u16), layout.pageIndex);
+  write(slots.data(), slots.size() * sizeof(u32), layout.slots);
+  write(infos.data(), infos.size() * sizeof(FirstCodepointInfo), layout.infos);
+}
+
+}  // namespace
+
+constexpr u32 FirstCodepointIndex::PageBits;
+constexpr u32 FirstCodepointIndex::PageSize;
+constexpr u32 FirstCodepointIndex::NumPages;
+
+Status FirstCodepointIndex::load(StringPiece data) {
+  std::vector<FirstCodepointInfo> infos;
+  util::serialization::Loader loader{data};
+  if (!loader.load(&infos)) {
+    return JPPS_INVALID_PARAMETER << "failed to read first codepoint index";
+  }
+
+  std::vector<u64> image;
+  if (!infos.empty()) {
+    makeImage(infos, &image);
+  }
+  owned_ = std::move(image);
+  auto ptr = reinterpret_cast<StringPiece::pointer_t>(owned_.data());
+  return loadImage(StringPiece{ptr, owned_.size() * sizeof(u64)});
+}
+
+Status FirstCodepointIndex::loadImage(StringPiece image) {
+  pageIndex_ = nullptr;
+  slots_ = nullptr;
+  infos_ = nullptr;
+  image_ = StringPiece{};
+  if (image.size() == 0) {
+    return Status::Ok();
+  }
+
+  if (reinterpret_cast<uintptr_t>(image.begin()) % alignof(u64) != 0) {
+    std::vector<u64> copy((image.size() + sizeof(u64) - 1) / sizeof(u64));
+    std::memcpy(copy.data(), image.begin(), image.size());
+    owned_ = std::move(copy);
+    image = StringPiece{reinterpret_cast<StringPiece::pointer_t>(owned_.data()),
+                        image.size()};
+  }
+
+  IndexHeader header;
+  if (image.size() < sizeof(header)) {
+    return JPPS_INVALID_PARAMETER << "first codepoint index was too small";
+  }
+  std::memcpy(&header, image.begin(), sizeof(header));
+  if (header.magic != IndexMagic || header.version != IndexVersion) {
+    return JPPS_INVALID_PARAMETER << "unsupported first codepoint index format";
+  }
+  IndexLayout layout{header};
+  if (header.numPages > NumPages || layout.total() != image.size()) {
+    return JPPS_INVALID_PARAMETER << "first codepoint index had invalid size";
+  }
+
+  auto ptr = image.begin() + sizeof(header);
+  auto pageIndex = reinterpret_cast<const u16*>(ptr);
+  ptr += layout.pageIndex;
+  auto slots = reinterpret_cast<const u32*>(ptr);
+  ptr += layout.slots;
+  for (u32 i = 0; i < NumPages; ++i) {
+    if (pageIndex[i] > header.numPages) {
+      return JPPS_INVALID_PARAMETER << "first codepoint index had invalid page";
+    }
+  }
+  for (u32 i = 0; i < header.numPages * PageSize; ++i) {
+    if (slots[i] > header.numInfos) {
+      return JPPS_INVALID_PARAMETER << "first codepoint index had invalid slot";
+    }
+  }
+
+  pageIndex_ = pageIndex;
+  slots_ = slots;
+  infos_ = reinterpret_cast<const FirstCodepointInfo*>(ptr);
+  image_ = image;
+  return Status::Ok();
+}
+
+}  // namespace dic
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,125 @@
+#ifndef JUMANPP_FIRST_CODEPOINT_INDEX_H
+#define JUMANPP_FIRST_CODEPOINT_INDEX_H
+
+#include <vector>
+#include "core/dic/darts_trie.h"
+#include "util/characters.h"
+#include "util/coded_io.h"
+#include "util/flatmap.h"
+#include "util/status.hpp"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace dic {
+
+/**
+ * Information about trie keys which start with a codepoint.
+ */
+struct FirstCodepointInfo {
+  u32 codepoint;
+  // length of the first codepoint in UTF-8
+  u32 byteLength;
+  // length of the longest key in codepoints
+  u32 maxLength;
+  // trie value if the codepoint itself is a key, -1 otherwise
+  i32 value;
+  // trie node after the first codepoint
+  u64 nodePos;
+};
+
+/**
+ * Auxiliary index over the first codepoints of dictionary trie keys.
+ * It is computed when building a dictionary and stored in the model.
+ * Dictionaries which have a CodepointTrie do not need the index,
+ * it is built only for ones where the codepoint trie can not be built.
+ *
+ * Dictionary lookup uses it to skip positions where no key can start,
+ * to resume trie traversal after the first codepoint and to stop
+ * traversal after the longest possible key.
+ *
+ * Lookups use a flat image: a page table over codepoints which points
+ * to a sorted array of infos. The image does not contain pointers,
+ * so it can be used in place from a model file (see RuntimeImage).
+ */
+class FirstCodepointIndex {
+ public:
+  static constexpr u32 PageBits = 8;
+  static constexpr u32 PageSize = 1u << PageBits;
+  static constexpr u32 NumPages = 0x110000u >> PageBits;
+
+ private:
+  const u16* pageIndex_ = nullptr;
+  // 1-based indices of infos, 0 if there is no info
+  const u32* slots_ = nullptr;
+  const FirstCodepointInfo* infos_ = nullptr;
+  StringPiece image_;
+  // image is built here when loading the serialized index
+  std::vector<u64> owned_;
+
+ public:
+  Status load(StringPiece data);
+
+  /**
+   * Load the index from its flat image.
+   * Loaded index references the passed memory.
+   */
+  Status loadImage(StringPiece image);
+
+  /**
+   * Empty data (e.g. models which were built before the index existed)
+   * do not load the index
+   */
+  bool loaded() const { return pageIndex_ != nullptr; }
+
+  StringPiece image() const { return image_; }
+
+  /**
+   * @return nullptr if no key starts with the codepoint
+   */
+  const FirstCodepointInfo* find(char32_t codepoint) const {
+    auto page = static_cast<u32>(codepoint) >> PageBits;
+    if (JPP_UNLIKELY(page >= NumPages)) {
+      return nullptr;
+    }
+    u32 pageIdx = pageIndex_[page];
+    if (pageIdx == 0) {
+      return nullptr;
+    }
+    auto slot = slots_[(pageIdx - 1) * PageSize + (codepoint & (PageSize - 1))];
+    if (slot == 0) {
+      return nullptr;
+    }
+    return &infos_[slot - 1];
+  }
+};
+
+class FirstCodepointIndexBuilder {
+  struct KeyStart {
+    FirstCodepointInfo info;
+    StringPiece bytes;
+  };
+
+  util::FlatMap<char32_t, KeyStart, chars::CodepointHash> infos_;
+  util::CodedBuffer buffer_;
+  bool valid_ = true;
+
+ public:
+  void add(StringPiece key);
+
+  /**
+   * Find trie positions of all first codepoints.
+   * Keys which are not valid UTF-8 make the index empty,
+   * lookups fall back to plain trie traversal in that case.
+   */
+  Status build(StringPiece trieContent);
+
+  StringPiece result() const { return buffer_.contents(); }
+};
+
+}  // namespace dic
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_FIRST_CODEPOINT_INDEX_H
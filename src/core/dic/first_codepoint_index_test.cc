@@ -0,0 +1,116 @@
+#include "first_codepoint_index.h"
+#include <testing/standalone_test.h>
+
+namespace c = jumanpp::core::dic;
+namespace j = jumanpp;
+
+namespace {
+
+struct IndexEnv {
+  c::DoubleArrayBuilder trieBldr;
+  c::FirstCodepointIndexBuilder indexBldr;
+  c::DoubleArray trie;
+  c::FirstCodepointIndex index;
+
+  void add(j::StringPiece key, int value) {
+    trieBldr.add(key, value);
+    indexBldr.add(key);
+  }
+
+  void build() {
+    REQUIRE_OK(trieBldr.build());
+    REQUIRE_OK(indexBldr.build(trieBldr.result()));
+    REQUIRE_OK(trie.loadFromMemory(trieBldr.result()));
+    REQUIRE_OK(index.load(indexBldr.result()));
+  }
+};
+
+}  // namespace
+
+TEST_CASE("first codepoint index knows which codepoints start keys") {
+  IndexEnv env;
+  env.add("東", 1);
+  env.add("東京", 2);
+  env.add("東京都", 3);
+  env.add("京都", 4);
+  env.add("a", 5);
+  env.add("𠮷野家", 6);
+  env.build();
+  REQUIRE(env.index.loaded());
+
+  CHECK(env.index.find(U'都') == nullptr);
+  CHECK(env.index.find(U'b') == nullptr);
+
+  auto higashi = env.index.find(U'東');
+  REQUIRE(higashi != nullptr);
+  CHECK(higashi->byteLength == 3);
+  CHECK(higashi->maxLength == 3);
+  CHECK(higashi->value == 1);
+
+  auto kyo = env.index.find(U'京');
+  REQUIRE(kyo != nullptr);
+  CHECK(kyo->maxLength == 2);
+  CHECK(kyo->value == -1);
+
+  auto yoshi = env.index.find(U'𠮷');
+  REQUIRE(yoshi != nullptr);
+  CHECK(yoshi->byteLength == 4);
+  CHECK(yoshi->maxLength == 3);
+}
+
+TEST_CASE("trie traversal can continue after the first codepoint") {
+  IndexEnv env;
+  env.add("東京", 2);
+  env.add("東京都", 3);
+  env.add("京都", 4);
+  env.build();
+  auto info = env.index.find(U'東');
+  REQUIRE(info != nullptr);
+  auto trav = env.trie.traversalAt(info->nodePos, info->value);
+  CHECK(trav.step("京") == c::TraverseStatus::Ok);
+  CHECK(trav.value() == 2);
+  CHECK(trav.step("都") == c::TraverseStatus::Ok);
+  CHECK(trav.value() == 3);
+  CHECK(trav.step("府") == c::TraverseStatus::NoNode);
+}
+
+TEST_CASE("first codepoint index is empty for invalid utf8 keys") {
+  IndexEnv env;
+  env.add("東京", 2);
+  env.add("\xff\xfe", 3);
+  env.build();
+  CHECK_FALSE(env.index.loaded());
+}
+
+TEST_CASE("first codepoint index can be used from its image") {
+  IndexEnv env;
+  env.add("東京", 2);
+  env.add("京都", 4);
+  env.add("a", 5);
+  env.add("𠮷野家", 6);
+  env.build();
+  auto image = env.index.image();
+  REQUIRE(image.size() > 0);
+
+  // image is used in place, even when it is not aligned
+  std::string copy = " " + image.str();
+  c::FirstCodepointIndex fromImage;
+  REQUIRE_OK(fromImage.loadImage(j::StringPiece{copy}.slice(1, copy.size())));
+  REQUIRE(fromImage.loaded());
+  for (char32_t cp : {U'東', U'京', U'a', U'𠮷', U'都', U'b'}) {
+    CAPTURE(static_cast<j::u32>(cp));
+    auto expected = env.index.find(cp);
+    auto actual = fromImage.find(cp);
+    REQUIRE((expected == nullptr) == (actual == nullptr));
+    if (expected != nullptr) {
+      CHECK(actual->codepoint == expected->codepoint);
+      CHECK(actual->maxLength == expected->maxLength);
+      CHECK(actual->value == expected->value);
+      CHECK(actual->nodePos == expected->nodePos);
+    }
+  }
+  CHECK(fromImage.find(char32_t{0x110000}) == nullptr);
+
+  copy[5] ^= 0x7f;
+  CHECK_FALSE(fromImage.loadImage(j::StringPiece{copy}.slice(1, copy.size())));
+}
@@ -3,7 +3,11 @@
 //
 
 #include "env.h"
+#include <errors.hpp>
+#include <path.hpp>
+#include "core/spec/spec_hashing.h"
 #include "core_version.h"
+#include "util/logging.hpp"
 
 namespace jumanpp {
 namespace core {
@@ -11,29 +15,61 @@ namespace core {
 Status JumanppEnv::loadModel(StringPiece filename) {
   JPP_RETURN_IF_ERROR(modelFile_.open(filename));
   JPP_RETURN_IF_ERROR(modelFile_.load(&modelInfo_));
+  markPhase("model header");
   JPP_RETURN_IF_ERROR(dicBldr_.restoreDictionary(modelInfo_));
-  JPP_RETURN_IF_ERROR(dicHolder_.load(dicBldr_));
+  JPP_RETURN_IF_ERROR(runtimeImage_.load(modelInfo_));
+  dicBldr_.firstCodepointImage = runtimeImage_.firstCodepoints();
+  markPhase("dictionary decode");
+  JPP_RETURN_IF_ERROR(dicHolder_.loadFields(dicBldr_));
+  markPhase("dictionary fields");
+  JPP_RETURN_IF_ERROR(dicHolder_.loadEntries(dicBldr_));
+  markPhase("dictionary trie");
 
   if (hasPerceptronModel()) {
+    perceptron_.setCopyWeights(loadMode_ != model::ModelLoadMode::Mapped);
     JPP_RETURN_IF_ERROR(perceptron_.load(modelInfo_));
     scorers_.feature = &perceptron_;
     scorers_.scoreWeights.push_back(1);
     scoringConf_.numScorers += 1;
+    markPhase("perceptron weights");
   }
 
   if (hasRnnModel()) {
+    rnnHolder_.setPrebuiltBosState(runtimeImage_.rnnBosState());
     JPP_RETURN_IF_ERROR(rnnHolder_.load(modelInfo_));
     scorers_.others.push_back(&rnnHolder_);
     scorers_.scoreWeights.push_back(1);
     scoringConf_.numScorers += 1;
     setRnnHolder(&rnnHolder_);
+    markPhase("rnn matrices");
   }
 
   core_.reset(new CoreHolder{dicBldr_.spec, dicHolder_});
+  markPhase("core holder");
 
   return Status::Ok();
 }
 
+Status JumanppEnv::loadUserDictionary(StringPiece filename) {
+  if (!core_) {
+    return JPPS_INVALID_STATE
+           << "user dictionary can be loaded only after the model";
+  }
+  if (userDic_) {
+    return JPPS_INVALID_STATE << "user dictionary was already loaded, "
+                                 "reloading it needs a new environment";
+  }
+  JPP_RETURN_IF_ERROR(userDicFile_.open(filename, util::MMapType::ReadOnly));
+  userDic_.reset(new dic::DictionaryBuilder);
+  JPP_RETURN_IF_ERROR(userDic_->importSpec(&dicBldr_.spec));
+  JPP_RIE_MSG(userDic_->importOverlayCsv(dicBldr_, filename,
+                                         userDicFile_.contents()),
+              "when building user dictionary");
+  JPP_RETURN_IF_ERROR(dicHolder_.loadOverlay(userDic_->result()));
+  markPhase("user dictionary");
+  return Status::Ok();
+}
+
 bool JumanppEnv::hasPerceptronModel() const {
   for (auto& x : modelInfo_.parts) {
     if (x.kind == core::model::ModelPartKind::Perceprton) {
@@ -45,7 +81,52 @@ bool JumanppEnv::hasPerceptronModel() const {
 
 void JumanppEnv::setBeamSize(u32 size) { scoringConf_.beamSize = size; }
 
+namespace {
+
+std::string featurePluginPath(StringPiece directory, StringPiece modelFile,
+                              u64 specHash) {
+  auto name = features::FeaturePlugin::filename(specHash);
+  try {
+    Pathie::Path dir;
+    if (directory.empty()) {
+      dir = Pathie::Path{modelFile.str()}.parent();
+    } else {
+      dir = Pathie::Path{directory.str()};
+    }
+    auto path = dir / name;
+    if (path.exists()) {
+      return path.utf8_str();
+    }
+  } catch (Pathie::PathieError& e) {
+    LOG_WARN() << "failed to look for a feature plugin " << name << ": "
+               << e.what();
+  }
+  return std::string{};
+}
+
+}  // namespace
+
 Status JumanppEnv::initFeatures(const features::StaticFeatureFactory* sff) {
+  if (!core_) {
+    return JPPS_INVALID_STATE << "features can be initialized only after "
+                                 "the model is loaded";
+  }
+  if (useFeaturePlugins_) {
+    auto specHash = spec::hashSpec(spec());
+    if (sff == nullptr || sff->runtimeHash() != specHash) {
+      auto path =
+          featurePluginPath(featurePluginDir_, modelFile_.name(), specHash);
+      if (!path.empty()) {
+        Status s = featurePlugin_.load(path, specHash);
+        if (s) {
+          sff = featurePlugin_.factory();
+          markPhase("feature plugin");
+        } else {
+          LOG_WARN() << "feature plugin was not used: " << s;
+        }
+      }
+    }
+  }
   return core_->initialize(sff);
 }
 
@@ -112,6 +193,16 @@ void JumanppEnv::setAutoBeam(i32 base, i32 step, i32 max) {
   analyzerConfig_.autoBeamMax = max;
 }
 
+void JumanppEnv::setAdaptiveBeam(float margin, i32 minGlobal, i32 minRight) {
+  analyzerConfig_.adaptiveBeamMargin = margin;
+  analyzerConfig_.adaptiveGlobalBeamMin = minGlobal;
+  analyzerConfig_.adaptiveRightBeamMin = minRight;
+}
+
+void JumanppEnv::setTrigramPruning(bool value) {
+  analyzerConfig_.trigramPruning = value;
+}
+
 void JumanppEnv::fillVersion(VersionInfo* result) const {
   result->binary = JPP_VERSION_STRING.str();
   using model::ModelPartKind;
@@ -8,7 +8,12 @@
 #include "core/analysis/analyzer.h"
 #include "core/analysis/perceptron.h"
 #include "core/analysis/rnn_scorer_gbeam.h"
+#include "core/dic/dic_builder.h"
+#include "core/impl/feature_plugin.h"
 #include "core/impl/model_io.h"
+#include "core/impl/runtime_image.h"
+#include "core/impl/startup_profile.h"
+#include "util/mmap.h"
 
 namespace jumanpp {
 namespace core {
@@ -24,8 +29,15 @@ class JumanppEnv {
   ScoringConfig scoringConf_{1, 0};
   model::FilesystemModel modelFile_;
   model::ModelInfo modelInfo_;
+  model::RuntimeImage runtimeImage_;
   dic::BuiltDictionary dicBldr_;
   dic::DictionaryHolder dicHolder_;
+  util::FullyMappedFile userDicFile_;
+  std::unique_ptr<dic::DictionaryBuilder> userDic_;
+  // must be destroyed after the features created by its factory
+  features::FeaturePlugin featurePlugin_;
+  bool useFeaturePlugins_ = false;
+  std::string featurePluginDir_;
   std::unique_ptr<core::CoreHolder> core_;
 
   analysis::AnalyzerConfig analyzerConfig_{};
@@ -33,11 +45,47 @@ class JumanppEnv {
   analysis::HashedFeaturePerceptron perceptron_;
   analysis::RnnScorerGbeamFactory rnnHolder_;
   analysis::ScorerDef scorers_;
+  model::ModelLoadMode loadMode_ = model::ModelLoadMode::Default;
+  StartupProfile* profile_ = nullptr;
+
+  void markPhase(StringPiece name) {
+    if (profile_ != nullptr) {
+      profile_->mark(name);
+    }
+  }
 
  public:
   Status loadModel(StringPiece filename);
-
+  /**
+   * Add entries from a csv file in the format of the model dictionary.
+   * They are used in addition to the model dictionary entries.
+   * Must be called after loadModel and before initFeatures.
+   * Only new data is built, the model dictionary is used in place.
+   * A user dictionary can be loaded only once: analyzers use the dictionary
+   * without synchronization, so it is not reloaded in a running environment.
+   */
+  Status loadUserDictionary(StringPiece filename);
+  void setModelLoadMode(model::ModelLoadMode mode) { loadMode_ = mode; }
+  // Phases of model loading will be recorded to the profile if it is set
+  void setStartupProfile(StartupProfile* profile) { profile_ = profile; }
+
+  /**
+   * Initialize features of the loaded model.
+   * If the passed static features do not match the model spec and
+   * feature plugins are enabled, a matching plugin is loaded when it exists.
+   * Otherwise, features are computed dynamically.
+   */
   Status initFeatures(const features::StaticFeatureFactory* pFactory);
+  /**
+   * Look for feature plugins in the directory, the model directory if empty.
+   * Plugins are native code, so they are never loaded without this call.
+   * Only analysis uses plugins, training always uses dynamic features.
+   */
+  void enableFeaturePlugins(StringPiece dir) {
+    useFeaturePlugins_ = true;
+    featurePluginDir_ = dir.str();
+  }
+  bool usesFeaturePlugin() const { return featurePlugin_.factory() != nullptr; }
   void setBeamSize(u32 size);
 
   const CoreHolder* coreHolder() const { return core_.get(); }
@@ -63,6 +111,8 @@ class JumanppEnv {
 
   void setGlobalBeam(i32 globalBeam, i32 rightCheck, i32 rightBeam);
   void setAutoBeam(i32 base, i32 step, i32 max);
+  void setAdaptiveBeam(float margin, i32 minGlobal, i32 minRight);
+  void setTrigramPruning(bool value);
 
   const analysis::FeatureScorer* featureScorer() const { return &perceptron_; }
 
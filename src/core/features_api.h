@@ -7,6 +7,7 @@
 
 #include <memory>
 #include "core/core_types.h"
+#include "core_config.h"
 #include "util/memory.hpp"
 #include "util/sliceable_array.h"
 #include "util/status.hpp"
@@ -144,6 +145,31 @@ class PartialNgramFeatureApply : public FeatureApply {
       util::ArraySlice<u32> t1idxes, analysis::FeatureScorer* scorer,
       util::MutableArraySlice<float> result) const noexcept = 0;
 
+  /**
+   * Bigram part of applyBiTri: scores of bigram features between
+   * the right node t0idx and each t1 row.
+   */
+  virtual void applyBi(FeatureBuffer* buffers, u32 t0idx,
+                       util::ConstSliceable<u64> t1,
+                       analysis::FeatureScorer* scorer,
+                       util::MutableArraySlice<float> result) const
+      noexcept = 0;
+
+  /**
+   * Trigram part of applyBiTri, computed only for the selected rows of t2.
+   * Trigram scores are added to result.at(row) for each row of rows.
+   * Uses the trigram state of the right node t0idx and the second
+   * trigram buffer as a scratch space.
+   */
+  virtual void applyTri(FeatureBuffer* buffers, u32 t0idx,
+                        util::ConstSliceable<u64> t1,
+                        util::ConstSliceable<u64> t2,
+                        util::ArraySlice<u32> t1idxes,
+                        util::ArraySlice<u32> rows,
+                        analysis::FeatureScorer* scorer,
+                        util::MutableArraySlice<float> result) const
+      noexcept = 0;
+
   virtual u32 numUnigrams() const noexcept = 0;
   virtual u32 numBigrams() const noexcept = 0;
   virtual u32 numTrigrams() const noexcept = 0;
@@ -157,6 +183,30 @@ class StaticFeatureFactory : public FeatureApply {
   virtual PartialNgramFeatureApply* ngramPartial() const { return nullptr; }
 };
 
+/**
+ * Static features can also be compiled into a shared library, a feature
+ * plugin, which is loaded at runtime (see FeaturePlugin).
+ * The plugin exports a function with the name JPP_FEATURE_PLUGIN_ENTRY
+ * of the FeaturePluginEntry type.
+ *
+ * The function returns nullptr if the plugin was compiled with a
+ * configuration incompatible with the passed one: the layout version,
+ * configuration values or JPP_PLUGIN_BUILD_ID differ.
+ */
+#define JPP_FEATURE_PLUGIN_ENTRY jumanpp_feature_plugin_v2
+
+#ifdef _WIN32
+#define JPP_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define JPP_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+constexpr u32 FeaturePluginAbi =
+    (3u << 24) | (static_cast<u32>(JPP_MAX_DIC_FIELDS) << 8) | JPP_WEIGHT_BITS;
+
+using FeaturePluginEntry = const StaticFeatureFactory* (*)(u32 abi,
+                                                           const char* buildId);
+
 struct FeatureHolder {
   std::unique_ptr<features::PatternFeatureApply> patternDynamic;
   std::unique_ptr<features::GeneratedPatternFeatureApply> patternStatic;
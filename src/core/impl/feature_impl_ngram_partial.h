@@ -378,6 +378,39 @@ class PartialNgramFeatureApplyImpl : public PartialNgramFeatureApply {
     result.at(row - 1) +=
         analysis::impl::computeUnrolled4RawPerceptron(weights, buf2);
   }
+
+  void applyBi(FeatureBuffer* buffers, u32 t0idx, util::ConstSliceable<u64> t1,
+               analysis::FeatureScorer* scorer,
+               util::MutableArraySlice<float> result) const noexcept override {
+    auto numBigrams = child().numBigrams();
+    auto buf = buffers->valBuf1(numBigrams);
+    auto state = buffers->t1Buf(numBigrams, buffers->currentElems).row(t0idx);
+    auto weights = scorer->weights();
+    auto mask = static_cast<u32>(weights.size() - 1);
+    for (u32 row = 0; row < t1.numRows(); ++row) {
+      child().biStep1(t1.row(row), state, mask, weights, buf);
+      result.at(row) =
+          analysis::impl::computeUnrolled4RawPerceptron(weights, buf);
+    }
+  }
+
+  void applyTri(FeatureBuffer* buffers, u32 t0idx, util::ConstSliceable<u64> t1,
+                util::ConstSliceable<u64> t2, util::ArraySlice<u32> t1idxes,
+                util::ArraySlice<u32> rows, analysis::FeatureScorer* scorer,
+                util::MutableArraySlice<float> result) const noexcept override {
+    auto numTrigrams = child().numTrigrams();
+    auto buf = buffers->valBuf1(numTrigrams);
+    auto state = buffers->t2Buf1(numTrigrams, buffers->currentElems).row(t0idx);
+    auto scratch = buffers->t2Buf2(numTrigrams, 1).row(0);
+    auto weights = scorer->weights();
+    auto mask = static_cast<u32>(weights.size() - 1);
+    for (auto row : rows) {
+      child().triStep1(t1.row(t1idxes.at(row)), state, scratch);
+      child().triStep2(t2.row(row), scratch, mask, weights, buf);
+      result.at(row) +=
+          analysis::impl::computeUnrolled4RawPerceptron(weights, buf);
+    }
+  }
 };
 
 class PartialNgramDynamicFeatureApply
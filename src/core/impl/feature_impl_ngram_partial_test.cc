@@ -67,7 +67,11 @@ spec::NgramFeatureDescriptor nf(i32 index, std::initializer_list<i32> data) {
 TEST_CASE("partial and full trigram features produce the same result") {
   NgramDynamicFeatureApply full;
   PartialNgramDynamicFeatureApply part;
-  util::ArraySlice<float> fake{nullptr, fullMask + size_t{1}};
+#if JPP_WEIGHT_BITS == 32
+  WeightBuffer fake{util::ArraySlice<float>{nullptr, fullMask + size_t{1}}};
+#else
+  WeightBuffer fake{nullptr, nullptr, fullMask + size_t{1}};
+#endif
 
   int idx = 0;
   auto add = [&](std::initializer_list<i32> data) {
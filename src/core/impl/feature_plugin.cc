@@ -0,0 +1,45 @@
+#include "feature_plugin.h"
+#include "util/format.h"
+
+namespace jumanpp {
+namespace core {
+namespace features {
+
+#define JPP_PLUGIN_STR2(x) #x
+#define JPP_PLUGIN_STR(x) JPP_PLUGIN_STR2(x)
+
+Status FeaturePlugin::load(StringPiece filename, u64 specHash) {
+  factory_ = nullptr;
+  JPP_RETURN_IF_ERROR(library_.open(filename));
+  auto entry = reinterpret_cast<FeaturePluginEntry>(
+      library_.symbol(JPP_PLUGIN_STR(JPP_FEATURE_PLUGIN_ENTRY)));
+  if (entry == nullptr) {
+    library_.close();
+    return JPPS_INVALID_PARAMETER << filename
+                                  << " is not a compatible feature plugin";
+  }
+  auto factory = entry(FeaturePluginAbi, JPP_PLUGIN_BUILD_ID);
+  if (factory == nullptr) {
+    library_.close();
+    return JPPS_INVALID_PARAMETER
+           << "feature plugin " << filename
+           << " was compiled for another build of Juman++, this build has id "
+           << JPP_PLUGIN_BUILD_ID;
+  }
+  if (factory->runtimeHash() != specHash) {
+    library_.close();
+    return JPPS_INVALID_PARAMETER << "feature plugin " << filename
+                                  << " was generated for another spec";
+  }
+  factory_ = factory;
+  return Status::Ok();
+}
+
+std::string FeaturePlugin::filename(u64 specHash) {
+  return fmt::format("jpp_features_{0:016x}{1}", specHash,
+                     util::SharedLibrary::extension().str());
+}
+
+}  // namespace features
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,43 @@
+#ifndef JUMANPP_FEATURE_PLUGIN_H
+#define JUMANPP_FEATURE_PLUGIN_H
+
+#include <string>
+#include "core/features_api.h"
+#include "util/shared_library.h"
+
+namespace jumanpp {
+namespace core {
+namespace features {
+
+/**
+ * Static features which are compiled into a shared library
+ * (see jumanpp_tool feature-plugin) and loaded at runtime.
+ *
+ * Plugins are named after the hash of the spec they were generated for,
+ * so a model can find the plugin with its features in a directory.
+ * The plugin must outlive the features which were created by its factory.
+ */
+class FeaturePlugin {
+  util::SharedLibrary library_;
+  const StaticFeatureFactory* factory_ = nullptr;
+
+ public:
+  /**
+   * Load the plugin and check that it was generated for the spec
+   * with the passed hash
+   */
+  Status load(StringPiece filename, u64 specHash);
+
+  const StaticFeatureFactory* factory() const { return factory_; }
+
+  /**
+   * @return filename of the plugin for a spec, without a directory
+   */
+  static std::string filename(u64 specHash);
+};
+
+}  // namespace features
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_FEATURE_PLUGIN_H
@@ -0,0 +1,16 @@
+#include "feature_plugin.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp::core::features;
+
+TEST_CASE("feature plugin filename depends on the spec hash") {
+  auto name = FeaturePlugin::filename(0x12abULL);
+  CHECK(name.find("jpp_features_00000000000012ab") == 0);
+  CHECK(FeaturePlugin::filename(0x12acULL) != name);
+}
+
+TEST_CASE("missing feature plugin is not loaded") {
+  FeaturePlugin plugin;
+  CHECK_FALSE(plugin.load("/nonexistent/jpp_features.so", 0));
+  CHECK(plugin.factory() == nullptr);
+}
@@ -12,7 +12,14 @@ namespace jumanpp {
 namespace core {
 namespace model {
 
-enum class ModelPartKind { Dictionary, Perceprton, Rnn, ScwDump };
+enum class ModelPartKind {
+  Dictionary,
+  Perceprton,
+  Rnn,
+  ScwDump,
+  QuantizedPerceptron,
+  RuntimeImage
+};
 
 struct ModelPart {
   ModelPartKind kind;
@@ -11,6 +11,8 @@
 #include <iostream>
 #include "core/dic/dic_builder.h"
 #include "model_format_ser.h"
+#include "perceptron_io.h"
+#include "runtime_image.h"
 #include "util/debug_output.h"
 #include "util/memory.hpp"
 #include "util/mmap.h"
@@ -58,6 +60,11 @@ Status ModelSaver::save(const ModelInfo& info) {
     rawPart.comment = part.comment;
 
     for (auto& buf : part.data) {
+      if (buf.size() == 0) {
+        // empty chunks can not be mapped and do not take space in the file
+        rawPart.data.push_back(BlockPtr{0, 0});
+        continue;
+      }
       util::MappedFileFragment frag;
       JPP_RETURN_IF_ERROR(file_->mmap.map(&frag, offset, buf.size()));
       std::memcpy(frag.address(), buf.data(), buf.size());
@@ -290,11 +297,35 @@ void FilesystemModel::renderInfo() {
           printPerceptronInfo(p, mp, rawPart, info);
           break;
         }
+        case ModelPartKind::QuantizedPerceptron: {
+          p << "\nQuantized linear model: [" << rawPart.start << "-"
+            << rawPart.end << "] " << mp.comment;
+          i::Indent id{p, 2};
+          QuantizedPerceptronInfo qi{};
+          StringPiece data;
+          StringPiece scales;
+          if (analysis::readQuantizedPerceptron(mp, &qi, &data, &scales)) {
+            p << "\n  bits=" << qi.bits << " block=" << qi.blockSize;
+          }
+          break;
+        }
         case ModelPartKind::Rnn: {
           p << "\nRNN: [" << rawPart.start << "-" << rawPart.end << "] "
             << mp.comment;
           break;
         }
+        case ModelPartKind::RuntimeImage: {
+          p << "\nRuntime image: [" << rawPart.start << "-" << rawPart.end
+            << "]";
+          RuntimeImage image;
+          if (image.load(info)) {
+            p << "\n  first codepoint index: "
+              << (image.firstCodepoints().size() != 0 ? "used" : "not used")
+              << "\n  rnn initial state: "
+              << (image.rnnBosState().size() != 0 ? "used" : "not used");
+          }
+          break;
+        }
         default: {
           p << "\nUnsupported Segment Type";
         }
@@ -17,6 +17,16 @@ namespace model {
 
 struct ModelFile;
 
+enum class ModelLoadMode {
+  // Hot model parts (e.g. linear model weights) are copied into
+  // huge page backed memory when it is supported
+  Default,
+  // All model parts are used directly from the file mapping.
+  // Loading does not touch the model data, processes which use the same
+  // model file share its pages in the page cache.
+  Mapped
+};
+
 class ModelSaver {
   std::unique_ptr<ModelFile> file_;
 
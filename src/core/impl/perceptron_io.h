@@ -19,6 +19,21 @@ void Serialize(Arch& arch, PerceptronInfo& obj) {
   arch& obj.modelSizeExponent;
 }
 
+// Weights are stored as bits-wide signed integers with a float scale
+// per block of blockSize weights: scale[idx / blockSize] * value
+struct QuantizedPerceptronInfo {
+  i32 modelSizeExponent;
+  i32 bits;
+  u32 blockSize;
+};
+
+template <typename Arch>
+void Serialize(Arch& arch, QuantizedPerceptronInfo& obj) {
+  arch& obj.modelSizeExponent;
+  arch& obj.bits;
+  arch& obj.blockSize;
+}
+
 }  // namespace core
 }  // namespace jumanpp
 
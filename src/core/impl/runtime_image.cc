@@ -0,0 +1,129 @@
+#include "runtime_image.h"
+#include <algorithm>
+#include <cstring>
+#include "util/fast_hash.h"
+#include "util/serialization.h"
+
+namespace jumanpp {
+namespace core {
+namespace model {
+
+namespace {
+
+constexpr i32 ImageVersion = 2;
+
+// four independent hash chains make hashing of large parts
+// limited by memory bandwidth instead of the multiplication latency
+u64 hashChunk(u64 seed, StringPiece chunk) {
+  using util::hashing::FastHash1;
+  FastHash1 lanes[4] = {FastHash1{seed}, FastHash1{seed + 1},
+                        FastHash1{seed + 2}, FastHash1{seed + 3}};
+  auto data = chunk.char_begin();
+  auto size = chunk.size();
+  size_t pos = 0;
+  for (; pos + 4 * sizeof(u64) <= size; pos += 4 * sizeof(u64)) {
+    u64 words[4];
+    std::memcpy(words, data + pos, sizeof(words));
+    for (int i = 0; i < 4; ++i) {
+      lanes[i] = lanes[i].mix(words[i]);
+    }
+  }
+  for (; pos < size; pos += sizeof(u64)) {
+    u64 word = 0;
+    std::memcpy(&word, data + pos, std::min(sizeof(u64), size - pos));
+    lanes[0] = lanes[0].mix(word);
+  }
+  auto result = lanes[0].mix(size);
+  for (int i = 1; i < 4; ++i) {
+    result = result.mix(lanes[i].result());
+  }
+  return result.result();
+}
+
+}  // namespace
+
+template <typename Arch>
+void Serialize(Arch& a, RuntimeImageInfo& o) {
+  a& o.version;
+  a& o.dictionary;
+  a& o.rnn;
+}
+
+u64 RuntimeImage::fingerprint(const ModelInfo& model, ModelPartKind kind) {
+  auto part = model.firstPartOf(kind);
+  if (part == nullptr) {
+    return 0;
+  }
+  util::hashing::FastHash1 hash{};
+  hash = hash.mix(static_cast<u64>(kind));
+  for (auto& chunk : part->data) {
+    hash = hash.mix(hashChunk(hash.result(), chunk));
+  }
+  auto result = hash.result();
+  // 0 is reserved for missing parts
+  return result == 0 ? 1 : result;
+}
+
+Status RuntimeImage::load(const ModelInfo& model) {
+  info_ = RuntimeImageInfo{};
+  firstCodepoints_ = StringPiece{};
+  rnnBosState_ = StringPiece{};
+
+  auto part = model.firstPartOf(ModelPartKind::RuntimeImage);
+  if (part == nullptr) {
+    return Status::Ok();
+  }
+  if (part->data.size() != 3) {
+    return JPPS_INVALID_PARAMETER
+           << "runtime image: model part did not have exactly three chunks";
+  }
+  RuntimeImageInfo info;
+  util::serialization::Loader loader{part->data[0]};
+  if (!loader.load(&info)) {
+    return JPPS_INVALID_PARAMETER << "runtime image: failed to load the header";
+  }
+  if (info.version != ImageVersion) {
+    // image of another version is not an error, it is rebuilt when loading
+    return Status::Ok();
+  }
+
+  info_ = info;
+  if (info.dictionary != 0 &&
+      info.dictionary == fingerprint(model, ModelPartKind::Dictionary)) {
+    firstCodepoints_ = part->data[1];
+  }
+  if (info.rnn != 0 && info.rnn == fingerprint(model, ModelPartKind::Rnn)) {
+    rnnBosState_ = part->data[2];
+  }
+  return Status::Ok();
+}
+
+void RuntimeImage::setFirstCodepoints(const ModelInfo& model,
+                                      StringPiece data) {
+  info_.dictionary =
+      data.size() == 0 ? 0 : fingerprint(model, ModelPartKind::Dictionary);
+  firstCodepoints_ = data;
+}
+
+void RuntimeImage::setRnnBosState(const ModelInfo& model, StringPiece data) {
+  info_.rnn = data.size() == 0 ? 0 : fingerprint(model, ModelPartKind::Rnn);
+  rnnBosState_ = data;
+}
+
+void RuntimeImage::fill(ModelPart* part) {
+  info_.version = ImageVersion;
+  header_.reset();
+  util::serialization::Saver saver{&header_};
+  saver.save(info_);
+
+  part->kind = ModelPartKind::RuntimeImage;
+  part->comment.clear();
+  part->data.clear();
+  part->data.push_back(header_.contents());
+  part->data.push_back(firstCodepoints_);
+  part->data.push_back(rnnBosState_);
+}
+
+}  // namespace model
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,76 @@
+#ifndef JUMANPP_RUNTIME_IMAGE_H
+#define JUMANPP_RUNTIME_IMAGE_H
+
+#include "model_format.h"
+#include "util/coded_io.h"
+#include "util/status.hpp"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace model {
+
+struct RuntimeImageInfo {
+  i32 version = 0;
+  // fingerprints of the model parts the image was built from
+  u64 dictionary = 0;
+  u64 rnn = 0;
+};
+
+/**
+ * Read-only structures which would be derived from other model parts
+ * on every model load.
+ *
+ * They are stored in the model in a form which does not contain pointers
+ * and are used in place from the model file: processes which use the same
+ * model file share them through the page cache.
+ * The image is created by `jumanpp_tool prebuild`.
+ *
+ * Parts of the image are used only if the model parts they were built from
+ * did not change, e.g. after embedding a different RNN.
+ */
+class RuntimeImage {
+  RuntimeImageInfo info_{};
+  util::CodedBuffer header_;
+  StringPiece firstCodepoints_;
+  StringPiece rnnBosState_;
+
+ public:
+  /**
+   * Fingerprint of the full contents of the model part.
+   * It is computed on load only for parts which have an image section.
+   * @return 0 if the model does not contain the part
+   */
+  static u64 fingerprint(const ModelInfo& model, ModelPartKind kind);
+
+  /**
+   * Take sections which are valid for the model.
+   * Models without the image produce an empty one.
+   */
+  Status load(const ModelInfo& model);
+
+  /**
+   * Image of dic::FirstCodepointIndex of the model dictionary.
+   */
+  StringPiece firstCodepoints() const { return firstCodepoints_; }
+
+  /**
+   * Initial state of the model RNN.
+   */
+  StringPiece rnnBosState() const { return rnnBosState_; }
+
+  /**
+   * Data of sections must be alive until the image is saved.
+   */
+  void setFirstCodepoints(const ModelInfo& model, StringPiece data);
+  void setRnnBosState(const ModelInfo& model, StringPiece data);
+
+  void fill(ModelPart* part);
+};
+
+}  // namespace model
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_RUNTIME_IMAGE_H
@@ -0,0 +1,116 @@
+#include "runtime_image.h"
+#include <sstream>
+#include "core/dic/dic_builder.h"
+#include "core/dic/first_codepoint_index.h"
+#include "core/spec/spec_dsl.h"
+#include "model_io.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core;
+using namespace jumanpp::core::model;
+
+namespace {
+
+struct ImageTestModel {
+  spec::AnalysisSpec spec;
+  dic::DictionaryBuilder bldr;
+  ModelInfo info;
+  std::vector<std::string> keys;
+  dic::FirstCodepointIndexBuilder indexBldr;
+
+  explicit ImageTestModel(StringPiece csv) {
+    spec::dsl::ModelSpecBuilder msb;
+    auto& a = msb.field(1, "a").strings().trieIndex();
+    auto& b = msb.field(2, "b").strings();
+    msb.unigram({a, b});
+    REQUIRE_OK(msb.build(&spec));
+    REQUIRE_OK(bldr.importSpec(&spec));
+    REQUIRE_OK(bldr.importCsv("test", csv));
+    info.parts.emplace_back();
+    REQUIRE_OK(bldr.fillModelPart(&info.parts.back()));
+
+    // the dictionary has a codepoint trie, so it does not contain the index
+    std::stringstream lines{csv.str()};
+    std::string line;
+    while (std::getline(lines, line)) {
+      keys.push_back(line.substr(0, line.find(',')));
+    }
+    for (auto& key : keys) {
+      indexBldr.add(key);
+    }
+    REQUIRE_OK(indexBldr.build(bldr.result().trieContent));
+  }
+};
+
+}  // namespace
+
+TEST_CASE("runtime image is used in place from the model file") {
+  ImageTestModel model{"東京,a\n京都,b\n𠮷野家,c"};
+  dic::FirstCodepointIndex index;
+  REQUIRE_OK(index.load(model.indexBldr.result()));
+  RuntimeImage image;
+  image.setFirstCodepoints(model.info, index.image());
+  model.info.parts.emplace_back();
+  image.fill(&model.info.parts.back());
+
+  TempFile tf;
+  ModelSaver saver;
+  REQUIRE_OK(saver.open(tf.name()));
+  REQUIRE_OK(saver.save(model.info));
+
+  FilesystemModel file;
+  ModelInfo loaded;
+  REQUIRE_OK(file.open(tf.name()));
+  REQUIRE_OK(file.load(&loaded));
+  RuntimeImage loadedImage;
+  REQUIRE_OK(loadedImage.load(loaded));
+  CHECK(loadedImage.rnnBosState().size() == 0);
+  auto data = loadedImage.firstCodepoints();
+  REQUIRE(data == index.image());
+
+  dic::FirstCodepointIndex fromImage;
+  REQUIRE_OK(fromImage.loadImage(data));
+  CHECK(fromImage.image().begin() == data.begin());
+  auto info = fromImage.find(U'京');
+  REQUIRE(info != nullptr);
+  CHECK(info->maxLength == 2);
+  CHECK(fromImage.find(U'都') == nullptr);
+}
+
+TEST_CASE("runtime image is not used for a changed dictionary") {
+  ImageTestModel model{"東京,a\n京都,b"};
+  dic::FirstCodepointIndex index;
+  REQUIRE_OK(index.load(model.indexBldr.result()));
+  RuntimeImage image;
+  image.setFirstCodepoints(model.info, index.image());
+
+  ImageTestModel other{"東京,a\n大阪,b"};
+  other.info.parts.emplace_back();
+  image.fill(&other.info.parts.back());
+  RuntimeImage loaded;
+  REQUIRE_OK(loaded.load(other.info));
+  CHECK(loaded.firstCodepoints().size() == 0);
+
+  model.info.parts.emplace_back();
+  image.fill(&model.info.parts.back());
+  REQUIRE_OK(loaded.load(model.info));
+  CHECK(loaded.firstCodepoints() == index.image());
+}
+
+TEST_CASE("runtime image fingerprint covers the whole part") {
+  std::string data(3 * 4096 + 5, 'a');
+  ModelInfo info;
+  info.parts.push_back({ModelPartKind::Rnn, "", {data}});
+  auto original = RuntimeImage::fingerprint(info, ModelPartKind::Rnn);
+  CHECK(original != 0);
+  CHECK(RuntimeImage::fingerprint(info, ModelPartKind::Dictionary) == 0);
+
+  for (size_t pos : {size_t{0}, size_t{5000}, data.size() - 1}) {
+    CAPTURE(pos);
+    std::string changed = data;
+    changed[pos] = 'b';
+    info.parts[0].data[0] = changed;
+    CHECK(RuntimeImage::fingerprint(info, ModelPartKind::Rnn) != original);
+  }
+}
@@ -0,0 +1,68 @@
+#include "startup_profile.h"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+#if !defined(_WIN32_WINNT)
+#include <sys/resource.h>
+#endif
+
+namespace jumanpp {
+namespace core {
+
+u64 peakRssKb() {
+#if defined(_WIN32_WINNT)
+  return 0;
+#else
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#if defined(__APPLE__)
+  // reported in bytes on macOS
+  return static_cast<u64>(usage.ru_maxrss) / 1024;
+#else
+  return static_cast<u64>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+void StartupProfile::mark(StringPiece name) {
+  auto now = clock::now();
+  std::chrono::duration<double, std::milli> elapsed = now - last_;
+  phases_.push_back(StartupPhase{name.str(), elapsed.count(), peakRssKb()});
+  // do not count the time spent in mark itself
+  last_ = clock::now();
+}
+
+double StartupProfile::totalMillis() const {
+  double total = 0;
+  for (auto& p : phases_) {
+    total += p.millis;
+  }
+  return total;
+}
+
+void StartupProfile::print(std::ostream& os) const {
+  size_t width = 5;
+  for (auto& p : phases_) {
+    width = std::max(width, p.name.size());
+  }
+
+  auto flags = os.flags();
+  os << std::fixed << std::setprecision(3);
+  for (auto& p : phases_) {
+    os << std::left << std::setw(width) << p.name << std::right
+       << std::setw(12) << p.millis << " ms";
+    if (p.peakRssKb != 0) {
+      os << std::setw(12) << p.peakRssKb << " KB peak RSS";
+    }
+    os << "\n";
+  }
+  os << std::left << std::setw(width) << "total" << std::right << std::setw(12)
+     << totalMillis() << " ms\n";
+  os.flags(flags);
+}
+
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,54 @@
+#ifndef JUMANPP_STARTUP_PROFILE_H
+#define JUMANPP_STARTUP_PROFILE_H
+
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+
+struct StartupPhase {
+  std::string name;
+  double millis;
+  // peak resident set size of the process after the phase, 0 if unknown
+  u64 peakRssKb;
+};
+
+/**
+ * Measures wall time of consecutive initialization phases.
+ * Each call to mark() finishes a phase, which started at
+ * the previous mark() or at the construction/reset.
+ */
+class StartupProfile {
+  using clock = std::chrono::steady_clock;
+  std::vector<StartupPhase> phases_;
+  clock::time_point last_;
+
+ public:
+  StartupProfile() : last_{clock::now()} {}
+
+  void reset() {
+    phases_.clear();
+    last_ = clock::now();
+  }
+
+  void mark(StringPiece name);
+
+  const std::vector<StartupPhase>& phases() const { return phases_; }
+
+  double totalMillis() const;
+
+  void print(std::ostream& os) const;
+};
+
+// Peak resident set size of the current process, in kilobytes
+u64 peakRssKb();
+
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_STARTUP_PROFILE_H
@@ -0,0 +1,24 @@
+#include "startup_profile.h"
+#include <sstream>
+#include <vector>
+#include "testing/standalone_test.h"
+
+using namespace jumanpp::core;
+
+TEST_CASE("startup profile records phases in order") {
+  StartupProfile prof;
+  prof.mark("first");
+  std::vector<char> data(1024 * 1024, 'a');
+  prof.mark("second");
+  REQUIRE(prof.phases().size() == 2);
+  CHECK(prof.phases()[0].name == "first");
+  CHECK(prof.phases()[1].name == "second");
+  CHECK(prof.phases()[1].millis >= 0);
+  CHECK(prof.totalMillis() >= prof.phases()[1].millis);
+  std::stringstream ss;
+  prof.print(ss);
+  CHECK(ss.str().find("second") != std::string::npos);
+  CHECK(data[100] == 'a');
+  prof.reset();
+  CHECK(prof.phases().empty());
+}
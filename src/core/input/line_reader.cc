@@ -0,0 +1,220 @@
+#include "line_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32_WINNT
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace jumanpp {
+namespace core {
+namespace input {
+
+constexpr size_t LineReader::DefaultBlockSize;
+
+LineReader::~LineReader() {
+#ifndef _WIN32_WINNT
+  if (ownsFd_) {
+    ::close(fd_);
+  }
+#endif
+}
+
+void LineReader::reset(Mode mode, StringPiece name) {
+#ifndef _WIN32_WINNT
+  if (ownsFd_) {
+    ::close(fd_);
+  }
+#endif
+  mapping_.close();
+  mode_ = mode;
+  name_ = name.str();
+  fd_ = -1;
+  ownsFd_ = false;
+  stream_ = nullptr;
+  ownedStream_.reset();
+  error_.clear();
+  data_ = nullptr;
+  begin_ = 0;
+  end_ = 0;
+  exhausted_ = false;
+  if (mode != Mode::Mapped && buffer_.empty()) {
+    buffer_.resize(DefaultBlockSize);
+  }
+}
+
+Status LineReader::openFile(StringPiece filename) {
+  reset(Mode::Mapped, filename);
+  if (mapping_.open(filename)) {
+    auto contents = mapping_.contents();
+    data_ = contents.char_begin();
+    end_ = contents.size();
+    exhausted_ = true;
+    return Status::Ok();
+  }
+
+  // empty files and pipes can not be mapped
+#ifndef _WIN32_WINNT
+  int fd = ::open(name_.c_str(), O_RDONLY);
+  if (fd == -1) {
+    exhausted_ = true;
+    return JPPS_INVALID_PARAMETER << "failed to open input file " << filename
+                                  << ": " << std::strerror(errno);
+  }
+  openDescriptor(fd, filename);
+  ownsFd_ = true;
+#else
+  auto file = new std::ifstream{name_, std::ios::binary};
+  if (!file->is_open()) {
+    delete file;
+    exhausted_ = true;
+    return JPPS_INVALID_PARAMETER << "failed to open input file " << filename;
+  }
+  openStream(file, filename);
+  ownedStream_.reset(file);
+#endif
+  return Status::Ok();
+}
+
+void LineReader::openStream(std::istream* stream, StringPiece name) {
+  reset(Mode::Stream, name);
+  stream_ = stream;
+  data_ = buffer_.data();
+}
+
+#ifndef _WIN32_WINNT
+void LineReader::openDescriptor(int fd, StringPiece name) {
+  reset(Mode::Descriptor, name);
+  fd_ = fd;
+  data_ = buffer_.data();
+}
+#endif
+
+size_t LineReader::readLine() {
+  if (!std::getline(*stream_, temp_)) {
+    if (stream_->bad()) {
+      error_ = "failed to read from " + name_;
+    }
+    return 0;
+  }
+  if (!stream_->eof()) {
+    temp_.push_back('\n');
+  }
+  auto required = end_ + temp_.size();
+  if (required > buffer_.size()) {
+    buffer_.resize(std::max(required, buffer_.size() * 2));
+  }
+  std::memcpy(buffer_.data() + end_, temp_.data(), temp_.size());
+  return temp_.size();
+}
+
+size_t LineReader::readBlock() {
+#ifndef _WIN32_WINNT
+  if (end_ == buffer_.size()) {
+    // a line which is longer than the buffer
+    buffer_.resize(buffer_.size() * 2);
+  }
+  while (true) {
+    auto result = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+    if (result >= 0) {
+      return static_cast<size_t>(result);
+    }
+    if (errno != EINTR) {
+      error_ = "failed to read from " + name_ + ": " + std::strerror(errno);
+      return 0;
+    }
+  }
+#else
+  return 0;
+#endif
+}
+
+bool LineReader::inputAvailable() const {
+  switch (mode_) {
+    case Mode::Stream:
+      return stream_->rdbuf()->in_avail() > 0;
+#ifndef _WIN32_WINNT
+    case Mode::Descriptor: {
+      pollfd pfd{fd_, POLLIN, 0};
+      return ::poll(&pfd, 1, 0) == 1;
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+void LineReader::refill() {
+  if (exhausted_) {
+    return;
+  }
+
+  // flushing can be expensive (e.g. waiting for the analysis
+  // of submitted sentences), so do it only when a read will block
+  if (tie_ != nullptr && !inputAvailable()) {
+    tie_->flush();
+  }
+
+  auto remaining = end_ - begin_;
+  if (begin_ != 0) {
+    std::memmove(buffer_.data(), buffer_.data() + begin_, remaining);
+    begin_ = 0;
+    end_ = remaining;
+  }
+
+  auto read = mode_ == Mode::Stream ? readLine() : readBlock();
+  if (read == 0) {
+    exhausted_ = true;
+  }
+  end_ += read;
+  data_ = buffer_.data();
+}
+
+Status LineReader::status() const {
+  if (error_.empty()) {
+    return Status::Ok();
+  }
+  return JPPS_INVALID_STATE << error_;
+}
+
+bool LineReader::hasNext() {
+  while (begin_ == end_ && !exhausted_) {
+    refill();
+  }
+  return begin_ != end_;
+}
+
+bool LineReader::nextLine(StringPiece* line) {
+  while (true) {
+    auto start = data_ + begin_;
+    auto length = end_ - begin_;
+    if (length != 0) {
+      auto eol = static_cast<const char*>(std::memchr(start, '\n', length));
+      if (eol != nullptr) {
+        *line = StringPiece{start, eol};
+        begin_ = static_cast<size_t>(eol - data_) + 1;
+        return true;
+      }
+    }
+
+    if (exhausted_) {
+      if (length == 0) {
+        return false;
+      }
+      // the last line does not have a newline
+      *line = StringPiece{start, data_ + end_};
+      begin_ = end_;
+      return true;
+    }
+
+    refill();
+  }
+}
+
+}  // namespace input
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,107 @@
+#ifndef JUMANPP_LINE_READER_H
+#define JUMANPP_LINE_READER_H
+
+#include <istream>
+#include <memory>
+#include <vector>
+#include "util/mmap.h"
+#include "util/status.hpp"
+#include "util/string_piece.h"
+
+namespace jumanpp {
+namespace core {
+namespace input {
+
+/**
+ * Splits input into lines without per-line stream overhead.
+ *
+ * Files are memory-mapped and lines point directly into the mapping.
+ * Other inputs are read in large blocks, which are split in place.
+ * Newlines are located with memchr, which is vectorized
+ * by all major C libraries.
+ *
+ * Returned lines do not contain the newline character.
+ */
+class LineReader {
+  enum class Mode { None, Mapped, Descriptor, Stream };
+
+  Mode mode_ = Mode::None;
+  std::string name_;
+  util::FullyMappedFile mapping_;
+  int fd_ = -1;
+  bool ownsFd_ = false;
+  std::istream* stream_ = nullptr;
+  std::unique_ptr<std::istream> ownedStream_;
+  std::ostream* tie_ = nullptr;
+  std::string error_;
+
+  std::vector<char> buffer_;
+  std::string temp_;
+  const char* data_ = nullptr;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+  bool exhausted_ = true;
+
+  void reset(Mode mode, StringPiece name);
+  void refill();
+  bool inputAvailable() const;
+  size_t readLine();
+  size_t readBlock();
+
+ public:
+  static constexpr size_t DefaultBlockSize = 1024 * 1024;
+
+  LineReader() = default;
+  LineReader(const LineReader&) = delete;
+  LineReader& operator=(const LineReader&) = delete;
+  ~LineReader();
+
+  /**
+   * Memory-map the file. Files which can not be mapped
+   * (e.g. pipes) are read in blocks instead.
+   */
+  Status openFile(StringPiece filename);
+
+  /**
+   * Read from the stream.
+   * Streams are read line by line, so interactive input is not delayed.
+   */
+  void openStream(std::istream* stream, StringPiece name = "<stream>");
+
+#ifndef _WIN32_WINNT
+  /**
+   * Read from the file descriptor (e.g. stdin) in blocks.
+   * A read returns as soon as some input is available,
+   * so interactive input is not delayed.
+   */
+  void openDescriptor(int fd, StringPiece name);
+#endif
+
+  /**
+   * The stream is flushed every time the reader is going to wait for input,
+   * like std::ios::tie. Reads of already available input do not flush it.
+   */
+  void tie(std::ostream* output) { tie_ = output; }
+
+  bool hasNext();
+  bool nextLine(StringPiece* line);
+
+  /**
+   * Lines stay valid while this reader is alive.
+   * Otherwise, a line is valid only until the next call of nextLine.
+   */
+  bool stableLines() const { return mode_ == Mode::Mapped; }
+
+  StringPiece name() const { return name_; }
+
+  /**
+   * Error which happened while reading the input, if any.
+   */
+  Status status() const;
+};
+
+}  // namespace input
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_LINE_READER_H
@@ -0,0 +1,154 @@
+#include "line_reader.h"
+#include <fstream>
+#include <sstream>
+#include "stream_reader.h"
+#include "testing/standalone_test.h"
+#include "util/buffered_output.h"
+
+#ifndef _WIN32_WINNT
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace jumanpp;
+using namespace jumanpp::core::input;
+
+namespace {
+
+std::vector<std::string> allLines(LineReader* rdr) {
+  std::vector<std::string> result;
+  StringPiece line;
+  while (rdr->hasNext()) {
+    REQUIRE(rdr->nextLine(&line));
+    result.push_back(line.str());
+  }
+  CHECK_FALSE(rdr->nextLine(&line));
+  CHECK_OK(rdr->status());
+  return result;
+}
+
+void writeFile(const TempFile& file, StringPiece data) {
+  std::ofstream out{file.name(), std::ios::binary};
+  out.write(data.char_begin(), data.size());
+}
+
+}  // namespace
+
+TEST_CASE("line reader reads a mapped file") {
+  TempFile file;
+  writeFile(file, "a\nbc\n\ndef");
+  LineReader rdr;
+  REQUIRE_OK(rdr.openFile(file.name()));
+  CHECK(rdr.stableLines());
+  std::vector<std::string> expected{"a", "bc", "", "def"};
+  CHECK(allLines(&rdr) == expected);
+}
+
+TEST_CASE("line reader reads an empty file") {
+  TempFile file;
+  writeFile(file, "");
+  LineReader rdr;
+  REQUIRE_OK(rdr.openFile(file.name()));
+  CHECK_FALSE(rdr.hasNext());
+  CHECK(allLines(&rdr).empty());
+}
+
+TEST_CASE("line reader reports missing files") {
+  LineReader rdr;
+  CHECK_FALSE(rdr.openFile("this/file/does/not/exist"));
+}
+
+TEST_CASE("line reader reads a stream") {
+  std::stringstream ss{"a\nbc\n\ndef\n"};
+  LineReader rdr;
+  rdr.openStream(&ss);
+  CHECK_FALSE(rdr.stableLines());
+  std::vector<std::string> expected{"a", "bc", "", "def"};
+  CHECK(allLines(&rdr) == expected);
+}
+
+#ifndef _WIN32_WINNT
+TEST_CASE("line reader reads lines longer than the block size") {
+  TempFile file;
+  std::string longLine(LineReader::DefaultBlockSize * 2 + 5, 'x');
+  writeFile(file, "a\n" + longLine + "\nb\n");
+  int fd = ::open(file.name().c_str(), O_RDONLY);
+  REQUIRE(fd != -1);
+  LineReader rdr;
+  rdr.openDescriptor(fd, file.name());
+  std::vector<std::string> expected{"a", longLine, "b"};
+  CHECK(allLines(&rdr) == expected);
+  ::close(fd);
+}
+#endif
+
+TEST_CASE("line reader does not flush the tied stream for available input") {
+  std::stringstream in{"a\nb\n"};
+  std::stringstream sink;
+  util::BufferedOutput out{&sink};
+  LineReader rdr;
+  rdr.openStream(&in);
+  rdr.tie(&out);
+  StringPiece line;
+  REQUIRE(rdr.nextLine(&line));
+  out << "result";
+  REQUIRE(rdr.nextLine(&line));
+  CHECK(line == "b");
+  CHECK(sink.str().empty());
+}
+
+TEST_CASE("line reader flushes the tied stream before waiting for input") {
+  std::stringstream sink;
+  util::BufferedOutput out{&sink};
+  // behaves like an interactive input: nothing is available in advance
+  struct SlowInput : std::streambuf {
+    std::vector<std::string> chunks{"a\n", "b\n"};
+    std::vector<std::string> sinkOnRead;
+    std::string current;
+    std::stringstream* sink;
+
+    int_type underflow() override {
+      if (chunks.empty()) {
+        return traits_type::eof();
+      }
+      sinkOnRead.push_back(sink->str());
+      current = chunks.front();
+      chunks.erase(chunks.begin());
+      setg(&current[0], &current[0], &current[0] + current.size());
+      return traits_type::to_int_type(current[0]);
+    }
+  } input;
+  input.sink = &sink;
+  std::istream in{&input};
+  LineReader rdr;
+  rdr.openStream(&in);
+  rdr.tie(&out);
+  StringPiece line;
+  REQUIRE(rdr.nextLine(&line));
+  out << "result";
+  REQUIRE(rdr.nextLine(&line));
+  CHECK(line == "b");
+  std::vector<std::string> expected{"", "result"};
+  CHECK(input.sinkOnRead == expected);
+}
+
+TEST_CASE("plain stream reader reads examples from a line reader") {
+  TempFile file;
+  writeFile(file, "# S-ID:1\nfirst\nsecond\n# S-ID:3\n");
+  LineReader rdr;
+  REQUIRE_OK(rdr.openFile(file.name()));
+  PlainStreamReader psr;
+  StringPiece input;
+  REQUIRE_OK(psr.readExample(&rdr));
+  CHECK(psr.comment() == "S-ID:1");
+  CHECK(psr.rawInput(&input));
+  CHECK(input == "first");
+  REQUIRE_OK(psr.readExample(&rdr));
+  CHECK(psr.comment() == EMPTY_SP);
+  CHECK(psr.rawInput(&input));
+  CHECK(input == "second");
+  REQUIRE_OK(psr.readExample(&rdr));
+  CHECK(psr.rawInput(&input));
+  CHECK(input == EMPTY_SP);
+  CHECK_FALSE(rdr.hasNext());
+}
@@ -21,6 +21,8 @@ struct PexStreamReaderImpl : public analysis::ScorePlugin {
   std::string buffer_;
   std::string temp_;
 
+  Status parseBuffer();
+
   bool updateScore(const analysis::Lattice *l,
                    const analysis::ConnectionPtr &ptr,
                    float *score) const override {
@@ -50,9 +52,29 @@ Status PexStreamReader::readExample(std::istream *stream) {
     buf.append(tmp);
     buf.push_back('\n');
   }
-  JPP_RETURN_IF_ERROR(impl_->reader_.setData(buf));
+  return impl_->parseBuffer();
+}
+
+Status PexStreamReader::readExample(LineReader *lines) {
+  auto &buf = impl_->buffer_;
+  buf.clear();
+  StringPiece line;
+  while (lines->nextLine(&line)) {
+    if (line.size() == 0) {
+      break;
+    }
+    buf.append(line.char_begin(), line.char_end());
+    buf.push_back('\n');
+  }
+  JPP_RETURN_IF_ERROR(lines->status());
+  return impl_->parseBuffer();
+}
+
+Status PexStreamReaderImpl::parseBuffer() {
+  auto &buf = buffer_;
+  JPP_RETURN_IF_ERROR(reader_.setData(buf));
   bool eof = false;
-  JPP_RETURN_IF_ERROR(impl_->reader_.readExample(&impl_->example_, &eof));
+  JPP_RETURN_IF_ERROR(reader_.readExample(&example_, &eof));
   if (!eof) {
     return Status::InvalidState() << "Could not parse full example: [\n"
                                   << buf << "\n]";
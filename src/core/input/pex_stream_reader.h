@@ -25,6 +25,7 @@ class PexStreamReader : public StreamReader {
   Status initialize(const CoreHolder &core, char32_t noBreak = U'&');
   Status initialize(const PexStreamReader &other);
   Status readExample(std::istream *stream) override;
+  Status readExample(LineReader *lines) override;
   Status analyzeWith(analysis::Analyzer *an) override;
   StringPiece comment() override;
   StringPiece surface() const;
@@ -20,15 +20,45 @@ Status PlainStreamReader::readExample(std::istream *stream) {
     }
   }
 
+  inputView_ = input_;
+  return checkSizes();
+}
+
+Status PlainStreamReader::readExample(LineReader *lines) {
+  comment_.clear();
+  StringPiece line;
+  while (true) {
+    if (!lines->nextLine(&line)) {
+      line = EMPTY_SP;
+      break;
+    }
+    if (line.size() > 2 && line[0] == '#' && line[1] == ' ') {
+      comment_.assign(line.char_begin(), line.char_end());
+    } else {
+      break;
+    }
+  }
+  JPP_RETURN_IF_ERROR(lines->status());
+
+  if (lines->stableLines()) {
+    inputView_ = line;
+  } else {
+    input_.assign(line.char_begin(), line.char_end());
+    inputView_ = input_;
+  }
+  return checkSizes();
+}
+
+Status PlainStreamReader::checkSizes() const {
   if (comment_.size() > maxCommentLength_) {
     return Status::InvalidParameter()
            << "Comment size was: " << comment_.size()
            << " which is more than max: " << maxCommentLength_;
   }
 
-  if (input_.size() > maxInputLength_) {
+  if (inputView_.size() > maxInputLength_) {
     return Status::InvalidParameter()
-           << "Input size was: " << input_.size()
+           << "Input size was: " << inputView_.size()
            << " which is more than max: " << maxInputLength_;
   }
 
@@ -6,6 +6,7 @@
 #define JUMANPP_STREAM_READER_H
 
 #include "core/analysis/analyzer.h"
+#include "core/input/line_reader.h"
 #include "util/status.hpp"
 
 namespace jumanpp {
@@ -15,17 +16,29 @@ namespace input {
 class StreamReader {
  public:
   virtual Status readExample(std::istream* stream) = 0;
+  virtual Status readExample(LineReader* lines) = 0;
   virtual Status analyzeWith(analysis::Analyzer* an) = 0;
   virtual StringPiece comment() = 0;
+
+  /**
+   * Get the raw input of the current example if the analysis result
+   * depends only on it and the comment (e.g. there are no annotations).
+   * Used for caching analysis results.
+   */
+  virtual bool rawInput(StringPiece* result) { return false; }
   virtual ~StreamReader() = default;
 };
 
 class PlainStreamReader : public StreamReader {
   std::string input_;
+  // points either to input_ or to a line of a LineReader with stable lines
+  StringPiece inputView_;
   std::string comment_;
   u64 maxInputLength_ = 4096;
   u64 maxCommentLength_ = 4096;
 
+  Status checkSizes() const;
+
  public:
   void setMaxSizes(u64 inputLength, u64 commentLength) {
     maxInputLength_ = inputLength;
@@ -33,8 +46,9 @@ class PlainStreamReader : public StreamReader {
   }
 
   virtual Status readExample(std::istream* stream) override;
+  virtual Status readExample(LineReader* lines) override;
   virtual Status analyzeWith(analysis::Analyzer* an) override {
-    JPP_RETURN_IF_ERROR(an->analyze(input_));
+    JPP_RETURN_IF_ERROR(an->analyze(inputView_));
     return Status::Ok();
   }
   virtual StringPiece comment() override {
@@ -43,6 +57,10 @@ class PlainStreamReader : public StreamReader {
     }
     return StringPiece{comment_}.from(2);
   }
+  virtual bool rawInput(StringPiece* result) override {
+    *result = inputView_;
+    return true;
+  }
 };
 
 }  // namespace input
@@ -105,6 +105,8 @@ class PrimFeatureTestEnv {
     CHECK_OK(top1.fillIn(tenv.analyzer->lattice()));
   }
 
+  const AnalysisStats& stats() const { return tenv.analyzer->stats(); }
+
   size_t numNodeSeeds() const {
     return tenv.analyzer->latticeBuilder().seeds().size();
   }
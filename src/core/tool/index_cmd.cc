@@ -3,6 +3,8 @@
 //
 
 #include "index_cmd.h"
+#include <algorithm>
+#include <thread>
 #include "core/dic/dic_builder.h"
 #include "core/impl/model_io.h"
 #include "core/spec/spec_parser.h"
@@ -26,6 +28,13 @@ void IndexTool::setProgressCallback(ProgressCallback* callback) {
   impl_->builder.setProgress(callback);
 }
 
+void IndexTool::setNumThreads(u32 numThreads) {
+  if (numThreads == 0) {
+    numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  impl_->builder.setNumThreads(numThreads);
+}
+
 Status IndexTool::indexDictionary(StringPiece specFile, StringPiece dicFile) {
   JPP_RETURN_IF_ERROR(spec::parseFromFile(specFile, &impl_->rawSpec));
   JPP_RETURN_IF_ERROR(impl_->builder.importSpec(&impl_->rawSpec));
@@ -9,6 +9,7 @@
 
 #include "util/status.hpp"
 #include "util/string_piece.h"
+#include "util/types.hpp"
 
 namespace jumanpp {
 namespace core {
@@ -27,6 +28,10 @@ class IndexTool {
   ~IndexTool();
 
   void setProgressCallback(ProgressCallback* callback);
+  /**
+   * 0 uses all available cores
+   */
+  void setNumThreads(u32 numThreads);
   Status indexDictionary(StringPiece specFile, StringPiece dicFile);
   Status saveModel(StringPiece outputFile, StringPiece dicComment);
 };
@@ -17,6 +17,9 @@
 #include "core/dic/progress.h"
 #include "core/tool/codegen_cmd.h"
 #include "core/tool/index_cmd.h"
+#include "core/tool/plugin_cmd.h"
+#include "core/tool/prebuild_cmd.h"
+#include "core/tool/quantize_cmd.h"
 #include "core/tool/train_cmd.h"
 #include "core/training/training_env.h"
 #include "rnn/rnn_arg_parse.h"
@@ -39,7 +42,15 @@ void copyValue(T1& out, args::Base& flag, const T1& val) {
   }
 }
 
-enum class ToolMode { Index, Train, EmbedRnn, StaticFeatures };
+enum class ToolMode {
+  Index,
+  Train,
+  EmbedRnn,
+  StaticFeatures,
+  Quantize,
+  Prebuild,
+  FeaturePlugin
+};
 
 namespace t = ::jumanpp::core::training;
 
@@ -47,6 +58,9 @@ struct JumanppToolArgs {
   std::string specFile;
   std::string dictFile;
   std::string comment;
+  std::string pluginDir;
+  i32 quantizeBits = 8;
+  u32 indexThreads = 1;
 
   t::TrainingArguments trainArgs;
 
@@ -72,6 +86,20 @@ struct JumanppToolArgs {
                            "Embed a RNN into a trained model"};
     args::Command staticFeatures{commandGroup, "static-features",
                                  "Generate a C++ code for feature processing"};
+    args::Command quantize{
+        commandGroup, "quantize",
+        "Embed linear model weights quantized to 8 or 16 bits into a model. "
+        "They are used by Juman++ built with the same JPP_WEIGHT_BITS."};
+    args::Command prebuild{
+        commandGroup, "prebuild",
+        "Embed structures which are computed on every model load into a "
+        "model. They are used directly from the model file and are shared "
+        "by processes which use it."};
+    args::Command featurePlugin{
+        commandGroup, "feature-plugin",
+        "Generate and compile static feature code for a model into a shared "
+        "library. Juman++ uses it instead of dynamic features when it is in "
+        "the model directory."};
 
     args::HelpFlag help{globalParams,
                         "Help",
@@ -80,6 +108,12 @@ struct JumanppToolArgs {
 
     args::ValueFlag<std::string> dictFile{
         index, "FILE", "A raw dictionary file to index", {"dict-file"}};
+    args::ValueFlag<u32> indexThreads{
+        index,
+        "N",
+        "# of threads for indexing, 1 (default) builds serially, "
+        "0 uses all available cores",
+        {"index-threads"}};
 
     args::ValueFlag<std::string> specFile{
         globalParams, "FILE", "Analysis Spec file", {"spec"}};
@@ -159,6 +193,13 @@ struct JumanppToolArgs {
         trainingParams, "BATCH", "Batch Size, 1 default", {"batch"}, 1};
     args::ValueFlag<u32> numThreads{
         trainingParams, "THREADS", "# of threads, 1 default", {"threads"}, 1};
+    args::ValueFlag<u32> updateStripes{
+        trainingParams,
+        "STRIPES",
+        "Experimental: apply SCW updates in training threads, locking weights "
+        "in STRIPES parts (0 = apply updates serially, default)",
+        {"parallel-updates"},
+        0};
     args::ValueFlag<u32> maxBatchIters{trainingParams,
                                        "BATCH_ITERS",
                                        "max # of batch iterations",
@@ -196,8 +237,33 @@ struct JumanppToolArgs {
         "Filename of fasterrnn trained model. It will be embedded inside the "
         "Juman++ model. RNN parameters will be embedded as well.",
         {"rnn-model"}};
+    args::ValueFlag<std::string> embedRnnInput{
+        embedRnn, "FILENAME", "Trained model", {"model-input"}};
+    args::ValueFlag<i32> rnnBits{
+        embedRnn,
+        "BITS",
+        "Also embed RNN embeddings and maxent weights quantized to 8 or 16 "
+        "bits, they are used instead of floats (0 = no quantization, default)",
+        {"rnn-bits"},
+        0};
     RnnArgs rnnArgs{embedRnn};
 
+    args::ValueFlag<std::string> quantizeInput{
+        quantize, "FILENAME", "Trained model", {"model-input"}};
+    args::ValueFlag<i32> quantizeBits{
+        quantize, "BITS", "Bits per weight: 8 (default) or 16", {"bits"}, 8};
+
+    args::ValueFlag<std::string> prebuildInput{
+        prebuild, "FILENAME", "Trained model", {"model-input"}};
+
+    args::ValueFlag<std::string> pluginInput{
+        featurePlugin, "FILENAME", "Trained model", {"model-input"}};
+    args::ValueFlag<std::string> pluginDir{
+        featurePlugin,
+        "DIR",
+        "Output directory, the directory of the model by default",
+        {"plugin-dir"}};
+
     args::ValueFlag<std::string> cgClassName{
         staticFeatures,
         "NAME",
@@ -230,11 +296,17 @@ struct JumanppToolArgs {
     copyValue(result->mode, train, ToolMode::Train);
     copyValue(result->mode, embedRnn, ToolMode::EmbedRnn);
     copyValue(result->mode, staticFeatures, ToolMode::StaticFeatures);
+    copyValue(result->mode, quantize, ToolMode::Quantize);
+    copyValue(result->mode, prebuild, ToolMode::Prebuild);
+    copyValue(result->mode, featurePlugin, ToolMode::FeaturePlugin);
 
     copyValue(result->specFile, specFile);
     copyValue(result->dictFile, dictFile);
     copyValue(result->comment, comment);
     copyValue(result->comment, cgClassName);
+    copyValue(result->quantizeBits, quantizeBits);
+    copyValue(result->indexThreads, indexThreads);
+    copyValue(result->pluginDir, pluginDir);
 
     auto trg = &result->trainArgs;
     trg->trainingConfig.beamSize = beamSize.Get();
@@ -244,16 +316,22 @@ struct JumanppToolArgs {
     trg->batchSize = batchSize.Get();
     trg->numThreads = numThreads.Get();
     trg->modelFilename = modelFile.Get();
+    copyValue(trg->modelFilename, embedRnnInput);
+    copyValue(trg->modelFilename, quantizeInput);
+    copyValue(trg->modelFilename, prebuildInput);
+    copyValue(trg->modelFilename, pluginInput);
     trg->outputFilename = modelOutput.Get();
     trg->corpusFilename = corpusFile.Get();
     trg->partialCorpus = partialCorpus.Get();
     trg->rnnModelFilename = rnnFile.Get();
+    trg->rnnQuantizeBits = rnnBits.Get();
     auto sizeExp = paramSizeExponent.Get();
     trg->trainingConfig.featureNumberExponent = sizeExp;
     trg->trainingConfig.randomSeed = randomSeed.Get();
     trg->trainingConfig.mode = trainMode.Get();
     trg->trainingConfig.scw.C = scwC.Get();
     trg->trainingConfig.scw.phi = scwPhi.Get();
+    trg->trainingConfig.scw.updateStripes = updateStripes.Get();
     trg->batchMaxIterations = maxBatchIters.Get();
     trg->maxEpochs = maxEpochs.Get();
     trg->batchLossEpsilon = epsilon.Get();
@@ -318,6 +396,7 @@ void invokeTool(const JumanppToolArgs& args) {
       core::tool::IndexTool tool;
       StdoutProgressReporter progress;
       tool.setProgressCallback(&progress);
+      tool.setNumThreads(args.indexThreads);
 
       std::cout << "Indexing a dictionary!";
       std::cout << "\nSpec: " << args.specFile;
@@ -331,12 +410,26 @@ void invokeTool(const JumanppToolArgs& args) {
       break;
     }
     case ToolMode::Train:
+    case ToolMode::EmbedRnn:
       invokeTrain(args.trainArgs);
       return;
     case ToolMode::StaticFeatures:
       dieOnError(core::tool::generateStaticFeatures(
           args.specFile, args.trainArgs.outputFilename, args.comment));
       return;
+    case ToolMode::Quantize:
+      dieOnError(core::tool::quantizeModel(args.trainArgs.modelFilename,
+                                           args.trainArgs.outputFilename,
+                                           args.quantizeBits));
+      return;
+    case ToolMode::Prebuild:
+      dieOnError(core::tool::prebuildModel(args.trainArgs.modelFilename,
+                                           args.trainArgs.outputFilename));
+      return;
+    case ToolMode::FeaturePlugin:
+      dieOnError(core::tool::buildFeaturePlugin(args.trainArgs.modelFilename,
+                                                args.pluginDir));
+      return;
     default:
       std::cerr << "The tool is not implemented\n";
       exit(5);
@@ -0,0 +1,127 @@
+#include "plugin_cmd.h"
+#include <algorithm>
+#include <cstdlib>
+#include "core/codegen/feature_codegen.h"
+#include "core/dic/dic_builder.h"
+#include "core/impl/feature_plugin.h"
+#include "core/impl/model_io.h"
+#include "core/spec/spec_hashing.h"
+#include "core_config.h"
+#include "pathie-cpp/include/errors.hpp"
+#include "pathie-cpp/include/path.hpp"
+#include "util/format.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+namespace {
+
+bool hasPluginHeaders(StringPiece includes) {
+  auto first = includes.str();
+  first = first.substr(0, first.find(';'));
+  return (Pathie::Path{first} / "core/features_api.h").exists();
+}
+
+std::string compileCommand(const Pathie::Path& directory,
+                           const Pathie::Path& source,
+                           const Pathie::Path& library) {
+  StringPiece includes = JPP_PLUGIN_SOURCE_INCLUDES;
+  StringPiece link = JPP_PLUGIN_SOURCE_LINK;
+  if (!hasPluginHeaders(includes)) {
+    includes = JPP_PLUGIN_INSTALL_INCLUDES;
+    link = JPP_PLUGIN_INSTALL_LINK;
+  }
+
+#ifdef _MSC_VER
+  constexpr const char* includeOpt = "/I";
+#else
+  constexpr const char* includeOpt = "-I";
+#endif
+
+  std::string command =
+      fmt::format("\"{0}\" {1} {2}\"{3}\"", JPP_PLUGIN_CXX,
+                  JPP_PLUGIN_CXX_FLAGS, includeOpt, directory.str());
+  auto dirs = includes.str();
+  size_t start = 0;
+  while (start < dirs.size()) {
+    auto end = std::min(dirs.find(';', start), dirs.size());
+    command += fmt::format(" {0}\"{1}\"", includeOpt,
+                           dirs.substr(start, end - start));
+    start = end + 1;
+  }
+
+#ifdef _MSC_VER
+  command += fmt::format(" /Fe\"{0}\" \"{1}\"", library.str(), source.str());
+  if (!link.empty()) {
+    command += fmt::format(" /link \"{0}\"", link.str());
+  }
+#else
+  command += fmt::format(" -o \"{0}\" \"{1}\"", library.str(), source.str());
+#endif
+
+#ifdef _WIN32
+  // cmd.exe strips the outer quotes of a command
+  command = "\"" + command + "\"";
+#endif
+  return command;
+}
+
+}  // namespace
+
+Status buildFeaturePlugin(StringPiece modelFile, StringPiece outputDir) {
+  model::FilesystemModel file;
+  model::ModelInfo info;
+  JPP_RETURN_IF_ERROR(file.open(modelFile));
+  JPP_RETURN_IF_ERROR(file.load(&info));
+  dic::BuiltDictionary dic;
+  JPP_RETURN_IF_ERROR(dic.restoreDictionary(info));
+
+  auto specHash = spec::hashSpec(dic.spec);
+  try {
+    Pathie::Path directory;
+    if (outputDir.empty()) {
+      directory = Pathie::Path{modelFile.str()}.parent();
+    } else {
+      directory = Pathie::Path{outputDir.str()};
+      directory.mktree();
+    }
+
+    features::codegen::FeatureCodegenConfig cfg;
+    cfg.className = "FeaturePlugin";
+    cfg.baseDirectory = directory.str();
+    cfg.filename = fmt::format("jpp_features_{0:016x}", specHash);
+    cfg.pluginEntry = true;
+
+    features::codegen::StaticFeatureCodegen codegen{cfg, dic.spec};
+    JPP_RETURN_IF_ERROR(codegen.generateAndWrite());
+
+    auto source = directory / (cfg.filename + ".cc");
+    auto header = directory / (cfg.filename + ".h");
+    auto library = directory / features::FeaturePlugin::filename(specHash);
+
+    if (!hasPluginHeaders(JPP_PLUGIN_SOURCE_INCLUDES) &&
+        !hasPluginHeaders(JPP_PLUGIN_INSTALL_INCLUDES)) {
+      return JPPS_INVALID_STATE
+             << "Juman++ headers for compiling feature plugins were not found "
+             << "in " << JPP_PLUGIN_SOURCE_INCLUDES << " or "
+             << JPP_PLUGIN_INSTALL_INCLUDES;
+    }
+    auto command = compileCommand(directory, source, library);
+    if (std::system(command.c_str()) != 0) {
+      return JPPS_INVALID_STATE
+             << "failed to compile the feature plugin, command: " << command;
+    }
+
+    source.remove();
+    header.remove();
+  } catch (Pathie::PathieError& e) {
+    return JPPS_INVALID_STATE << "failed to create the feature plugin: "
+                              << e.what();
+  }
+  return Status::Ok();
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,23 @@
+#ifndef JUMANPP_PLUGIN_CMD_H
+#define JUMANPP_PLUGIN_CMD_H
+
+#include "util/status.hpp"
+#include "util/string_piece.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+/**
+ * Generate static feature code for the spec of a model and compile it into
+ * a feature plugin in the output directory (the model directory if empty).
+ * The plugin is compiled with the compiler and flags of this build,
+ * against headers of its source tree or of the installed Juman++.
+ */
+Status buildFeaturePlugin(StringPiece modelFile, StringPiece outputDir);
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_PLUGIN_CMD_H
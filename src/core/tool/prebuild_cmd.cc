@@ -0,0 +1,58 @@
+#include "prebuild_cmd.h"
+#include <algorithm>
+#include "core/analysis/rnn_scorer_gbeam.h"
+#include "core/dic/dic_builder.h"
+#include "core/dic/first_codepoint_index.h"
+#include "core/impl/model_io.h"
+#include "core/impl/runtime_image.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+Status prebuildModel(StringPiece inputFile, StringPiece outputFile) {
+  if (inputFile == outputFile) {
+    return JPPS_INVALID_PARAMETER
+           << "prebuilt model must be written to a different file";
+  }
+
+  model::FilesystemModel input;
+  model::ModelInfo info;
+  JPP_RETURN_IF_ERROR(input.open(inputFile));
+  JPP_RETURN_IF_ERROR(input.load(&info));
+
+  model::RuntimeImage image;
+
+  dic::BuiltDictionary dic;
+  JPP_RETURN_IF_ERROR(dic.restoreDictionary(info));
+  dic::FirstCodepointIndex index;
+  if (dic.firstCodepointIndex.size() != 0) {
+    JPP_RETURN_IF_ERROR(index.load(dic.firstCodepointIndex));
+  }
+  image.setFirstCodepoints(info, index.image());
+
+  analysis::RnnScorerGbeamFactory rnn;
+  if (info.firstPartOf(model::ModelPartKind::Rnn) != nullptr) {
+    JPP_RETURN_IF_ERROR(rnn.load(info));
+    image.setRnnBosState(info, rnn.bosStateData());
+  }
+
+  auto& parts = info.parts;
+  parts.erase(std::remove_if(parts.begin(), parts.end(),
+                             [](const model::ModelPart& p) {
+                               return p.kind ==
+                                      model::ModelPartKind::RuntimeImage;
+                             }),
+              parts.end());
+  parts.emplace_back();
+  image.fill(&parts.back());
+
+  model::ModelSaver saver;
+  JPP_RETURN_IF_ERROR(saver.open(outputFile));
+  JPP_RETURN_IF_ERROR(saver.save(info));
+  return Status::Ok();
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
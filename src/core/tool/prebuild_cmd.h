@@ -0,0 +1,21 @@
+#ifndef JUMANPP_PREBUILD_CMD_H
+#define JUMANPP_PREBUILD_CMD_H
+
+#include "util/status.hpp"
+#include "util/string_piece.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+/**
+ * Copy a model, embedding an image of read-only structures which are
+ * otherwise computed from the model on every load (see model::RuntimeImage).
+ */
+Status prebuildModel(StringPiece inputFile, StringPiece outputFile);
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_PREBUILD_CMD_H
@@ -0,0 +1,42 @@
+#include "quantize_cmd.h"
+#include <algorithm>
+#include "core/analysis/perceptron.h"
+#include "core/impl/model_io.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+Status quantizeModel(StringPiece inputFile, StringPiece outputFile, i32 bits) {
+  if (inputFile == outputFile) {
+    return JPPS_INVALID_PARAMETER
+           << "quantized model must be written to a different file";
+  }
+
+  model::FilesystemModel input;
+  model::ModelInfo info;
+  JPP_RETURN_IF_ERROR(input.open(inputFile));
+  JPP_RETURN_IF_ERROR(input.load(&info));
+
+  analysis::QuantizedPerceptronPart quantized;
+  JPP_RETURN_IF_ERROR(quantized.build(info, bits));
+
+  auto& parts = info.parts;
+  parts.erase(std::remove_if(parts.begin(), parts.end(),
+                             [](const model::ModelPart& p) {
+                               return p.kind == model::ModelPartKind::
+                                                   QuantizedPerceptron;
+                             }),
+              parts.end());
+  parts.emplace_back();
+  quantized.fill(&parts.back());
+
+  model::ModelSaver saver;
+  JPP_RETURN_IF_ERROR(saver.open(outputFile));
+  JPP_RETURN_IF_ERROR(saver.save(info));
+  return Status::Ok();
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,22 @@
+#ifndef JUMANPP_QUANTIZE_CMD_H
+#define JUMANPP_QUANTIZE_CMD_H
+
+#include "util/status.hpp"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+/**
+ * Copy a trained model, embedding its linear model weights
+ * quantized to 8 or 16 bits.
+ */
+Status quantizeModel(StringPiece inputFile, StringPiece outputFile, i32 bits);
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_QUANTIZE_CMD_H
@@ -3,6 +3,7 @@
 //
 
 #include "train_cmd.h"
+#include "core/analysis/rnn_scorer_gbeam.h"
 #include "core/env.h"
 #include "util/logging.hpp"
 
@@ -105,6 +106,28 @@ int doTrainJpp(const t::TrainingArguments& args, core::JumanppEnv& env) {
   return saveModel(args, model);
 }
 
+int doEmbedRnn(const t::TrainingArguments& args, core::JumanppEnv& env) {
+  LOG_INFO() << "embedding the rnn into the model file";
+
+  core::analysis::RnnScorerGbeamFactory rnnHolder;
+  Status s = rnnHolder.make(args.rnnModelFilename, env.coreHolder()->dic(),
+                            args.rnnConfig);
+  if (!s) {
+    LOG_ERROR() << "failed to initialize rnn: " << s;
+    return 1;
+  }
+
+  auto info = env.modelInfoCopy();
+
+  s = rnnHolder.makeInfo(&info, args.comment, args.rnnQuantizeBits);
+  if (!s) {
+    LOG_ERROR() << "failed to add rnn info to the model: " << s;
+    return 1;
+  }
+
+  return saveModel(args, info);
+}
+
 }  // namespace
 
 int trainCommandImpl(const training::TrainingArguments& args) {
@@ -120,8 +143,7 @@ int trainCommandImpl(const training::TrainingArguments& args) {
     return doTrainJpp(args, env);
   }
 
-  LOG_ERROR() << "Model filename is empty";
-  return 1;
+  return doEmbedRnn(args, env);
 }
 
 }  // namespace tool
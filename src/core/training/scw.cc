@@ -3,6 +3,7 @@
 //
 
 #include "scw.h"
+#include <algorithm>
 #include <cmath>
 #include <random>
 #include "core/impl/model_io.h"
@@ -36,7 +37,81 @@ void SoftConfidenceWeighted::update(float loss,
   updateMatrix((float)betat, features);
 }
 
-void SoftConfidenceWeighted::updateWeights(
+template <typename Fn>
+void SoftConfidenceWeighted::forEachStripe(
+    util::ArraySlice<ScoredFeature> sorted, Fn fn) {
+  auto begin = sorted.begin();
+  auto end = sorted.end();
+  while (begin != end) {
+    auto stripe = begin->feature >> stripeShift_;
+    auto stripeEnd = begin + 1;
+    while (stripeEnd != end &&
+           (stripeEnd->feature >> stripeShift_) == stripe) {
+      ++stripeEnd;
+    }
+    std::lock_guard<std::mutex> lock{stripeLocks_[stripe]};
+    fn(util::ArraySlice<ScoredFeature>{begin,
+                                       static_cast<size_t>(stripeEnd - begin)});
+    begin = stripeEnd;
+  }
+}
+
+void SoftConfidenceWeighted::updateConcurrent(
+    float loss, util::ArraySlice<ScoredFeature> features,
+    std::vector<ScoredFeature>* buffer) {
+  JPP_DCHECK(concurrentUpdates());
+  if (loss < 1e-5) {
+    return;
+  }
+
+  buffer->assign(features.begin(), features.end());
+  std::stable_sort(buffer->begin(), buffer->end(),
+                   [](const ScoredFeature& a, const ScoredFeature& b) {
+                     return a.feature < b.feature;
+                   });
+
+  double score = 0;
+  double vt = 0;
+  forEachStripe(*buffer, [&](util::ArraySlice<ScoredFeature> part) {
+    score += calcScore(part);
+    vt += calcVt(part);
+  });
+
+  double alphat = calcAlpha(vt, loss * score);
+  double ut = calcUt(alphat, vt);
+  double betat = calcBeta(alphat, ut, vt);
+
+  JPP_DCHECK(std::isfinite(betat));
+  JPP_DCHECK(std::isfinite(alphat));
+  if (vt == 0) {
+    return;
+  }
+
+  forEachStripe(*buffer, [&](util::ArraySlice<ScoredFeature> part) {
+    updateWeights((float)alphat, loss, part);
+    updateMatrix((float)betat, part);
+  });
+}
+
+void SoftConfidenceWeighted::enableConcurrentUpdates(u32 numStripes) {
+  if (numStripes == 0) {
+    numStripes_ = 0;
+    stripeLocks_.reset();
+    return;
+  }
+
+  u32 stripeExp = 0;
+  while ((u32{1} << stripeExp) < numStripes && stripeExp < featureExponent_) {
+    stripeExp += 1;
+  }
+  numStripes_ = u32{1} << stripeExp;
+  stripeShift_ = featureExponent_ - stripeExp;
+  stripeLocks_.reset(new std::mutex[numStripes_]);
+}
+
+// Concurrent updates race with unlocked reads of the analysis,
+// see updateConcurrent
+JPP_NO_SANITIZE_THREAD void SoftConfidenceWeighted::updateWeights(
     float alpha, float y, util::ArraySlice<ScoredFeature> features) {
   for (auto& v : features) {
     auto update = alpha * y * matrixDiagonal[v.feature] * v.score;
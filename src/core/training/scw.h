@@ -6,6 +6,8 @@
 #define JUMANPP_SCW_H
 
 #include <cmath>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include "core/analysis/perceptron.h"
 #include "core/impl/model_format.h"
@@ -38,6 +40,13 @@ class SoftConfidenceWeighted {
   analysis::ScorerDef sconf;
   std::unique_ptr<ScwData> data_;
 
+  u32 stripeShift_ = 0;
+  u32 numStripes_ = 0;
+  std::unique_ptr<std::mutex[]> stripeLocks_;
+
+  template <typename Fn>
+  void forEachStripe(util::ArraySlice<ScoredFeature> sorted, Fn fn);
+
   void updateMatrix(float beta, util::ArraySlice<ScoredFeature> features);
 
   double calcAlpha(double vt, double mt);
@@ -57,6 +66,24 @@ class SoftConfidenceWeighted {
   explicit SoftConfidenceWeighted(const TrainingConfig& conf);
   Status validate() const;
   void update(float loss, util::ArraySlice<ScoredFeature> features);
+
+  /**
+   * Thread-safe version of update, requires concurrent updates to be enabled.
+   * Features are reordered by their stripes into the buffer,
+   * every stripe is read and then updated under its own lock.
+   * Concurrent updates do not see consistent weights of other stripes
+   * (same as in Hogwild), so the result depends on the scheduling.
+   *
+   * Analysis in other training threads reads the weights without locks
+   * while they are updated. This race is intentional: the scoring code reads
+   * plain floats and can not use atomics, and a stale or a fresh value of
+   * an aligned float are both acceptable. Weight writes are excluded from
+   * ThreadSanitizer instrumentation, see updateWeights.
+   */
+  void updateConcurrent(float loss, util::ArraySlice<ScoredFeature> features,
+                        std::vector<ScoredFeature>* buffer);
+  void enableConcurrentUpdates(u32 numStripes);
+  bool concurrentUpdates() const { return numStripes_ != 0; }
   const analysis::ScorerDef* scorers() const { return &sconf; }
   void exportModel(model::ModelInfo* model, StringPiece comment = EMPTY_SP);
   void dumpModel(StringPiece directory, StringPiece prefix, i32 number);
@@ -99,7 +99,9 @@ Status TrainingEnv::handleProcessedTrainer(
   }
   auto loss = processed->loss();
   *curLoss += loss;
-  scw_.update(loss, processed->featureDiff());
+  if (!scw_.concurrentUpdates()) {
+    scw_.update(loss, processed->featureDiff());
+  }
   return Status::Ok();
 }
 
@@ -142,6 +144,12 @@ Status TrainingEnv::initFeatures(
 }
 
 Status TrainingEnv::initOther() {
+#if JPP_WEIGHT_BITS != 32
+  return JPPS_NOT_IMPLEMENTED
+         << "training needs float weights, this binary was built with "
+            "JPP_WEIGHT_BITS="
+         << JPP_WEIGHT_BITS;
+#endif
   auto pHolder = env_->coreHolder();
   if (pHolder == nullptr) {
     return Status::InvalidState() << "core holder was not constructed yet";
@@ -155,7 +163,14 @@ Status TrainingEnv::initOther() {
                                          &args_.trainingConfig};
   auto sconf = scw_.scorers();
   JPP_RETURN_IF_ERROR(trainers_.initialize(conf, sconf, args_.batchSize));
-  JPP_RETURN_IF_ERROR(executor_.initialize(sconf, args_.numThreads));
+  SoftConfidenceWeighted* concurrentScw = nullptr;
+  auto stripes = args_.trainingConfig.scw.updateStripes;
+  if (stripes > 0) {
+    scw_.enableConcurrentUpdates(stripes);
+    concurrentScw = &scw_;
+  }
+  JPP_RETURN_IF_ERROR(
+      executor_.initialize(sconf, args_.numThreads, concurrentScw));
   JPP_RETURN_IF_ERROR(args_.globalBeam.validate());
   return Status::Ok();
 }
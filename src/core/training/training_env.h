@@ -45,6 +45,7 @@ struct TrainingArguments {
   std::string corpusFilename;
   std::string partialCorpus;
   std::string rnnModelFilename;
+  i32 rnnQuantizeBits = 0;
   std::string scwDumpDirectory;
   std::string scwDumpPrefix;
   TrainingConfig trainingConfig;
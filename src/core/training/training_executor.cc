@@ -10,11 +10,14 @@ namespace core {
 namespace training {
 
 TrainingExecutorThread::TrainingExecutorThread(
-    const analysis::ScorerDef* conf, util::bounded_queue<ITrainer*>* trainers,
-    util::bounded_queue<TrainingExecutionResult>* results)
+    const analysis::ScorerDef* conf,
+    util::mpmc_bounded_queue<ITrainer*>* trainers,
+    util::mpmc_bounded_queue<TrainingExecutionResult>* results,
+    SoftConfidenceWeighted* scw)
     : scoreConf_{conf},
       trainers_{trainers},
       results_{results},
+      scw_{scw},
       thread_{TrainingExecutorThread::runMain, this} {}
 
 void TrainingExecutorThread::run() {
@@ -32,6 +35,10 @@ void TrainingExecutorThread::run() {
       if (status) {
         status = trainer->compute(scoreConf_);
       }
+      if (status && scw_ != nullptr) {
+        scw_->updateConcurrent(trainer->loss(), trainer->featureDiff(),
+                               &updateBuffer_);
+      }
     } catch (std::exception& ae) {
       status = JPPS_INVALID_STATE << "caught an exception while training: "
                                   << ae.what();
@@ -56,15 +63,22 @@ void TrainingExecutorThread::run() {
 void TrainingExecutorThread::finish() { thread_.join(); }
 
 Status TrainingExecutor::initialize(const analysis::ScorerDef* sconf,
-                                    u32 nthreads) {
+                                    u32 nthreads,
+                                    SoftConfidenceWeighted* scw) {
+  if (scw != nullptr && !scw->concurrentUpdates()) {
+    return JPPS_INVALID_PARAMETER
+           << "concurrent updates were not enabled for SCW";
+  }
+
   threads_.clear();
+  // queues must be ready before threads start to poll them
+  trainers_.initialize(nthreads * 2);
+  results_.initialize(nthreads * 2);
   try {
     for (u32 i = 0; i < nthreads; ++i) {
       threads_.emplace_back(
-          new TrainingExecutorThread{sconf, &trainers_, &results_});
+          new TrainingExecutorThread{sconf, &trainers_, &results_, scw});
     }
-    trainers_.initialize(nthreads * 2);
-    results_.initialize(nthreads * 2);
   } catch (std::system_error& e) {
     return JPPS_INVALID_STATE << "failed to initialize executor: " << e.code()
                               << " msg: " << e.what();
@@ -8,7 +8,7 @@
 #include "scw.h"
 #include "trainer.h"
 
-#include <util/bounded_queue.h>
+#include <util/lockfree_queue.h>
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
@@ -29,8 +29,11 @@ struct TrainingExecutionResult {
 
 class TrainingExecutorThread {
   const analysis::ScorerDef* scoreConf_;
-  util::bounded_queue<ITrainer*>* trainers_;
-  util::bounded_queue<TrainingExecutionResult>* results_;
+  util::mpmc_bounded_queue<ITrainer*>* trainers_;
+  util::mpmc_bounded_queue<TrainingExecutionResult>* results_;
+  // if not null, updates are applied by this thread
+  SoftConfidenceWeighted* scw_;
+  std::vector<ScoredFeature> updateBuffer_;
   std::thread thread_;
 
   void run();
@@ -40,18 +43,26 @@ class TrainingExecutorThread {
 
  public:
   explicit TrainingExecutorThread(
-      const analysis::ScorerDef* conf, util::bounded_queue<ITrainer*>* trainers,
-      util::bounded_queue<TrainingExecutionResult>* results);
+      const analysis::ScorerDef* conf,
+      util::mpmc_bounded_queue<ITrainer*>* trainers,
+      util::mpmc_bounded_queue<TrainingExecutionResult>* results,
+      SoftConfidenceWeighted* scw);
   void finish();
 };
 
 class TrainingExecutor {
   std::vector<std::unique_ptr<TrainingExecutorThread>> threads_;
-  util::bounded_queue<ITrainer*> trainers_;
-  util::bounded_queue<TrainingExecutionResult> results_;
+  util::mpmc_bounded_queue<ITrainer*> trainers_;
+  util::mpmc_bounded_queue<TrainingExecutionResult> results_;
 
  public:
-  Status initialize(const analysis::ScorerDef* sconf, u32 nthreads);
+  /**
+   * When scw is passed, training threads apply updates to it concurrently
+   * right after computing the feature difference.
+   * The scw must have concurrent updates enabled in that case.
+   */
+  Status initialize(const analysis::ScorerDef* sconf, u32 nthreads,
+                    SoftConfidenceWeighted* scw = nullptr);
 
   bool submitNext(ITrainer* next) { return trainers_.offer(std::move(next)); }
 
@@ -30,6 +30,13 @@ enum class InputFormat { Csv, Morph };
 struct ScwConfig {
   float C = 1.0f;
   float phi = 5.0f;
+  // When positive, training threads apply SCW updates themselves.
+  // Weights are split into this number (rounded to a power of 2)
+  // of contiguous stripes, every stripe is guarded by its own lock.
+  // Zero means that updates are applied serially by the main thread.
+  // Off by default: it was slower than serial updates in measurements
+  // and its effect on accuracy is not evaluated.
+  u32 updateStripes = 0;
 };
 
 struct TrainingConfig {
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include "args.h"
+#include "core/analysis/analysis_result.h"
+#include "core/analysis/analysis_stats.h"
+#include "core/analysis/analyzer_impl.h"
+#include "jpp_jumandic_cg.h"
+#include "jumandic/shared/juman_format.h"
+#include "util/characters.h"
+
+// Accuracy/throughput curve of adaptive global beams on a held-out set.
+// Held-out data uses the training format: space-separated tokens
+// surface_reading_baseform_pos_subpos_conjtype_conjform.
+
+using namespace jumanpp;
+
+struct BeamCurveConf {
+  std::string modelFile;
+  std::string inputFile;
+  std::vector<float> margins;
+  i32 beam;
+  i32 globalBeam;
+  i32 rightCheck;
+  i32 rightBeam;
+  i32 minGlobal;
+  i32 minRight;
+  i32 repeat;
+
+  static BeamCurveConf parse(int argc, const char* argv[]) {
+    args::ArgumentParser parser{"Adaptive beam accuracy/throughput curve"};
+    args::Positional<std::string> model{parser, "model", "model"};
+    args::Positional<std::string> input{parser, "input",
+                                        "held-out data in training format"};
+    args::ValueFlag<std::string> margins{
+        parser, "M1,M2,...", "margins to evaluate, 0 is a fixed beam",
+        {"margins"}, "0,0.5,1,2,4,8"};
+    args::ValueFlag<i32> beam{parser, "N", "local beam", {"beam"}, 5};
+    args::ValueFlag<i32> globalBeam{
+        parser, "N", "(maximum) global beam", {"global-beam"}, 6};
+    args::ValueFlag<i32> rightCheck{
+        parser, "N", "right check size", {"right-check"}, 1};
+    args::ValueFlag<i32> rightBeam{
+        parser, "N", "(maximum) right beam", {"right-beam"}, 5};
+    args::ValueFlag<i32> minGlobal{
+        parser, "N", "minimum adaptive global beam", {"min-global"}, 1};
+    args::ValueFlag<i32> minRight{
+        parser, "N", "minimum adaptive right beam", {"min-right"}, 1};
+    args::ValueFlag<i32> repeat{
+        parser,
+        "N",
+        "analyze the data N times, throughput of the fastest pass is reported",
+        {"repeat"},
+        1};
+
+    try {
+      parser.ParseCLI(argc, argv);
+    } catch (std::exception& e) {
+      std::cerr << e.what();
+      exit(1);
+    }
+
+    BeamCurveConf inst;
+    inst.modelFile = model.Get();
+    inst.inputFile = input.Get();
+    std::stringstream ss{margins.Get()};
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      inst.margins.push_back(std::stof(item));
+    }
+    inst.beam = beam.Get();
+    inst.globalBeam = globalBeam.Get();
+    inst.rightCheck = rightCheck.Get();
+    inst.rightBeam = rightBeam.Get();
+    inst.minGlobal = minGlobal.Get();
+    inst.minRight = minRight.Get();
+    inst.repeat = std::max(repeat.Get(), 1);
+    return inst;
+  }
+};
+
+struct Token {
+  i32 begin;
+  i32 end;
+  std::string pos;
+
+  bool operator<(const Token& o) const {
+    return std::tie(begin, end, pos) < std::tie(o.begin, o.end, o.pos);
+  }
+};
+
+struct HeldOutSentence {
+  std::string surface;
+  std::set<Token> tokens;
+};
+
+// spans are in lattice boundaries: the first character starts at 2
+std::vector<HeldOutSentence> readHeldOut(std::istream& is) {
+  std::vector<HeldOutSentence> result;
+  std::string line;
+  while (std::getline(is, line)) {
+    if (line.empty() || (line.size() > 2 && line[0] == '#' && line[1] == ' ')) {
+      continue;
+    }
+    HeldOutSentence sent;
+    std::stringstream tokens{line};
+    std::string token;
+    i32 position = 2;
+    while (std::getline(tokens, token, ' ')) {
+      if (token.empty()) {
+        continue;
+      }
+      auto surface = token.substr(0, token.find('_'));
+      std::string pos;
+      auto start = token.find('_');
+      for (int i = 0; i < 2 && start != std::string::npos; ++i) {
+        start = token.find('_', start + 1);
+      }
+      if (start != std::string::npos) {
+        pos = token.substr(start + 1, token.find('_', start + 1) - start - 1);
+      }
+      auto length = chars::numCodepoints(surface);
+      sent.tokens.insert({position, position + length, pos});
+      sent.surface += surface;
+      position += length;
+    }
+    result.push_back(std::move(sent));
+  }
+  return result;
+}
+
+struct Counts {
+  i64 gold = 0;
+  i64 system = 0;
+  i64 segCorrect = 0;
+  i64 posCorrect = 0;
+
+  static double f1(i64 correct, i64 gold, i64 system) {
+    if (correct == 0) {
+      return 0;
+    }
+    double prec = static_cast<double>(correct) / system;
+    double rec = static_cast<double>(correct) / gold;
+    return 2 * prec * rec / (prec + rec);
+  }
+
+  double segF1() const { return f1(segCorrect, gold, system); }
+  double posF1() const { return f1(posCorrect, gold, system); }
+};
+
+struct BeamCurve {
+  core::JumanppEnv env;
+  jumandic::output::JumandicFields fields;
+  core::analysis::AnalysisResult result;
+  core::analysis::AnalysisPath top1;
+  std::vector<Token> system;
+
+  Status init(const BeamCurveConf& conf) {
+    JPP_RETURN_IF_ERROR(env.loadModel(conf.modelFile));
+    jumanpp_generated::JumandicStatic staticFeatures;
+    JPP_RETURN_IF_ERROR(env.initFeatures(&staticFeatures));
+    env.setBeamSize(static_cast<u32>(conf.beam));
+    env.setGlobalBeam(conf.globalBeam, conf.rightCheck, conf.rightBeam);
+    return Status::Ok();
+  }
+
+  Status topPath(core::analysis::Analyzer* ana) {
+    JPP_RETURN_IF_ERROR(result.reset(*ana));
+    JPP_RETURN_IF_ERROR(result.fillTop1(&top1));
+    auto& om = ana->output();
+    auto walker = om.nodeWalker();
+    system.clear();
+    while (top1.nextBoundary()) {
+      core::analysis::ConnectionPtr ptr;
+      if (!top1.nextNode(&ptr)) {
+        return JPPS_INVALID_STATE << "failed to load a node";
+      }
+      if (!system.empty()) {
+        system.back().end = ptr.boundary;
+      }
+      if (!om.locate(ptr.latticeNodePtr(), &walker) || !walker.next()) {
+        return JPPS_INVALID_STATE << "failed to locate a node";
+      }
+      system.push_back({ptr.boundary, 0, fields.pos[walker].str()});
+    }
+    if (!system.empty()) {
+      auto lattice = ana->impl()->lattice();
+      system.back().end = lattice->createdBoundaryCount() - 1;
+    }
+    return Status::Ok();
+  }
+
+  Status evaluate(const BeamCurveConf& conf, float margin,
+                  const std::vector<HeldOutSentence>& data) {
+    env.setAdaptiveBeam(margin, conf.minGlobal, conf.minRight);
+    core::analysis::Analyzer ana;
+    JPP_RETURN_IF_ERROR(env.makeAnalyzer(&ana));
+    JPP_RETURN_IF_ERROR(fields.initialize(ana.output()));
+
+    Counts counts;
+    u64 scored = 0;
+    std::chrono::steady_clock::duration time{0};
+    for (auto& sent : data) {
+      auto start = std::chrono::steady_clock::now();
+      JPP_RIE_MSG(ana.analyze(sent.surface), sent.surface);
+      time += std::chrono::steady_clock::now() - start;
+      scored += ana.stats().scoredConnections;
+      JPP_RETURN_IF_ERROR(topPath(&ana));
+      counts.gold += sent.tokens.size();
+      counts.system += system.size();
+      for (auto& tok : system) {
+        auto it = sent.tokens.lower_bound({tok.begin, tok.end, std::string{}});
+        if (it != sent.tokens.end() && it->begin == tok.begin &&
+            it->end == tok.end) {
+          counts.segCorrect += 1;
+          if (sent.tokens.count(tok) != 0) {
+            counts.posCorrect += 1;
+          }
+        }
+      }
+    }
+
+    // a single pass over a small held-out set is too short for timing
+    for (int pass = 1; pass < conf.repeat; ++pass) {
+      auto start = std::chrono::steady_clock::now();
+      for (auto& sent : data) {
+        JPP_RIE_MSG(ana.analyze(sent.surface), sent.surface);
+      }
+      time = std::min(time, std::chrono::steady_clock::now() - start);
+    }
+
+    auto seconds = std::chrono::duration<double>(time).count();
+    std::cout << std::fixed << std::setprecision(3) << margin << "\t"
+              << std::setprecision(1) << data.size() / seconds << "\t"
+              << static_cast<double>(scored) / data.size() << "\t"
+              << std::setprecision(4) << counts.segF1() << "\t"
+              << counts.posF1() << "\n";
+    return Status::Ok();
+  }
+};
+
+int main(int argc, const char* argv[]) {
+  auto conf = BeamCurveConf::parse(argc, argv);
+
+  BeamCurve curve;
+  Status s = curve.init(conf);
+  if (!s) {
+    std::cerr << s;
+    return 1;
+  }
+
+  std::ifstream ifs{conf.inputFile};
+  auto data = readHeldOut(ifs);
+  if (data.empty()) {
+    std::cerr << "no sentences in " << conf.inputFile << "\n";
+    return 1;
+  }
+
+  if (!core::analysis::AnalysisStatsEnabled) {
+    std::cerr << "analysis stats are disabled, scored pairs will be zero\n";
+  }
+
+  std::cout << "margin\tsent/s\tpairs/sent\tseg F1\tpos F1\n";
+  for (auto margin : conf.margins) {
+    s = curve.evaluate(conf, margin, data);
+    if (!s) {
+      std::cerr << "failed to evaluate margin " << margin << ": " << s << "\n";
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -1,8 +1,11 @@
 //
 // Created by Arseny Tolmachev on 2017/03/09.
 //
+#include <algorithm>
 #include <fstream>
 #ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
 #include <nowide/iostream.hpp>
 #include <nowide/fstream.hpp>
 #include <nowide/args.hpp>
@@ -12,6 +15,8 @@
 #include "jumanpp.h"
 #include "core/input/pex_stream_reader.h"
 #include "jumandic/shared/jumanpp_args.h"
+#include "jumandic/shared/jumanpp_parallel.h"
+#include "util/buffered_output.h"
 #include "util/logging.hpp"
 
 using namespace jumanpp;
@@ -22,92 +27,179 @@ namespace io = std;
 #endif
 struct InputOutput {
   std::unique_ptr<core::input::StreamReader> streamReader_;
-  std::shared_ptr<io::ifstream> fileInput_;
+  // finished readers are kept alive: analysis threads can still
+  // reference lines of memory-mapped files
+  std::vector<std::unique_ptr<core::input::LineReader>> lineReaders_;
+  core::input::LineReader* input_ = nullptr;
   int currentInFile_ = 0;
   const std::vector<std::string>* inFiles_;
-  StringPiece currentInputFilename_;
-  std::istream* input_;
 
   std::shared_ptr<io::ofstream> fileOutput_;
+  std::unique_ptr<util::BufferedOutput> bufferedOutput_;
   std::ostream* output_;
+  // flushed before waiting for input
+  std::ostream* inputTie_ = nullptr;
+
+  const core::CoreHolder* core_;
+  jumandic::InputType inputType_;
+
+  core::input::LineReader* addReader() {
+    lineReaders_.emplace_back(new core::input::LineReader);
+    input_ = lineReaders_.back().get();
+    input_->tie(inputTie_);
+    return input_;
+  }
+
+  void tieInput(std::ostream* stream) {
+    inputTie_ = stream;
+    input_->tie(stream);
+  }
 
   Status moveToNextFile() {
     auto& fn = (*inFiles_)[currentInFile_];
-    fileInput_.reset(new io::ifstream{fn});
-    if (fileInput_->bad()) {
-      return JPPS_INVALID_PARAMETER << "failed to open output file: " << fn;
-    }
-    input_ = fileInput_.get();
-    currentInputFilename_ = fn;
     currentInFile_ += 1;
+    JPP_RETURN_IF_ERROR(addReader()->openFile(fn));
     return Status::Ok();
   }
 
-  Status nextInput() {
-    if (*input_) {
-      JPP_RETURN_IF_ERROR(streamReader_->readExample(input_));
-      return Status::Ok();
-    }
-
-    if (input_->fail()) {
-      return JPPS_INVALID_STATE << "failed when reading from file: "
-                                << currentInputFilename_;
-    }
+  Status nextInput() { return nextInput(streamReader_.get()); }
 
-    return JPPS_NOT_IMPLEMENTED << "should not reach here, it is a bug";
+  Status nextInput(core::input::StreamReader* reader) {
+    JPP_RETURN_IF_ERROR(reader->readExample(input_));
+    return Status::Ok();
   }
 
   Status initialize(const jumandic::JumanppConf& conf,
                     const core::CoreHolder& cholder) {
     inFiles_ = &conf.inputFiles.value();
     std::setlocale(LC_ALL, "");
-    if (!inFiles_->empty()) {
-      JPP_RETURN_IF_ERROR(moveToNextFile());
+
+    // binary formats must not have their newline bytes translated
+    auto outputType = conf.outputType.value();
+    bool binary = outputType == jumandic::OutputType::Columnar ||
+                  outputType == jumandic::OutputType::ColumnarScores;
+
+    std::ostream* target;
+    if (conf.outputFile == "-") {
+      target = &io::cout;
+#ifdef _WIN32
+      if (binary) {
+        io::cout.flush();
+        _setmode(_fileno(stdout), _O_BINARY);
+      }
+#endif
     } else {
-      input_ = &io::cin;
-      currentInputFilename_ = "<stdin>";
+      auto mode = std::ios::out;
+      if (binary) {
+        mode |= std::ios::binary;
+      }
+      fileOutput_.reset(new io::ofstream{conf.outputFile, mode});
+      target = fileOutput_.get();
     }
+    bufferedOutput_.reset(new util::BufferedOutput{target});
+    output_ = bufferedOutput_.get();
+    inputTie_ = output_;
 
-    if (conf.outputFile == "-") {
-      output_ = &io::cout;
+    if (!inFiles_->empty()) {
+      JPP_RETURN_IF_ERROR(moveToNextFile());
     } else {
-      fileOutput_.reset(new io::ofstream{conf.outputFile});
-      output_ = fileOutput_.get();
+#ifdef _WIN32
+      addReader()->openStream(&io::cin, "<stdin>");
+#else
+      addReader()->openDescriptor(0, "<stdin>");
+#endif
     }
 
-    auto inType = conf.inputType.value();
-    if (inType == jumandic::InputType::Raw) {
+    core_ = &cholder;
+    inputType_ = conf.inputType.value();
+    JPP_RETURN_IF_ERROR(makeReader(&streamReader_));
+
+    return Status::Ok();
+  }
+
+  Status makeReader(std::unique_ptr<core::input::StreamReader>* result) const {
+    if (inputType_ == jumandic::InputType::Raw) {
 
       auto rdr = new core::input::PlainStreamReader{};
 
-      streamReader_.reset(rdr);
+      result->reset(rdr);
       rdr->setMaxSizes(65535, 1024);
     } else {
       auto rdr = new core::input::PexStreamReader{};
-      streamReader_.reset(rdr);
-      JPP_RETURN_IF_ERROR(rdr->initialize(cholder, '&'));
+      result->reset(rdr);
+      JPP_RETURN_IF_ERROR(rdr->initialize(*core_, '&'));
     }
-
     return Status::Ok();
   }
 
   bool hasNext() {
-    if (input_->good()) {
-      auto ch = input_->peek();
-      if (ch == std::char_traits<char>::eof()) {
-        return false;
-      }
-    }
-    while (input_->eof() && currentInFile_ < inFiles_->size()) {
+    while (!input_->hasNext() && currentInFile_ < inFiles_->size()) {
       auto s = moveToNextFile();
       if (!s) {
         LOG_ERROR() << s.message();
       }
     }
-    auto isOk = !input_->eof();
-    return isOk;
+    return input_->hasNext();
   }
 };
+
+void printCacheStats(const jumandic::JumanppExec& exec) {
+  auto cache = exec.resultCache();
+  if (cache == nullptr) {
+    return;
+  }
+  auto stats = cache->stats();
+  LOG_INFO() << "result cache: hits=" << stats.hits
+             << " misses=" << stats.misses << " hit ratio=" << stats.hitRatio()
+             << " stored=" << stats.insertions
+             << " too large=" << stats.rejected;
+}
+
+void printAnalysisStats(jumandic::JumanppExec& exec) {
+  if (exec.collectStats()) {
+    exec.analysisStats().print(io::cerr);
+  }
+}
+
+int analyzeParallel(jumandic::JumanppExec& exec, InputOutput& io,
+                    u32 numThreads, bool pipeline) {
+  jumandic::JumanppParallelExec pexec;
+  auto readerFactory = [&io](
+      std::unique_ptr<core::input::StreamReader>* result) {
+    return io.makeReader(result);
+  };
+  Status s = pexec.initialize(&exec, numThreads, readerFactory, io.output_,
+                              &io::cerr, 4, pipeline);
+  if (!s) {
+    io::cerr << "Failed to initialize analysis threads: " << s;
+    return 1;
+  }
+
+  // results of submitted sentences must be written before waiting for input,
+  // with the output thread the output belongs to it now
+  io.tieInput(pexec.flushStream());
+
+  int result = 0;
+
+  while (io.hasNext()) {
+    auto task = pexec.acquire();
+    s = io.nextInput(task->reader.get());
+    if (!s) {
+      io::cerr << "failed to read an example: " << s;
+      pexec.submitEmpty(task);
+      result = 1;
+      continue;
+    }
+
+    result = 0;
+    pexec.submit(task);
+  }
+
+  pexec.finish();
+  printCacheStats(exec);
+  return result;
+}
+
 #ifdef _WIN32
 int main(int argc,char** argv) {
   auto args=io::args(argc, argv);
@@ -161,6 +253,11 @@ int main(int argc,const char** argv) {
     return 0;
   }
 
+  if (conf.profileStartup) {
+    io::cerr << "Startup profile:\n";
+    exec.startupProfile().print(io::cerr);
+  }
+
   InputOutput io;
 
   s = io.initialize(conf, exec.core());
@@ -169,32 +266,40 @@ int main(int argc,const char** argv) {
     return 1;
   }
 
+  if (conf.numThreads > 1 || conf.pipeline) {
+    auto numThreads = std::max(conf.numThreads.value(), 1);
+    int result = analyzeParallel(exec, io, static_cast<u32>(numThreads),
+                                 conf.pipeline);
+    printAnalysisStats(exec);
+    return result;
+  }
+
+  auto stats = exec.collectStats() ? &exec.analysisStats() : nullptr;
+
   int result = 0;
+  std::string output;
 
   while (io.hasNext()) {
     s = io.nextInput();
     if (!s) {
         io::cerr << "failed to read an example: " << s;
+      // keep the output aligned with the input
+      *io.output_ << exec.emptyResult();
       result = 1;
       continue;
     }
 
     result = 0;
 
-    s = io.streamReader_->analyzeWith(exec.analyzerPtr());
-    if (!s) {
-        io::cerr << s;
-      *io.output_ << exec.emptyResult();
-      continue;
-    }
-
-    s = exec.format()->format(*exec.analyzerPtr(), io.streamReader_->comment());
+    s = exec.analyzeExample(io.streamReader_.get(), exec.analyzerPtr(),
+                            exec.format(), &output, stats);
     if (!s) {
         io::cerr << s;
-    } else {
-      *io.output_ << exec.format()->result();
     }
+    *io.output_ << output;
   }
 
+  printCacheStats(exec);
+  printAnalysisStats(exec);
   return result;
 }
\ No newline at end of file
@@ -91,6 +91,13 @@ Status parseArgs(int argc, const char** argv, t::TrainingArguments* args) {
       trainingParams, "BATCH", "Batch Size, 1 default", {"batch"}, 1};
   args::ValueFlag<u32> numThreads{
       trainingParams, "THREADS", "# of threads, 1 default", {"threads"}, 1};
+  args::ValueFlag<u32> updateStripes{
+      trainingParams,
+      "STRIPES",
+      "Experimental: apply SCW updates in training threads, locking weights "
+      "in STRIPES parts (0 = apply updates serially, default)",
+      {"parallel-updates"},
+      0};
   args::ValueFlag<u32> maxBatchIters{trainingParams,
                                      "BATCH_ITERS",
                                      "max # of batch iterations",
@@ -101,6 +108,14 @@ Status parseArgs(int argc, const char** argv, t::TrainingArguments* args) {
   args::ValueFlag<float> epsilon{
       trainingParams, "EPSILON", "stopping epsilon (1e-3)", {"epsilon"}, 1e-3f};
 
+  args::ValueFlag<i32> rnnBits{
+      parser,
+      "BITS",
+      "Also embed RNN embeddings and maxent weights quantized to 8 or 16 bits, "
+      "they are used instead of floats (0 = no quantization, default)",
+      {"rnn-bits"},
+      0};
+
   RnnArgs rnnArgs{parser};
 
   args::Group gbeam{parser, "Global Beam"};
@@ -136,12 +151,14 @@ Status parseArgs(int argc, const char** argv, t::TrainingArguments* args) {
   args->corpusFilename = corpusFile.Get();
   args->partialCorpus = partialCorpus.Get();
   args->rnnModelFilename = rnnFile.Get();
+  args->rnnQuantizeBits = rnnBits.Get();
   auto sizeExp = paramSizeExponent.Get();
   args->trainingConfig.featureNumberExponent = sizeExp;
   args->trainingConfig.randomSeed = randomSeed.Get();
   args->trainingConfig.mode = trainMode.Get();
   args->trainingConfig.scw.C = scwC.Get();
   args->trainingConfig.scw.phi = scwPhi.Get();
+  args->trainingConfig.scw.updateStripes = updateStripes.Get();
   args->batchMaxIterations = maxBatchIters.Get();
   args->maxEpochs = maxEpochs.Get();
   args->batchLossEpsilon = epsilon.Get();
@@ -275,7 +292,7 @@ int doEmbedRnn(t::TrainingArguments& args, core::JumanppEnv& env) {
 
   auto info = env.modelInfoCopy();
 
-  s = rnnHolder.makeInfo(&info, args.comment);
+  s = rnnHolder.makeInfo(&info, args.comment, args.rnnQuantizeBits);
   if (!s) {
     LOG_ERROR() << "failed to add rnn info to the model: " << s;
     return 1;
@@ -0,0 +1,147 @@
+#include "columnar_format.h"
+#include "core/analysis/analyzer_impl.h"
+
+namespace jumanpp {
+namespace jumandic {
+namespace output {
+
+namespace {
+
+template <typename T>
+void append(std::string* buffer, T value) {
+  auto start = buffer->size();
+  buffer->resize(start + sizeof(T));
+  columnar::encodeLittleEndian(&(*buffer)[start], value);
+}
+
+template <typename T>
+void appendColumn(std::string* buffer, const std::vector<T>& column) {
+  auto start = buffer->size();
+  buffer->resize(start + column.size() * sizeof(T));
+  auto out = &(*buffer)[start];
+  for (auto value : column) {
+    columnar::encodeLittleEndian(out, value);
+    out += sizeof(T);
+  }
+}
+
+void appendHeader(std::string* buffer, u8 flags, u32 numNodes,
+                  u32 commentSize) {
+  append(buffer, columnar::FormatVersion);
+  append(buffer, flags);
+  append(buffer, u16{0});
+  append(buffer, numNodes);
+  append(buffer, commentSize);
+}
+
+}  // namespace
+
+Status ColumnarFormat::initialize(const core::analysis::OutputManager& om) {
+  JPP_RETURN_IF_ERROR(idResolver_.initialize(om.dic()));
+  return fields_.initialize(om);
+}
+
+Status ColumnarFormat::format(const core::analysis::Analyzer& analyzer,
+                              StringPiece comment) {
+  begin_.clear();
+  end_.clear();
+  pos_.clear();
+  subpos_.clear();
+  conjType_.clear();
+  conjForm_.clear();
+  entry_.clear();
+  score_.clear();
+
+  JPP_RETURN_IF_ERROR(analysisResult_.reset(analyzer));
+  JPP_RETURN_IF_ERROR(analysisResult_.fillTop1(&top1_));
+
+  auto& om = analyzer.output();
+  auto& input = analyzer.impl()->input();
+  auto& codepoints = input.codepoints();
+  auto surface = input.surface();
+
+  while (top1_.nextBoundary()) {
+    auto beam = top1_.nextBeamPtr();
+    if (beam == nullptr) {
+      return JPPS_INVALID_STATE << "there were no nodes at boundary: "
+                                << top1_.currentBoundary();
+    }
+
+    auto& cptr = beam->ptr;
+    if (!om.locate(cptr.latticeNodePtr(), &walker_) || !walker_.next()) {
+      return JPPS_INVALID_STATE << "could not find a ready node: "
+                                << top1_.currentBoundary() << " "
+                                << cptr.right;
+    }
+
+    // the first character starts at the lattice boundary 2
+    auto cpIdx = static_cast<size_t>(cptr.boundary) - 2;
+    if (cpIdx >= codepoints.size()) {
+      return JPPS_INVALID_STATE << "node boundary " << cptr.boundary
+                                << " was outside of the input";
+    }
+    auto offset = static_cast<u32>(codepoints[cpIdx].bytes.begin() -
+                                   surface.begin());
+    if (!begin_.empty()) {
+      end_.push_back(offset);
+    }
+    begin_.push_back(offset);
+
+    JumandicPosId internalPos{
+        fields_.pos.pointer(walker_), fields_.subpos.pointer(walker_),
+        fields_.conjType.pointer(walker_), fields_.conjForm.pointer(walker_)};
+    auto idPos = idResolver_.dicToJuman(internalPos);
+    pos_.push_back(static_cast<u16>(idPos.pos));
+    subpos_.push_back(static_cast<u16>(idPos.subpos));
+    conjType_.push_back(static_cast<u16>(idPos.conjType));
+    conjForm_.push_back(static_cast<u16>(idPos.conjForm));
+    entry_.push_back(walker_.eptr().rawValue());
+    if (scores_) {
+      score_.push_back(beam->totalScore);
+    }
+  }
+
+  if (!begin_.empty()) {
+    end_.push_back(static_cast<u32>(surface.size()));
+  }
+
+  writeFrame(comment);
+  return Status::Ok();
+}
+
+void ColumnarFormat::writeFrame(StringPiece comment) {
+  auto numNodes = static_cast<u32>(begin_.size());
+  auto commentSize = static_cast<u32>(comment.size());
+  u8 flags = scores_ ? columnar::HasScores : 0;
+
+  buffer_.clear();
+  append(&buffer_, u32{0});
+  appendHeader(&buffer_, flags, numNodes, commentSize);
+  buffer_.append(comment.char_begin(), comment.size());
+  buffer_.resize((buffer_.size() + 3) & ~size_t{3}, '\0');
+  appendColumn(&buffer_, begin_);
+  appendColumn(&buffer_, end_);
+  appendColumn(&buffer_, pos_);
+  appendColumn(&buffer_, subpos_);
+  appendColumn(&buffer_, conjType_);
+  appendColumn(&buffer_, conjForm_);
+  appendColumn(&buffer_, entry_);
+  appendColumn(&buffer_, score_);
+
+  auto frameSize = static_cast<u32>(buffer_.size() - sizeof(u32));
+  columnar::encodeLittleEndian(&buffer_[0], frameSize);
+}
+
+StringPiece ColumnarFormat::errorFrame() {
+  static const std::string frame = []() {
+    std::string result;
+    append(&result, u32{3 * sizeof(u32)});
+    appendHeader(&result, columnar::AnalysisFailed, 0, 0);
+    return result;
+  }();
+  return frame;
+}
+
+}  // namespace output
+}  // namespace jumandic
+}  // namespace jumanpp
@@ -0,0 +1,53 @@
+#ifndef JUMANPP_COLUMNAR_FORMAT_H
+#define JUMANPP_COLUMNAR_FORMAT_H
+
+#include "columnar_reader.h"
+#include "juman_format.h"
+
+namespace jumanpp {
+namespace jumandic {
+namespace output {
+
+/**
+ * Binary columnar output which does not need any string formatting.
+ * Every sentence is a self-contained length-prefixed frame,
+ * the layout is described in columnar_reader.h.
+ */
+class ColumnarFormat : public core::OutputFormat {
+  JumandicFields fields_;
+  JumandicIdResolver idResolver_;
+  core::analysis::AnalysisResult analysisResult_;
+  core::analysis::AnalysisPath top1_;
+  core::analysis::NodeWalker walker_;
+  bool scores_;
+
+  std::vector<u32> begin_;
+  std::vector<u32> end_;
+  std::vector<u16> pos_;
+  std::vector<u16> subpos_;
+  std::vector<u16> conjType_;
+  std::vector<u16> conjForm_;
+  std::vector<i32> entry_;
+  std::vector<float> score_;
+  std::string buffer_;
+
+  void writeFrame(StringPiece comment);
+
+ public:
+  explicit ColumnarFormat(bool scores = false) : scores_{scores} {}
+  Status initialize(const core::analysis::OutputManager& om);
+  Status format(const core::analysis::Analyzer& analyzer, StringPiece comment);
+  StringPiece result() const { return buffer_; }
+
+  /**
+   * Frame without nodes which is written for failed sentences,
+   * so consumers stay aligned with the input.
+   */
+  static StringPiece errorFrame();
+};
+
+}  // namespace output
+}  // namespace jumandic
+}  // namespace jumanpp
+
+#endif  // JUMANPP_COLUMNAR_FORMAT_H
@@ -0,0 +1,165 @@
+#include "columnar_format.h"
+#include <sstream>
+#include "jumandic_env.h"
+#include "jumandic_test_env.h"
+
+namespace {
+
+struct JumanNode {
+  std::string surface;
+  u16 pos;
+  u16 subpos;
+  u16 conjType;
+  u16 conjForm;
+};
+
+class ColumnarTestEnv {
+ public:
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  TempFile modelFile;
+  jumandic::JumanppExec exec;
+  jumandic::output::JumanFormat juman;
+
+  explicit ColumnarTestEnv(jumandic::OutputType type) {
+    env.singleEpochFrom("jumandic/train_mini_01.txt");
+    auto model = env.jppEnv.modelInfoCopy();
+    env.trainEnv.value().exportScwParams(&model);
+    {
+      core::model::ModelSaver saver;
+      REQUIRE_OK(saver.open(modelFile.name()));
+      REQUIRE_OK(saver.save(model));
+    }
+    jumandic::JumanppConf conf;
+    conf.modelFile = modelFile.name();
+    conf.outputType = type;
+    REQUIRE_OK(exec.init(conf));
+    REQUIRE_OK(juman.initialize(exec.analyzerPtr()->output()));
+  }
+
+  std::string analyze(StringPiece sentence, StringPiece comment,
+                      std::vector<JumanNode>* nodes) {
+    auto ana = exec.analyzerPtr();
+    REQUIRE_OK(ana->analyze(sentence));
+    REQUIRE_OK(exec.format()->format(*ana, comment));
+    std::string result = exec.format()->result().str();
+
+    REQUIRE_OK(juman.format(*ana, EMPTY_SP));
+    std::stringstream lines{juman.result().str()};
+    std::string line;
+    while (std::getline(lines, line)) {
+      if (line == "EOS" || line.compare(0, 2, "@ ") == 0) {
+        continue;
+      }
+      std::stringstream fields{line};
+      std::vector<std::string> parts;
+      std::string part;
+      while (std::getline(fields, part, ' ')) {
+        parts.push_back(part);
+      }
+      REQUIRE(parts.size() > 10);
+      nodes->push_back({parts[0], static_cast<u16>(std::stoi(parts[4])),
+                        static_cast<u16>(std::stoi(parts[6])),
+                        static_cast<u16>(std::stoi(parts[8])),
+                        static_cast<u16>(std::stoi(parts[10]))});
+    }
+    return result;
+  }
+};
+
+const std::string sentences[] = {"大阪の田舎で住む人", "鍵をかける人が少ない",
+                                 "かつての重い効果は明らかだ",
+                                 "白いのお金は持つのね"};
+
+void checkSentence(const jumandic::columnar::ColumnarSentence& sent,
+                   StringPiece input, const std::vector<JumanNode>& nodes) {
+  CAPTURE(input);
+  REQUIRE(sent.size() == nodes.size());
+  CHECK(sent.begin[0] == 0);
+  CHECK(sent.end[sent.size() - 1] == input.size());
+  for (size_t i = 0; i < sent.size(); ++i) {
+    CAPTURE(i);
+    if (i > 0) {
+      CHECK(sent.begin[i] == sent.end[i - 1]);
+    }
+    CHECK(sent.surface(input, i) == nodes[i].surface);
+    CHECK(sent.pos[i] == nodes[i].pos);
+    CHECK(sent.subpos[i] == nodes[i].subpos);
+    CHECK(sent.conjType[i] == nodes[i].conjType);
+    CHECK(sent.conjForm[i] == nodes[i].conjForm);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("columnar output can be read back in a batch") {
+  ColumnarTestEnv env{jumandic::OutputType::Columnar};
+  std::string data;
+  std::vector<std::vector<JumanNode>> expected;
+  for (auto& s : sentences) {
+    expected.emplace_back();
+    data += env.analyze(s, "comment", &expected.back());
+  }
+
+  jumandic::columnar::ColumnarReader reader;
+  REQUIRE_OK(reader.parse(data));
+  auto sents = reader.sentences();
+  REQUIRE(sents.size() == 4);
+  for (int i = 0; i < 4; ++i) {
+    CHECK_FALSE(sents[i].failed());
+    CHECK(sents[i].comment == "comment");
+    CHECK(sents[i].score.empty());
+    checkSentence(sents[i], sentences[i], expected[i]);
+  }
+}
+
+TEST_CASE("columnar output with scores can be read from a stream") {
+  ColumnarTestEnv env{jumandic::OutputType::ColumnarScores};
+  std::string data;
+  std::vector<std::vector<JumanNode>> expected;
+  for (auto& s : sentences) {
+    expected.emplace_back();
+    data += env.analyze(s, EMPTY_SP, &expected.back());
+  }
+  data += jumandic::output::ColumnarFormat::errorFrame().str();
+
+  std::stringstream ss{data};
+  jumandic::columnar::ColumnarReader reader;
+  REQUIRE_OK(reader.readBatch(&ss, 3));
+  REQUIRE(reader.sentences().size() == 3);
+  for (int i = 0; i < 3; ++i) {
+    auto& sent = reader.sentences()[i];
+    CHECK(sent.comment.empty());
+    REQUIRE(sent.score.size() == sent.size());
+    checkSentence(sent, sentences[i], expected[i]);
+  }
+  REQUIRE_OK(reader.readBatch(&ss, 3));
+  REQUIRE(reader.sentences().size() == 2);
+  checkSentence(reader.sentences()[0], sentences[3], expected[3]);
+  CHECK(reader.sentences()[1].failed());
+  CHECK(reader.sentences()[1].size() == 0);
+  REQUIRE_OK(reader.readBatch(&ss, 3));
+  CHECK(reader.sentences().empty());
+}
+
+TEST_CASE("columnar frames are little-endian") {
+  std::string expected{"\x0c\0\0\0\x01\x02\0\0\0\0\0\0\0\0\0\0", 16};
+  CHECK(jumandic::output::ColumnarFormat::errorFrame() == expected);
+  char data[4];
+  jumandic::columnar::encodeLittleEndian(data, u32{0x01020304});
+  CHECK(data[0] == 4);
+  CHECK(data[3] == 1);
+  CHECK(jumandic::columnar::decodeLittleEndian<u32>(data) == 0x01020304);
+  jumandic::columnar::encodeLittleEndian(data, -2.5f);
+  CHECK(jumandic::columnar::decodeLittleEndian<float>(data) == -2.5f);
+}
+
+TEST_CASE("columnar reader rejects truncated data") {
+  ColumnarTestEnv env{jumandic::OutputType::Columnar};
+  std::vector<JumanNode> nodes;
+  auto data = env.analyze(sentences[0], EMPTY_SP, &nodes);
+  jumandic::columnar::ColumnarReader reader;
+  auto truncated = data.substr(0, data.size() - 4);
+  CHECK_FALSE(reader.parse(truncated));
+  std::stringstream ss{truncated};
+  CHECK_FALSE(reader.readBatch(&ss, 10));
+}
@@ -0,0 +1,136 @@
+#include "columnar_reader.h"
+#include <cstring>
+#include <istream>
+#include "util/common.hpp"
+
+namespace jumanpp {
+namespace jumandic {
+namespace columnar {
+
+namespace {
+
+constexpr size_t HeaderSize = 3 * sizeof(u32);
+constexpr u32 MaxFrameSize = 1u << 30;
+
+inline u32 readU32(const char* data) { return decodeLittleEndian<u32>(data); }
+
+inline bool hostIsLittleEndian() {
+  u32 one = 1;
+  u8 first;
+  std::memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+inline u64 padTo4(u64 size) { return (size + 3) & ~u64{3}; }
+
+// columns are views into the storage,
+// so values are converted to the host order in place
+template <typename T>
+util::ArraySlice<T> column(char** data, size_t size) {
+  auto bytes = *data;
+  if (!hostIsLittleEndian()) {
+    for (size_t i = 0; i < size; ++i) {
+      auto value = decodeLittleEndian<T>(bytes + i * sizeof(T));
+      std::memcpy(bytes + i * sizeof(T), &value, sizeof(T));
+    }
+  }
+  *data += size * sizeof(T);
+  return util::ArraySlice<T>{reinterpret_cast<const T*>(bytes), size};
+}
+
+}  // namespace
+
+Status ColumnarReader::parseStorage() {
+  sentences_.clear();
+  char* data = &storage_[0];
+  const char* end = data + storage_.size();
+  while (data != end) {
+    if (end - data < static_cast<ptrdiff_t>(sizeof(u32) + HeaderSize)) {
+      return JPPS_INVALID_PARAMETER << "columnar: truncated frame header at "
+                                    << (data - storage_.data());
+    }
+    auto frameSize = readU32(data);
+    data += sizeof(u32);
+    if (frameSize > static_cast<u64>(end - data)) {
+      return JPPS_INVALID_PARAMETER << "columnar: frame size " << frameSize
+                                    << " is larger than remaining data";
+    }
+    auto frameEnd = data + frameSize;
+
+    ColumnarSentence sent;
+    auto version = static_cast<u8>(data[0]);
+    sent.flags = static_cast<u8>(data[1]);
+    if (version != FormatVersion) {
+      return JPPS_INVALID_PARAMETER << "columnar: unsupported version "
+                                    << static_cast<i32>(version);
+    }
+    u64 numNodes = readU32(data + 4);
+    u64 commentSize = readU32(data + 8);
+    u64 nodeSize = 2 * sizeof(u32) + 4 * sizeof(u16) + sizeof(i32);
+    if ((sent.flags & HasScores) != 0) {
+      nodeSize += sizeof(float);
+    }
+    auto expected = HeaderSize + padTo4(commentSize) + numNodes * nodeSize;
+    if (expected != frameSize) {
+      return JPPS_INVALID_PARAMETER << "columnar: frame size " << frameSize
+                                    << " was not equal to expected "
+                                    << expected;
+    }
+    data += HeaderSize;
+    sent.comment = StringPiece{data, static_cast<size_t>(commentSize)};
+    data += padTo4(commentSize);
+    sent.begin = column<u32>(&data, numNodes);
+    sent.end = column<u32>(&data, numNodes);
+    sent.pos = column<u16>(&data, numNodes);
+    sent.subpos = column<u16>(&data, numNodes);
+    sent.conjType = column<u16>(&data, numNodes);
+    sent.conjForm = column<u16>(&data, numNodes);
+    sent.entry = column<i32>(&data, numNodes);
+    if ((sent.flags & HasScores) != 0) {
+      sent.score = column<float>(&data, numNodes);
+    }
+    JPP_DCHECK_EQ(data, frameEnd);
+    data = frameEnd;
+    sentences_.push_back(sent);
+  }
+  return Status::Ok();
+}
+
+Status ColumnarReader::parse(StringPiece data) {
+  // copy makes all columns correctly aligned
+  storage_.assign(data.begin(), data.end());
+  return parseStorage();
+}
+
+Status ColumnarReader::readBatch(std::istream* is, size_t maxSentences) {
+  storage_.clear();
+  for (size_t i = 0; i < maxSentences; ++i) {
+    char sizeBytes[sizeof(u32)];
+    is->read(sizeBytes, sizeof(u32));
+    if (is->gcount() == 0 && is->eof()) {
+      break;
+    }
+    if (is->gcount() != sizeof(u32)) {
+      return JPPS_INVALID_PARAMETER << "columnar: truncated frame size";
+    }
+    auto frameSize = readU32(sizeBytes);
+    if (frameSize > MaxFrameSize) {
+      return JPPS_INVALID_PARAMETER << "columnar: frame size " << frameSize
+                                    << " is too large";
+    }
+    auto start = storage_.size();
+    storage_.append(sizeBytes, sizeof(u32));
+    storage_.resize(start + sizeof(u32) + frameSize);
+    is->read(&storage_[start + sizeof(u32)], frameSize);
+    if (static_cast<u32>(is->gcount()) != frameSize) {
+      return JPPS_INVALID_PARAMETER << "columnar: truncated frame, expected "
+                                    << frameSize << " bytes, got "
+                                    << is->gcount();
+    }
+  }
+  return parseStorage();
+}
+
+}  // namespace columnar
+}  // namespace jumandic
+}  // namespace jumanpp
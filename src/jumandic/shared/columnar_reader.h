@@ -0,0 +1,115 @@
+#ifndef JUMANPP_COLUMNAR_READER_H
+#define JUMANPP_COLUMNAR_READER_H
+
+#include <cstring>
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "util/array_slice.h"
+#include "util/status.hpp"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace jumandic {
+namespace columnar {
+
+/**
+ * Columnar output consists of self-contained frames, one per input sentence.
+ * All values are little-endian and every section is 4-byte aligned.
+ *
+ * u32 frameSize: number of bytes in the frame after this field
+ * u8 version, u8 flags, u16 reserved
+ * u32 numNodes
+ * u32 commentSize, comment bytes padded to 4 bytes
+ * u32 begin[numNodes]: byte offset of a node in the input sentence
+ * u32 end[numNodes]
+ * u16 pos[numNodes], u16 subpos[numNodes],
+ * u16 conjType[numNodes], u16 conjForm[numNodes]: Juman grammar ids
+ * i32 entry[numNodes]: dictionary entry pointer, negative for unknown words
+ * f32 score[numNodes]: cumulative path score, only with HasScores flag
+ *
+ * Sentences which could not be read, analyzed or formatted
+ * still have a frame: it has no nodes and the AnalysisFailed flag.
+ */
+constexpr u8 FormatVersion = 1;
+
+enum FrameFlags : u8 { HasScores = 0x1, AnalysisFailed = 0x2 };
+
+template <typename T>
+using EncodedType = typename std::conditional<
+    sizeof(T) == 1, u8,
+    typename std::conditional<sizeof(T) == 2, u16, u32>::type>::type;
+
+/**
+ * Write the value as little-endian bytes independently of the host order.
+ */
+template <typename T>
+inline void encodeLittleEndian(char* out, T value) {
+  static_assert(sizeof(T) <= 4, "only values up to 4 bytes are supported");
+  EncodedType<T> bits;
+  std::memcpy(&bits, &value, sizeof(T));
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    out[i] = static_cast<char>((bits >> (8 * i)) & 0xff);
+  }
+}
+
+template <typename T>
+inline T decodeLittleEndian(const char* data) {
+  static_assert(sizeof(T) <= 4, "only values up to 4 bytes are supported");
+  EncodedType<T> bits = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    bits |= static_cast<EncodedType<T>>(static_cast<u8>(data[i])) << (8 * i);
+  }
+  T result;
+  std::memcpy(&result, &bits, sizeof(T));
+  return result;
+}
+
+struct ColumnarSentence {
+  u8 flags;
+  StringPiece comment;
+  util::ArraySlice<u32> begin;
+  util::ArraySlice<u32> end;
+  util::ArraySlice<u16> pos;
+  util::ArraySlice<u16> subpos;
+  util::ArraySlice<u16> conjType;
+  util::ArraySlice<u16> conjForm;
+  util::ArraySlice<i32> entry;
+  // empty if the output was produced without scores
+  util::ArraySlice<float> score;
+
+  size_t size() const { return begin.size(); }
+  bool failed() const { return (flags & AnalysisFailed) != 0; }
+  StringPiece surface(StringPiece input, size_t idx) const {
+    return input.slice(begin[idx], end[idx]);
+  }
+};
+
+/**
+ * Reads batches of columnar frames.
+ * Sentences are views into the internal storage and stay valid
+ * until the next call of parse or readBatch.
+ */
+class ColumnarReader {
+  std::string storage_;
+  std::vector<ColumnarSentence> sentences_;
+
+  Status parseStorage();
+
+ public:
+  Status parse(StringPiece data);
+  /**
+   * Read at most maxSentences frames from the stream.
+   * Returns an empty batch when the stream is exhausted.
+   */
+  Status readBatch(std::istream* is, size_t maxSentences);
+  util::ArraySlice<ColumnarSentence> sentences() const { return sentences_; }
+};
+
+}  // namespace columnar
+}  // namespace jumandic
+}  // namespace jumanpp
+
+#endif  // JUMANPP_COLUMNAR_READER_H
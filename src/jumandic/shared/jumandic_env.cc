@@ -9,6 +9,7 @@
 #include "core/impl/segmented_format.h"
 #include "core_version.h"
 #include "jpp_jumandic_cg.h"
+#include "jumandic/shared/columnar_format.h"
 #include "jumandic/shared/lattice_format.h"
 #include "jumandic/shared/morph_format.h"
 #include "jumandic/shared/subset_format.h"
@@ -28,12 +29,30 @@
 namespace jumanpp {
 namespace jumandic {
 Status JumanppExec::init() {
+  if (conf.mappedModel) {
+    env.setModelLoadMode(core::model::ModelLoadMode::Mapped);
+  }
+  if (conf.profileStartup) {
+    startupProfile_.reset();
+    env.setStartupProfile(&startupProfile_);
+  }
   JPP_RETURN_IF_ERROR(env.loadModel(conf.modelFile.value()));
+  if (!conf.userDicFile.value().empty()) {
+    JPP_RETURN_IF_ERROR(env.loadUserDictionary(conf.userDicFile.value()));
+  }
+  if (conf.featurePlugins) {
+    env.enableFeaturePlugins(conf.featurePluginDir.value());
+  }
   env.setBeamSize(conf.beamSize);
   env.setGlobalBeam(conf.globalBeam, conf.rightCheck, conf.rightBeam);
   if (conf.autoStep.defined()) {
     env.setAutoBeam(conf.beamSize, conf.autoStep, conf.globalBeam);
   }
+  if (conf.beamMargin.value() > 0) {
+    env.setAdaptiveBeam(conf.beamMargin, conf.adaptiveGlobalMin,
+                        conf.adaptiveRightMin);
+  }
+  env.setTrigramPruning(conf.trigramPruning);
 
   bool newRnn = !conf.rnnModelFile.value().empty();
 
@@ -46,40 +65,111 @@ Status JumanppExec::init() {
         conf.rnnModelFile.value(), env.coreHolder()->dic(), conf.rnnConfig));
     env.setRnnHolder(&rnnFactory);
   }
+  markPhase("rnn config");
 
   JPP_RETURN_IF_ERROR(idResolver_.initialize(core().dic()));
+  markPhase("id resolver");
 
   jumanpp_generated::JumandicStatic features;
   JPP_RETURN_IF_ERROR(env.initFeatures(&features));
+  markPhase("feature init");
   JPP_RETURN_IF_ERROR(env.makeAnalyzer(&analyzer_));
+  markPhase("analyzer");
   JPP_RETURN_IF_ERROR(initOutput());
+  markPhase("output format");
+  initResultCache();
+
+  if (conf.profileStartup) {
+    JPP_RETURN_IF_ERROR(analyzer_.analyze("外国人参政権について議論する"));
+    JPP_RETURN_IF_ERROR(format_->format(analyzer_, EMPTY_SP));
+    markPhase("first sentence");
+    env.setStartupProfile(nullptr);
+  }
+  return Status::Ok();
+}
+
+void JumanppExec::initResultCache() {
+  resultCache_.reset();
+  // only raw input fully determines the result,
+  // graphviz output is a side effect which must happen for every sentence
+  if (conf.cacheSize <= 0 || conf.inputType != InputType::Raw ||
+      !conf.graphvizDir.value().empty()) {
+    return;
+  }
+
+  resultCache_.reset(new core::analysis::ResultCache{
+      static_cast<size_t>(conf.cacheSize.value())});
+}
+
+Status JumanppExec::analyzeExample(
+    core::input::StreamReader* reader, core::analysis::Analyzer* analyzer,
+    core::OutputFormat* format, std::string* output,
+    core::analysis::AnalysisStatsAggregate* stats) {
+  core::analysis::ResultCacheKey key;
+  StringPiece input;
+  bool cacheable = resultCache_ != nullptr && reader->rawInput(&input);
+  if (cacheable) {
+    core::analysis::ResultCache::makeKey(input, reader->comment(), &key);
+    if (resultCache_->tryGet(key, output)) {
+      return Status::Ok();
+    }
+  }
+
+  Status s = reader->analyzeWith(analyzer);
+  if (!s) {
+    auto empty = emptyResult();
+    output->assign(empty.begin(), empty.end());
+    return s;
+  }
+
+  if (stats != nullptr) {
+    stats->add(analyzer->stats());
+  }
+
+  s = format->format(*analyzer, reader->comment());
+  if (!s) {
+    auto empty = emptyResult();
+    output->assign(empty.begin(), empty.end());
+    return s;
+  }
+
+  auto result = format->result();
+  output->assign(result.begin(), result.end());
+  if (cacheable) {
+    resultCache_->put(key, result);
+  }
   return Status::Ok();
 }
 
 Status JumanppExec::initOutput() {
+  return makeFormat(&analyzer_, &format_);
+}
+
+Status JumanppExec::makeFormat(core::analysis::Analyzer* analyzer,
+                               std::unique_ptr<core::OutputFormat>* result) {
   switch (conf.outputType.value()) {
     case jumandic::OutputType::Juman: {
       auto jfmt = new jumandic::output::JumanFormat;
-      format_.reset(jfmt);
-      JPP_RETURN_IF_ERROR(jfmt->initialize(analyzer_.output()));
+      result->reset(jfmt);
+      JPP_RETURN_IF_ERROR(jfmt->initialize(analyzer->output()));
       break;
     }
     case jumandic::OutputType::Morph: {
       auto mfmt = new jumandic::output::MorphFormat(false);
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case jumandic::OutputType::FullMorph: {
       auto mfmt = new jumandic::output::MorphFormat(true);
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case OutputType::DicSubset: {
       auto mfmt = new jumandic::output::SubsetFormat{};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case OutputType::Lattice: {
@@ -90,14 +180,22 @@ Status JumanppExec::initOutput() {
         numOutput = conf.beamSize;
       }
       auto mfmt = new jumandic::output::LatticeFormat{numOutput};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
+      break;
+    }
+    case OutputType::Columnar:
+    case OutputType::ColumnarScores: {
+      bool scores = conf.outputType.value() == OutputType::ColumnarScores;
+      auto mfmt = new jumandic::output::ColumnarFormat{scores};
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case OutputType::Segmentation: {
       auto mfmt = new core::output::SegmentedFormat{};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output(),
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output(),
                                            *env.coreHolder(),
                                            conf.segmentSeparator.value()));
       break;
@@ -108,22 +206,22 @@ Status JumanppExec::initOutput() {
 #if defined(JPP_USE_PROTOBUF)
     case OutputType::FullLatticeDump: {
       auto mfmt = new core::output::LatticeDumpOutput{true, true};
-      format_.reset(mfmt);
+      result->reset(mfmt);
       JPP_RETURN_IF_ERROR(
-          mfmt->initialize(analyzer_.impl(), &env.featureScorer()->weights()));
-      analyzer_.impl()->setStoreAllPatterns(true);
+          mfmt->initialize(analyzer->impl(), &env.featureScorer()->weights()));
+      analyzer->impl()->setStoreAllPatterns(true);
       break;
     }
     case OutputType::JumanPb: {
       auto mfmt = new jumandic::JumanPbFormat();
-      format_.reset(mfmt);
+      result->reset(mfmt);
       JPP_RETURN_IF_ERROR(
-          mfmt->initialize(analyzer_.output(), &idResolver_, true));
+          mfmt->initialize(analyzer->output(), &idResolver_, true));
       break;
     }
     case OutputType::LatticePb: {
       auto mfmt = new jumandic::JumanppProtobufOutput();
-      format_.reset(mfmt);
+      result->reset(mfmt);
       i32 numOutput = conf.beamOutput;
       if (numOutput == -1) {
         LOG_TRACE() << "Using beam width for lattice output format instead of "
@@ -131,15 +229,15 @@ Status JumanppExec::initOutput() {
         numOutput = conf.beamSize;
       }
       JPP_RETURN_IF_ERROR(
-          mfmt->initialize(analyzer_.output(), &idResolver_, numOutput, true));
+          mfmt->initialize(analyzer->output(), &idResolver_, numOutput, true));
       break;
     }
 #endif
 #ifdef JPP_ENABLE_DEV_TOOLS
     case OutputType::GlobalBeamPos: {
       auto mfmt = new core::output::GlobalBeamPositionFormat{conf.globalBeam};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(*analyzer));
       break;
     }
 #endif
@@ -216,6 +314,9 @@ StringPiece JumanppExec::emptyResult() const {
     case OutputType::Morph:
     case OutputType::FullMorph:
       return StringPiece{"# ERROR\n"};
+    case OutputType::Columnar:
+    case OutputType::ColumnarScores:
+      return jumandic::output::ColumnarFormat::errorFrame();
     default:
       return EMPTY_SP;
   }
@@ -5,11 +5,14 @@
 #ifndef JUMANPP_JUMANDIC_ENV_H
 #define JUMANPP_JUMANDIC_ENV_H
 
+#include "core/analysis/analysis_stats.h"
 #include "core/analysis/perceptron.h"
+#include "core/analysis/result_cache.h"
 #include "core/analysis/rnn_scorer.h"
 #include "core/analysis/score_api.h"
 #include "core/env.h"
 #include "core/impl/model_io.h"
+#include "core/input/stream_reader.h"
 #include "jumandic/shared/juman_format.h"
 #include "jumandic/shared/jumandic_id_resolver.h"
 #include "jumandic/shared/jumanpp_args.h"
@@ -31,7 +34,19 @@ class JumanppExec {
 
   u64 numAnalyzed_ = 0;
 
+  core::StartupProfile startupProfile_;
+
+  std::unique_ptr<core::analysis::ResultCache> resultCache_;
+
+  core::analysis::AnalysisStatsAggregate analysisStats_;
+
   Status writeGraphviz();
+  void initResultCache();
+  void markPhase(StringPiece name) {
+    if (conf.profileStartup) {
+      startupProfile_.mark(name);
+    }
+  }
 
  public:
   JumanppExec() = default;
@@ -39,6 +54,13 @@ class JumanppExec {
 
   virtual Status initOutput();
 
+  /**
+   * Create an output format for the configured output type, bound to the
+   * passed analyzer. The analyzer must outlive the format.
+   */
+  Status makeFormat(core::analysis::Analyzer* analyzer,
+                    std::unique_ptr<core::OutputFormat>* result);
+
   virtual Status init(const jumandic::JumanppConf& conf) {
     this->conf.mergeWith(conf);
     return init();
@@ -63,8 +85,48 @@ class JumanppExec {
 
   StringPiece output() const { return format_->result(); }
 
+  /**
+   * Analyze the current example of the reader and format the result
+   * into output, using the result cache when it is enabled.
+   * Can be called from several threads with different analyzers and formats.
+   *
+   * When analysis fails, output contains the empty result.
+   * Statistics of analyzed (not cached) examples are added to stats
+   * when it is not null.
+   */
+  Status analyzeExample(
+      core::input::StreamReader* reader, core::analysis::Analyzer* analyzer,
+      core::OutputFormat* format, std::string* output,
+      core::analysis::AnalysisStatsAggregate* stats = nullptr);
+
+  /**
+   * @return null if result caching is disabled
+   */
+  const core::analysis::ResultCache* resultCache() const {
+    return resultCache_.get();
+  }
+
   u64 numAnalyzed() const { return numAnalyzed_; }
 
+  /**
+   * Analysis statistics are collected only when enabled in the configuration.
+   * The aggregate is not thread-safe: analysis threads
+   * need to collect statistics separately and merge them.
+   */
+  bool collectStats() const { return conf.stats; }
+  core::analysis::AnalysisStatsAggregate& analysisStats() {
+    return analysisStats_;
+  }
+
+  /**
+   * Timings of initialization phases, filled when
+   * startup profiling was enabled in the configuration.
+   * Analysis of the first sentence is included as a warmup phase.
+   */
+  const core::StartupProfile& startupProfile() const {
+    return startupProfile_;
+  }
+
   virtual ~JumanppExec() = default;
 
   void printModelInfo() const;
@@ -5,13 +5,17 @@
 #ifndef JUMANPP_JUMANDIC_TEST_ENV_H
 #define JUMANPP_JUMANDIC_TEST_ENV_H
 
+#include <algorithm>
 #include <fstream>
+#include <vector>
+#include "core/analysis/analyzer_impl.h"
 #include "core/impl/graphviz_format.h"
 #include "core/training/training_env.h"
 #include "jumandic/shared/juman_format.h"
 #include "jumandic/shared/jumandic_spec.h"
 #include "jumandic_spec.h"
 #include "testing/test_analyzer.h"
+#include "util/array_slice.h"
 #include "util/lazy.h"
 
 using namespace jumanpp;
@@ -113,6 +117,51 @@ class JumandicTrainingTestEnv {
     }
   }
 };
+
+// Sentences for analysis tests with jumanpp_minimal.mdic
+inline util::ArraySlice<StringPiece> jumandicTestExamples() {
+  static const StringPiece examples[] = {
+      "大阪の田舎で住む人",
+      "かつての重い効果は明らかだ",
+      "コンピュータＡＢＣで２０１８年にソフトウェアを開発した",
+      "ほげほげぴよぴよは知らない単語だよ！！",
+      "外国人の参政権について議論する",
+  };
+  return examples;
+}
+
+struct BeamStats {
+  // scores of complete paths, best first
+  std::vector<float> eosScores;
+  u64 scoredConnections;
+  u64 prunedConnections;
+  u64 featuresHashed;
+  size_t maxGlobalBeam;
+};
+
+// Analyze the input and collect beam statistics of the analysis
+inline BeamStats analyzeBeams(core::analysis::Analyzer* ana,
+                              StringPiece input) {
+  REQUIRE_OK(ana->analyze(input));
+  auto lat = ana->impl()->lattice();
+  auto eos = lat->boundary(lat->createdBoundaryCount() - 1);
+  BeamStats result{};
+  for (auto& el : eos->starts()->beamData()) {
+    if (core::analysis::EntryBeam::isFake(el)) {
+      break;
+    }
+    result.eosScores.push_back(el.totalScore);
+  }
+  auto& stats = ana->stats();
+  result.scoredConnections = stats.scoredConnections;
+  result.prunedConnections = stats.prunedConnections;
+  result.featuresHashed = stats.featuresHashed;
+  for (u32 i = 2; i < lat->createdBoundaryCount(); ++i) {
+    auto gbeam = lat->boundary(i)->ends()->globalBeam();
+    result.maxGlobalBeam = std::max(result.maxGlobalBeam, gbeam.size());
+  }
+  return result;
+}
 }  // namespace
 
 #endif  // JUMANPP_JUMANDIC_TEST_ENV_H
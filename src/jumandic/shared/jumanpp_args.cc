@@ -53,6 +53,8 @@ struct JppArgsParser {
       instance["morph"] = OutputType::Morph;
       instance["full-morph"] = OutputType::FullMorph;
       instance["dic-subset"] = OutputType::DicSubset;
+      instance["columnar"] = OutputType::Columnar;
+      instance["columnar-scores"] = OutputType::ColumnarScores;
 #if defined(JPP_USE_PROTOBUF)
       instance["juman-pb"] = OutputType::JumanPb;
       instance["lattice-pb"] = OutputType::LatticePb;
@@ -89,6 +91,15 @@ struct JppArgsParser {
                           "partianInput",
                           "Input is partially-annotated",
                           {"partial-input"}};
+  args::Flag profileStartup{
+      general,
+      "profileStartup",
+      "Print time and peak memory of initialization phases to stderr",
+      {"profile-startup"}};
+  args::Flag stats{general, "stats",
+                   "Print per-phase analysis timings and lattice statistics "
+                   "to stderr after the input is analyzed",
+                   {"stats"}};
 
   args::Group outputType{parser, "Output format"};
   args::MapFlag<std::string, OutputType, args::ValueReader, util::FlatMap>
@@ -127,6 +138,30 @@ struct JppArgsParser {
       modelParams, "model", "Model filename", {"model"}};
   args::ValueFlag<std::string> rnnModelFile{
       modelParams, "rnn model", "RNN model filename", {"rnn-model"}};
+  args::ValueFlag<std::string> userDicFile{
+      modelParams,
+      "csv",
+      "User dictionary in the csv format of the model dictionary, its "
+      "entries are used in addition to the model ones",
+      {"user-dic"}};
+  args::Flag featurePlugins{
+      modelParams,
+      "featurePlugins",
+      "Use feature plugins built by jumanpp_tool feature-plugin for models "
+      "which do not match the built-in static features",
+      {"feature-plugins"}};
+  args::ValueFlag<std::string> featurePluginDir{
+      modelParams,
+      "DIRECTORY",
+      "Directory with feature plugins for --feature-plugins, "
+      "the model directory by default",
+      {"feature-plugin-dir"}};
+  args::Flag mappedModel{modelParams,
+                         "mappedModel",
+                         "Use the model directly from the memory mapped file "
+                         "without copying, faster startup and the model is "
+                         "shared between processes",
+                         {"mapped-model"}};
 
   args::Group analysisParams{parser, "Analysis parameters"};
   args::ValueFlag<i32> beamSize{
@@ -142,6 +177,35 @@ struct JppArgsParser {
       "BASE:STEP:MAX",
       "Automatic beam size (from length). Sets local and global left beams.",
       {"auto-nbest"}};
+  args::ValueFlag<std::string> adaptiveBeam{
+      analysisParams,
+      "MARGIN[:MIN_GLOBAL:MIN_RIGHT]",
+      "Adaptive beams, off by default: keep only candidates within MARGIN "
+      "from the best score. Global and right beam sizes become the maximums. "
+      "Margins were evaluated only on synthetic data.",
+      {"adaptive-beam"}};
+  args::Flag trigramPruning{
+      analysisParams,
+      "trigramPruning",
+      "Skip trigram features of global beam connections which can not enter "
+      "the beam because of score upper bounds",
+      {"trigram-pruning"}};
+  args::ValueFlag<i32> numThreads{
+      analysisParams,
+      "N",
+      "# of analysis threads, 1 default. Output keeps the input order.",
+      {"threads"}};
+  args::Flag pipeline{
+      analysisParams,
+      "pipeline",
+      "Read input, analyze and write output in separate threads, "
+      "so reading and writing overlap with the analysis",
+      {"pipeline"}};
+  args::ValueFlag<i32> cacheSize{
+      analysisParams,
+      "N",
+      "Cache results for up to N distinct sentences, 0 (default) disables",
+      {"cache"}};
 #ifdef JPP_ENABLE_DEV_TOOLS
   args::Group devParams{parser, "Dev options"};
   args::Flag globalBeamPos{devParams,
@@ -253,6 +317,13 @@ struct JppArgsParser {
     result->outputFile.set(outputFile);
     result->modelFile.set(modelFile);
     result->rnnModelFile.set(rnnModelFile);
+    result->userDicFile.set(userDicFile);
+    result->featurePlugins.set(featurePlugins, true);
+    result->featurePluginDir.set(featurePluginDir);
+    result->mappedModel.set(mappedModel, true);
+    result->profileStartup.set(profileStartup, true);
+    result->stats.set(stats, true);
+    result->trigramPruning.set(trigramPruning, true);
     result->graphvizDir.set(graphvis);
     result->segmentSeparator.set(segmentSeparator);
 
@@ -264,6 +335,9 @@ struct JppArgsParser {
     result->globalBeam.set(globalBeamSize);
     result->rightCheck.set(rightCheckBeam);
     result->rightBeam.set(rightBeamSize);
+    result->numThreads.set(numThreads);
+    result->pipeline.set(pipeline, true);
+    result->cacheSize.set(cacheSize);
 
     if (autoBeam) {
       std::regex autoBeamRegex(R"(^(\d+):(\d+):(\d+)$)");
@@ -276,6 +350,19 @@ struct JppArgsParser {
       }
     }
 
+    if (adaptiveBeam) {
+      std::regex adaptiveBeamRegex(R"(^(\d+(?:\.\d*)?)(?::(\d+):(\d+))?$)");
+      std::smatch results;
+      auto& s = adaptiveBeam.Get();
+      if (std::regex_search(s, results, adaptiveBeamRegex)) {
+        result->beamMargin = std::stof(results[1]);
+        if (results[2].matched) {
+          result->adaptiveGlobalMin = to_int10<i32>(results[2]);
+          result->adaptiveRightMin = to_int10<i32>(results[3]);
+        }
+      }
+    }
+
 #ifdef JPP_ENABLE_DEV_TOOLS
     result->outputType.set(globalBeamPos, OutputType::GlobalBeamPos);
 #endif
@@ -403,13 +490,26 @@ std::ostream& operator<<(std::ostream& os, const JumanppConf& conf) {
      << "\noutputFile: " << conf.outputFile
      << "\ninputFiles: " << VOut(conf.inputFiles.value())
      << "\nrnnModelFile: " << conf.rnnModelFile
+     << "\nuserDicFile: " << conf.userDicFile
+     << "\nfeaturePlugins: " << conf.featurePlugins
+     << "\nfeaturePluginDir: " << conf.featurePluginDir
      << "\nrnnConfig: " << conf.rnnConfig
      << "\ngraphvizDir: " << conf.graphvizDir << "\nbeamSize: " << conf.beamSize
      << "\nbeamOutput: " << conf.beamOutput
      << "\nglobalBeam: " << conf.globalBeam << "\nrightBeam: " << conf.rightBeam
      << "\nrightCheck: " << conf.rightCheck
      << "\nsegmentSeparator: " << conf.segmentSeparator
-     << "\nautoStep: " << conf.autoStep << "\nlogLevel: " << conf.logLevel;
+     << "\nautoStep: " << conf.autoStep << "\nbeamMargin: " << conf.beamMargin
+     << "\nadaptiveGlobalMin: " << conf.adaptiveGlobalMin
+     << "\nadaptiveRightMin: " << conf.adaptiveRightMin
+     << "\ntrigramPruning: " << conf.trigramPruning
+     << "\nnumThreads: " << conf.numThreads
+     << "\npipeline: " << conf.pipeline
+     << "\ncacheSize: " << conf.cacheSize
+     << "\nmappedModel: " << conf.mappedModel
+     << "\nprofileStartup: " << conf.profileStartup
+     << "\nstats: " << conf.stats
+     << "\nlogLevel: " << conf.logLevel;
   return os;
 }
 }  // namespace jumandic
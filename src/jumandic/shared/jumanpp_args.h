@@ -25,6 +25,8 @@ enum class OutputType {
   FullMorph,
   DicSubset,
   Lattice,
+  Columnar,
+  ColumnarScores,
 #if defined(JPP_USE_PROTOBUF)
   JumanPb,
   LatticePb,
@@ -45,6 +47,9 @@ struct JumanppConf {
   util::Cfg<std::string> outputFile{"-"};
   util::Cfg<std::vector<std::string>> inputFiles{};
   util::Cfg<std::string> rnnModelFile;
+  util::Cfg<std::string> userDicFile;
+  util::Cfg<bool> featurePlugins = false;
+  util::Cfg<std::string> featurePluginDir;
   core::analysis::rnn::RnnInferenceConfig rnnConfig{};
   util::Cfg<std::string> graphvizDir;
   util::Cfg<i32> beamSize = 5;
@@ -54,6 +59,16 @@ struct JumanppConf {
   util::Cfg<i32> rightCheck = 1;
   util::Cfg<i32> logLevel = 0;
   util::Cfg<i32> autoStep = 0;
+  util::Cfg<float> beamMargin = 0;
+  util::Cfg<i32> adaptiveGlobalMin = 1;
+  util::Cfg<i32> adaptiveRightMin = 1;
+  util::Cfg<bool> trigramPruning = false;
+  util::Cfg<i32> numThreads = 1;
+  util::Cfg<bool> pipeline = false;
+  util::Cfg<i32> cacheSize = 0;
+  util::Cfg<bool> mappedModel = false;
+  util::Cfg<bool> profileStartup = false;
+  util::Cfg<bool> stats = false;
   util::Cfg<std::string> segmentSeparator{" "};
 
   void mergeWith(const JumanppConf& o) {
@@ -64,6 +79,9 @@ struct JumanppConf {
     inputType.mergeWith(o.inputType);
     inputFiles.mergeWith(o.inputFiles);
     rnnModelFile.mergeWith(o.rnnModelFile);
+    userDicFile.mergeWith(o.userDicFile);
+    featurePlugins.mergeWith(o.featurePlugins);
+    featurePluginDir.mergeWith(o.featurePluginDir);
     rnnConfig.mergeWith(o.rnnConfig);
     graphvizDir.mergeWith(o.graphvizDir);
     beamSize.mergeWith(o.beamSize);
@@ -73,6 +91,16 @@ struct JumanppConf {
     rightCheck.mergeWith(o.rightCheck);
     logLevel.mergeWith(o.logLevel);
     autoStep.mergeWith(o.autoStep);
+    beamMargin.mergeWith(o.beamMargin);
+    adaptiveGlobalMin.mergeWith(o.adaptiveGlobalMin);
+    adaptiveRightMin.mergeWith(o.adaptiveRightMin);
+    trigramPruning.mergeWith(o.trigramPruning);
+    numThreads.mergeWith(o.numThreads);
+    pipeline.mergeWith(o.pipeline);
+    cacheSize.mergeWith(o.cacheSize);
+    mappedModel.mergeWith(o.mappedModel);
+    profileStartup.mergeWith(o.profileStartup);
+    stats.mergeWith(o.stats);
     segmentSeparator.mergeWith(o.segmentSeparator);
   }
 
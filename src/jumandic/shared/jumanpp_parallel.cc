@@ -0,0 +1,320 @@
+#include "jumanpp_parallel.h"
+#include <algorithm>
+#include "util/logging.hpp"
+
+namespace jumanpp {
+namespace jumandic {
+
+Status ParallelAnalysisThread::initialize(JumanppExec* exec) {
+  JPP_RETURN_IF_ERROR(exec->initAnalyzer(&analyzer_));
+  JPP_RETURN_IF_ERROR(exec->makeFormat(&analyzer_, &format_));
+  exec_ = exec;
+  emptyResult_ = exec->emptyResult();
+  try {
+    thread_ = std::thread{ParallelAnalysisThread::runMain, this};
+  } catch (std::system_error& e) {
+    return JPPS_INVALID_STATE << "failed to start analysis thread: "
+                              << e.code() << " msg: " << e.what();
+  }
+  return Status::Ok();
+}
+
+void ParallelAnalysisThread::run() {
+  while (true) {
+    auto task = input_->waitFor();
+    if (task == nullptr) {
+      return;
+    }
+
+    try {
+      process(task);
+    } catch (std::exception& e) {
+      task->status = JPPS_INVALID_STATE
+                     << "caught an exception while analyzing: " << e.what();
+      task->output.assign(emptyResult_.begin(), emptyResult_.end());
+    }
+
+    while (!output_->offer(std::move(task))) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void ParallelAnalysisThread::process(ParallelAnalysisTask* task) {
+  if (task->skipAnalysis) {
+    return;
+  }
+  auto stats = exec_->collectStats() ? &stats_ : nullptr;
+  task->status = exec_->analyzeExample(task->reader.get(), &analyzer_,
+                                       format_.get(), &task->output, stats);
+}
+
+void ParallelAnalysisThread::finish() {
+  if (thread_.joinable()) {
+    thread_.join();
+    if (exec_->collectStats()) {
+      exec_->analysisStats().merge(stats_);
+    }
+  }
+}
+
+Status ParallelOutputThread::initialize(size_t maxInFlight) {
+  reorder_.assign(maxInFlight, nullptr);
+  try {
+    thread_ = std::thread{ParallelOutputThread::runMain, this};
+  } catch (std::system_error& e) {
+    return JPPS_INVALID_STATE << "failed to start output thread: " << e.code()
+                              << " msg: " << e.what();
+  }
+  return Status::Ok();
+}
+
+void ParallelOutputThread::run() {
+  while (true) {
+    auto task = input_->waitFor();
+    if (task == nullptr) {
+      output_->flush();
+      return;
+    }
+
+    if (task == flushMarker_) {
+      flushPending_ = true;
+      flushIfIdle();
+      continue;
+    }
+
+    reorder_[task->sequence % reorder_.size()] = task;
+    while (true) {
+      auto& slot = reorder_[nextSequence_ % reorder_.size()];
+      if (slot == nullptr) {
+        break;
+      }
+      write(slot);
+      slot = nullptr;
+      nextSequence_ += 1;
+    }
+    flushIfIdle();
+  }
+}
+
+void ParallelOutputThread::write(ParallelAnalysisTask* task) {
+  if (!task->status) {
+    *errors_ << task->status;
+  }
+  *output_ << task->output;
+  while (!written_->offer(std::move(task))) {
+    std::this_thread::yield();
+  }
+}
+
+void ParallelOutputThread::flushIfIdle() {
+  if (flushPending_ &&
+      nextSequence_ == numSubmitted_->load(std::memory_order_acquire)) {
+    // the marker is returned before flushing: a client can react to
+    // the flushed output with new input, and the flush it causes
+    // must not be skipped because the marker is still queued
+    flushPending_ = false;
+    auto marker = flushMarker_;
+    while (!written_->offer(std::move(marker))) {
+      std::this_thread::yield();
+    }
+    output_->flush();
+  }
+}
+
+void ParallelOutputThread::finish() {
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+Status JumanppParallelExec::initialize(JumanppExec* exec, u32 nthreads,
+                                       const ReaderFactory& readerFactory,
+                                       std::ostream* output,
+                                       std::ostream* errors,
+                                       u32 tasksPerThread, bool outputThread) {
+  if (nthreads == 0) {
+    return JPPS_INVALID_PARAMETER << "number of threads must be positive";
+  }
+
+  output_ = output;
+  errors_ = errors;
+  emptyResult_ = exec->emptyResult();
+
+  auto numTasks = nthreads * std::max<u32>(tasksPerThread, 1);
+  tasks_.clear();
+  free_.clear();
+  for (u32 i = 0; i < numTasks; ++i) {
+    tasks_.emplace_back(new ParallelAnalysisTask);
+    JPP_RETURN_IF_ERROR(readerFactory(&tasks_.back()->reader));
+    free_.push_back(tasks_.back().get());
+  }
+
+  // queues must fit every task and a stop marker for every thread,
+  // so offers from the executor never fail.
+  // The output thread also gets a stop and a flush marker.
+  submitted_.initialize(numTasks + nthreads);
+  processed_.initialize(numTasks + 2);
+  written_.initialize(numTasks + 1);
+
+  if (outputThread) {
+    writer_.reset(new ParallelOutputThread{&processed_, &written_, output_,
+                                           errors_, &numSubmitted_,
+                                           &flushMarker_});
+    JPP_RETURN_IF_ERROR(writer_->initialize(numTasks));
+  }
+
+  for (u32 i = 0; i < nthreads; ++i) {
+    auto thread = new ParallelAnalysisThread{&submitted_, &processed_};
+    threads_.emplace_back(thread);
+    JPP_RETURN_IF_ERROR(thread->initialize(exec));
+  }
+
+  return Status::Ok();
+}
+
+void JumanppParallelExec::markProcessed(ParallelAnalysisTask* task) {
+  task->processed = true;
+  writeProcessed();
+}
+
+void JumanppParallelExec::writeProcessed() {
+  while (!pending_.empty() && pending_.front()->processed) {
+    auto task = pending_.front();
+    pending_.pop_front();
+    if (!task->status) {
+      *errors_ << task->status;
+    }
+    *output_ << task->output;
+    free_.push_back(task);
+  }
+}
+
+void JumanppParallelExec::reclaimWritten(ParallelAnalysisTask* task) {
+  if (task == &flushMarker_) {
+    flushQueued_ = false;
+    return;
+  }
+  numInFlight_ -= 1;
+  free_.push_back(task);
+}
+
+void JumanppParallelExec::requestFlush() {
+  if (!writer_) {
+    // a flush is requested before waiting for input,
+    // so results of all submitted sentences must be in the output
+    while (!pending_.empty()) {
+      markProcessed(processed_.waitFor());
+    }
+    output_->flush();
+    return;
+  }
+  ParallelAnalysisTask* task;
+  while (written_.recieve(&task)) {
+    reclaimWritten(task);
+  }
+  // at most one flush marker is queued at a time
+  if (!flushQueued_) {
+    flushQueued_ = true;
+    auto marker = &flushMarker_;
+    while (!processed_.offer(std::move(marker))) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+ParallelAnalysisTask* JumanppParallelExec::acquire() {
+  ParallelAnalysisTask* task;
+  if (writer_) {
+    while (written_.recieve(&task)) {
+      reclaimWritten(task);
+    }
+    while (free_.empty()) {
+      reclaimWritten(written_.waitFor());
+    }
+  } else {
+    while (processed_.recieve(&task)) {
+      markProcessed(task);
+    }
+    while (free_.empty()) {
+      markProcessed(processed_.waitFor());
+    }
+  }
+
+  task = free_.back();
+  free_.pop_back();
+  task->processed = false;
+  task->skipAnalysis = false;
+  task->status = Status::Ok();
+  task->output.clear();
+  return task;
+}
+
+void JumanppParallelExec::release(ParallelAnalysisTask* task) {
+  free_.push_back(task);
+}
+
+void JumanppParallelExec::submit(ParallelAnalysisTask* task) {
+  auto sequence = numSubmitted_.load(std::memory_order_relaxed);
+  task->sequence = sequence;
+  if (writer_) {
+    numInFlight_ += 1;
+  } else {
+    pending_.push_back(task);
+  }
+  // the output thread must not see the task before the counter
+  numSubmitted_.store(sequence + 1, std::memory_order_release);
+  while (!submitted_.offer(std::move(task))) {
+    std::this_thread::yield();
+  }
+}
+
+void JumanppParallelExec::submitEmpty(ParallelAnalysisTask* task) {
+  task->skipAnalysis = true;
+  task->output.assign(emptyResult_.begin(), emptyResult_.end());
+  submit(task);
+}
+
+void JumanppParallelExec::finish() {
+  if (writer_) {
+    while (numInFlight_ > 0) {
+      reclaimWritten(written_.waitFor());
+    }
+    // the output thread flushes the output when it is stopped
+    stopWriter();
+    return;
+  }
+  while (!pending_.empty()) {
+    markProcessed(processed_.waitFor());
+  }
+  output_->flush();
+}
+
+void JumanppParallelExec::stopThreads() {
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    while (!submitted_.offer(nullptr)) {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& t : threads_) {
+    t->finish();
+  }
+  threads_.clear();
+  stopWriter();
+}
+
+void JumanppParallelExec::stopWriter() {
+  if (writer_) {
+    ParallelAnalysisTask* stop = nullptr;
+    while (!processed_.offer(std::move(stop))) {
+      std::this_thread::yield();
+    }
+    writer_->finish();
+    writer_.reset();
+  }
+}
+
+JumanppParallelExec::~JumanppParallelExec() { stopThreads(); }
+
+}  // namespace jumandic
+}  // namespace jumanpp
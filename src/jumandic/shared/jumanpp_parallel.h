@@ -0,0 +1,240 @@
+#ifndef JUMANPP_JUMANPP_PARALLEL_H
+#define JUMANPP_JUMANPP_PARALLEL_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include "core/input/stream_reader.h"
+#include "jumandic/shared/jumandic_env.h"
+#include "util/lockfree_queue.h"
+
+namespace jumanpp {
+namespace jumandic {
+
+/**
+ * A single sentence travelling through the parallel executor.
+ * The reader holds the input (and its per-sentence state, e.g. partial
+ * annotation), workers fill output and status.
+ */
+struct ParallelAnalysisTask {
+  std::unique_ptr<core::input::StreamReader> reader;
+  std::string output;
+  Status status = Status::Ok();
+  // Position in the submission order
+  u64 sequence = 0;
+  // The output is already filled, the task must not be analyzed
+  bool skipAnalysis = false;
+  // Touched only by the thread which owns the executor
+  bool processed = false;
+};
+
+using TaskQueue = util::mpmc_bounded_queue<ParallelAnalysisTask*>;
+
+class ParallelAnalysisThread {
+  core::analysis::Analyzer analyzer_;
+  std::unique_ptr<core::OutputFormat> format_;
+  core::analysis::AnalysisStatsAggregate stats_;
+  JumanppExec* exec_ = nullptr;
+  StringPiece emptyResult_;
+  TaskQueue* input_;
+  TaskQueue* output_;
+  std::thread thread_;
+
+  void run();
+  void process(ParallelAnalysisTask* task);
+
+  // an entry point of the thread
+  static void runMain(ParallelAnalysisThread* ctx) { ctx->run(); }
+
+ public:
+  ParallelAnalysisThread(TaskQueue* input, TaskQueue* output)
+      : input_{input}, output_{output} {}
+  Status initialize(JumanppExec* exec);
+
+  /**
+   * Stops the thread and merges its analysis statistics into the executor.
+   */
+  void finish();
+};
+
+/**
+ * Writes analyzed sentences to the output in the submission order
+ * and returns their tasks to the executor.
+ * Having a separate thread for the output lets writes overlap
+ * with reading the input and with the analysis.
+ *
+ * The output is flushed only when the flush marker is received
+ * and all submitted sentences are written, and when the thread is stopped.
+ */
+class ParallelOutputThread {
+  TaskQueue* input_;
+  TaskQueue* written_;
+  std::ostream* output_;
+  std::ostream* errors_;
+  const std::atomic<u64>* numSubmitted_;
+  ParallelAnalysisTask* flushMarker_;
+  // analyzed tasks which wait for their predecessors, by sequence
+  std::vector<ParallelAnalysisTask*> reorder_;
+  u64 nextSequence_ = 0;
+  bool flushPending_ = false;
+  std::thread thread_;
+
+  void run();
+  void write(ParallelAnalysisTask* task);
+  void flushIfIdle();
+
+  static void runMain(ParallelOutputThread* ctx) { ctx->run(); }
+
+ public:
+  ParallelOutputThread(TaskQueue* input, TaskQueue* written,
+                       std::ostream* output, std::ostream* errors,
+                       const std::atomic<u64>* numSubmitted,
+                       ParallelAnalysisTask* flushMarker)
+      : input_{input},
+        written_{written},
+        output_{output},
+        errors_{errors},
+        numSubmitted_{numSubmitted},
+        flushMarker_{flushMarker} {}
+  Status initialize(size_t maxInFlight);
+  void finish();
+};
+
+/**
+ * Stream buffer which does not hold any data,
+ * but calls a function when it is flushed.
+ */
+class FlushCallbackBuf : public std::streambuf {
+  std::function<void()> callback_;
+
+ protected:
+  int sync() override {
+    callback_();
+    return 0;
+  }
+
+ public:
+  explicit FlushCallbackBuf(std::function<void()> callback)
+      : callback_{std::move(callback)} {}
+};
+
+/**
+ * Analyzes sentences with a pool of threads.
+ * Each thread owns an Analyzer and an OutputFormat, model data is
+ * shared through the JumanppExec.
+ *
+ * Sentences are read by the caller into tasks, which are
+ * then analyzed out-of-order, but written to the output stream in
+ * the order they were submitted.
+ * The number of sentences in flight is bounded,
+ * so the memory usage does not depend on the input size.
+ *
+ * With a separate output thread, the executor is a three-stage pipeline:
+ * the caller reads, analysis threads analyze and format,
+ * and the output thread writes. Otherwise results are written
+ * by the caller while it acquires tasks.
+ *
+ * All methods must be called from a single thread.
+ */
+class JumanppParallelExec {
+ public:
+  using ReaderFactory =
+      std::function<Status(std::unique_ptr<core::input::StreamReader>*)>;
+
+ private:
+  std::vector<std::unique_ptr<ParallelAnalysisTask>> tasks_;
+  std::vector<ParallelAnalysisTask*> free_;
+  std::deque<ParallelAnalysisTask*> pending_;
+  TaskQueue submitted_;
+  TaskQueue processed_;
+  std::vector<std::unique_ptr<ParallelAnalysisThread>> threads_;
+  std::ostream* output_ = nullptr;
+  std::ostream* errors_ = nullptr;
+  StringPiece emptyResult_;
+
+  // output thread state
+  std::unique_ptr<ParallelOutputThread> writer_;
+  TaskQueue written_;
+  std::atomic<u64> numSubmitted_{0};
+  u64 numInFlight_ = 0;
+  bool flushQueued_ = false;
+  ParallelAnalysisTask flushMarker_;
+  FlushCallbackBuf flushBuf_{[this]() { requestFlush(); }};
+  std::ostream flushStream_{&flushBuf_};
+
+  void markProcessed(ParallelAnalysisTask* task);
+  void writeProcessed();
+  void reclaimWritten(ParallelAnalysisTask* task);
+  void requestFlush();
+  void stopThreads();
+  void stopWriter();
+
+ public:
+  JumanppParallelExec() = default;
+  JumanppParallelExec(const JumanppParallelExec&) = delete;
+
+  /**
+   * When outputThread is true, results are written by a separate thread.
+   * The output stream must not be used by other threads
+   * until the executor is finished.
+   */
+  Status initialize(JumanppExec* exec, u32 nthreads,
+                    const ReaderFactory& readerFactory, std::ostream* output,
+                    std::ostream* errors, u32 tasksPerThread = 4,
+                    bool outputThread = false);
+
+  /**
+   * Get a task to read the next sentence into.
+   * Blocks until a task becomes available,
+   * writing results of already analyzed sentences meanwhile.
+   */
+  ParallelAnalysisTask* acquire();
+
+  /**
+   * Return the task without analyzing it, e.g. when reading has failed.
+   */
+  void release(ParallelAnalysisTask* task);
+
+  /**
+   * Queue the task for analysis.
+   */
+  void submit(ParallelAnalysisTask* task);
+
+  /**
+   * Queue the task without analyzing it, e.g. when reading has failed.
+   * Its output is the error result of the output format,
+   * so the output stays aligned with the input.
+   */
+  void submitEmpty(ParallelAnalysisTask* task);
+
+  /**
+   * Wait until all submitted sentences are analyzed
+   * and write their results to the output.
+   * The output thread is stopped, so this must be the last call.
+   * Analysis statistics of threads are merged into the JumanppExec
+   * only when the threads are stopped, in the destructor.
+   */
+  void finish();
+
+  u32 numThreads() const { return static_cast<u32>(threads_.size()); }
+
+  /**
+   * Flushing this stream makes all submitted sentences appear in the output.
+   * Without the output thread, it waits for their analysis and writes them.
+   * With the output thread, the output is flushed by that thread
+   * as soon as all submitted sentences are written.
+   * Input readers should be tied to it instead of the output,
+   * so interactive clients get results before more input is read.
+   */
+  std::ostream* flushStream() { return &flushStream_; }
+
+  ~JumanppParallelExec();
+};
+
+}  // namespace jumandic
+}  // namespace jumanpp
+
+#endif  // JUMANPP_JUMANPP_PARALLEL_H
@@ -0,0 +1,270 @@
+#include "jumanpp_parallel.h"
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include "core/input/stream_reader.h"
+#include "jumandic_test_env.h"
+
+namespace {
+
+class ParallelTestEnv {
+ public:
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  TempFile modelFile;
+  jumandic::JumanppExec exec;
+
+  explicit ParallelTestEnv(i32 cacheSize = 0) {
+    env.singleEpochFrom("jumandic/train_mini_01.txt");
+    auto model = env.jppEnv.modelInfoCopy();
+    env.trainEnv.value().exportScwParams(&model);
+    {
+      core::model::ModelSaver saver;
+      REQUIRE_OK(saver.open(modelFile.name()));
+      REQUIRE_OK(saver.save(model));
+    }
+    jumandic::JumanppConf conf;
+    conf.modelFile = modelFile.name();
+    conf.cacheSize = cacheSize;
+    REQUIRE_OK(exec.init(conf));
+  }
+
+  std::string input(int copies) const {
+    std::stringstream ss;
+    for (int i = 0; i < copies; ++i) {
+      ss << "# sentence-" << i << "\n";
+      ss << "大阪の田舎で住む人\n";
+      ss << "鍵をかける人が少ない\n";
+      ss << "かつての重い効果は明らかだ\n";
+      ss << "白いのお金は持つのね\n";
+    }
+    return ss.str();
+  }
+
+  std::string sequential(const std::string& data) {
+    std::stringstream in{data};
+    std::stringstream out;
+    core::input::PlainStreamReader rdr;
+    while (in.peek() != std::char_traits<char>::eof()) {
+      REQUIRE_OK(rdr.readExample(&in));
+      REQUIRE_OK(rdr.analyzeWith(exec.analyzerPtr()));
+      REQUIRE_OK(exec.format()->format(*exec.analyzerPtr(), rdr.comment()));
+      out << exec.format()->result();
+    }
+    return out.str();
+  }
+
+  std::string parallel(const std::string& data, u32 nthreads,
+                       bool outputThread = false) {
+    std::stringstream in{data};
+    std::stringstream out;
+    std::stringstream err;
+    jumandic::JumanppParallelExec pexec;
+    REQUIRE_OK(pexec.initialize(
+        &exec, nthreads,
+        [](std::unique_ptr<core::input::StreamReader>* result) {
+          result->reset(new core::input::PlainStreamReader);
+          return Status::Ok();
+        },
+        &out, &err, 2, outputThread));
+    int count = 0;
+    while (in.peek() != std::char_traits<char>::eof()) {
+      auto task = pexec.acquire();
+      REQUIRE_OK(task->reader->readExample(&in));
+      pexec.submit(task);
+      // readers request flushes when they wait for input
+      if (++count % 7 == 0) {
+        pexec.flushStream()->flush();
+      }
+    }
+    pexec.finish();
+    CHECK(err.str().empty());
+    return out.str();
+  }
+};
+
+}  // namespace
+
+TEST_CASE("parallel analysis keeps the input order") {
+  ParallelTestEnv env;
+  auto data = env.input(50);
+  auto expected = env.sequential(data);
+  CHECK(!expected.empty());
+  CHECK(env.parallel(data, 1) == expected);
+  CHECK(env.parallel(data, 4) == expected);
+}
+
+TEST_CASE("parallel analysis works with empty input") {
+  ParallelTestEnv env;
+  CHECK(env.parallel("", 3).empty());
+  CHECK(env.parallel("", 1, true).empty());
+}
+
+TEST_CASE("pipelined analysis with an output thread keeps the input order") {
+  ParallelTestEnv env;
+  auto data = env.input(50);
+  auto expected = env.sequential(data);
+  CHECK(env.parallel(data, 1, true) == expected);
+  CHECK(env.parallel(data, 4, true) == expected);
+}
+
+TEST_CASE("parallel analysis keeps the place of failed reads") {
+  ParallelTestEnv env;
+  auto data = env.input(1);
+  // the second sentence is not analyzed
+  auto expected = env.sequential("# sentence-0\n大阪の田舎で住む人\n") +
+                  env.exec.emptyResult().str() +
+                  env.sequential("かつての重い効果は明らかだ\n白いのお金は持つのね\n");
+  std::stringstream in{data};
+  std::stringstream out;
+  std::stringstream err;
+  jumandic::JumanppParallelExec pexec;
+  REQUIRE_OK(pexec.initialize(
+      &env.exec, 2,
+      [](std::unique_ptr<core::input::StreamReader>* result) {
+        result->reset(new core::input::PlainStreamReader);
+        return Status::Ok();
+      },
+      &out, &err));
+  int count = 0;
+  while (in.peek() != std::char_traits<char>::eof()) {
+    auto task = pexec.acquire();
+    REQUIRE_OK(task->reader->readExample(&in));
+    if (++count == 2) {
+      pexec.submitEmpty(task);
+    } else {
+      pexec.submit(task);
+    }
+  }
+  pexec.finish();
+  CHECK(out.str() == expected);
+}
+
+TEST_CASE("flushing parallel analysis writes all submitted sentences") {
+  ParallelTestEnv env;
+  auto data = env.input(3);
+  auto expected = env.sequential(data);
+  std::stringstream in{data};
+  std::stringstream out;
+  std::stringstream err;
+  jumandic::JumanppParallelExec pexec;
+  REQUIRE_OK(pexec.initialize(
+      &env.exec, 3,
+      [](std::unique_ptr<core::input::StreamReader>* result) {
+        result->reset(new core::input::PlainStreamReader);
+        return Status::Ok();
+      },
+      &out, &err));
+  while (in.peek() != std::char_traits<char>::eof()) {
+    auto task = pexec.acquire();
+    REQUIRE_OK(task->reader->readExample(&in));
+    pexec.submit(task);
+  }
+  // an interactive client gets the results without closing the input
+  pexec.flushStream()->flush();
+  CHECK(out.str() == expected);
+  pexec.finish();
+  CHECK(out.str() == expected);
+}
+
+namespace {
+
+// output which can be observed while the output thread writes to it,
+// only flushed data is visible
+class SyncedOutput : public std::streambuf {
+  std::mutex mutex_;
+  std::string buffer_;
+  std::string flushed_;
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      std::lock_guard<std::mutex> lock{mutex_};
+      buffer_.push_back(traits_type::to_char_type(ch));
+    }
+    return ch;
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    std::lock_guard<std::mutex> lock{mutex_};
+    buffer_.append(s, static_cast<size_t>(n));
+    return n;
+  }
+
+  int sync() override {
+    std::lock_guard<std::mutex> lock{mutex_};
+    flushed_ = buffer_;
+    return 0;
+  }
+
+ public:
+  std::string flushed() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return flushed_;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("pipelined analysis flushes every requested result") {
+  ParallelTestEnv env;
+  auto data = env.input(5);
+  // output after each sentence
+  std::vector<std::string> expected;
+  {
+    std::stringstream in{data};
+    core::input::PlainStreamReader rdr;
+    std::string output;
+    while (in.peek() != std::char_traits<char>::eof()) {
+      REQUIRE_OK(rdr.readExample(&in));
+      REQUIRE_OK(rdr.analyzeWith(env.exec.analyzerPtr()));
+      REQUIRE_OK(env.exec.format()->format(*env.exec.analyzerPtr(),
+                                           rdr.comment()));
+      output += env.exec.format()->result().str();
+      expected.push_back(output);
+    }
+  }
+
+  SyncedOutput outBuf;
+  std::ostream out{&outBuf};
+  std::stringstream err;
+  std::stringstream in{data};
+  jumandic::JumanppParallelExec pexec;
+  REQUIRE_OK(pexec.initialize(
+      &env.exec, 2,
+      [](std::unique_ptr<core::input::StreamReader>* result) {
+        result->reset(new core::input::PlainStreamReader);
+        return Status::Ok();
+      },
+      &out, &err, 2, true));
+  // like an interactive client, which waits for every response
+  // before sending the next request
+  for (auto& exp : expected) {
+    auto task = pexec.acquire();
+    REQUIRE_OK(task->reader->readExample(&in));
+    pexec.submit(task);
+    pexec.flushStream()->flush();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (outBuf.flushed() != exp &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    REQUIRE(outBuf.flushed() == exp);
+  }
+  pexec.finish();
+  CHECK(outBuf.flushed() == expected.back());
+  CHECK(err.str().empty());
+}
+
+TEST_CASE("parallel analysis serves repeated sentences from the cache") {
+  ParallelTestEnv env{100};
+  auto data = env.input(20);
+  auto expected = env.sequential(data);
+  REQUIRE(env.exec.resultCache() != nullptr);
+  CHECK(env.parallel(data, 3) == expected);
+  CHECK(env.parallel(data, 1) == expected);
+  auto stats = env.exec.resultCache()->stats();
+  CHECK(stats.hits + stats.misses == 160);
+  // the second pass is fully cached
+  CHECK(stats.hits >= 80);
+  CHECK(stats.misses >= 23);
+}
@@ -28,4 +28,13 @@ TEST_CASE("jumanpp can learn with minidic") {
   env.singleEpochFrom("jumandic/train_mini_01.txt");
   env.singleEpochFrom("jumandic/train_mini_01.txt");
   env.singleEpochFrom("jumandic/train_mini_01.txt");
-}
\ No newline at end of file
+}
+
+TEST_CASE("jumanpp can learn with minidic and concurrent updates") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainArgs.numThreads = 4;
+  env.trainArgs.batchSize = 5;
+  env.trainArgs.trainingConfig.scw.updateStripes = 16;
+  auto loss = env.trainNepochsFrom("jumandic/train_mini_01.txt", 10);
+  CHECK(loss == Approx(0.0f));
+}
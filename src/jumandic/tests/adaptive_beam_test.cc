@@ -0,0 +1,44 @@
+#include "core/analysis/analysis_stats.h"
+#include "jumandic/shared/jumandic_test_env.h"
+
+TEST_CASE("adaptive beam with a large margin does not change analysis",
+          "[gbeam]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 1);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana->impl()->setGlobalBeam(6, 1, 5));
+  for (auto ex : jumandicTestExamples()) {
+    CAPTURE(ex);
+    ana->impl()->setAdaptiveBeam(0, 1, 1);
+    auto fixed = analyzeBeams(ana.get(), ex);
+    ana->impl()->setAdaptiveBeam(1e6f, 1, 1);
+    auto adaptive = analyzeBeams(ana.get(), ex);
+    CHECK(fixed.eosScores.at(0) == adaptive.eosScores.at(0));
+    CHECK(fixed.scoredConnections == adaptive.scoredConnections);
+    CHECK(fixed.maxGlobalBeam == adaptive.maxGlobalBeam);
+  }
+}
+
+TEST_CASE("adaptive beam with a small margin shrinks beams", "[gbeam]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 1);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana->impl()->setGlobalBeam(6, 1, 5));
+  u64 fixedTotal = 0;
+  u64 adaptiveTotal = 0;
+  for (auto ex : jumandicTestExamples()) {
+    CAPTURE(ex);
+    ana->impl()->setAdaptiveBeam(0, 1, 1);
+    auto fixed = analyzeBeams(ana.get(), ex);
+    ana->impl()->setAdaptiveBeam(1e-6f, 1, 1);
+    auto adaptive = analyzeBeams(ana.get(), ex);
+    CHECK(adaptive.maxGlobalBeam <= fixed.maxGlobalBeam);
+    CHECK(adaptive.maxGlobalBeam >= 1);
+    CHECK(adaptive.scoredConnections <= fixed.scoredConnections);
+    fixedTotal += fixed.scoredConnections;
+    adaptiveTotal += adaptive.scoredConnections;
+  }
+  if (core::analysis::AnalysisStatsEnabled) {
+    CHECK(adaptiveTotal < fixedTotal);
+  }
+}
@@ -0,0 +1,42 @@
+#include "jumandic/shared/jumandic_test_env.h"
+#include "util/allocation_counter.h"
+
+namespace {
+
+u64 analysisAllocations(core::analysis::Analyzer* ana, StringPiece input) {
+  util::memory::AllocationCounter counter;
+  auto status = ana->analyze(input);
+  auto result = counter.allocations();
+  CHECK_OK(status);
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("analyzer does not allocate after warmup") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 1);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  for (auto ex : jumandicTestExamples()) {
+    CHECK_OK(ana->analyze(ex));
+  }
+  for (auto ex : jumandicTestExamples()) {
+    CAPTURE(ex);
+    CHECK(analysisAllocations(ana.get(), ex) == 0);
+  }
+}
+
+TEST_CASE("analyzer does not allocate after warmup with global beam",
+          "[gbeam]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.globalBeam(3, 1, 3);
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 1);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  for (auto ex : jumandicTestExamples()) {
+    CHECK_OK(ana->analyze(ex));
+  }
+  for (auto ex : jumandicTestExamples()) {
+    CAPTURE(ex);
+    CHECK(analysisAllocations(ana.get(), ex) == 0);
+  }
+}
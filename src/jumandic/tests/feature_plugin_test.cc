@@ -0,0 +1,94 @@
+#include "core/impl/feature_plugin.h"
+#include "core/spec/spec_hashing.h"
+#include "core/tool/plugin_cmd.h"
+#include "jumandic/shared/columnar_format.h"
+#include "jumandic/shared/jumandic_test_env.h"
+#include "pathie-cpp/include/path.hpp"
+
+namespace {
+
+const std::string sentences[] = {"大阪の田舎で住む人", "鍵をかける人が少ない",
+                                 "かつての重い効果は明らかだ",
+                                 "白いのお金は持つのね"};
+
+std::string analyzeColumnar(StringPiece modelFile, StringPiece pluginDir,
+                            bool usePlugins) {
+  core::JumanppEnv env;
+  REQUIRE_OK(env.loadModel(modelFile));
+  if (usePlugins) {
+    env.enableFeaturePlugins(pluginDir);
+  }
+  env.setBeamSize(5);
+  REQUIRE_OK(env.initFeatures(nullptr));
+  REQUIRE(env.usesFeaturePlugin() == usePlugins);
+  core::analysis::Analyzer analyzer;
+  REQUIRE_OK(env.makeAnalyzer(&analyzer));
+  jumandic::output::ColumnarFormat format{true};
+  REQUIRE_OK(format.initialize(analyzer.output()));
+  std::string result;
+  for (auto& s : sentences) {
+    REQUIRE_OK(analyzer.analyze(s));
+    REQUIRE_OK(format.format(analyzer, EMPTY_SP));
+    result += format.result().str();
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("feature plugin computes the same scores as dynamic features") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.singleEpochFrom("jumandic/train_mini_01.txt");
+  auto model = env.jppEnv.modelInfoCopy();
+  env.trainEnv.value().exportScwParams(&model);
+  TempFile modelFile;
+  {
+    core::model::ModelSaver saver;
+    REQUIRE_OK(saver.open(modelFile.name()));
+    REQUIRE_OK(saver.save(model));
+  }
+
+  Pathie::Path pluginDir{modelFile.name() + "_plugins"};
+  REQUIRE_OK(
+      core::tool::buildFeaturePlugin(modelFile.name(), pluginDir.str()));
+
+  auto dynamic = analyzeColumnar(modelFile.name(), EMPTY_SP, false);
+  auto plugin = analyzeColumnar(modelFile.name(), pluginDir.str(), true);
+
+  jumandic::columnar::ColumnarReader dynamicReader;
+  jumandic::columnar::ColumnarReader pluginReader;
+  REQUIRE_OK(dynamicReader.parse(dynamic));
+  REQUIRE_OK(pluginReader.parse(plugin));
+  auto expected = dynamicReader.sentences();
+  auto actual = pluginReader.sentences();
+  REQUIRE(actual.size() == 4);
+  REQUIRE(expected.size() == 4);
+  for (int i = 0; i < 4; ++i) {
+    CAPTURE(sentences[i]);
+    REQUIRE(actual[i].size() == expected[i].size());
+    REQUIRE(actual[i].score.size() == actual[i].size());
+    for (size_t j = 0; j < actual[i].size(); ++j) {
+      CAPTURE(j);
+      CHECK(actual[i].begin[j] == expected[i].begin[j]);
+      CHECK(actual[i].entry[j] == expected[i].entry[j]);
+      CHECK(actual[i].score[j] == Approx(expected[i].score[j]));
+    }
+  }
+
+  // the entry function checks the build of the loading binary
+  auto specHash = core::spec::hashSpec(env.jppEnv.spec());
+  auto path = pluginDir / core::features::FeaturePlugin::filename(specHash);
+  util::SharedLibrary library;
+  REQUIRE_OK(library.open(path.str()));
+  auto entry = reinterpret_cast<core::features::FeaturePluginEntry>(
+      library.symbol("jumanpp_feature_plugin_v2"));
+  REQUIRE(entry != nullptr);
+  CHECK(entry(core::features::FeaturePluginAbi, JPP_PLUGIN_BUILD_ID) !=
+        nullptr);
+  CHECK(entry(core::features::FeaturePluginAbi, "0000000000000000") ==
+        nullptr);
+  CHECK(entry(core::features::FeaturePluginAbi + 1, JPP_PLUGIN_BUILD_ID) ==
+        nullptr);
+
+  pluginDir.rmtree();
+}
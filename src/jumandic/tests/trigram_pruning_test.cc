@@ -0,0 +1,64 @@
+#include <limits>
+#include "core/analysis/analysis_stats.h"
+#include "core/analysis/score_processor.h"
+#include "jumandic/shared/jumandic_test_env.h"
+
+namespace {
+
+// pruned connections must not reach beams or their lattice scores
+void checkBeamScores(core::analysis::Lattice* lat) {
+  auto lowest = std::numeric_limits<float>::lowest();
+  for (u32 bndIdx = 2; bndIdx < lat->createdBoundaryCount(); ++bndIdx) {
+    auto bnd = lat->boundary(bndIdx);
+    for (auto& el : bnd->starts()->beamData()) {
+      if (core::analysis::EntryBeam::isFake(el)) {
+        continue;
+      }
+      CHECK(el.totalScore > lowest / 2);
+      auto scores = bnd->scores()->forPtr(el.ptr);
+      CHECK(scores.at(0) > lowest / 2);
+    }
+  }
+}
+
+void checkPruning(i32 rightCheck) {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 1);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana->impl()->setGlobalBeam(6, rightCheck, 5));
+  auto numTrigrams = ana->impl()->core().features().ngramPartial->numTrigrams();
+  u64 pruned = 0;
+  for (auto ex : jumandicTestExamples()) {
+    CAPTURE(ex);
+    ana->impl()->setTrigramPruning(false);
+    auto full = analyzeBeams(ana.get(), ex);
+    checkBeamScores(ana->impl()->lattice());
+    CHECK(full.prunedConnections == 0);
+    ana->impl()->setTrigramPruning(true);
+    auto bounded = analyzeBeams(ana.get(), ex);
+    checkBeamScores(ana->impl()->lattice());
+    REQUIRE(full.eosScores.size() == bounded.eosScores.size());
+    for (size_t i = 0; i < full.eosScores.size(); ++i) {
+      CHECK(full.eosScores[i] == Approx(bounded.eosScores[i]).epsilon(1e-4));
+    }
+    // pruned connections skip only trigram features
+    CHECK(full.featuresHashed - bounded.featuresHashed ==
+          bounded.prunedConnections * numTrigrams);
+    pruned += bounded.prunedConnections;
+  }
+  if (core::analysis::AnalysisStatsEnabled) {
+    CHECK(pruned > 0);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("trigram pruning does not change global beam analysis",
+          "[gbeam]") {
+  checkPruning(0);
+}
+
+TEST_CASE("trigram pruning does not change analysis with right beam",
+          "[gbeam]") {
+  checkPruning(1);
+}
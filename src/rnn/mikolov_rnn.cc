@@ -93,16 +93,34 @@ Status MikolovRnn::init(const MikolovRnnModelHeader& header,
 
   this->weights = weights;
   this->maxentWeights = maxentW;
+  this->maxentBits = 32;
   this->header = header;
   this->rnnNceConstant = header.nceLnz;
   return Status::Ok();
 }
 
+void MikolovRnn::useQuantizedMaxent(const QuantizedMaxent8& weights) {
+  JPP_DCHECK_EQ(weights.size(), header.maxentSize);
+  maxentWeights8 = weights;
+  maxentBits = 8;
+}
+
+void MikolovRnn::useQuantizedMaxent(const QuantizedMaxent16& weights) {
+  JPP_DCHECK_EQ(weights.size(), header.maxentSize);
+  maxentWeights16 = weights;
+  maxentBits = 16;
+}
+
 void MikolovRnn::applyParallel(ParallelStepData* data) const {
   MikolovRnnImplParallel impl{*this};
   impl.apply(data);
 }
 
+void MikolovRnn::applyBatched(BatchedStepData* data) const {
+  MikolovRnnImplBatched impl{*this};
+  impl.apply(data);
+}
+
 void MikolovRnn::computeNewParCtx(ParallelContextData* pcd) const {
   MikolovRnnImplParallel impl{*this};
   impl.computeNewContext(*pcd);
@@ -6,6 +6,7 @@
 #define JUMANPP_MIKOLOV_RNN_H
 
 #include <memory>
+#include "util/quantized_weights.h"
 #include "util/sliceable_array.h"
 #include "util/status.hpp"
 #include "util/string_piece.h"
@@ -69,6 +70,34 @@ struct ParallelStepData {
   util::MutableArraySlice<float> scores;  // nvals
 };
 
+/**
+ * Scoring input for a whole lattice boundary.
+ * Contexts and words are deduplicated and each score item refers
+ * to a (context, word) pair, so context scores of a dense boundary
+ * are computed with a single GEMM and maxent indices are hashed
+ * once per context.
+ */
+struct BatchedStepData {
+  // MaxEnt part
+  util::ConstSliceable<i32> contextIds;  // ctx - 1 x nctx
+  util::ArraySlice<i32> rightIds;        // nwords
+
+  // RNN part
+  util::ConstSliceable<float> context;    // size x nctx
+  util::ConstSliceable<float> nceEmbeds;  // size x nwords
+
+  // Score items
+  util::ArraySlice<u32> contextIdx;  // nvals
+  util::ArraySlice<u32> wordIdx;     // nvals
+
+  // Buffers
+  util::Sliceable<float> scoreMatrix;  // nwords x nctx, 64-aligned
+  util::Sliceable<u64> maxentIndices;  // ctx x nctx
+
+  // Output
+  util::MutableArraySlice<float> scores;  // nvals
+};
+
 Status readHeader(StringPiece data, MikolovRnnModelHeader* header,
                   size_t* offset);
 
@@ -90,23 +119,52 @@ class MikolovModelReader {
   util::ArraySlice<float> maxentWeights() const;
 };
 
+using QuantizedMaxent8 = util::BlockQuantizedWeights<i8>;
+using QuantizedMaxent16 = util::BlockQuantizedWeights<i16>;
+
 class MikolovRnn {
   MikolovRnnModelHeader header;
   util::ArraySlice<float> weights;
   util::ArraySlice<float> maxentWeights;
+  QuantizedMaxent8 maxentWeights8;
+  QuantizedMaxent16 maxentWeights16;
+  i32 maxentBits = 32;
   float rnnNceConstant;
 
+  template <typename Fn>
+  void withMaxentWeights(Fn&& fn) const {
+    switch (maxentBits) {
+      case 8:
+        fn(maxentWeights8);
+        break;
+      case 16:
+        fn(maxentWeights16);
+        break;
+      default:
+        fn(maxentWeights);
+    }
+  }
+
   friend class MikolovRnnImpl;
   friend class MikolovRnnImplParallel;
+  friend class MikolovRnnImplBatched;
 
  public:
   Status init(const MikolovRnnModelHeader& header,
               const util::ArraySlice<float>& weights,
               const util::ArraySlice<float>& maxentW);
+  /**
+   * Maxent weights are read from the quantized table instead of floats.
+   * The table must be alive while the RNN is used.
+   */
+  void useQuantizedMaxent(const QuantizedMaxent8& weights);
+  void useQuantizedMaxent(const QuantizedMaxent16& weights);
+  i32 maxentWeightBits() const { return maxentBits; }
   void setNceConstant(float value) { rnnNceConstant = value; }
   float nceConstant() const { return rnnNceConstant; }
   void apply(StepData* data);
   void applyParallel(ParallelStepData* data) const;
+  void applyBatched(BatchedStepData* data) const;
   void computeNewParCtx(ParallelContextData* pcd) const;
   const MikolovRnnModelHeader& modelHeader() const { return header; }
 
@@ -6,6 +6,7 @@
 #define JUMANPP_MIKOLOV_RNN_IMPL_H
 
 #include <array>
+#include <type_traits>
 #include "mikolov_rnn.h"
 #include "simple_rnn_impl.h"
 #include "util/debug_output.h"
@@ -18,42 +19,85 @@ namespace mikolov {
 
 using namespace jumanpp::rnn::impl;
 
-class MikolovScoreCalculator {
+// Weights are either floats or a quantized table,
+// they need only to support operator[].
+template <typename Weights>
+class MikolovScoreCalculatorT {
   util::ArraySlice<u64> indices;
-  util::ArraySlice<float> weights;
+  Weights weights;
   u64 hashMax;
+  u64 hashMax2;
 
  public:
-  MikolovScoreCalculator(const util::ArraySlice<u64> &indices,
-                         const util::ArraySlice<float> &weights, u64 hashMax)
-      : indices(indices), weights(weights), hashMax(hashMax) {}
+  MikolovScoreCalculatorT(const util::ArraySlice<u64> &indices,
+                          const Weights &weights, u64 hashMax)
+      : indices(indices),
+        weights(weights),
+        hashMax(hashMax),
+        hashMax2(hashMax * 2) {}
+
+  // Equal to (index + word) % hashMax.
+  // Indices are always less than hashMax and words usually are as well,
+  // so a conditional subtraction replaces the division most of the time.
+  inline size_t wrap(u64 index, i32 word) const {
+    u64 raw = index + word;
+    if (JPP_LIKELY(raw < hashMax2)) {
+      return static_cast<size_t>(raw >= hashMax ? raw - hashMax : raw);
+    }
+    return static_cast<size_t>(raw % hashMax);
+  }
 
   inline float calcScores1(i32 word) const {
-    auto idx0 = static_cast<size_t>((indices[0] + word) % hashMax);
+    auto idx0 = wrap(indices[0], word);
     return weights[idx0];
   }
 
   inline float calcScores2(i32 word) const {
-    auto idx0 = static_cast<size_t>((indices[0] + word) % hashMax);
-    auto idx1 = static_cast<size_t>((indices[1] + word) % hashMax);
+    auto idx0 = wrap(indices[0], word);
+    auto idx1 = wrap(indices[1], word);
     return weights[idx0] + weights[idx1];
   }
 
   inline float calcScores3(i32 word) const {
-    auto idx0 = static_cast<size_t>((indices[0] + word) % hashMax);
-    auto idx1 = static_cast<size_t>((indices[1] + word) % hashMax);
-    auto idx2 = static_cast<size_t>((indices[2] + word) % hashMax);
+    auto idx0 = wrap(indices[0], word);
+    auto idx1 = wrap(indices[1], word);
+    auto idx2 = wrap(indices[2], word);
     return weights[idx0] + weights[idx1] + weights[idx2];
   }
 
   inline float calcScores4(i32 word) const {
-    auto idx0 = static_cast<size_t>((indices[0] + word) % hashMax);
-    auto idx1 = static_cast<size_t>((indices[1] + word) % hashMax);
-    auto idx2 = static_cast<size_t>((indices[2] + word) % hashMax);
-    auto idx3 = static_cast<size_t>((indices[3] + word) % hashMax);
+    auto idx0 = wrap(indices[0], word);
+    auto idx1 = wrap(indices[1], word);
+    auto idx2 = wrap(indices[2], word);
+    auto idx3 = wrap(indices[3], word);
     return weights[idx0] + weights[idx1] + weights[idx2] + weights[idx3];
   }
 
+  inline float calcScoresN(i32 word) const {
+    float res = 0;
+    for (int j = 0; j < indices.size(); ++j) {
+      res += weights[wrap(indices[j], word)];
+    }
+    return res;
+  }
+
+  inline float calcScore(i32 word) const {
+    switch (indices.size()) {
+      case 0:
+        return 0;
+      case 1:
+        return calcScores1(word);
+      case 2:
+        return calcScores2(word);
+      case 3:
+        return calcScores3(word);
+      case 4:
+        return calcScores4(word);
+      default:
+        return calcScoresN(word);
+    }
+  }
+
   void addScores(util::ArraySlice<i32> words,
                  util::MutableArraySlice<float> result) const {
     switch (indices.size()) {
@@ -82,19 +126,15 @@ class MikolovScoreCalculator {
         break;
       default: {
         for (int i = 0; i < words.size(); ++i) {
-          auto w = words[i];
-          float res = 0;
-          for (int j = 0; j < indices.size(); ++j) {
-            auto idx = (indices[i] + w) % hashMax;
-            res += weights[idx];
-          }
-          result.at(i) += res;
+          result.at(i) += calcScoresN(words.at(i));
         }
       }
     }
   }
 };
 
+using MikolovScoreCalculator = MikolovScoreCalculatorT<util::ArraySlice<float>>;
+
 class MikolovIndexCalculator {
   u64 hashMax;
 
@@ -118,14 +158,17 @@ class MikolovIndexCalculator {
     }
   }
 
+  u64 tableSize() const { return hashMax; }
+
+  template <typename Weights>
   void addScores(util::ArraySlice<i32> context, util::ArraySlice<i32> words,
-                 util::ArraySlice<float> weights,
+                 const Weights &weights,
                  util::MutableArraySlice<float> scores) {
     std::array<u64, 4> hashedIndex{{0}};
     JPP_DCHECK_IN(context.size(), 0, 4);
     util::MutableArraySlice<u64> slice{hashedIndex.data(), context.size() + 1};
     calcIndices(context, slice);
-    MikolovScoreCalculator msc{slice, weights, hashMax};
+    MikolovScoreCalculatorT<Weights> msc{slice, weights, hashMax};
     msc.addScores(words, scores);
   }
 };
@@ -165,11 +208,13 @@ class MikolovRnnImpl {
     auto contexts = data->contextIds;
     auto words = data->rightIds;
     auto scorePack = data->scores;
-    for (int beam = 0; beam < contexts.numRows(); ++beam) {
-      auto ctx = contexts.row(beam);
-      auto scores = scorePack.row(beam);
-      calc.addScores(ctx, words, rnn.maxentWeights, scores);
-    }
+    rnn.withMaxentWeights([&](const auto &weights) {
+      for (int beam = 0; beam < contexts.numRows(); ++beam) {
+        auto ctx = contexts.row(beam);
+        auto scores = scorePack.row(beam);
+        calc.addScores(ctx, words, weights, scores);
+      }
+    });
   }
 
   void applyNceConstant(StepData *data) {
@@ -227,13 +272,15 @@ class MikolovRnnImplParallel {
     auto contexts = data->contextIds;
     auto words = data->rightIds;
     auto scorePack = data->scores;
-    for (int item = 0; item < words.size(); ++item) {
-      auto ctx = contexts.row(item);
-      auto idx = static_cast<u32>(item);
-      util::MutableArraySlice<float> scores(scorePack, idx, 1);
-      util::ArraySlice<i32> wordSlice{words, idx, 1};
-      calc.addScores(ctx, wordSlice, rnn.maxentWeights, scores);
-    }
+    rnn.withMaxentWeights([&](const auto &weights) {
+      for (int item = 0; item < words.size(); ++item) {
+        auto ctx = contexts.row(item);
+        auto idx = static_cast<u32>(item);
+        util::MutableArraySlice<float> scores(scorePack, idx, 1);
+        util::ArraySlice<i32> wordSlice{words, idx, 1};
+        calc.addScores(ctx, wordSlice, weights, scores);
+      }
+    });
   }
 
   void applyNceConstant(ParallelStepData *data) {
@@ -255,6 +302,89 @@ class MikolovRnnImplParallel {
   }
 };
 
+class MikolovRnnImplBatched {
+  const MikolovRnn &rnn;
+
+ public:
+  MikolovRnnImplBatched(const MikolovRnn &rnn) : rnn(rnn) {}
+
+  bool isDense(const BatchedStepData &data) const {
+    auto numCtx = data.context.numRows();
+    auto numWords = data.nceEmbeds.numRows();
+    // GEMM computes all pairs, it is worth it only when most of them are used
+    return numCtx * numWords <= data.scores.size() * 2;
+  }
+
+  void computeContextScoresGemm(BatchedStepData *data) {
+    auto esize = rnn.header.layerSize;
+    auto numCtx = data->context.numRows();
+    auto numWords = data->nceEmbeds.numRows();
+    auto context = impl::asMatrix(data->context, esize, numCtx);
+    auto embeddings = impl::asMatrix(data->nceEmbeds, esize, numWords);
+    auto all = impl::asMatrix(data->scoreMatrix, numWords, numCtx);
+    all.noalias() = embeddings.transpose() * context;
+
+    for (int i = 0; i < data->scores.size(); ++i) {
+      auto ctx = data->contextIdx[i];
+      auto word = data->wordIdx[i];
+      data->scores.at(i) = all(word, ctx);
+    }
+  }
+
+  void computeContextScoresSparse(BatchedStepData *data) {
+    auto esize = rnn.header.layerSize;
+    auto numCtx = data->context.numRows();
+    auto numWords = data->nceEmbeds.numRows();
+    auto context = impl::asMatrix(data->context, esize, numCtx);
+    auto embeddings = impl::asMatrix(data->nceEmbeds, esize, numWords);
+
+    for (int i = 0; i < data->scores.size(); ++i) {
+      auto ctx = data->contextIdx[i];
+      auto word = data->wordIdx[i];
+      data->scores.at(i) = embeddings.col(word).dot(context.col(ctx));
+    }
+  }
+
+  void computeMaxentScores(BatchedStepData *data) {
+    MikolovIndexCalculator calc{rnn.header.maxentSize, rnn.header.vocabSize};
+    auto contexts = data->contextIds;
+    auto indices = data->maxentIndices;
+    JPP_DCHECK_EQ(indices.rowSize(), contexts.rowSize() + 1);
+    // hashed indices depend only on the context, compute them once
+    for (int ctx = 0; ctx < contexts.numRows(); ++ctx) {
+      calc.calcIndices(contexts.row(ctx), indices.row(ctx));
+    }
+
+    auto hashMax = calc.tableSize();
+    rnn.withMaxentWeights([&](const auto &weights) {
+      using Weights = std::decay_t<decltype(weights)>;
+      for (int i = 0; i < data->scores.size(); ++i) {
+        auto ctx = data->contextIdx[i];
+        auto word = data->rightIds[data->wordIdx[i]];
+        MikolovScoreCalculatorT<Weights> msc{indices.row(ctx), weights,
+                                             hashMax};
+        data->scores.at(i) += msc.calcScore(word);
+      }
+    });
+  }
+
+  void applyNceConstant(BatchedStepData *data) {
+    size_t numEntries = data->scores.size();
+    auto result = impl::asMatrix(data->scores, numEntries, 1);
+    result.array() -= rnn.rnnNceConstant;
+  }
+
+  void apply(BatchedStepData *data) {
+    if (isDense(*data)) {
+      computeContextScoresGemm(data);
+    } else {
+      computeContextScoresSparse(data);
+    }
+    computeMaxentScores(data);
+    applyNceConstant(data);
+  }
+};
+
 }  // namespace mikolov
 }  // namespace rnn
 }  // namespace jumanpp
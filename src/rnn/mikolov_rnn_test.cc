@@ -4,6 +4,8 @@
 
 #include "mikolov_rnn.h"
 #include <util/memory.hpp>
+#include <random>
+#include "mikolov_rnn_impl.h"
 #include "legacy/rnnlmlib_static.h"
 #include "testing/standalone_test.h"
 #include "util/logging.hpp"
@@ -393,4 +395,118 @@ TEST_CASE("reimplementation works in parallel mode") {
   REQUIRE(b.size() == 2);
   CHECK(b[0].nScore(0) == Approx(b1a.normalizedScore));
   CHECK(b[1].nScore(0) == Approx(b2a.normalizedScore));
-}
\ No newline at end of file
+}
+
+TEST_CASE("maxent score calculator is equal to modulo indexing") {
+  std::vector<float> weights;
+  for (int i = 0; i < 97; ++i) {
+    weights.push_back(i * 0.5f);
+  }
+  std::vector<u64> indices{0, 5, 96, 33, 50, 71};
+  for (size_t order = 0; order <= indices.size(); ++order) {
+    util::ArraySlice<u64> idxSlice{indices.data(), order};
+    MikolovScoreCalculator msc{idxSlice, weights, weights.size()};
+    for (i32 word : {-1, 0, 1, 50, 96, 97, 200, 1000}) {
+      float expected = 0;
+      for (size_t j = 0; j < order; ++j) {
+        expected += weights[(indices[j] + word) % weights.size()];
+      }
+      CAPTURE(order);
+      CAPTURE(word);
+      CHECK(msc.calcScore(word) == Approx(expected));
+    }
+  }
+}
+
+class RandomRnn {
+ public:
+  util::memory::Manager mgr{1024 * 1024};
+  std::unique_ptr<util::memory::PoolAlloc> alloc{mgr.core()};
+  std::minstd_rand rng{42};
+  std::uniform_real_distribution<float> values{-0.5f, 0.5f};
+  MikolovRnnModelHeader header{8, 3, 1000, 50, 9.0f};
+  MikolovRnn rnn;
+
+  RandomRnn() {
+    auto weights = randomBuf(header.layerSize * header.layerSize);
+    auto maxent = randomBuf(header.maxentSize);
+    REQUIRE_OK(rnn.init(header, weights, maxent));
+  }
+
+  util::MutableArraySlice<float> randomBuf(size_t size) {
+    auto buf = alloc->allocateBuf<float>(size, 64);
+    for (auto& v : buf) {
+      v = values(rng);
+    }
+    return buf;
+  }
+
+  util::Sliceable<float> randomRows(size_t rows) {
+    auto buf = randomBuf(rows * header.layerSize);
+    return util::Sliceable<float>{buf, header.layerSize, rows};
+  }
+
+  // Scores of all items via batched scoring and via per-item scoring
+  void compare(u32 numCtx, u32 numWords, const std::vector<u32>& ctxIdx,
+               const std::vector<u32>& wordIdx) {
+    auto context = randomRows(numCtx);
+    auto nceEmbeds = randomRows(numWords);
+    auto ctxIds = alloc->allocate2d<i32>(numCtx, header.maxentOrder - 1);
+    std::uniform_int_distribution<i32> words{-1, (i32)header.vocabSize - 1};
+    for (auto& id : ctxIds.data()) {
+      id = words(rng);
+    }
+    auto rightIds = alloc->allocateBuf<i32>(numWords);
+    for (auto& id : rightIds) {
+      id = words(rng);
+    }
+
+    auto numItems = ctxIdx.size();
+    auto scores = alloc->allocateBuf<float>(numItems, 64);
+    auto matrix = alloc->allocate2d<float>(numCtx, numWords, 64);
+    auto maxentIdx = alloc->allocate2d<u64>(numCtx, header.maxentOrder);
+    BatchedStepData bsd{ctxIds,  rightIds, context,   nceEmbeds, ctxIdx,
+                        wordIdx, matrix,   maxentIdx, scores};
+    rnn.applyBatched(&bsd);
+
+    auto expCtxIds = alloc->allocate2d<i32>(numItems, header.maxentOrder - 1);
+    auto expIds = alloc->allocateBuf<i32>(numItems);
+    auto expCtx = randomRows(numItems);
+    auto expEmbeds = randomRows(numItems);
+    auto expected = alloc->allocateBuf<float>(numItems, 64);
+    for (size_t i = 0; i < numItems; ++i) {
+      auto idRow = expCtxIds.row(i);
+      util::copy_buffer(ctxIds.row(ctxIdx[i]), idRow);
+      expIds.at(i) = rightIds.at(wordIdx[i]);
+      auto ctxRow = expCtx.row(i);
+      util::copy_buffer(context.row(ctxIdx[i]), ctxRow);
+      auto embRow = expEmbeds.row(i);
+      util::copy_buffer(nceEmbeds.row(wordIdx[i]), embRow);
+    }
+    ParallelStepData psd{expCtxIds, expIds, expCtx, expEmbeds, expected};
+    rnn.applyParallel(&psd);
+
+    for (size_t i = 0; i < numItems; ++i) {
+      CAPTURE(i);
+      CHECK(scores.at(i) == Approx(expected.at(i)));
+    }
+  }
+};
+
+TEST_CASE("batched scoring is equal to parallel scoring for dense batches") {
+  RandomRnn r;
+  std::vector<u32> ctxIdx;
+  std::vector<u32> wordIdx;
+  for (u32 word = 0; word < 7; ++word) {
+    for (u32 ctx = 0; ctx < 5; ++ctx) {
+      ctxIdx.push_back(ctx);
+      wordIdx.push_back(word);
+    }
+  }
+  r.compare(5, 7, ctxIdx, wordIdx);
+}
+
+TEST_CASE("batched scoring is equal to parallel scoring for sparse batches") {
+  RandomRnn r;
+  r.compare(6, 6, {0, 1, 2, 3, 4, 5, 5}, {5, 4, 3, 2, 1, 0, 1});
+}
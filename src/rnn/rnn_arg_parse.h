@@ -74,6 +74,12 @@ class RnnArgs {
       "Separator for field values in RNN dictionary (default _)",
       {"rnn-separator"}};
 
+  args::ValueFlag<i32> stateCacheSize{
+      rnnGrp,
+      "N",
+      "Number of RNN states which are cached between sentences, default: 0",
+      {"rnn-state-cache"}};
+
  public:
   explicit RnnArgs(args::Group& parent) { parent.Add(rnnGrp); }
 
@@ -87,6 +93,7 @@ class RnnArgs {
     copy.unkSymbol.set(rnnUnk);
     copy.eosSymbol.set(rnnEos);
     copy.fieldSeparator.set(rnnFieldSeparator);
+    copy.stateCacheSize.set(stateCacheSize);
     if (rnnFields) {
       std::vector<std::string> values;
       auto& data = rnnFields.Get();
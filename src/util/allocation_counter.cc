@@ -0,0 +1,26 @@
+#include "allocation_counter.h"
+
+namespace jumanpp {
+namespace util {
+namespace memory {
+
+namespace {
+AllocationCountSource countSource = nullptr;
+}  // namespace
+
+AllocationCount threadAllocationCount() {
+  if (countSource == nullptr) {
+    return AllocationCount{0, 0, 0};
+  }
+  return countSource();
+}
+
+bool allocationCountingEnabled() { return countSource != nullptr; }
+
+void setAllocationCountSource(AllocationCountSource source) {
+  countSource = source;
+}
+
+}  // namespace memory
+}  // namespace util
+}  // namespace jumanpp
@@ -0,0 +1,61 @@
+#ifndef JUMANPP_ALLOCATION_COUNTER_H
+#define JUMANPP_ALLOCATION_COUNTER_H
+
+#include "types.hpp"
+
+namespace jumanpp {
+namespace util {
+namespace memory {
+
+struct AllocationCount {
+  u64 allocations;
+  u64 deallocations;
+  u64 bytes;
+};
+
+using AllocationCountSource = AllocationCount (*)();
+
+/**
+ * Heap allocations which were done by the current thread so far.
+ *
+ * Counting is done by replacing global operator new and delete
+ * in the jpp_util_alloc_counter library. Only binaries which link it
+ * are instrumented, all counts are zero in other binaries.
+ */
+AllocationCount threadAllocationCount();
+
+bool allocationCountingEnabled();
+
+/**
+ * Called by the instrumented operator new when its library is linked.
+ */
+void setAllocationCountSource(AllocationCountSource source);
+
+/**
+ * Counts heap allocations done by the current thread
+ * during the lifetime of the object.
+ */
+class AllocationCounter {
+  AllocationCount start_;
+
+ public:
+  AllocationCounter() : start_(threadAllocationCount()) {}
+
+  void restart() { start_ = threadAllocationCount(); }
+
+  AllocationCount count() const {
+    auto now = threadAllocationCount();
+    return AllocationCount{now.allocations - start_.allocations,
+                           now.deallocations - start_.deallocations,
+                           now.bytes - start_.bytes};
+  }
+
+  u64 allocations() const { return count().allocations; }
+  u64 deallocations() const { return count().deallocations; }
+};
+
+}  // namespace memory
+}  // namespace util
+}  // namespace jumanpp
+
+#endif  // JUMANPP_ALLOCATION_COUNTER_H
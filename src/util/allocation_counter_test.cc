@@ -0,0 +1,19 @@
+#include "allocation_counter.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+
+TEST_CASE("allocation counter counts allocations") {
+  util::memory::AllocationCounter counter;
+  // direct calls of operator new can not be elided by compiler
+  void* ptr = ::operator new(16);
+  CHECK(counter.allocations() == 1);
+  CHECK(counter.deallocations() == 0);
+  ::operator delete(ptr);
+  auto cnt = counter.count();
+  CHECK(cnt.allocations == 1);
+  CHECK(cnt.deallocations == 1);
+  CHECK(cnt.bytes == 16);
+  counter.restart();
+  CHECK(counter.allocations() == 0);
+}
@@ -0,0 +1,66 @@
+#include "buffered_output.h"
+
+namespace jumanpp {
+namespace util {
+
+BlockOutputBuf::BlockOutputBuf(std::ostream* sink, size_t bufferSize)
+    : sink_{sink}, buffer_(bufferSize) {
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+bool BlockOutputBuf::writePending() {
+  auto size = pptr() - pbase();
+  if (size > 0) {
+    sink_->write(pbase(), size);
+  }
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+  return sink_->good();
+}
+
+BlockOutputBuf::int_type BlockOutputBuf::overflow(int_type ch) {
+  if (!writePending()) {
+    return traits_type::eof();
+  }
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+std::streamsize BlockOutputBuf::xsputn(const char* s, std::streamsize n) {
+  if (n <= epptr() - pptr()) {
+    traits_type::copy(pptr(), s, static_cast<size_t>(n));
+    pbump(static_cast<int>(n));
+    return n;
+  }
+  if (!writePending()) {
+    return 0;
+  }
+  if (n >= static_cast<std::streamsize>(buffer_.size())) {
+    // does not fit into the buffer anyway
+    sink_->write(s, n);
+    return sink_->good() ? n : 0;
+  }
+  traits_type::copy(pptr(), s, static_cast<size_t>(n));
+  pbump(static_cast<int>(n));
+  return n;
+}
+
+int BlockOutputBuf::sync() {
+  if (!writePending()) {
+    return -1;
+  }
+  sink_->flush();
+  return sink_->good() ? 0 : -1;
+}
+
+BufferedOutput::BufferedOutput(std::ostream* sink, size_t bufferSize)
+    : std::ostream{nullptr}, buf_{sink, bufferSize} {
+  rdbuf(&buf_);
+}
+
+BufferedOutput::~BufferedOutput() { flush(); }
+
+}  // namespace util
+}  // namespace jumanpp
@@ -0,0 +1,48 @@
+#ifndef JUMANPP_BUFFERED_OUTPUT_H
+#define JUMANPP_BUFFERED_OUTPUT_H
+
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+namespace jumanpp {
+namespace util {
+
+/**
+ * Stream buffer which collects output in a large block
+ * and passes it to the underlying stream in a single write call.
+ */
+class BlockOutputBuf : public std::streambuf {
+  std::ostream* sink_;
+  std::vector<char> buffer_;
+
+  bool writePending();
+
+ protected:
+  int_type overflow(int_type ch) override;
+  std::streamsize xsputn(const char* s, std::streamsize n) override;
+  int sync() override;
+
+ public:
+  BlockOutputBuf(std::ostream* sink, size_t bufferSize);
+};
+
+/**
+ * Output stream which writes to another stream in large blocks,
+ * so the per-call overhead of the target (e.g. synchronized std::cout)
+ * is paid once per block instead of once per sentence.
+ *
+ * flush() writes the pending block and flushes the target stream.
+ */
+class BufferedOutput : public std::ostream {
+  BlockOutputBuf buf_;
+
+ public:
+  explicit BufferedOutput(std::ostream* sink, size_t bufferSize = 1024 * 1024);
+  ~BufferedOutput() override;
+};
+
+}  // namespace util
+}  // namespace jumanpp
+
+#endif  // JUMANPP_BUFFERED_OUTPUT_H
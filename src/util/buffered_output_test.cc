@@ -0,0 +1,29 @@
+#include "buffered_output.h"
+#include <sstream>
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+
+TEST_CASE("buffered output writes data only when the block is full") {
+  std::stringstream sink;
+  util::BufferedOutput out{&sink, 8};
+  out << "abc";
+  CHECK(sink.str().empty());
+  out << "defgh";
+  out << 'i';
+  CHECK(sink.str() == "abcdefgh");
+  out.flush();
+  CHECK(sink.str() == "abcdefghi");
+}
+
+TEST_CASE("buffered output passes through large writes") {
+  std::stringstream sink;
+  {
+    util::BufferedOutput out{&sink, 4};
+    out << "ab";
+    out << "0123456789";
+    CHECK(sink.str() == "ab0123456789");
+    out << "xy";
+  }
+  CHECK(sink.str() == "ab0123456789xy");
+}
@@ -163,6 +163,16 @@ Status preprocessRawData(StringPiece utf8data,
 
 i32 numCodepoints(StringPiece utf8);
 
+/**
+ * Hash for using codepoints as keys of util::FlatMap.
+ * Identity hash puts every 256 consecutive codepoints into a single bucket.
+ */
+struct CodepointHash {
+  size_t operator()(char32_t cp) const noexcept {
+    return static_cast<size_t>(cp * 0x9e3779b97f4a7c15ULL);
+  }
+};
+
 }  // namespace chars
 }  // namespace jumanpp
 
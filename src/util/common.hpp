@@ -29,6 +29,14 @@
 #define JPP_NODISCARD
 #endif
 
+// For code with intentional races on plain memory (Hogwild-style updates),
+// ThreadSanitizer does not instrument memory accesses of such functions
+#if defined(__clang__) || defined(__GNUC__)
+#define JPP_NO_SANITIZE_THREAD __attribute__((no_sanitize_thread))
+#else
+#define JPP_NO_SANITIZE_THREAD
+#endif
+
 namespace jumanpp {
 namespace util {
 
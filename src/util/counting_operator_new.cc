@@ -0,0 +1,84 @@
+// Replacement of global operator new and delete which counts
+// heap allocations of every thread for util::memory::AllocationCounter.
+// It is in the jpp_util_alloc_counter library, which only tests,
+// benchmarks and instrumented builds link.
+
+#include "allocation_counter.h"
+#include <cstdlib>
+#include <new>
+
+namespace jumanpp {
+namespace util {
+namespace memory {
+
+namespace {
+thread_local AllocationCount currentCount{0, 0, 0};
+
+void* countedAllocate(std::size_t size) {
+  currentCount.allocations += 1;
+  currentCount.bytes += size;
+  if (size == 0) {
+    size = 1;
+  }
+  return std::malloc(size);
+}
+
+void countedFree(void* ptr) {
+  if (ptr != nullptr) {
+    currentCount.deallocations += 1;
+    std::free(ptr);
+  }
+}
+
+void* allocateOrThrow(std::size_t size) {
+  void* ptr = countedAllocate(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+AllocationCount countOfThread() { return currentCount; }
+
+// operator new of this file is used by the whole binary,
+// so the initializer always runs when the library is linked
+struct RegisterCountSource {
+  RegisterCountSource() { setAllocationCountSource(countOfThread); }
+} registerCountSource;
+}  // namespace
+
+}  // namespace memory
+}  // namespace util
+}  // namespace jumanpp
+
+namespace m = jumanpp::util::memory;
+
+void* operator new(std::size_t size) { return m::allocateOrThrow(size); }
+
+void* operator new[](std::size_t size) { return m::allocateOrThrow(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return m::countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return m::countedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept { m::countedFree(ptr); }
+
+void operator delete[](void* ptr) noexcept { m::countedFree(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { m::countedFree(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  m::countedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  m::countedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  m::countedFree(ptr);
+}
@@ -0,0 +1,320 @@
+#ifndef JUMANPP_LOCKFREE_QUEUE_H
+#define JUMANPP_LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "common.hpp"
+#include "types.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#include <immintrin.h>
+#define JPP_CPU_RELAX() _mm_pause()
+#else
+#define JPP_CPU_RELAX() std::this_thread::yield()
+#endif
+
+namespace jumanpp {
+namespace util {
+
+constexpr size_t CacheLineSize = 64;
+
+namespace impl {
+
+/**
+ * Blocking support for lock-free queues.
+ *
+ * A waiting consumer spins for a while and then parks on a condition
+ * variable. Producers touch the mutex only when somebody is parked,
+ * so the uncontended path stays lock-free.
+ */
+class QueueParking {
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<u32> sleepers_{0};
+  u32 spinCount_;
+
+ public:
+  explicit QueueParking(u32 spinCount) : spinCount_{spinCount} {}
+
+  // Spinning is useless when there is no other core to produce an item
+  static u32 defaultSpinCount() {
+    return std::thread::hardware_concurrency() > 1 ? 1000 : 0;
+  }
+
+  void setSpinCount(u32 spinCount) { spinCount_ = spinCount; }
+
+  template <typename Fn>
+  void wait(Fn tryConsume) {
+    for (u32 i = 0; i < spinCount_; ++i) {
+      if (tryConsume()) {
+        return;
+      }
+      JPP_CPU_RELAX();
+    }
+
+    while (!tryConsume()) {
+      std::unique_lock<std::mutex> lock{mutex_};
+      sleepers_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      // producers check sleepers_ after publishing an item,
+      // so either we see the item here, or they see us sleeping
+      if (tryConsume()) {
+        sleepers_.fetch_sub(1);
+        return;
+      }
+      cv_.wait(lock);
+      sleepers_.fetch_sub(1);
+    }
+  }
+
+  void notifyOne() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> lock{mutex_};
+      cv_.notify_one();
+    }
+  }
+
+  void notifyAll() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    cv_.notify_all();
+  }
+};
+
+}  // namespace impl
+
+/**
+ * Lock-free bounded queue for a single producer and a single consumer.
+ * Has the same interface as bounded_queue.
+ *
+ * Producer and consumer positions are padded to separate cache lines,
+ * each side keeps a cached copy of the other side position to avoid
+ * touching the shared cache line on every operation.
+ */
+template <typename T>
+class spsc_bounded_queue {
+  struct ProducerSide {
+    std::atomic<size_t> head{0};
+    size_t cachedTail = 0;
+  };
+
+  struct ConsumerSide {
+    std::atomic<size_t> tail{0};
+    size_t cachedHead = 0;
+  };
+
+  std::unique_ptr<T[]> items_;
+  size_t capa_;
+  char pad0_[CacheLineSize];
+  ProducerSide producer_;
+  char pad1_[CacheLineSize];
+  ConsumerSide consumer_;
+  char pad2_[CacheLineSize];
+  impl::QueueParking parking_;
+
+ public:
+  size_t size() const noexcept {
+    auto tail = consumer_.tail.load(std::memory_order_acquire);
+    auto head = producer_.head.load(std::memory_order_acquire);
+    return head - tail;
+  }
+
+  size_t remaining() const noexcept { return capa_ - size(); }
+
+  explicit spsc_bounded_queue(
+      unsigned int max_size = 0,
+      u32 spinCount = impl::QueueParking::defaultSpinCount())
+      : capa_{0}, parking_{spinCount} {
+    initialize(max_size);
+  }
+
+  void initialize(unsigned int max_size) {
+    items_.reset(new T[max_size]);
+    capa_ = max_size;
+    producer_.head.store(0, std::memory_order_relaxed);
+    producer_.cachedTail = 0;
+    consumer_.tail.store(0, std::memory_order_relaxed);
+    consumer_.cachedHead = 0;
+  }
+
+  void setSpinCount(u32 spinCount) { parking_.setSpinCount(spinCount); }
+
+  bool offer(T&& item, unsigned int reserve = 0) noexcept(
+      std::is_nothrow_move_assignable<T>::value) {
+    if (reserve >= capa_) {
+      return false;
+    }
+    auto head = producer_.head.load(std::memory_order_relaxed);
+    auto limit = capa_ - reserve;
+    if (head - producer_.cachedTail >= limit) {
+      producer_.cachedTail = consumer_.tail.load(std::memory_order_acquire);
+      if (head - producer_.cachedTail >= limit) {
+        return false;
+      }
+    }
+    items_[head % capa_] = std::move(item);
+    producer_.head.store(head + 1, std::memory_order_release);
+    parking_.notifyOne();
+    return true;
+  }
+
+  // an item will be MOVED there
+  bool recieve(T* result) noexcept(std::is_nothrow_move_assignable<T>::value) {
+    auto tail = consumer_.tail.load(std::memory_order_relaxed);
+    if (consumer_.cachedHead == tail) {
+      consumer_.cachedHead = producer_.head.load(std::memory_order_acquire);
+      if (consumer_.cachedHead == tail) {
+        return false;
+      }
+    }
+    *result = std::move(items_[tail % capa_]);
+    consumer_.tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  T waitFor() noexcept(std::is_nothrow_move_constructible<T>::value) {
+    T result{};
+    parking_.wait([&]() { return recieve(&result); });
+    return result;
+  }
+
+  void unblock_all() { parking_.notifyAll(); }
+};
+
+/**
+ * Lock-free bounded queue for multiple producers and multiple consumers.
+ * Has the same interface as bounded_queue.
+ *
+ * Follows the design of Dmitry Vyukov's bounded MPMC queue:
+ * every cell has a sequence number which tells whether the cell
+ * is ready to be written to or to be read from at the current position.
+ * Producers and consumers claim positions with a CAS on their own
+ * (cache line padded) counters and do not write each other's counter.
+ */
+template <typename T>
+class mpmc_bounded_queue {
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t capa_;
+  char pad0_[CacheLineSize];
+  std::atomic<size_t> head_{0};
+  char pad1_[CacheLineSize];
+  std::atomic<size_t> tail_{0};
+  char pad2_[CacheLineSize];
+  impl::QueueParking parking_;
+
+  using diff_t = std::ptrdiff_t;
+
+ public:
+  size_t size() const noexcept {
+    auto tail = tail_.load(std::memory_order_acquire);
+    auto head = head_.load(std::memory_order_acquire);
+    auto res = head - tail;
+    return res > capa_ ? capa_ : res;
+  }
+
+  size_t remaining() const noexcept { return capa_ - size(); }
+
+  explicit mpmc_bounded_queue(
+      unsigned int max_size = 0,
+      u32 spinCount = impl::QueueParking::defaultSpinCount())
+      : capa_{0}, parking_{spinCount} {
+    initialize(max_size);
+  }
+
+  void initialize(unsigned int max_size) {
+    cells_.reset(new Cell[max_size]);
+    for (size_t i = 0; i < max_size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    capa_ = max_size;
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+  }
+
+  void setSpinCount(u32 spinCount) { parking_.setSpinCount(spinCount); }
+
+  /**
+   * Reserve is checked approximately:
+   * concurrent producers can pass the check simultaneously.
+   */
+  bool offer(T&& item, unsigned int reserve = 0) noexcept(
+      std::is_nothrow_move_assignable<T>::value) {
+    if (capa_ == 0 || (reserve != 0 && remaining() <= reserve)) {
+      return false;
+    }
+
+    Cell* cell;
+    auto pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos % capa_];
+      auto seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<diff_t>(seq) - static_cast<diff_t>(pos);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->data = std::move(item);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    parking_.notifyOne();
+    return true;
+  }
+
+  // an item will be MOVED there
+  bool recieve(T* result) noexcept(std::is_nothrow_move_assignable<T>::value) {
+    if (capa_ == 0) {
+      return false;
+    }
+
+    Cell* cell;
+    auto pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos % capa_];
+      auto seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<diff_t>(seq) - static_cast<diff_t>(pos + 1);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    *result = std::move(cell->data);
+    cell->sequence.store(pos + capa_, std::memory_order_release);
+    return true;
+  }
+
+  T waitFor() noexcept(std::is_nothrow_move_constructible<T>::value) {
+    T result{};
+    parking_.wait([&]() { return recieve(&result); });
+    return result;
+  }
+
+  void unblock_all() { parking_.notifyAll(); }
+};
+
+}  // namespace util
+}  // namespace jumanpp
+
+#endif  // JUMANPP_LOCKFREE_QUEUE_H
@@ -0,0 +1,113 @@
+#include "lockfree_queue.h"
+#include <thread>
+#include <vector>
+#include "testing/standalone_test.h"
+
+using namespace jumanpp::util;
+using jumanpp::u64;
+
+template <typename Q>
+void checkSingleThreaded(Q& q) {
+  CHECK(q.size() == 0);
+  CHECK(q.remaining() == 3);
+  int x = 0;
+  CHECK_FALSE(q.recieve(&x));
+  CHECK(q.offer(1));
+  CHECK(q.offer(2));
+  CHECK_FALSE(q.offer(3, 1));
+  CHECK(q.offer(3));
+  CHECK_FALSE(q.offer(4));
+  CHECK(q.size() == 3);
+  CHECK(q.recieve(&x));
+  CHECK(x == 1);
+  CHECK(q.offer(4));
+  CHECK(q.waitFor() == 2);
+  CHECK(q.recieve(&x));
+  CHECK(x == 3);
+  CHECK(q.recieve(&x));
+  CHECK(x == 4);
+  CHECK_FALSE(q.recieve(&x));
+  CHECK(q.remaining() == 3);
+}
+
+TEST_CASE("spsc queue works in a single thread") {
+  spsc_bounded_queue<int> q{3};
+  checkSingleThreaded(q);
+}
+
+TEST_CASE("mpmc queue works in a single thread") {
+  mpmc_bounded_queue<int> q{3};
+  checkSingleThreaded(q);
+}
+
+TEST_CASE("uninitialized queues reject items") {
+  mpmc_bounded_queue<int> q1;
+  spsc_bounded_queue<int> q2;
+  CHECK_FALSE(q1.offer(1));
+  CHECK_FALSE(q2.offer(1));
+  q1.initialize(2);
+  q2.initialize(2);
+  CHECK(q1.offer(1));
+  CHECK(q2.offer(1));
+}
+
+TEST_CASE("spsc queue passes all items between threads") {
+  spsc_bounded_queue<u64> q{16};
+  q.setSpinCount(10);
+  constexpr u64 count = 100000;
+  std::thread producer{[&]() {
+    for (u64 i = 1; i <= count; ++i) {
+      while (!q.offer(std::move(i))) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+  u64 last = 0;
+  bool ordered = true;
+  for (u64 i = 0; i < count; ++i) {
+    auto v = q.waitFor();
+    ordered &= (v == last + 1);
+    last = v;
+  }
+  producer.join();
+  CHECK(ordered);
+  CHECK(last == count);
+}
+
+TEST_CASE("mpmc queue passes all items between threads") {
+  mpmc_bounded_queue<u64> q{7};
+  q.setSpinCount(10);
+  constexpr u64 count = 20000;
+  constexpr int threads = 4;
+  std::vector<std::thread> producers;
+  std::vector<std::thread> consumers;
+  std::vector<u64> sums(threads);
+  for (int t = 0; t < threads; ++t) {
+    producers.emplace_back([&q]() {
+      for (u64 i = 1; i <= count; ++i) {
+        while (!q.offer(std::move(i))) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    consumers.emplace_back([&q, &sums, t]() {
+      u64 sum = 0;
+      for (u64 i = 0; i < count; ++i) {
+        sum += q.waitFor();
+      }
+      sums[t] = sum;
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  for (auto& t : consumers) {
+    t.join();
+  }
+  u64 total = 0;
+  for (auto s : sums) {
+    total += s;
+  }
+  CHECK(total == threads * count * (count + 1) / 2);
+  CHECK(q.size() == 0);
+}
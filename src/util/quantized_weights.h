@@ -5,33 +5,195 @@
 #ifndef JUMANPP_QUANTIZED_WEIGHTS_H
 #define JUMANPP_QUANTIZED_WEIGHTS_H
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "util/array_slice.h"
 #include "util/common.hpp"
+#include "util/types.hpp"
 
 namespace jumanpp {
 namespace util {
 
-class Float8BitLinearQ {
-  const unsigned char* memory_;
+/**
+ * Weights which are stored as unsigned integers and
+ * are linearly mapped to floats: value = min + step * stored.
+ */
+template <typename Storage>
+class LinearQuantizedWeights {
+  const Storage* memory_;
   size_t size_;
   float min_;
   float step_;
 
  public:
-  Float8BitLinearQ(const char* memory, size_t size, float min, float step)
-      : memory_(reinterpret_cast<const unsigned char*>(memory)),
+  LinearQuantizedWeights(const char* memory, size_t size, float min,
+                         float step)
+      : memory_(reinterpret_cast<const Storage*>(memory)),
         size_(size),
         min_(min),
         step_(step) {}
   size_t size() const { return size_; }
   float at(size_t idx) const {
     JPP_DCHECK_IN(idx, 0, size_);
-    unsigned char data = memory_[idx];
+    Storage data = memory_[idx];
     return min_ + step_ * data;
   }
   template <util::PrefetchHint kind>
-  void prefetch(size_t idx) const {}
+  void prefetch(size_t idx) const {
+    util::prefetch<kind>(memory_ + idx);
+  }
+};
+
+using Float8BitLinearQ = LinearQuantizedWeights<u8>;
+using Float16BitLinearQ = LinearQuantizedWeights<u16>;
+
+struct LinearQuantization {
+  float min;
+  float step;
+};
+
+/**
+ * Quantize weights linearly into the range of Storage.
+ * The grid is shifted so zero is represented exactly,
+ * which is important for hashed feature weights: most of them are zeros.
+ * The absolute error of other values is at most step / 2.
+ */
+template <typename Storage>
+LinearQuantization quantizeLinear(ArraySlice<float> weights,
+                                  MutableArraySlice<Storage> result) {
+  JPP_DCHECK_EQ(weights.size(), result.size());
+  float min = 0;
+  float max = 0;
+  for (auto w : weights) {
+    min = std::min(min, w);
+    max = std::max(max, w);
+  }
+
+  constexpr auto maxLevel = std::numeric_limits<Storage>::max();
+  LinearQuantization q{min, (max - min) / maxLevel};
+  if (q.step == 0) {
+    q.step = 1;
+  }
+
+  auto zeroLevel = std::round(-min / q.step);
+  q.min = -zeroLevel * q.step;
+
+  for (size_t i = 0; i < weights.size(); ++i) {
+    auto level = std::round((weights[i] - q.min) / q.step);
+    level = std::max(0.0f, std::min(level, static_cast<float>(maxLevel)));
+    result[i] = static_cast<Storage>(level);
+  }
+  return q;
+}
+
+/**
+ * Row-major matrix which is stored as signed integers
+ * with a float scale per row: value = scale[row] * stored.
+ */
+template <typename Storage>
+class RowQuantizedWeights {
+  const Storage* memory_ = nullptr;
+  const float* scales_ = nullptr;
+  size_t rowSize_ = 0;
+  size_t numRows_ = 0;
+
+ public:
+  RowQuantizedWeights() = default;
+  RowQuantizedWeights(const char* memory, const float* scales, size_t rowSize,
+                      size_t numRows)
+      : memory_(reinterpret_cast<const Storage*>(memory)),
+        scales_(scales),
+        rowSize_(rowSize),
+        numRows_(numRows) {}
+  size_t rowSize() const { return rowSize_; }
+  size_t numRows() const { return numRows_; }
+  float at(size_t row, size_t col) const {
+    JPP_DCHECK_IN(row, 0, numRows_);
+    JPP_DCHECK_IN(col, 0, rowSize_);
+    return scales_[row] * memory_[row * rowSize_ + col];
+  }
+  void dequantizeRow(size_t row, MutableArraySlice<float> result) const {
+    JPP_DCHECK_IN(row, 0, numRows_);
+    JPP_DCHECK_EQ(result.size(), rowSize_);
+    auto scale = scales_[row];
+    auto data = memory_ + row * rowSize_;
+    auto out = result.data();
+    for (size_t i = 0; i < rowSize_; ++i) {
+      out[i] = scale * data[i];
+    }
+  }
 };
 
+/**
+ * One-dimensional weights which are stored as signed integers
+ * with a float scale per block of 2^BlockShift consecutive weights.
+ * Random accesses need a single extra load from the small scale array.
+ */
+template <typename Storage, size_t BlockShift = 6>
+class BlockQuantizedWeights {
+  const Storage* memory_ = nullptr;
+  const float* scales_ = nullptr;
+  size_t size_ = 0;
+
+ public:
+  static constexpr size_t BlockSize = size_t{1} << BlockShift;
+
+  BlockQuantizedWeights() = default;
+  BlockQuantizedWeights(const char* memory, const float* scales, size_t size)
+      : memory_(reinterpret_cast<const Storage*>(memory)),
+        scales_(scales),
+        size_(size) {}
+  size_t size() const { return size_; }
+  float operator[](size_t idx) const {
+    JPP_DCHECK_IN(idx, 0, size_);
+    return scales_[idx >> BlockShift] * memory_[idx];
+  }
+  float at(size_t idx) const { return (*this)[idx]; }
+  template <util::PrefetchHint kind>
+  void prefetch(size_t idx) const {
+    util::prefetch<kind>(memory_ + idx);
+    util::prefetch<kind>(scales_ + (idx >> BlockShift));
+  }
+};
+
+inline size_t numQuantizedRows(size_t size, size_t rowSize) {
+  return (size + rowSize - 1) / rowSize;
+}
+
+/**
+ * Quantize weights symmetrically into signed Storage by rows of rowSize.
+ * The last row can be shorter. Zeros are represented exactly and
+ * the absolute error of other values is at most scale / 2 of their row.
+ */
+template <typename Storage>
+void quantizeRows(ArraySlice<float> weights, size_t rowSize,
+                  MutableArraySlice<Storage> result,
+                  MutableArraySlice<float> scales) {
+  JPP_DCHECK_EQ(weights.size(), result.size());
+  JPP_DCHECK_EQ(scales.size(), numQuantizedRows(weights.size(), rowSize));
+  constexpr auto maxLevel = static_cast<float>(
+      std::numeric_limits<Storage>::max());
+  for (size_t row = 0; row < scales.size(); ++row) {
+    auto start = row * rowSize;
+    auto end = std::min(start + rowSize, weights.size());
+    float maxAbs = 0;
+    for (size_t i = start; i < end; ++i) {
+      maxAbs = std::max(maxAbs, std::abs(weights[i]));
+    }
+    auto scale = maxAbs / maxLevel;
+    if (scale == 0) {
+      scale = 1;
+    }
+    scales[row] = scale;
+    for (size_t i = start; i < end; ++i) {
+      auto level = std::round(weights[i] / scale);
+      level = std::max(-maxLevel, std::min(level, maxLevel));
+      result[i] = static_cast<Storage>(level);
+    }
+  }
+}
+
 }  // namespace util
 }  // namespace jumanpp
 
@@ -0,0 +1,92 @@
+#include "quantized_weights.h"
+#include <vector>
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::util;
+
+namespace {
+template <typename Storage>
+void checkRoundtrip(const std::vector<float>& weights) {
+  std::vector<Storage> storage(weights.size());
+  auto q = quantizeLinear<Storage>(weights, &storage);
+  LinearQuantizedWeights<Storage> quantized{
+      reinterpret_cast<const char*>(storage.data()), storage.size(), q.min,
+      q.step};
+  REQUIRE(quantized.size() == weights.size());
+  for (size_t i = 0; i < weights.size(); ++i) {
+    CHECK(std::abs(quantized.at(i) - weights[i]) <= q.step / 2 + 1e-6f);
+    if (weights[i] == 0) {
+      CHECK(quantized.at(i) == 0.0f);
+    }
+  }
+}
+}  // namespace
+
+TEST_CASE("8-bit quantization keeps values close") {
+  checkRoundtrip<u8>({0.0f, -1.0f, 0.5f, 0.25f, 0.0f, 1.7f, -0.3f, 0.01f});
+}
+
+TEST_CASE("16-bit quantization keeps values close") {
+  checkRoundtrip<u16>({0.0f, -1.0f, 0.5f, 0.25f, 0.0f, 1.7f, -0.3f, 0.01f});
+}
+
+TEST_CASE("quantization works with only positive or zero weights") {
+  checkRoundtrip<u8>({0.0f, 0.0f, 0.0f});
+  checkRoundtrip<u8>({0.0f, 2.0f, 1.0f});
+  checkRoundtrip<u8>({-2.0f, -1.0f, 0.0f});
+}
+
+namespace {
+template <typename Storage>
+void checkRowRoundtrip(const std::vector<float>& weights, size_t rowSize) {
+  std::vector<Storage> storage(weights.size());
+  std::vector<float> scales(numQuantizedRows(weights.size(), rowSize));
+  quantizeRows<Storage>(weights, rowSize, &storage, &scales);
+  auto numRows = weights.size() / rowSize;
+  RowQuantizedWeights<Storage> rows{
+      reinterpret_cast<const char*>(storage.data()), scales.data(), rowSize,
+      numRows};
+  std::vector<float> row(rowSize);
+  for (size_t r = 0; r < numRows; ++r) {
+    rows.dequantizeRow(r, &row);
+    for (size_t c = 0; c < rowSize; ++c) {
+      auto orig = weights[r * rowSize + c];
+      CHECK(row[c] == rows.at(r, c));
+      CHECK(std::abs(row[c] - orig) <= scales[r] / 2 + 1e-6f);
+      if (orig == 0) {
+        CHECK(row[c] == 0.0f);
+      }
+    }
+  }
+}
+}  // namespace
+
+TEST_CASE("row quantization keeps values close") {
+  std::vector<float> weights{0.0f,  -1.0f, 0.5f,  0.25f, 0.0f,   1.7f,
+                             -0.3f, 0.01f, 20.0f, -4.0f, 0.001f, 0.0f};
+  checkRowRoundtrip<i8>(weights, 4);
+  checkRowRoundtrip<i16>(weights, 4);
+  checkRowRoundtrip<i8>(weights, 3);
+}
+
+TEST_CASE("block quantization uses a scale per block") {
+  std::vector<float> weights(100);
+  for (size_t i = 0; i < weights.size(); ++i) {
+    weights[i] = i < 64 ? 0.001f * i : 100.0f - i;
+  }
+  using Weights = BlockQuantizedWeights<i8>;
+  std::vector<i8> storage(weights.size());
+  std::vector<float> scales(
+      numQuantizedRows(weights.size(), Weights::BlockSize));
+  REQUIRE(scales.size() == 2);
+  quantizeRows<i8>(weights, Weights::BlockSize, &storage, &scales);
+  Weights quantized{reinterpret_cast<const char*>(storage.data()),
+                    scales.data(), weights.size()};
+  for (size_t i = 0; i < weights.size(); ++i) {
+    CHECK(std::abs(quantized[i] - weights[i]) <= scales[i / 64] / 2 + 1e-6f);
+    CHECK(quantized.at(i) == quantized[i]);
+  }
+  // small weights of the first block are not flattened by large ones
+  CHECK(quantized[10] != quantized[11]);
+}
@@ -0,0 +1,85 @@
+#include "shared_library.h"
+
+#if defined(_WIN32_WINNT)
+#include "win32_utils.h"
+#else
+#include <dlfcn.h>
+#endif
+
+namespace jumanpp {
+namespace util {
+
+SharedLibrary::~SharedLibrary() { close(); }
+
+#if defined(_WIN32_WINNT)
+
+Status SharedLibrary::open(StringPiece filename) {
+  close();
+  auto wideName = to_wide_string(filename);
+  auto handle = ::LoadLibraryW(wideName.c_str());
+  if (handle == nullptr) {
+    return JPPS_INVALID_PARAMETER << "failed to load library " << filename
+                                  << ", error code: " << ::GetLastError();
+  }
+  handle_ = handle;
+  filename_ = filename.str();
+  return Status::Ok();
+}
+
+void SharedLibrary::close() {
+  if (handle_ != nullptr) {
+    ::FreeLibrary(static_cast<HMODULE>(handle_));
+    handle_ = nullptr;
+  }
+}
+
+void* SharedLibrary::symbol(StringPiece name) const {
+  if (handle_ == nullptr) {
+    return nullptr;
+  }
+  auto ptr = ::GetProcAddress(static_cast<HMODULE>(handle_), name.str().c_str());
+  return reinterpret_cast<void*>(ptr);
+}
+
+StringPiece SharedLibrary::extension() { return ".dll"; }
+
+#else
+
+Status SharedLibrary::open(StringPiece filename) {
+  close();
+  auto handle = ::dlopen(filename.str().c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr) {
+    return JPPS_INVALID_PARAMETER << "failed to load library " << filename
+                                  << ": " << ::dlerror();
+  }
+  handle_ = handle;
+  filename_ = filename.str();
+  return Status::Ok();
+}
+
+void SharedLibrary::close() {
+  if (handle_ != nullptr) {
+    ::dlclose(handle_);
+    handle_ = nullptr;
+  }
+}
+
+void* SharedLibrary::symbol(StringPiece name) const {
+  if (handle_ == nullptr) {
+    return nullptr;
+  }
+  return ::dlsym(handle_, name.str().c_str());
+}
+
+StringPiece SharedLibrary::extension() {
+#ifdef __APPLE__
+  return ".dylib";
+#else
+  return ".so";
+#endif
+}
+
+#endif
+
+}  // namespace util
+}  // namespace jumanpp
@@ -0,0 +1,46 @@
+#ifndef JUMANPP_SHARED_LIBRARY_H
+#define JUMANPP_SHARED_LIBRARY_H
+
+#include <string>
+#include "status.hpp"
+#include "string_piece.h"
+
+namespace jumanpp {
+namespace util {
+
+/**
+ * A shared library which is loaded at runtime.
+ * The library is unloaded when the object is destroyed,
+ * so the object must outlive everything which uses the library code.
+ */
+class SharedLibrary {
+  void* handle_ = nullptr;
+  std::string filename_;
+
+  SharedLibrary(const SharedLibrary&) = delete;
+  SharedLibrary& operator=(const SharedLibrary&) = delete;
+
+ public:
+  SharedLibrary() = default;
+  ~SharedLibrary();
+
+  Status open(StringPiece filename);
+  void close();
+  bool isOpen() const { return handle_ != nullptr; }
+  const std::string& filename() const { return filename_; }
+
+  /**
+   * @return nullptr if the library does not export the symbol
+   */
+  void* symbol(StringPiece name) const;
+
+  /**
+   * Platform-specific filename extension of shared libraries, with the dot
+   */
+  static StringPiece extension();
+};
+
+}  // namespace util
+}  // namespace jumanpp
+
+#endif  // JUMANPP_SHARED_LIBRARY_H